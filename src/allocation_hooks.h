@@ -0,0 +1,25 @@
+// Аллокатор raylib (RL_MALLOC и т.д.) через счётчики из allocation_tracker.cpp.
+//
+// Заголовок на C: его же принудительно подключает (-include / /FI) сборка raylib
+// из исходников, см. CMakeLists.txt. В нашем коде подключается до raylib.h.
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* TrackedMalloc(size_t size);
+void* TrackedCalloc(size_t count, size_t size);
+void* TrackedRealloc(void* ptr, size_t size);
+void  TrackedFree(void* ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define RL_MALLOC(sz) TrackedMalloc(sz)
+#define RL_CALLOC(n, sz) TrackedCalloc(n, sz)
+#define RL_REALLOC(ptr, sz) TrackedRealloc(ptr, sz)
+#define RL_FREE(ptr) TrackedFree(ptr)
@@ -0,0 +1,295 @@
+//----------------------------------------------------------------------------------
+// Allocation Tracker.
+//----------------------------------------------------------------------------------
+// Считает выделения в куче: глобальные operator new / delete
+// и RL_MALLOC / RL_FREE (см. allocation_hooks.h), во всех потоках.
+// Выделения дополнительно разбиты по зонам: ALLOCATION_ZONE("name")
+// до конца scope относит выделения этого потока к зоне "name".
+//
+// Не считаются: malloc в обход RL_MALLOC (GLFW, драйвер, raylib не из исходников)
+// и operator new с align_val_t.
+//
+// Использование:
+//
+//     void SimulateGameplay() {
+//         ALLOCATION_ZONE("simulation");
+//         ...
+//     }
+//
+//     // Раз в кадр, с главного потока.
+//     const auto frame = EndAllocationFrame(allocationTracker);
+//
+const int ALLOCATION_ZONES_MAX     = 32;
+const int ALLOCATION_WARMUP_FRAMES = 120;
+
+struct AllocationStats {
+    i64 allocations = 0;  // Включая realloc.
+    i64 bytes       = 0;
+    i64 frees       = 0;
+};
+
+struct AllocationCounters_ {
+    std::atomic<i64> allocations = 0;
+    std::atomic<i64> bytes       = 0;
+    std::atomic<i64> frees       = 0;
+};
+
+struct AllocationTracker {
+    AllocationCounters_ total = {};
+
+    // Нулевая зона - всё вне ALLOCATION_ZONE.
+    // frees зоны - освобождения, сделанные в этой зоне.
+    AllocationCounters_ zones[ALLOCATION_ZONES_MAX]     = {};
+    const char*         zoneNames[ALLOCATION_ZONES_MAX] = {"other"};
+    std::atomic<int>    zonesCount                      = 1;
+
+    // Дальше - только главный поток.
+    i64             frames                                = 0;
+    AllocationStats lastFrame                             = {};
+    AllocationStats zonesLastFrame[ALLOCATION_ZONES_MAX]  = {};
+    AllocationStats frameStart                            = {};
+    AllocationStats zonesFrameStart[ALLOCATION_ZONES_MAX] = {};
+
+    // Режим "ноль выделений за кадр". Кадры с выделениями после warmupFrames
+    // пишутся в лог с разбивкой по зонам и считаются в framesWithAllocations.
+    bool forbidFrameAllocations = false;
+    int  warmupFrames           = ALLOCATION_WARMUP_FRAMES;
+    i64  framesWithAllocations  = 0;
+};
+
+globalVar AllocationTracker allocationTracker;
+
+thread_local int currentAllocationZone_ = 0;
+
+void CountAllocation_(size_t size) {
+    auto& zone = allocationTracker.zones[currentAllocationZone_];
+    allocationTracker.total.allocations.fetch_add(1, std::memory_order_relaxed);
+    allocationTracker.total.bytes.fetch_add((i64)size, std::memory_order_relaxed);
+    zone.allocations.fetch_add(1, std::memory_order_relaxed);
+    zone.bytes.fetch_add((i64)size, std::memory_order_relaxed);
+}
+
+void CountFree_() {
+    auto& zone = allocationTracker.zones[currentAllocationZone_];
+    allocationTracker.total.frees.fetch_add(1, std::memory_order_relaxed);
+    zone.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void* TrackedMalloc(size_t size) {
+    CountAllocation_(size);
+    return malloc(size);
+}
+
+extern "C" void* TrackedCalloc(size_t count, size_t size) {
+    CountAllocation_(count * size);
+    return calloc(count, size);
+}
+
+extern "C" void* TrackedRealloc(void* ptr, size_t size) {
+    CountAllocation_(size);
+    return realloc(ptr, size);
+}
+
+extern "C" void TrackedFree(void* ptr) {
+    if (ptr != nullptr)
+        CountFree_();
+    free(ptr);
+}
+
+void* operator new(size_t size) {
+    CountAllocation_(size);
+    if (void* ptr = malloc(Max(size, (size_t)1)))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t /* size */) noexcept {
+    TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t /* size */) noexcept {
+    TrackedFree(ptr);
+}
+
+// Вызывается один раз на место ALLOCATION_ZONE. Зоны сверх
+// ALLOCATION_ZONES_MAX попадают в нулевую.
+int RegisterAllocationZone(const char* name) {
+    const int zone = allocationTracker.zonesCount.fetch_add(1);
+    Assert(zone < ALLOCATION_ZONES_MAX);
+    if (zone >= ALLOCATION_ZONES_MAX)
+        return 0;
+
+    allocationTracker.zoneNames[zone] = name;
+    return zone;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+struct AllocationZoneScope_ {
+    AllocationZoneScope_(int zone)
+        : previous(currentAllocationZone_) {
+        currentAllocationZone_ = zone;
+    }
+    ~AllocationZoneScope_() {
+        currentAllocationZone_ = previous;
+    }
+    int previous;
+};
+
+#define allocation_zone_with_counter_(name, counter)                                 \
+    localPersist const int allocationZone_##counter = RegisterAllocationZone(name); \
+    AllocationZoneScope_   allocationZoneScope_##counter(allocationZone_##counter)
+#define allocation_zone_(name, counter) allocation_zone_with_counter_(name, counter)
+
+// Usage:
+//     {
+//         ALLOCATION_ZONE("draw");
+//         ...
+//     }
+#define ALLOCATION_ZONE(name) allocation_zone_(name, __COUNTER__)
+
+AllocationStats LoadAllocationStats_(const AllocationCounters_& counters) {
+    AllocationStats result = {};
+    result.allocations     = counters.allocations.load(std::memory_order_relaxed);
+    result.bytes           = counters.bytes.load(std::memory_order_relaxed);
+    result.frees           = counters.frees.load(std::memory_order_relaxed);
+    return result;
+}
+
+AllocationStats operator-(const AllocationStats& a, const AllocationStats& b) {
+    AllocationStats result = {};
+    result.allocations     = a.allocations - b.allocations;
+    result.bytes           = a.bytes - b.bytes;
+    result.frees           = a.frees - b.frees;
+    return result;
+}
+
+// Всё с начала программы.
+AllocationStats GetAllocationStats(const AllocationTracker& t) {
+    return LoadAllocationStats_(t.total);
+}
+
+void LogFrameAllocations_(const AllocationTracker& t) {
+    TraceLog(
+        LOG_WARNING,
+        "ALLOCATIONS: frame %lld: %lld allocations, %lld bytes",
+        (long long)t.frames,
+        (long long)t.lastFrame.allocations,
+        (long long)t.lastFrame.bytes
+    );
+
+    const int zonesCount = Min(t.zonesCount.load(), ALLOCATION_ZONES_MAX);
+    FOR_RANGE (int, i, zonesCount) {
+        const auto& zone = t.zonesLastFrame[i];
+        if (zone.allocations == 0)
+            continue;
+
+        TraceLog(
+            LOG_WARNING,
+            "ALLOCATIONS:     %-20s %lld allocations, %lld bytes",
+            (t.zoneNames[i] != nullptr) ? t.zoneNames[i] : "?",
+            (long long)zone.allocations,
+            (long long)zone.bytes
+        );
+    }
+}
+
+// Выделения с прошлого вызова. Результат также в t.lastFrame и t.zonesLastFrame.
+AllocationStats EndAllocationFrame(AllocationTracker& t) {
+    const auto total = LoadAllocationStats_(t.total);
+    t.lastFrame      = total - t.frameStart;
+    t.frameStart     = total;
+
+    FOR_RANGE (int, i, ALLOCATION_ZONES_MAX) {
+        const auto zone      = LoadAllocationStats_(t.zones[i]);
+        t.zonesLastFrame[i]  = zone - t.zonesFrameStart[i];
+        t.zonesFrameStart[i] = zone;
+    }
+
+    t.frames++;
+    if (t.forbidFrameAllocations && (t.frames > t.warmupFrames)
+        && (t.lastFrame.allocations > 0))
+    {
+        t.framesWithAllocations++;
+        LogFrameAllocations_(t);
+    }
+    return t.lastFrame;
+}
+
+// Начать отсчёт warmupFrames заново, например, после загрузки уровня.
+void ResetAllocationFrames(AllocationTracker& t) {
+    EndAllocationFrame(t);
+    t.frames                = 0;
+    t.framesWithAllocations = 0;
+}
+
+TEST_CASE ("AllocationTracker") {
+    auto& t = allocationTracker;
+    ResetAllocationFrames(t);
+
+    {  // operator new и RL_MALLOC, по зонам.
+        ALLOCATION_ZONE("test");
+        // new-выражение компилятор может выкинуть, вызов - нет.
+        void* value = ::operator new(16);
+        ::operator delete(value);
+
+        auto buffer = (u8*)RL_MALLOC(100);
+        RL_FREE(buffer);
+    }
+    {
+        std::vector<u8> bytes(64);
+    }
+
+    auto frame = EndAllocationFrame(t);
+    Assert(frame.allocations >= 3);
+    Assert(frame.bytes >= 16 + 100 + 64);
+    Assert(frame.frees >= 3);
+
+    int testZone = -1;
+    FOR_RANGE (int, i, Min(t.zonesCount.load(), ALLOCATION_ZONES_MAX)) {
+        if ((t.zoneNames[i] != nullptr) && (strcmp(t.zoneNames[i], "test") == 0))
+            testZone = i;
+    }
+    Assert(testZone > 0);
+    Assert(t.zonesLastFrame[testZone].allocations == 2);
+    Assert(t.zonesLastFrame[testZone].bytes == 16 + 100);
+    Assert(t.zonesLastFrame[testZone].frees == 2);
+    Assert(t.zonesLastFrame[0].allocations >= 1);
+
+    // Между вызовами ничего не выделялось.
+    EndAllocationFrame(t);
+    frame = EndAllocationFrame(t);
+    Assert(frame.allocations == 0);
+
+    // Режим "ноль выделений за кадр": первый кадр - прогрев.
+    t.forbidFrameAllocations = true;
+    t.warmupFrames           = 1;
+    ResetAllocationFrames(t);
+
+    auto warmup = (u8*)RL_MALLOC(8);
+    RL_FREE(warmup);
+    EndAllocationFrame(t);
+    EndAllocationFrame(t);
+    const i64 framesAfterWarmup = t.framesWithAllocations;
+
+    auto leak = (u8*)RL_MALLOC(8);
+    RL_FREE(leak);
+    EndAllocationFrame(t);
+    Assert(framesAfterWarmup == 0);
+    Assert(t.framesWithAllocations == 1);
+
+    t.forbidFrameAllocations = false;
+    t.warmupFrames           = ALLOCATION_WARMUP_FRAMES;
+    ResetAllocationFrames(t);
+}
@@ -0,0 +1,532 @@
+//----------------------------------------------------------------------------------
+// Mapped File.
+//----------------------------------------------------------------------------------
+// Файл целиком, отображённый в память только для чтения.
+// Страницы подгружает ОС при первом обращении, системных вызовов на чтение нет.
+#if defined(_WIN32)
+// NOTE: windows.h конфликтует с raylib (см. raylib_hack_windows.cpp),
+// поэтому нужные функции объявлены руками - если его никто не подключил раньше.
+#    if !defined(_WINDOWS_)
+extern "C" {
+__declspec(dllimport) void* __stdcall CreateFileA(
+    const char*   fileName,
+    unsigned long access,
+    unsigned long shareMode,
+    void*         security,
+    unsigned long creation,
+    unsigned long flags,
+    void*         templateFile
+);
+__declspec(dllimport) unsigned long __stdcall GetFileSize(
+    void*          file,
+    unsigned long* high
+);
+__declspec(dllimport) void* __stdcall CreateFileMappingA(
+    void*         file,
+    void*         security,
+    unsigned long protect,
+    unsigned long maxSizeHigh,
+    unsigned long maxSizeLow,
+    const char*   name
+);
+__declspec(dllimport) void* __stdcall MapViewOfFile(
+    void*         mapping,
+    unsigned long access,
+    unsigned long offsetHigh,
+    unsigned long offsetLow,
+    size_t        size
+);
+__declspec(dllimport) int __stdcall UnmapViewOfFile(const void* address);
+__declspec(dllimport) int __stdcall CloseHandle(void* handle);
+}
+#    endif
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+struct MappedFile {
+    const u8* data = nullptr;
+    i64       size = 0;
+};
+
+bool MapFile(const char* path, MappedFile& out) {
+#if defined(_WIN32)
+    const unsigned long GENERIC_READ_          = 0x80000000;
+    const unsigned long FILE_SHARE_READ_       = 0x00000001;
+    const unsigned long OPEN_EXISTING_         = 3;
+    const unsigned long FILE_ATTRIBUTE_NORMAL_ = 0x80;
+    const unsigned long PAGE_READONLY_         = 0x02;
+    const unsigned long FILE_MAP_READ_         = 0x0004;
+    void* const         INVALID_HANDLE_VALUE_  = (void*)(intptr_t)-1;
+
+    void* file = CreateFileA(
+        path,
+        GENERIC_READ_,
+        FILE_SHARE_READ_,
+        nullptr,
+        OPEN_EXISTING_,
+        FILE_ATTRIBUTE_NORMAL_,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE_)
+        return false;
+
+    unsigned long high = 0;
+    const i64     size = GetFileSize(file, &high) | ((i64)high << 32);
+    void*         view = nullptr;
+    if (size > 0) {
+        // Отображение держит файл само, хендлы можно закрыть сразу.
+        void* mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY_, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            view = MapViewOfFile(mapping, FILE_MAP_READ_, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    const int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info = {};
+    void*       view = nullptr;
+    i64         size = 0;
+    if ((fstat(file, &info) == 0) && (info.st_size > 0)) {
+        size = (i64)info.st_size;
+        view = mmap(nullptr, (size_t)size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view == MAP_FAILED)
+            view = nullptr;
+    }
+    close(file);
+#endif
+
+    if (view == nullptr)
+        return false;
+
+    out.data = (const u8*)view;
+    out.size = (i64)size;
+    return true;
+}
+
+void UnmapFile(MappedFile& file) {
+    if (file.data != nullptr) {
+#if defined(_WIN32)
+        UnmapViewOfFile(file.data);
+#else
+        munmap((void*)file.data, (size_t)file.size);
+#endif
+    }
+    file = {};
+}
+
+//----------------------------------------------------------------------------------
+// Archive.
+//----------------------------------------------------------------------------------
+// Все ресурсы игры одним файлом. Собирается cooker-ом (см. cooking.cpp),
+// в игре отображается в память целиком (MapFile).
+//
+// Формат файла (little endian):
+//
+// u32           ARCHIVE_MAGIC
+// i32           entriesCount
+// ArchiveEntry  entries[entriesCount]  - по возрастанию pathHash
+// u8            paths[]                - пути записей без нулей
+// u8            data[]                 - записи, каждая с границы ARCHIVE_ALIGNMENT
+//
+// Запись ищется двоичным поиском по Hash64 пути, путь сверяется целиком.
+// Несжатую запись можно читать прямо из отображения (ArchiveView),
+// сжатая (DEFLATE, CompressData) распаковывается в новый буфер.
+const u32 ARCHIVE_MAGIC     = 0x314B4150;  // "PAK1".
+const int ARCHIVE_ALIGNMENT = 64;
+
+struct ArchiveHeader_ {
+    u32 magic        = ARCHIVE_MAGIC;
+    int entriesCount = 0;
+};
+static_assert(sizeof(ArchiveHeader_) == 8);
+
+struct ArchiveEntry {
+    u64 pathHash   = 0;
+    u64 offset     = 0;  // От начала файла.
+    u32 size       = 0;
+    u32 packedSize = 0;  // Равен size - запись не сжата.
+    u32 pathOffset = 0;  // От начала файла.
+    u32 pathSize   = 0;
+};
+static_assert(sizeof(ArchiveEntry) == 32);
+
+struct Archive {
+    MappedFile file = {};  // Пустой, если архив открыт из памяти.
+
+    const u8*           data         = nullptr;
+    i64                 size         = 0;
+    const ArchiveEntry* entries      = nullptr;
+    int                 entriesCount = 0;
+};
+
+// Файл для BuildArchive.
+struct ArchiveFile {
+    std::string     path     = {};
+    std::vector<u8> data     = {};
+    bool            compress = false;  // Сжимается, если выходит заметно меньше.
+};
+
+std::vector<u8> BuildArchive(const std::vector<ArchiveFile>& files) {
+    const int count = (int)files.size();
+
+    std::vector<ArchiveEntry> entries(count);
+    std::vector<int>          order(count);
+    FOR_RANGE (int, i, count) {
+        const auto& path    = files[i].path;
+        entries[i].pathHash = Hash64(path.data(), path.size());
+        entries[i].pathSize = (u32)path.size();
+        order[i]            = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return entries[a].pathHash < entries[b].pathHash;
+    });
+
+    ArchiveHeader_ header = {};
+    header.entriesCount   = count;
+
+    std::vector<u8> result(sizeof(header) + count * sizeof(ArchiveEntry));
+    memcpy(result.data(), &header, sizeof(header));
+
+    for (int i : order) {
+        entries[i].pathOffset = (u32)result.size();
+        const auto& path      = files[i].path;
+        result.insert(result.end(), path.begin(), path.end());
+    }
+
+    for (int i : order) {
+        const auto& file  = files[i];
+        auto&       entry = entries[i];
+
+        const int aligned = CeilDivision((int)result.size(), ARCHIVE_ALIGNMENT);
+        result.resize((size_t)aligned * ARCHIVE_ALIGNMENT);
+        entry.offset     = result.size();
+        entry.size       = (u32)file.data.size();
+        entry.packedSize = entry.size;
+
+        int packedSize = 0;
+        u8* packed     = nullptr;
+        if (file.compress && !file.data.empty()) {
+            packed = (u8*)CompressData(
+                (const unsigned char*)file.data.data(), (int)file.data.size(), &packedSize
+            );
+        }
+
+        // Сжатие, которое экономит меньше четверти, не стоит распаковки.
+        if ((packed != nullptr) && (packedSize < (int)(entry.size - entry.size / 4))) {
+            entry.packedSize = (u32)packedSize;
+            result.insert(result.end(), packed, packed + packedSize);
+        }
+        else
+            result.insert(result.end(), file.data.begin(), file.data.end());
+
+        if (packed != nullptr)
+            MemFree(packed);
+    }
+
+    FOR_RANGE (int, i, count) {
+        memcpy(
+            result.data() + sizeof(header) + i * sizeof(ArchiveEntry),
+            &entries[order[i]],
+            sizeof(ArchiveEntry)
+        );
+    }
+    return result;
+}
+
+// data должны жить, пока открыт архив. Возвращает false, если данные битые.
+bool OpenArchiveFromMemory(const u8* data, i64 size, Archive& out) {
+    ArchiveHeader_ header = {};
+    if (size < (i64)sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+
+    if ((header.magic != ARCHIVE_MAGIC) || (header.entriesCount < 0))
+        return false;
+
+    const i64 entriesSize = (i64)header.entriesCount * (i64)sizeof(ArchiveEntry);
+    if ((i64)sizeof(header) + entriesSize > size)
+        return false;
+
+    // Выравнивание записей кратно alignof(ArchiveEntry), отображение - странице.
+    Assert(((uintptr_t)data % alignof(ArchiveEntry)) == 0);
+    const auto entries = (const ArchiveEntry*)(data + sizeof(header));
+
+    FOR_RANGE (int, i, header.entriesCount) {
+        const auto& entry = entries[i];
+        if ((i > 0) && (entries[i - 1].pathHash > entry.pathHash))
+            return false;
+        if ((i64)entry.pathOffset + entry.pathSize > size)
+            return false;
+        if ((i64)entry.offset + entry.packedSize > size)
+            return false;
+    }
+
+    Archive archive      = {};
+    archive.data         = data;
+    archive.size         = size;
+    archive.entries      = entries;
+    archive.entriesCount = header.entriesCount;
+    out                  = archive;
+    return true;
+}
+
+bool OpenArchive(const char* path, Archive& out) {
+    MappedFile file = {};
+    if (!MapFile(path, file))
+        return false;
+
+    Archive archive = {};
+    if (!OpenArchiveFromMemory(file.data, file.size, archive)) {
+        UnmapFile(file);
+        return false;
+    }
+
+    archive.file = file;
+    out          = archive;
+    return true;
+}
+
+void CloseArchive(Archive& archive) {
+    UnmapFile(archive.file);
+    archive = {};
+}
+
+const ArchiveEntry* ArchiveFind(const Archive& archive, const char* path) {
+    const size_t pathSize = strlen(path);
+    const u64    hash     = Hash64(path, pathSize);
+
+    const auto begin = archive.entries;
+    const auto end   = archive.entries + archive.entriesCount;
+
+    auto it = std::lower_bound(begin, end, hash, [](const ArchiveEntry& e, u64 value) {
+        return e.pathHash < value;
+    });
+    for (; (it != end) && (it->pathHash == hash); it++) {
+        if ((it->pathSize == pathSize)
+            && (memcmp(archive.data + it->pathOffset, path, pathSize) == 0))
+            return it;
+    }
+    return nullptr;
+}
+
+// Несжатая запись прямо из архива, без копирования.
+// false - записи нет или она сжата (тогда - ArchiveRead).
+bool ArchiveView(const Archive& archive, const char* path, const u8*& data, int& size) {
+    const auto entry = ArchiveFind(archive, path);
+    if ((entry == nullptr) || (entry->packedSize != entry->size))
+        return false;
+
+    data = archive.data + entry->offset;
+    size = (int)entry->size;
+    return true;
+}
+
+// Копия записи в буфере RL_MALLOC (освобождается UnloadFileData).
+// text - с нулём в конце, как у LoadFileText.
+u8* ArchiveRead(const Archive& archive, const ArchiveEntry& entry, int* size, bool text) {
+    const auto packed = (const unsigned char*)(archive.data + entry.offset);
+
+    u8* result = nullptr;
+    if (entry.packedSize == entry.size) {
+        result = (u8*)RL_MALLOC(entry.size + 1);
+        memcpy(result, packed, entry.size);
+    }
+    else {
+        int unpackedSize = 0;
+        result = (u8*)DecompressData(packed, (int)entry.packedSize, &unpackedSize);
+        if ((result == nullptr) || (unpackedSize != (int)entry.size)) {
+            MemFree(result);
+            return nullptr;
+        }
+        result = (u8*)RL_REALLOC(result, entry.size + 1);
+    }
+
+    if (text)
+        result[entry.size] = '\0';
+    if (size != nullptr)
+        *size = (int)entry.size;
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Resource Archive.
+//----------------------------------------------------------------------------------
+// Архив, подключённый вместо папки resources. Пути "resources/<путь>"
+// ищутся в архиве как "<путь>". Всё остальное (shader_cache и т.д.) - с диска.
+//
+// LoadFileData / LoadFileText raylib-а идут через колбеки, поэтому LoadSound,
+// LoadImage, LoadShader и т.д. работают без изменений. raylib освобождает
+// их результат сам, так что это копия из отображения. Без копий - ResourceView.
+//
+// Без архива (запуск из папки с исходниками) всё читается с диска.
+const char* RESOURCE_ARCHIVE_PREFIX = "resources/";
+
+globalVar struct ResourceArchive_ {
+    Archive archive = {};
+    bool    mounted = false;
+} resourceArchive;
+
+const ArchiveEntry* FindResource_(const char* path) {
+    if (!resourceArchive.mounted)
+        return nullptr;
+
+    const size_t prefixSize = strlen(RESOURCE_ARCHIVE_PREFIX);
+    if (strncmp(path, RESOURCE_ARCHIVE_PREFIX, prefixSize) != 0)
+        return nullptr;
+    return ArchiveFind(resourceArchive.archive, path + prefixSize);
+}
+
+// Как LoadFileData raylib-а без колбеков.
+u8* LoadDiskFile_(const char* path, int* size, bool text) {
+    *size      = 0;
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        TraceLog(LOG_WARNING, "FILEIO: [%s] Failed to open file", path);
+        return nullptr;
+    }
+    defer {
+        fclose(file);
+    };
+
+    fseek(file, 0, SEEK_END);
+    const long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fileSize < 0)
+        return nullptr;
+
+    auto result = (u8*)RL_MALLOC(fileSize + 1);
+    if (fread(result, 1, fileSize, file) != (size_t)fileSize) {
+        RL_FREE(result);
+        return nullptr;
+    }
+    if (text)
+        result[fileSize] = '\0';
+
+    *size = (int)fileSize;
+    return result;
+}
+
+unsigned char* LoadResourceFileData_(const char* fileName, int* dataSize) {
+    const auto entry = FindResource_(fileName);
+    if (entry != nullptr) {
+        auto data = ArchiveRead(resourceArchive.archive, *entry, dataSize, false);
+        return (unsigned char*)data;
+    }
+    return (unsigned char*)LoadDiskFile_(fileName, dataSize, false);
+}
+
+char* LoadResourceFileText_(const char* fileName) {
+    int  size  = 0;
+    auto entry = FindResource_(fileName);
+    if (entry != nullptr)
+        return (char*)ArchiveRead(resourceArchive.archive, *entry, &size, true);
+    return (char*)LoadDiskFile_(fileName, &size, true);
+}
+
+// false - архива нет или он битый, ресурсы читаются с диска.
+bool MountResourceArchive(const char* path) {
+    Assert(!resourceArchive.mounted);
+
+    if (!OpenArchive(path, resourceArchive.archive))
+        return false;
+
+    resourceArchive.mounted = true;
+    SetLoadFileDataCallback(LoadResourceFileData_);
+    SetLoadFileTextCallback(LoadResourceFileText_);
+    TraceLog(
+        LOG_INFO,
+        "ARCHIVE: [%s] Mounted, %d entries",
+        path,
+        resourceArchive.archive.entriesCount
+    );
+    return true;
+}
+
+void UnmountResourceArchive() {
+    if (!resourceArchive.mounted)
+        return;
+
+    SetLoadFileDataCallback(nullptr);
+    SetLoadFileTextCallback(nullptr);
+    CloseArchive(resourceArchive.archive);
+    resourceArchive.mounted = false;
+}
+
+// FileExists, который видит архив.
+bool ResourceExists(const char* path) {
+    return (FindResource_(path) != nullptr) || FileExists(path);
+}
+
+// Несжатый ресурс из архива без копирования, живёт до UnmountResourceArchive.
+// false - ресурса в архиве нет или он сжат, тогда читать обычным способом.
+bool ResourceView(const char* path, const u8*& data, int& size) {
+    const auto entry = FindResource_(path);
+    if ((entry == nullptr) || (entry->packedSize != entry->size))
+        return false;
+
+    data = resourceArchive.archive.data + entry->offset;
+    size = (int)entry->size;
+    return true;
+}
+
+// Музыка стримится из данных всё время проигрывания: из архива - без копии.
+// LoadMusicStream читает файл сам, мимо колбеков.
+Music LoadResourceMusic(const char* path) {
+    const u8* data = nullptr;
+    int       size = 0;
+    if (ResourceView(path, data, size)) {
+        return LoadMusicStreamFromMemory(
+            GetFileExtension(path), (const unsigned char*)data, size
+        );
+    }
+    return LoadMusicStream(path);
+}
+
+TEST_CASE ("Archive") {
+    std::vector<ArchiveFile> files = {
+        {"a.txt", {'h', 'e', 'l', 'l', 'o'}, true},
+        {"dir/b.bin", std::vector<u8>(1000, 7), false},
+        {"empty", {}, false},
+    };
+    const auto data = BuildArchive(files);
+
+    // Как у отображения: начало буфера выровнено.
+    std::vector<u64> aligned(CeilDivision((int)data.size(), 8));
+    memcpy(aligned.data(), data.data(), data.size());
+
+    Archive archive = {};
+    Assert(OpenArchiveFromMemory((const u8*)aligned.data(), (i64)data.size(), archive));
+    Assert(archive.entriesCount == 3);
+
+    for (const auto& file : files) {
+        const auto entry = ArchiveFind(archive, file.path.c_str());
+        Assert(entry != nullptr);
+        Assert(entry->offset % ARCHIVE_ALIGNMENT == 0);
+
+        int  size = 0;
+        auto read = ArchiveRead(archive, *entry, &size, true);
+        Assert(size == (int)file.data.size());
+        Assert(read[size] == '\0');
+        Assert_False(memcmp(read, file.data.data(), size));
+        RL_FREE(read);
+    }
+    Assert(ArchiveFind(archive, "dir") == nullptr);
+    Assert(ArchiveFind(archive, "b.bin") == nullptr);
+
+    const u8* view     = nullptr;
+    int       viewSize = 0;
+    Assert(ArchiveView(archive, "dir/b.bin", view, viewSize));
+    Assert(viewSize == 1000);
+    Assert(view[999] == 7);
+
+    // Битые данные.
+    Assert_False(OpenArchiveFromMemory((const u8*)aligned.data(), 20, archive));
+}
@@ -0,0 +1,487 @@
+//----------------------------------------------------------------------------------
+// Arena Containers.
+//----------------------------------------------------------------------------------
+// Контейнеры, память которых - в арене. Сами они ничего не освобождают:
+// всё уходит разом вместе с ResetArena / FreeArena / TEMP_USAGE.
+// После сброса арены контейнер надо обнулить (= {}).
+//
+// Элементы копируются байтами и не разрушаются - только тривиальные типы.
+//
+// FixedArray - массив, ёмкость задаётся при создании.
+// BlockArray - растущий массив из цепочки блоков. Элементы не двигаются
+//              при росте, но лежат не подряд.
+// RingBuffer - кольцо. Новые элементы затирают самые старые.
+// HashMap    - открытая адресация, линейное пробирование.
+//
+// Использование:
+//
+//     auto cubes = MakeFixedArray<CubeVoxel>(arena, count);
+//     FixedArrayAdd(cubes, cube);
+//     for (auto& cube : cubes)
+//         ...
+//
+
+//----------------------------------------------------------------------------------
+// Fixed Array.
+//----------------------------------------------------------------------------------
+template <typename T>
+struct FixedArray {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    T*  items    = nullptr;
+    int count    = 0;
+    int capacity = 0;
+
+    T& operator[](int i) {
+        Assert(i >= 0);
+        Assert(i < count);
+        return items[i];
+    }
+    const T& operator[](int i) const {
+        Assert(i >= 0);
+        Assert(i < count);
+        return items[i];
+    }
+
+    T* begin() {
+        return items;
+    }
+    T* end() {
+        return items + count;
+    }
+    const T* begin() const {
+        return items;
+    }
+    const T* end() const {
+        return items + count;
+    }
+};
+
+template <typename T>
+FixedArray<T> MakeFixedArray(Arena& arena, int capacity) {
+    Assert(capacity >= 0);
+
+    FixedArray<T> result = {};
+    if (capacity > 0)
+        result.items = AllocateAlignedArray(arena, T, capacity);
+    result.capacity = capacity;
+    return result;
+}
+
+template <typename T>
+T& FixedArrayAdd(FixedArray<T>& array, const T& value) {
+    Assert(array.count < array.capacity);
+    array.items[array.count] = value;
+    return array.items[array.count++];
+}
+
+template <typename T>
+void FixedArrayClear(FixedArray<T>& array) {
+    array.count = 0;
+}
+
+//----------------------------------------------------------------------------------
+// Block Array.
+//----------------------------------------------------------------------------------
+template <typename T>
+struct BlockArrayBlock_ {
+    BlockArrayBlock_* next  = nullptr;
+    T*                items = nullptr;
+    int               count = 0;
+};
+
+template <typename T>
+struct BlockArrayIterator_ {
+    BlockArrayBlock_<T>* block = nullptr;  // nullptr - конец.
+    BlockArrayBlock_<T>* last  = nullptr;
+    int                  index = 0;
+
+    T& operator*() const {
+        return block->items[index];
+    }
+    BlockArrayIterator_& operator++() {
+        index++;
+        if (index == block->count) {
+            block = (block == last) ? nullptr : block->next;
+            index = 0;
+        }
+        return *this;
+    }
+    bool operator!=(const BlockArrayIterator_& other) const {
+        return (block != other.block) || (index != other.index);
+    }
+};
+
+template <typename T>
+struct BlockArray {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    Arena* arena         = nullptr;
+    int    blockCapacity = 0;
+    int    count         = 0;
+
+    // Блоки после last остаются от BlockArrayClear и переиспользуются.
+    BlockArrayBlock_<T>* first = nullptr;
+    BlockArrayBlock_<T>* last  = nullptr;  // Куда добавляем. nullptr - пусто.
+
+    BlockArrayIterator_<T> begin() const {
+        if (count == 0)
+            return {};
+        return {first, last, 0};
+    }
+    BlockArrayIterator_<T> end() const {
+        return {};
+    }
+};
+
+// arena должна жить дольше массива.
+template <typename T>
+BlockArray<T> MakeBlockArray(Arena& arena, int blockCapacity) {
+    Assert(blockCapacity > 0);
+
+    BlockArray<T> result = {};
+    result.arena         = &arena;
+    result.blockCapacity = blockCapacity;
+    return result;
+}
+
+template <typename T>
+T& BlockArrayAdd(BlockArray<T>& array, const T& value) {
+    auto block = array.last;
+    if ((block == nullptr) || (block->count == array.blockCapacity)) {
+        auto& next = (block == nullptr) ? array.first : block->next;
+        if (next == nullptr) {
+            next        = AllocateAlignedArray(*array.arena, BlockArrayBlock_<T>, 1);
+            *next       = {};
+            next->items = AllocateAlignedArray(*array.arena, T, array.blockCapacity);
+        }
+        next->count = 0;
+        array.last  = next;
+        block       = next;
+    }
+
+    array.count++;
+    block->items[block->count] = value;
+    return block->items[block->count++];
+}
+
+// Блоки остаются за массивом.
+template <typename T>
+void BlockArrayClear(BlockArray<T>& array) {
+    array.count = 0;
+    array.last  = nullptr;
+}
+
+// out - на array.count элементов.
+template <typename T>
+void BlockArrayCopyTo(const BlockArray<T>& array, T* out) {
+    for (const auto& value : array)
+        *(out++) = value;
+}
+
+//----------------------------------------------------------------------------------
+// Ring Buffer.
+//----------------------------------------------------------------------------------
+template <typename T>
+struct RingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    T*  items    = nullptr;
+    int capacity = 0;
+    int first    = 0;  // Самый старый.
+    int count    = 0;
+};
+
+template <typename T>
+RingBuffer<T> MakeRingBuffer(Arena& arena, int capacity) {
+    Assert(capacity > 0);
+
+    RingBuffer<T> result = {};
+    result.items         = AllocateAlignedArray(arena, T, capacity);
+    result.capacity      = capacity;
+    return result;
+}
+
+// Если места нет - затирает самый старый.
+template <typename T>
+void RingBufferPush(RingBuffer<T>& ring, const T& value) {
+    ring.items[(ring.first + ring.count) % ring.capacity] = value;
+    if (ring.count < ring.capacity)
+        ring.count++;
+    else
+        ring.first = (ring.first + 1) % ring.capacity;
+}
+
+// Самый старый.
+template <typename T>
+T RingBufferPop(RingBuffer<T>& ring) {
+    Assert(ring.count > 0);
+
+    const T result = ring.items[ring.first];
+    ring.first     = (ring.first + 1) % ring.capacity;
+    ring.count--;
+    return result;
+}
+
+// i-й от самого старого.
+template <typename T>
+T& RingBufferGet(RingBuffer<T>& ring, int i) {
+    Assert(i >= 0);
+    Assert(i < ring.count);
+    return ring.items[(ring.first + i) % ring.capacity];
+}
+
+template <typename T>
+void RingBufferClear(RingBuffer<T>& ring) {
+    ring.first = 0;
+    ring.count = 0;
+}
+
+//----------------------------------------------------------------------------------
+// Hash Map.
+//----------------------------------------------------------------------------------
+// Ключи хэшируются и сравниваются побайтово - в них не должно быть паддинга.
+// Заполненность держится не выше 3/4. При росте старая таблица остаётся в арене.
+enum class HashMapSlot_ : u8 {
+    EMPTY = 0,
+    FILLED,
+    REMOVED,
+};
+
+template <typename K, typename V>
+struct HashMap {
+    static_assert(std::is_trivially_copyable_v<K>);
+    static_assert(std::is_trivially_copyable_v<V>);
+
+    Arena*        arena    = nullptr;
+    K*            keys     = nullptr;
+    V*            values   = nullptr;
+    HashMapSlot_* slots    = nullptr;
+    int           capacity = 0;  // Степень двойки.
+    int           count    = 0;
+    int           removed  = 0;  // Слоты REMOVED. Занимают место до роста.
+};
+
+template <typename K, typename V>
+void AllocateHashMapTable_(HashMap<K, V>& map, int capacity) {
+    map.keys     = AllocateAlignedArray(*map.arena, K, capacity);
+    map.values   = AllocateAlignedArray(*map.arena, V, capacity);
+    map.slots    = AllocateZerosArray(*map.arena, HashMapSlot_, capacity);
+    map.capacity = capacity;
+    map.count    = 0;
+    map.removed  = 0;
+}
+
+// Влезет expectedCount ключей без роста. arena должна жить дольше таблицы.
+template <typename K, typename V>
+HashMap<K, V> MakeHashMap(Arena& arena, int expectedCount) {
+    int capacity = 8;
+    while (capacity * 3 < expectedCount * 4)
+        capacity *= 2;
+
+    HashMap<K, V> result = {};
+    result.arena         = &arena;
+    AllocateHashMapTable_(result, capacity);
+    return result;
+}
+
+// Слот с key или первый свободный слот, куда его можно вставить.
+template <typename K, typename V>
+int HashMapProbe_(const HashMap<K, V>& map, const K& key) {
+    const int mask = map.capacity - 1;
+
+    int slot      = (int)(Hash64(&key, sizeof(K)) & mask);
+    int available = -1;
+    while (true) {
+        const auto state = map.slots[slot];
+        if (state == HashMapSlot_::EMPTY)
+            return (available != -1) ? available : slot;
+
+        if (state == HashMapSlot_::REMOVED) {
+            if (available == -1)
+                available = slot;
+        }
+        else if (memcmp(map.keys + slot, &key, sizeof(K)) == 0)
+            return slot;
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+template <typename K, typename V>
+V* HashMapFind(HashMap<K, V>& map, const K& key) {
+    const int slot = HashMapProbe_(map, key);
+    if (map.slots[slot] != HashMapSlot_::FILLED)
+        return nullptr;
+    return map.values + slot;
+}
+
+template <typename K, typename V>
+V& HashMapSet(HashMap<K, V>& map, const K& key, const V& value) {
+    if ((map.count + map.removed + 1) * 4 > map.capacity * 3) {
+        // Если таблицу забили REMOVED - хватит перестроить в том же размере.
+        const auto old         = map;
+        const int  newCapacity = ((map.count + 1) * 2 > map.capacity)
+                                     ? map.capacity * 2
+                                     : map.capacity;
+        AllocateHashMapTable_(map, newCapacity);
+
+        FOR_RANGE (int, i, old.capacity) {
+            if (old.slots[i] == HashMapSlot_::FILLED)
+                HashMapSet(map, old.keys[i], old.values[i]);
+        }
+    }
+
+    const int slot = HashMapProbe_(map, key);
+    if (map.slots[slot] != HashMapSlot_::FILLED) {
+        if (map.slots[slot] == HashMapSlot_::REMOVED)
+            map.removed--;
+
+        map.slots[slot] = HashMapSlot_::FILLED;
+        map.keys[slot]  = key;
+        map.count++;
+    }
+    map.values[slot] = value;
+    return map.values[slot];
+}
+
+template <typename K, typename V>
+bool HashMapRemove(HashMap<K, V>& map, const K& key) {
+    const int slot = HashMapProbe_(map, key);
+    if (map.slots[slot] != HashMapSlot_::FILLED)
+        return false;
+
+    map.slots[slot] = HashMapSlot_::REMOVED;
+    map.count--;
+    map.removed++;
+    return true;
+}
+
+TEST_CASE ("ArenaContainers") {
+    u8    memory[64 * 1024] = {};
+    Arena arena             = {};
+    arena.size              = sizeof(memory);
+    arena.base              = memory;
+
+    SUBCASE ("FixedArray") {
+        auto array = MakeFixedArray<int>(arena, 3);
+        Assert(array.capacity == 3);
+
+        FixedArrayAdd(array, 1);
+        FixedArrayAdd(array, 2);
+        FixedArrayAdd(array, 3);
+        Assert(array.count == 3);
+
+        int sum = 0;
+        for (int value : array)
+            sum += value;
+        Assert(sum == 6);
+        Assert(array[1] == 2);
+
+        FixedArrayClear(array);
+        Assert(array.count == 0);
+
+        // Пустой массив не трогает арену.
+        const auto used  = arena.used;
+        auto       empty = MakeFixedArray<int>(arena, 0);
+        Assert(arena.used == used);
+        Assert(empty.begin() == empty.end());
+    }
+
+    SUBCASE ("BlockArray") {
+        auto array = MakeBlockArray<i64>(arena, 4);
+        Assert_False(array.begin() != array.end());
+
+        // Выравнивание: арена уже сдвинута на байт.
+        AllocateArray(arena, u8, 1);
+
+        i64* firstItem = &BlockArrayAdd(array, (i64)0);
+        Assert((uintptr_t)firstItem % alignof(i64) == 0);
+        for (i64 i = 1; i < 10; i++)
+            BlockArrayAdd(array, i);
+        Assert(array.count == 10);
+        Assert(*firstItem == 0);  // Рост не двигает элементы.
+
+        i64 expected = 0;
+        for (i64 value : array)
+            Assert(value == expected++);
+        Assert(expected == 10);
+
+        i64 flat[10] = {};
+        BlockArrayCopyTo(array, flat);
+        Assert(flat[9] == 9);
+
+        // После очистки блоки переиспользуются.
+        const auto used = arena.used;
+        BlockArrayClear(array);
+        FOR_RANGE (int, i, 6) {
+            BlockArrayAdd(array, (i64)(100 + i));
+        }
+        Assert(arena.used == used);
+
+        expected = 100;
+        for (i64 value : array)
+            Assert(value == expected++);
+        Assert(expected == 106);
+    }
+
+    SUBCASE ("RingBuffer") {
+        auto ring = MakeRingBuffer<int>(arena, 3);
+
+        RingBufferPush(ring, 1);
+        RingBufferPush(ring, 2);
+        Assert(RingBufferPop(ring) == 1);
+
+        RingBufferPush(ring, 3);
+        RingBufferPush(ring, 4);
+        RingBufferPush(ring, 5);  // Затирает 2.
+        Assert(ring.count == 3);
+        Assert(RingBufferGet(ring, 0) == 3);
+        Assert(RingBufferGet(ring, 2) == 5);
+
+        RingBufferClear(ring);
+        Assert(ring.count == 0);
+    }
+
+    SUBCASE ("HashMap") {
+        auto map = MakeHashMap<Vector3Int, int>(arena, 4);
+
+        FOR_RANGE (int, i, 100) {
+            HashMapSet(map, Vector3Int(i, -i, i * 7), i);
+        }
+        Assert(map.count == 100);
+        Assert(map.capacity * 3 >= map.count * 4);
+
+        bool allFound = true;
+        FOR_RANGE (int, i, 100) {
+            auto value = HashMapFind(map, Vector3Int(i, -i, i * 7));
+            allFound &= (value != nullptr) && (*value == i);
+        }
+        Assert(allFound);
+        Assert(HashMapFind(map, Vector3Int(1, 1, 1)) == nullptr);
+
+        HashMapSet(map, Vector3Int(5, -5, 35), 500);
+        Assert(map.count == 100);
+        Assert(*HashMapFind(map, Vector3Int(5, -5, 35)) == 500);
+
+        // Удаление, и вставки поверх удалённых не растят таблицу без нужды.
+        FOR_RANGE (int, i, 50) {
+            Assert(HashMapRemove(map, Vector3Int(i, -i, i * 7)));
+        }
+        Assert_False(HashMapRemove(map, Vector3Int(0, 0, 0)));
+        Assert(map.count == 50);
+        Assert(HashMapFind(map, Vector3Int(60, -60, 420)) != nullptr);
+
+        const int capacity = map.capacity;
+        FOR_RANGE (int, round, 10) {
+            FOR_RANGE (int, i, 50) {
+                HashMapSet(map, Vector3Int(i, round, 0), i);
+            }
+            FOR_RANGE (int, i, 50) {
+                HashMapRemove(map, Vector3Int(i, round, 0));
+            }
+        }
+        Assert(map.count == 50);
+        Assert(map.capacity == capacity);
+    }
+}
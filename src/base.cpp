@@ -25,7 +25,11 @@
 #define Assert_False(expr) assert(!((bool)(expr)))
 #endif  // TESTS
 
-using u8 = char;
+using u8  = char;
+using i16 = int16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using i64 = int64_t;
 
 constexpr float  floatInf  = std::numeric_limits<float>::infinity();
 constexpr double doubleInf = std::numeric_limits<double>::infinity();
@@ -72,3 +76,18 @@ Defer_<F> operator+(defer_dummy_, F&& f) {
 //
 // NOLINTNEXTLINE(bugprone-macro-parentheses)
 #define defer auto defer_(__COUNTER__) = defer_dummy_() + [&]()
+
+//----------------------------------------------------------------------------------
+// Hashing.
+//----------------------------------------------------------------------------------
+// FNV-1a, 64 бита. Для ключей кэшей, не для хэш-таблиц с чужими данными.
+const u64 HASH64_SEED = 0xCBF29CE484222325ull;
+
+u64 Hash64(const void* data, size_t size, u64 hash = HASH64_SEED) {
+    auto bytes = (const unsigned char*)data;
+    FOR_RANGE (size_t, i, size) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,483 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "main.cpp"
+
+//----------------------------------------------------------------------------------
+// Benchmarks.
+//----------------------------------------------------------------------------------
+// Сравнение Batch Math с обычными циклами по Vector3 / Vector4 (через операторы).
+// Имеет смысл запускать только Release сборку.
+const int BENCHMARK_COUNT       = 1 << 16;
+const int BENCHMARK_REPETITIONS = 200;
+
+// Не даёт компилятору выкинуть результат.
+globalVar volatile float benchmarkSink = 0;
+
+template <typename F>
+double BenchmarkMilliseconds_(F&& function) {
+    // Прогрев.
+    function();
+
+    const auto start = std::chrono::steady_clock::now();
+    FOR_RANGE (int, i, BENCHMARK_REPETITIONS) {
+        function();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count()
+           / BENCHMARK_REPETITIONS;
+}
+
+void ReportBenchmark_(const char* name, double scalarMs, double batchMs) {
+    printf(
+        "%-24s operators: %8.4f ms   batch: %8.4f ms   x%.2f\n",
+        name,
+        scalarMs,
+        batchMs,
+        scalarMs / batchMs
+    );
+}
+
+// Уровень side^3: пол и колонны разной высоты.
+std::vector<CubeVoxel> MakeBenchmarkLevel_(int side) {
+    std::vector<CubeVoxel> cubes;
+    auto                   random = MakeRandom(1);
+
+    FOR_RANGE (int, x, side) {
+        FOR_RANGE (int, z, side) {
+            cubes.push_back({{x, 0, z}, 0});
+        }
+    }
+    FOR_RANGE (int, i, 2000) {
+        const int x      = (int)(RandomU32(random) % side);
+        const int z      = (int)(RandomU32(random) % side);
+        const int height = 1 + (int)(RandomU32(random) % (side - 1));
+        for (int y = 1; y < height; y++)
+            cubes.push_back({{x, y, z}, 0});
+    }
+    cubes.push_back({{0, side - 1, 0}, 0});
+
+    return cubes;
+}
+
+// Запекание SDF уровня 256^3. Цель - меньше секунды.
+// Лучшее из нескольких запеканий: одно идёт долго и сильно зависит от соседей по машине.
+void BenchmarkSdfBake_() {
+    const auto cubes = MakeBenchmarkLevel_(256);
+    auto       grid  = MakeVoxelGrid(cubes.data(), (int)cubes.size());
+
+    FOR_RANGE (int, i, 2) {
+        const int threads = (i == 0) ? 1 : ParallelForThreadsCount(0);
+
+        double bestMs = floatInf;
+        FOR_RANGE (int, attempt, 3) {
+            const auto start = std::chrono::steady_clock::now();
+            auto       sdf   = BakeSignedDistanceField(grid, threads);
+            const auto end   = std::chrono::steady_clock::now();
+            FreeSignedDistanceField(sdf);
+
+            const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            bestMs          = Min(bestMs, ms);
+        }
+
+        printf(
+            "BakeSignedDistanceField %dx%dx%d, %d thread(s): %.1f ms\n",
+            grid.size.x,
+            grid.size.y,
+            grid.size.z,
+            threads,
+            bestMs
+        );
+    }
+
+    FreeVoxelGrid(grid);
+}
+
+// Память и лучи: VoxelGrid против BrickMap на уровне 512^3 (134M клеток).
+void BenchmarkBrickMap_() {
+    const auto cubes  = MakeBenchmarkLevel_(512);
+    auto       grid   = MakeVoxelGrid(cubes.data(), (int)cubes.size());
+    auto       bricks = MakeBrickMap(cubes.data(), (int)cubes.size());
+
+    printf(
+        "Voxels %dx%dx%d: CubeVoxel[] %.1f MB, VoxelGrid %.1f MB, BrickMap %.1f MB\n",
+        grid.size.x,
+        grid.size.y,
+        grid.size.z,
+        (double)(cubes.size() * sizeof(CubeVoxel)) / (1 << 20),
+        (double)grid.size.x * grid.size.y * grid.size.z / (1 << 20),
+        (double)BrickMapMemorySize(bricks) / (1 << 20)
+    );
+
+    // Лучи сверху вниз под углом - большая часть пути по пустому воздуху.
+    const int            raysCount = 1 << 14;
+    std::vector<Vector3> origins(raysCount);
+    std::vector<Vector3> directions(raysCount);
+    auto                 random = MakeRandom(2);
+    FOR_RANGE (int, i, raysCount) {
+        origins[i] = {
+            RandomFloat(random, 0, 512),
+            RandomFloat(random, 256, 511),
+            RandomFloat(random, 0, 512),
+        };
+        directions[i] = Vector3Normalize({
+            RandomFloat(random, -1, 1),
+            -1,
+            RandomFloat(random, -1, 1),
+        });
+    }
+
+    float      sink   = 0;
+    const auto gridMs = BenchmarkMilliseconds_([&]() {
+        FOR_RANGE (int, i, raysCount) {
+            sink += VoxelGridRaycast(grid, origins[i], directions[i], 1000).distance;
+        }
+    });
+    const auto bricksMs = BenchmarkMilliseconds_([&]() {
+        FOR_RANGE (int, i, raysCount) {
+            sink += BrickMapRaycast(bricks, origins[i], directions[i], 1000).distance;
+        }
+    });
+    printf(
+        "Raycasts x%d: VoxelGrid %8.4f ms   BrickMap %8.4f ms   x%.2f\n",
+        raysCount,
+        gridMs,
+        bricksMs,
+        gridMs / bricksMs
+    );
+    benchmarkSink = sink;
+
+    FreeBrickMap(bricks);
+    FreeVoxelGrid(grid);
+}
+
+// Верёвки на 120 Гц: MAX_ROPES верёвок качаются среди колонн уровня 256^3,
+// оборачиваются вокруг них и выталкиваются из вокселей. Цель - "сильно меньше
+// миллисекунды" на тик.
+void BenchmarkRopes_() {
+    const auto cubes  = MakeBenchmarkLevel_(256);
+    auto       bricks = MakeBrickMap(cubes.data(), (int)cubes.size());
+
+    static Ropes ropes = {};
+    auto         random = MakeRandom(3);
+
+    Vector3 anchors[MAX_ROPES] = {};
+    Vector3 ends[MAX_ROPES]    = {};
+    FOR_RANGE (int, rope, MAX_ROPES) {
+        // Крепление - в воздухе, конец раскручивается по кругу под ним.
+        Vector3 anchor = {};
+        do {
+            anchor = {
+                RandomFloat(random, 32, 224), 80, RandomFloat(random, 32, 224)
+            };
+        } while (BrickMapIsSolid(bricks, (int)anchor.x, (int)anchor.y, (int)anchor.z));
+
+        anchors[rope] = anchor;
+        ends[rope]    = anchor + Vector3{20, -30, 0};
+        RopeAttach(ropes, rope, anchor, ends[rope], 40);
+    }
+
+    const int ticks     = 1200;  // 10 секунд.
+    double    totalMs   = 0;
+    double    worstMs   = 0;
+    int       pivotsMax = 0;
+    FOR_RANGE (int, tick, ticks) {
+        const float angle = (float)tick * ropeSimulationStep * 2.0f;
+
+        const auto start = std::chrono::steady_clock::now();
+        FOR_RANGE (int, rope, MAX_ROPES) {
+            const auto offset = Vector3{20 * cosf(angle), -30, 20 * sinf(angle)};
+            const auto end    = anchors[rope] + offset;
+            RopeSetEnd(ropes, rope, end);
+            RopeUpdateWraps(ropes, rope, bricks, end, ends[rope]);
+            ends[rope] = end;
+        }
+        SimulateRopes(ropes, bricks, ropeSimulationStep);
+        const auto finish = std::chrono::steady_clock::now();
+
+        const double ms
+            = std::chrono::duration<double, std::milli>(finish - start).count();
+        totalMs += ms;
+        worstMs = Max(worstMs, ms);
+        FOR_RANGE (int, rope, MAX_ROPES) {
+            pivotsMax = Max(pivotsMax, ropes.pivotsCount[rope]);
+        }
+    }
+    printf(
+        "Ropes x%d at 120 Hz: %8.4f ms per tick, worst %8.4f ms, up to %d pivots\n",
+        MAX_ROPES,
+        totalMs / ticks,
+        worstMs,
+        pivotsMax
+    );
+    benchmarkSink = ropes.x[0];
+
+    FreeBrickMap(bricks);
+}
+
+// Отрисовка мира на GPU: WorldRenderPath::RASTERIZED против RAYMARCHED.
+// Нужен GPU, поэтому запускается только с --gpu:
+// окно создаётся скрытым, рисуется обычный кадр геймплея.
+void BenchmarkWorldRendering_() {
+    const int width  = 1280;
+    const int height = 720;
+    const int frames = 300;
+
+    MountResourceArchive("resources.pak");
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(width, height, "benchmarks");
+    RequireGL43();
+    SetTargetFPS(0);
+
+    Arena arena = {};
+    arena.size  = 4096;
+    arena.base  = (u8*)(RL_MALLOC(arena.size));
+    InitGameplayScreen(arena);
+
+    printf(
+        "World rendering %dx%d, %d cubes, %d frames:\n",
+        width,
+        height,
+        BrickMapCubesCount(gdata.bricks),
+        frames
+    );
+
+    FOR_RANGE (int, path, (int)WorldRenderPath::COUNT) {
+        gdata.worldRenderPath = (WorldRenderPath)path;
+
+        double totalMs  = 0;
+        int    measured = 0;
+        FOR_RANGE (int, frame, frames) {
+            BeginDrawing();
+            DrawGameplayScreen();
+            EndDrawing();
+
+            // Первые замеры ещё не готовы. См. GPU_TIMER_LATENCY.
+            if (frame > GPU_TIMER_LATENCY) {
+                totalMs += gdata.worldTimers[path].milliseconds;
+                measured++;
+            }
+        }
+
+        printf(
+            "  %-12s GPU %8.4f ms\n",
+            worldRenderPathNames[path],
+            totalMs / Max(1, measured)
+        );
+    }
+
+    UnloadGameplayScreen();
+    RL_FREE(arena.base);
+    CloseWindow();
+    UnmountResourceArchive();
+}
+
+// Ввод, когда записи нет: по кругу бег, прыжки, зацеп, dash и ускорение,
+// в начале - пачка ботов. Как запись с 60 FPS длиной 10 секунд.
+std::vector<GameplayInput> MakeScriptedReplay_() {
+    const int   ticks = 600;
+    const float dt    = 1.0f / 60.0f;
+
+    std::vector<GameplayInput> inputs(ticks);
+    FOR_RANGE (int, tick, ticks) {
+        auto& input = inputs[tick];
+        input.dt    = dt;
+        input.time  = tick * dt;
+
+        input.mouseDelta = {3, (tick % 120 < 60) ? -1.0f : 1.0f};
+        input.movement   = {0, 1};
+
+        input.jumpPressed    = (tick % 90) == 0;
+        input.grapplePressed = (tick % 180) == 30;
+        input.dashPressed    = (tick % 240) == 120;
+        input.boostDown      = (tick % 180) >= 90;
+
+        input.dashConfig = dashConfig;
+        if (tick == 1)
+            input.grapplersToSpawn = 512;
+    }
+    return inputs;
+}
+
+// Перцентили кадра геймплея на одинаковом вводе - для сравнения сборок.
+// replayPath - запись `game --record`, nullptr - MakeScriptedReplay_.
+void BenchmarkReplay_(const char* replayPath, double seconds, const char* csvPath) {
+    const int width  = 1280;
+    const int height = 720;
+
+    std::vector<GameplayInput> inputs;
+    if (replayPath != nullptr) {
+        int  size = 0;
+        auto data = (u8*)LoadFileData(replayPath, &size);
+
+        const bool ok = DeserializeGameplayReplay(data, size, inputs) && !inputs.empty();
+        UnloadFileData((unsigned char*)data);
+        if (!ok) {
+            printf("Failed to load replay %s\n", replayPath);
+            return;
+        }
+    }
+    else
+        inputs = MakeScriptedReplay_();
+
+    MountResourceArchive("resources.pak");
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(width, height, "benchmarks");
+    RequireGL43();
+    SetTargetFPS(0);
+
+    Arena arena = {};
+    arena.size  = 4096;
+    arena.base  = (u8*)(RL_MALLOC(arena.size));
+    InitGameplayScreen(arena);
+    PlayGameplayReplay(std::move(inputs));
+
+    // Загрузка уровня в замер не входит.
+    ResetTelemetry(telemetry);
+
+    const double start = GetTime();
+    while (GetTime() - start < seconds) {
+        UpdateGameplayScreen();
+        BeginDrawing();
+        DrawGameplayScreen();
+        EndDrawing();
+    }
+
+    printf(
+        "Replay %s, %dx%d, %.0f s, %lld frames:\n",
+        (replayPath != nullptr) ? replayPath : "scripted",
+        width,
+        height,
+        seconds,
+        (long long)telemetry.total
+    );
+    printf("%s", TelemetryReport(telemetry).c_str());
+    if (allocationTracker.forbidFrameAllocations) {
+        printf(
+            "Frames with heap allocations after warm-up: %lld\n",
+            (long long)allocationTracker.framesWithAllocations
+        );
+    }
+    if (csvPath != nullptr)
+        SaveTelemetryCsv(telemetry, csvPath);
+
+    // Пики памяти подсистем печатает UnloadGameplayScreen.
+    UnloadGameplayScreen();
+    RL_FREE(arena.base);
+    CloseWindow();
+    UnmountResourceArchive();
+}
+
+// benchmarks [--gpu]
+//            [--replay [<replay>] [--seconds N] [--csv <path>] [--no-frame-allocations]]
+int main(int argc, char** argv) {
+    if ((argc > 1) && (strcmp(argv[1], "--gpu") == 0)) {
+        BenchmarkWorldRendering_();
+        return 0;
+    }
+
+    if ((argc > 1) && (strcmp(argv[1], "--replay") == 0)) {
+        const char* replayPath = nullptr;
+        const char* csvPath    = nullptr;
+        double      seconds    = 30;
+        for (int i = 2; i < argc; i++) {
+            if ((strcmp(argv[i], "--seconds") == 0) && (i + 1 < argc))
+                seconds = atof(argv[++i]);
+            else if ((strcmp(argv[i], "--csv") == 0) && (i + 1 < argc))
+                csvPath = argv[++i];
+            else if (strcmp(argv[i], "--no-frame-allocations") == 0)
+                allocationTracker.forbidFrameAllocations = true;
+            else
+                replayPath = argv[i];
+        }
+
+        BenchmarkReplay_(replayPath, seconds, csvPath);
+        return 0;
+    }
+
+    const int n = BENCHMARK_COUNT;
+
+    std::vector<Vector4> positions4(n);
+    std::vector<Vector4> velocities4(n);
+    std::vector<Vector3> vectors(n);
+    std::vector<float>   x(n);
+    std::vector<float>   y(n);
+    std::vector<float>   z(n);
+    std::vector<float>   angles(n);
+    std::vector<float>   out(n);
+
+    auto random = MakeRandomBatch(1);
+    RandomFillFloats(random, (float*)velocities4.data(), n * 4, -1, 1);
+    RandomFillFloats(random, x.data(), n, -10, 10);
+    RandomFillFloats(random, y.data(), n, -10, 10);
+    RandomFillFloats(random, z.data(), n, -10, 10);
+    RandomFillFloats(random, angles.data(), n, 0, 2 * PI);
+    FOR_RANGE (int, i, n) {
+        vectors[i] = {x[i], y[i], z[i]};
+    }
+
+    const float   dt    = 1.0f / 60.0f;
+    const Vector3 axis  = Vector3Normalize({1, 2, 3});
+    const Vector3 point = {1, 2, 3};
+
+    printf("Batch Math: %d elements, BATCH_WIDTH = %d\n", n, BATCH_WIDTH);
+
+    {  // Интегрирование частиц.
+        const auto scalar = BenchmarkMilliseconds_([&]() {
+            FOR_RANGE (int, i, n) {
+                positions4[i] += velocities4[i] * dt;
+            }
+        });
+        const auto batch = BenchmarkMilliseconds_([&]() {
+            auto positions  = (float*)positions4.data();
+            auto velocities = (const float*)velocities4.data();
+            BatchAxpy(positions, velocities, dt, n * 4);
+        });
+        ReportBenchmark_("BatchAxpy", scalar, batch);
+    }
+
+    {  // Нормализация.
+        const auto scalar = BenchmarkMilliseconds_([&]() {
+            FOR_RANGE (int, i, n) {
+                vectors[i] = Vector3Normalize(vectors[i]);
+            }
+        });
+        const auto batch = BenchmarkMilliseconds_([&]() {
+            BatchNormalize(x.data(), y.data(), z.data(), n);
+        });
+        ReportBenchmark_("BatchNormalize", scalar, batch);
+    }
+
+    {  // Поворот.
+        const auto scalar = BenchmarkMilliseconds_([&]() {
+            FOR_RANGE (int, i, n) {
+                vectors[i] = Vector3RotateByAxisAngle(vectors[i], axis, angles[i]);
+            }
+        });
+        const auto batch = BenchmarkMilliseconds_([&]() {
+            BatchRotateByAxisAngle(x.data(), y.data(), z.data(), n, axis, angles.data());
+        });
+        ReportBenchmark_("BatchRotateByAxisAngle", scalar, batch);
+    }
+
+    {  // Расстояние до точки.
+        const auto scalar = BenchmarkMilliseconds_([&]() {
+            FOR_RANGE (int, i, n) {
+                out[i] = Vector3Distance(vectors[i], point);
+            }
+        });
+        const auto batch = BenchmarkMilliseconds_([&]() {
+            BatchDistanceToPoint(x.data(), y.data(), z.data(), n, point, out.data());
+        });
+        ReportBenchmark_("BatchDistanceToPoint", scalar, batch);
+    }
+
+    benchmarkSink = out[0] + x[0] + vectors[0].x + positions4[0].x;
+
+    BenchmarkSdfBake_();
+    BenchmarkBrickMap_();
+    BenchmarkRopes_();
+    return 0;
+}
@@ -0,0 +1,1031 @@
+//----------------------------------------------------------------------------------
+// Brick Map.
+//----------------------------------------------------------------------------------
+// Разреженное хранилище вокселей для больших уровней.
+//
+// Мир делится на кирпичи BRICK_SIZE^3 клеток. Верхний уровень - плотная
+// сетка u32 на кирпич:
+//
+// 0                            - кирпич пустой, клетки не хранятся.
+// BRICK_UNIFORM | value        - все клетки кирпича равны value, клетки не хранятся.
+// index + 1                    - клетки лежат в cells[index * BRICK_CELLS, ...).
+//
+// Значения клеток - как в VoxelGrid: 0 - пусто, иначе - индекс палитры + 1.
+// 100M клеток (464^3) - это ~800 KB верхнего уровня + 512 байт
+// на каждый кирпич, через который проходит поверхность.
+//
+// Кирпичи выровнены по мировым координатам (origin кратен BRICK_SIZE),
+// поэтому кирпич с одними и теми же координатами есть во всех уровнях.
+const int BRICK_SIZE_SHIFT = 3;
+const int BRICK_SIZE       = 1 << BRICK_SIZE_SHIFT;
+const int BRICK_CELLS      = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+const u32 BRICK_UNIFORM    = 1u << 31;
+
+struct BrickMap {
+    Vector3Int origin = {};  // Мировые координаты первой клетки кирпича (0, 0, 0).
+    Vector3Int size   = {};  // В кирпичах.
+
+    u32* bricks      = nullptr;  // size.x * size.y * size.z.
+    u8*  cells       = nullptr;  // cellsBricks * BRICK_CELLS.
+    int  cellsBricks = 0;        // Сколько кирпичей хранят клетки.
+};
+
+int BrickMapBricksCount(const BrickMap& map) {
+    return map.size.x * map.size.y * map.size.z;
+}
+
+// Размер карты в клетках. Клетки карты - [origin, origin + size в клетках).
+Vector3Int BrickMapCellsSize(const BrickMap& map) {
+    return {map.size.x * BRICK_SIZE, map.size.y * BRICK_SIZE, map.size.z * BRICK_SIZE};
+}
+
+// Сколько памяти занимает map.
+int BrickMapMemorySize(const BrickMap& map) {
+    return BrickMapBricksCount(map) * (int)sizeof(u32) + map.cellsBricks * BRICK_CELLS;
+}
+
+int BrickCellIndex_(int x, int y, int z) {
+    const int mask = BRICK_SIZE - 1;
+    return (((z & mask) << BRICK_SIZE_SHIFT) + (y & mask)) * BRICK_SIZE + (x & mask);
+}
+
+BrickMap MakeBrickMap(const CubeVoxel* cubes, int cubesCount) {
+    BrickMap map = {};
+    if (cubesCount == 0)
+        return map;
+
+    Vector3Int minPos = cubes[0].pos;
+    Vector3Int maxPos = cubes[0].pos;
+    FOR_RANGE (int, i, cubesCount) {
+        const auto& p = cubes[i].pos;
+        minPos        = {Min(minPos.x, p.x), Min(minPos.y, p.y), Min(minPos.z, p.z)};
+        maxPos        = {Max(maxPos.x, p.x), Max(maxPos.y, p.y), Max(maxPos.z, p.z)};
+    }
+
+    map.origin = {
+        Floor(minPos.x, BRICK_SIZE),
+        Floor(minPos.y, BRICK_SIZE),
+        Floor(minPos.z, BRICK_SIZE),
+    };
+    map.size = {
+        (maxPos.x - map.origin.x) / BRICK_SIZE + 1,
+        (maxPos.y - map.origin.y) / BRICK_SIZE + 1,
+        (maxPos.z - map.origin.z) / BRICK_SIZE + 1,
+    };
+    map.bricks = (u32*)RL_CALLOC(BrickMapBricksCount(map), sizeof(u32));
+
+    // Сначала заводим клетки для каждого непустого кирпича...
+    FOR_RANGE (int, i, cubesCount) {
+        const auto& p = cubes[i].pos;
+
+        const int bx = (p.x - map.origin.x) >> BRICK_SIZE_SHIFT;
+        const int by = (p.y - map.origin.y) >> BRICK_SIZE_SHIFT;
+        const int bz = (p.z - map.origin.z) >> BRICK_SIZE_SHIFT;
+
+        map.bricks[(bz * map.size.y + by) * map.size.x + bx] = 1;
+    }
+    // Нумеруем по порядку кирпичей, чтобы сдвиг ниже не затирал ещё не сдвинутые.
+    FOR_RANGE (int, i, BrickMapBricksCount(map)) {
+        if (map.bricks[i] != 0)
+            map.bricks[i] = (u32)(++map.cellsBricks);
+    }
+
+    map.cells = (u8*)RL_CALLOC(map.cellsBricks * BRICK_CELLS, sizeof(u8));
+
+    FOR_RANGE (int, i, cubesCount) {
+        const auto& cube = cubes[i];
+        // NOTE: u8 знаковый, поэтому в палитре не может быть больше 127 цветов.
+        Assert(cube.colorIndex >= 0);
+        Assert(cube.colorIndex < 127);
+
+        const int x = cube.pos.x - map.origin.x;
+        const int y = cube.pos.y - map.origin.y;
+        const int z = cube.pos.z - map.origin.z;
+
+        const int  bx    = x >> BRICK_SIZE_SHIFT;
+        const int  by    = y >> BRICK_SIZE_SHIFT;
+        const int  bz    = z >> BRICK_SIZE_SHIFT;
+        const auto brick = map.bricks[(bz * map.size.y + by) * map.size.x + bx];
+
+        map.cells[(brick - 1) * BRICK_CELLS + BrickCellIndex_(x, y, z)]
+            = (u8)(cube.colorIndex + 1);
+    }
+
+    // ...потом однородные кирпичи (например, толща пола) схлопываем
+    // в одно значение, а оставшиеся сдвигаем к началу cells.
+    int cellsBricks = 0;
+    FOR_RANGE (int, i, BrickMapBricksCount(map)) {
+        auto& brick = map.bricks[i];
+        if (brick == 0)
+            continue;
+
+        const u8* cells = map.cells + (brick - 1) * BRICK_CELLS;
+
+        bool uniform = true;
+        for (int k = 1; uniform && (k < BRICK_CELLS); k++)
+            uniform = cells[k] == cells[0];
+
+        if (uniform) {
+            brick = BRICK_UNIFORM | (u32)(u8)cells[0];
+            continue;
+        }
+
+        memmove(map.cells + cellsBricks * BRICK_CELLS, cells, BRICK_CELLS);
+        brick = (u32)(++cellsBricks);
+    }
+    map.cellsBricks = cellsBricks;
+
+    return map;
+}
+
+void FreeBrickMap(BrickMap& map) {
+    RL_FREE(map.bricks);
+    RL_FREE(map.cells);
+    map = {};
+}
+
+// Всё, что вне карты, считается пустым.
+u8 BrickMapGet(const BrickMap& map, int x, int y, int z) {
+    x -= map.origin.x;
+    y -= map.origin.y;
+    z -= map.origin.z;
+    if ((x < 0) || (y < 0) || (z < 0))
+        return 0;
+
+    const int bx = x >> BRICK_SIZE_SHIFT;
+    const int by = y >> BRICK_SIZE_SHIFT;
+    const int bz = z >> BRICK_SIZE_SHIFT;
+    if ((bx >= map.size.x) || (by >= map.size.y) || (bz >= map.size.z))
+        return 0;
+
+    const auto brick = map.bricks[(bz * map.size.y + by) * map.size.x + bx];
+    if (brick == 0)
+        return 0;
+    if (brick & BRICK_UNIFORM)
+        return (u8)(brick & 0xFF);
+
+    return map.cells[(brick - 1) * BRICK_CELLS + BrickCellIndex_(x, y, z)];
+}
+
+bool BrickMapIsSolid(const BrickMap& map, int x, int y, int z) {
+    return BrickMapGet(map, x, y, z) != 0;
+}
+
+// fn(Vector3Int cell) для каждой непустой клетки в [from, to] (включительно).
+// Пустые кирпичи пропускаются целиком. Если fn вернёт false - обход прекращается.
+template <typename F>
+void ForEachBrickMapSolidCell(
+    const BrickMap& map,
+    Vector3Int      from,
+    Vector3Int      to,
+    F&&             fn
+) {
+    const auto& o    = map.origin;
+    const auto  size = BrickMapCellsSize(map);
+
+    // Клетки относительно origin, зажатые в карту.
+    const int cellsMax[3] = {size.x - 1, size.y - 1, size.z - 1};
+    int       lo[3]       = {from.x - o.x, from.y - o.y, from.z - o.z};
+    int       hi[3]       = {to.x - o.x, to.y - o.y, to.z - o.z};
+    FOR_RANGE (int, axis, 3) {
+        lo[axis] = Max(lo[axis], 0);
+        hi[axis] = Min(hi[axis], cellsMax[axis]);
+        if (lo[axis] > hi[axis])
+            return;
+    }
+
+    const int b0[3] = {
+        lo[0] >> BRICK_SIZE_SHIFT, lo[1] >> BRICK_SIZE_SHIFT, lo[2] >> BRICK_SIZE_SHIFT
+    };
+    const int b1[3] = {
+        hi[0] >> BRICK_SIZE_SHIFT, hi[1] >> BRICK_SIZE_SHIFT, hi[2] >> BRICK_SIZE_SHIFT
+    };
+
+    for (int bz = b0[2]; bz <= b1[2]; bz++) {
+        for (int by = b0[1]; by <= b1[1]; by++) {
+            for (int bx = b0[0]; bx <= b1[0]; bx++) {
+                const auto brick = map.bricks[(bz * map.size.y + by) * map.size.x + bx];
+                if (brick == 0)
+                    continue;
+
+                const u8* cells = (brick & BRICK_UNIFORM)
+                                      ? nullptr
+                                      : map.cells + (brick - 1) * BRICK_CELLS;
+
+                const int x0 = Max(lo[0], bx * BRICK_SIZE);
+                const int y0 = Max(lo[1], by * BRICK_SIZE);
+                const int z0 = Max(lo[2], bz * BRICK_SIZE);
+                const int x1 = Min(hi[0], bx * BRICK_SIZE + BRICK_SIZE - 1);
+                const int y1 = Min(hi[1], by * BRICK_SIZE + BRICK_SIZE - 1);
+                const int z1 = Min(hi[2], bz * BRICK_SIZE + BRICK_SIZE - 1);
+
+                for (int z = z0; z <= z1; z++) {
+                    for (int y = y0; y <= y1; y++) {
+                        for (int x = x0; x <= x1; x++) {
+                            if ((cells != nullptr) && !cells[BrickCellIndex_(x, y, z)])
+                                continue;
+                            if (!fn(Vector3Int(o.x + x, o.y + y, o.z + z)))
+                                return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// fn(CubeVoxel) для каждой непустой клетки, кирпич за кирпичом.
+template <typename F>
+void ForEachBrickMapCube_(const BrickMap& map, F&& fn) {
+    FOR_RANGE (int, bz, map.size.z) {
+        FOR_RANGE (int, by, map.size.y) {
+            FOR_RANGE (int, bx, map.size.x) {
+                const auto brick = map.bricks[(bz * map.size.y + by) * map.size.x + bx];
+                if (brick == 0)
+                    continue;
+
+                const int x0 = map.origin.x + bx * BRICK_SIZE;
+                const int y0 = map.origin.y + by * BRICK_SIZE;
+                const int z0 = map.origin.z + bz * BRICK_SIZE;
+
+                FOR_RANGE (int, k, BRICK_CELLS) {
+                    const int x = k % BRICK_SIZE;
+                    const int y = (k / BRICK_SIZE) % BRICK_SIZE;
+                    const int z = k / (BRICK_SIZE * BRICK_SIZE);
+
+                    const u8 value = (brick & BRICK_UNIFORM)
+                                         ? (u8)(brick & 0xFF)
+                                         : map.cells[(brick - 1) * BRICK_CELLS + k];
+                    if (value != 0)
+                        fn(CubeVoxel{{x0 + x, y0 + y, z0 + z}, value - 1});
+                }
+            }
+        }
+    }
+}
+
+// Обратно в кубы - для кода, которому нужен список (отрисовка, VoxelGrid).
+// Кубы идут кирпич за кирпичом.
+void GetBrickMapCubes(const BrickMap& map, std::vector<CubeVoxel>& out) {
+    ForEachBrickMapCube_(map, [&](const CubeVoxel& cube) { out.push_back(cube); });
+}
+
+// out - на BrickMapCubesCount кубов.
+void GetBrickMapCubes(const BrickMap& map, FixedArray<CubeVoxel>& out) {
+    ForEachBrickMapCube_(map, [&](const CubeVoxel& cube) { FixedArrayAdd(out, cube); });
+}
+
+// Границы занятых клеток. У пустой карты - нулевой box.
+BoundingBox BrickMapBounds(const BrickMap& map) {
+    Vector3Int lo = {INT_MAX, INT_MAX, INT_MAX};
+    Vector3Int hi = {INT_MIN, INT_MIN, INT_MIN};
+
+    auto extend = [&](int x, int y, int z) {
+        lo = {Min(lo.x, x), Min(lo.y, y), Min(lo.z, z)};
+        hi = {Max(hi.x, x), Max(hi.y, y), Max(hi.z, z)};
+    };
+
+    FOR_RANGE (int, bz, map.size.z) {
+        FOR_RANGE (int, by, map.size.y) {
+            FOR_RANGE (int, bx, map.size.x) {
+                const auto brick = map.bricks[(bz * map.size.y + by) * map.size.x + bx];
+                if (brick == 0)
+                    continue;
+
+                const int x0 = bx * BRICK_SIZE;
+                const int y0 = by * BRICK_SIZE;
+                const int z0 = bz * BRICK_SIZE;
+
+                // Однородный кирпич занят целиком.
+                if (brick & BRICK_UNIFORM) {
+                    extend(x0, y0, z0);
+                    extend(x0 + BRICK_SIZE - 1, y0 + BRICK_SIZE - 1, z0 + BRICK_SIZE - 1);
+                    continue;
+                }
+
+                const u8* cells = map.cells + (brick - 1) * BRICK_CELLS;
+                FOR_RANGE (int, k, BRICK_CELLS) {
+                    if (cells[k] != 0) {
+                        const int x = k % BRICK_SIZE;
+                        const int y = (k / BRICK_SIZE) % BRICK_SIZE;
+                        const int z = k / (BRICK_SIZE * BRICK_SIZE);
+                        extend(x0 + x, y0 + y, z0 + z);
+                    }
+                }
+            }
+        }
+    }
+
+    if (lo.x > hi.x)
+        return {};
+
+    const auto& o = map.origin;
+    return {
+        {(float)(o.x + lo.x), (float)(o.y + lo.y), (float)(o.z + lo.z)},
+        {(float)(o.x + hi.x + 1), (float)(o.y + hi.y + 1), (float)(o.z + hi.z + 1)},
+    };
+}
+
+// Однородные кирпичи считаются целиком, клетки не перебираются.
+int BrickMapCubesCount(const BrickMap& map) {
+    int result = 0;
+    FOR_RANGE (int, i, BrickMapBricksCount(map)) {
+        const auto brick = map.bricks[i];
+        if ((brick & BRICK_UNIFORM) && (brick & 0xFF))
+            result += BRICK_CELLS;
+    }
+    FOR_RANGE (int, i, map.cellsBricks * BRICK_CELLS)
+        result += (map.cells[i] != 0);
+    return result;
+}
+
+// Наибольшее значение клетки - для проверки индексов палитры без обхода кубов.
+u8 BrickMapMaxValue(const BrickMap& map) {
+    u8 result = 0;
+    FOR_RANGE (int, i, BrickMapBricksCount(map)) {
+        const auto brick = map.bricks[i];
+        if (brick & BRICK_UNIFORM)
+            result = Max(result, (u8)(brick & 0xFF));
+    }
+    FOR_RANGE (int, i, map.cellsBricks * BRICK_CELLS)
+        result = Max(result, map.cells[i]);
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Swept AABB vs Brick Map.
+//----------------------------------------------------------------------------------
+struct VoxelContacts {
+    // По компоненте на каждую ось: -1, 0 или 1.
+    // normal.y == 1 - стоим на чём-то, normal.x == -1 - упёрлись в стену справа.
+    Vector3 normal = {};
+
+    // Упёрлись в стену, у которой на уровне верхушки box-а пусто.
+    // За такой уступ можно зацепиться и залезть наверх.
+    bool ledge = false;
+};
+
+// Зазор, который оставляем между box-ом и клетками,
+// чтобы на следующем шаге не начинать движение изнутри клетки.
+const float voxelSkin = 0.001f;
+
+bool VoxelSlabIsSolid_(
+    const BrickMap&    map,
+    int                axis,
+    int                slab,
+    const BoundingBox& box,
+    int                crossFromY,
+    int                crossToY
+) {
+    const int b = (axis + 1) % 3;
+    const int c = (axis + 2) % 3;
+
+    const int b0 = (int)floorf((&box.min.x)[b]);
+    const int b1 = (int)ceilf((&box.max.x)[b]) - 1;
+    const int c0 = (int)floorf((&box.min.x)[c]);
+    const int c1 = (int)ceilf((&box.max.x)[c]) - 1;
+
+    for (int j = b0; j <= b1; j++) {
+        for (int k = c0; k <= c1; k++) {
+            int cell[3] = {};
+            cell[axis]  = slab;
+            cell[b]     = j;
+            cell[c]     = k;
+
+            if ((cell[1] < crossFromY) || (cell[1] > crossToY))
+                continue;
+
+            if (BrickMapIsSolid(map, cell[0], cell[1], cell[2]))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// Двигает box вдоль одной оси. Возвращает смещение, на которое удалось сдвинуться.
+// Просматриваются только слои клеток, которые заметает передняя грань box-а.
+float SweepBoxAlongAxis_(
+    const BrickMap&    map,
+    const BoundingBox& box,
+    int                axis,
+    float              d,
+    int*               hitSlab
+) {
+    *hitSlab = INT_MAX;
+    if (d == 0)
+        return 0;
+
+    const int anyY = INT_MIN;
+
+    if (d > 0) {
+        const float e    = (&box.max.x)[axis];
+        const int   from = (int)ceilf(e);
+        const int   to   = (int)ceilf(e + d) - 1;
+
+        for (int i = from; i <= to; i++) {
+            if (VoxelSlabIsSolid_(map, axis, i, box, anyY, INT_MAX)) {
+                *hitSlab = i;
+                return Max(0.0f, (float)i - e - voxelSkin);
+            }
+        }
+    }
+    else {
+        const float e    = (&box.min.x)[axis];
+        const int   from = (int)floorf(e) - 1;
+        const int   to   = (int)floorf(e + d);
+
+        for (int i = from; i >= to; i--) {
+            // Пол. Всё, что ниже y = 0, считаем твёрдым.
+            const bool isFloor = (axis == 1) && (i < 0);
+
+            if (isFloor || VoxelSlabIsSolid_(map, axis, i, box, anyY, INT_MAX)) {
+                *hitSlab = i;
+                return Min(0.0f, (float)(i + 1) - e + voxelSkin);
+            }
+        }
+    }
+
+    return d;
+}
+
+// Перемещает box на delta с учётом твёрдых клеток карты.
+// Разрешение коллизий - поосевое: сначала Y, затем X и Z.
+// Стоимость пропорциональна количеству заметаемых клеток, а не количеству кубов уровня,
+// а туннелирования нет при любой скорости.
+//
+// Возвращает смещение, на которое удалось сдвинуть box.
+Vector3 SweepBoxThroughVoxels(
+    const BrickMap& map,
+    BoundingBox     box,
+    Vector3         delta,
+    VoxelContacts*  contacts
+) {
+    Vector3 moved = {};
+
+    const int axes[] = {1, 0, 2};
+    for (const int axis : axes) {
+        const float d = (&delta.x)[axis];
+
+        int         hitSlab = INT_MAX;
+        const float allowed = SweepBoxAlongAxis_(map, box, axis, d, &hitSlab);
+
+        (&moved.x)[axis] = allowed;
+        (&box.min.x)[axis] += allowed;
+        (&box.max.x)[axis] += allowed;
+
+        if (hitSlab == INT_MAX)
+            continue;
+
+        (&contacts->normal.x)[axis] = (d > 0) ? -1.0f : 1.0f;
+
+        if (axis != 1) {
+            const int topRow = (int)floorf(box.max.y - voxelSkin);
+            if (!VoxelSlabIsSolid_(map, axis, hitSlab, box, topRow, topRow))
+                contacts->ledge = true;
+        }
+    }
+
+    return moved;
+}
+
+TEST_CASE ("SweepBoxThroughVoxels") {
+    // Стена толщиной в 1 клетку на x = 3 высотой в 2 клетки и ступенька на x = -3.
+    CubeVoxel cubes[] = {
+        {{3, 0, 0}, 0},
+        {{3, 1, 0}, 0},
+        {{-3, 0, 0}, 0},
+    };
+    auto map = MakeBrickMap(cubes, 3);
+    defer {
+        FreeBrickMap(map);
+    };
+
+    const BoundingBox box = {{0.2f, 0, 0.2f}, {0.8f, 1.8f, 0.8f}};
+
+    SUBCASE ("Stops at the wall") {
+        VoxelContacts contacts = {};
+        auto moved = SweepBoxThroughVoxels(map, box, {5, 0, 0}, &contacts);
+
+        Assert(moved.x < 2.2f);
+        Assert(moved.x > 2.2f - 2 * voxelSkin);
+        Assert(contacts.normal.x == -1);
+        Assert(contacts.normal.y == 0);
+        Assert_False(contacts.ledge);
+    }
+
+    SUBCASE ("Does not tunnel at high speed") {
+        VoxelContacts contacts = {};
+        auto moved = SweepBoxThroughVoxels(map, box, {1000, 0, 0}, &contacts);
+
+        Assert(moved.x < 2.2f);
+        Assert(contacts.normal.x == -1);
+    }
+
+    SUBCASE ("Ledge") {
+        VoxelContacts contacts = {};
+        auto moved = SweepBoxThroughVoxels(map, box, {-5, 0, 0}, &contacts);
+
+        Assert(moved.x > -2.2f);
+        Assert(contacts.normal.x == 1);
+        Assert(contacts.ledge);
+    }
+
+    SUBCASE ("Lands on the floor") {
+        const BoundingBox airborne = {{0.2f, 2, 0.2f}, {0.8f, 3.8f, 0.8f}};
+
+        VoxelContacts contacts = {};
+        auto moved = SweepBoxThroughVoxels(map, airborne, {1, -10, 0}, &contacts);
+
+        Assert(FloatEquals(moved.x, 1));
+        Assert(moved.y > -2.0f);
+        Assert(moved.y < -2.0f + 2 * voxelSkin);
+        Assert(contacts.normal.y == 1);
+    }
+
+    SUBCASE ("Lands on top of the wall") {
+        const BoundingBox above = {{3.2f, 2.5f, 0.2f}, {3.8f, 4.3f, 0.8f}};
+
+        VoxelContacts contacts = {};
+        auto moved = SweepBoxThroughVoxels(map, above, {0, -1, 0}, &contacts);
+
+        Assert(moved.y < -0.5f + 2 * voxelSkin);
+        Assert(moved.y > -0.5f);
+        Assert(contacts.normal.y == 1);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Raycast vs Brick Map.
+//----------------------------------------------------------------------------------
+// Состояние обхода клеток размера cellSize вдоль луча. См. VoxelGridRaycast.
+struct BrickDda_ {
+    int   cell[3]   = {};
+    int   step[3]   = {};
+    float tMax[3]   = {};
+    float tDelta[3] = {};
+};
+
+// o - начало луча относительно map.origin. Клетки зажимаются в [cellMin, cellMax).
+BrickDda_ BrickDdaStart_(
+    const float* o,
+    const float* d,
+    float        t,
+    int          cellSize,
+    const int*   cellMin,
+    const int*   cellMax
+) {
+    BrickDda_ dda = {};
+
+    FOR_RANGE (int, a, 3) {
+        const float p = o[a] + d[a] * t;
+
+        dda.cell[a] = (int)floorf(p / (float)cellSize);
+        // Из-за погрешности на границе можем оказаться на клетку снаружи.
+        dda.cell[a] = Max(cellMin[a], Min(cellMax[a] - 1, dda.cell[a]));
+
+        if (d[a] > 0) {
+            dda.step[a]   = 1;
+            dda.tMax[a]   = t + ((float)((dda.cell[a] + 1) * cellSize) - p) / d[a];
+            dda.tDelta[a] = (float)cellSize / d[a];
+        }
+        else if (d[a] < 0) {
+            dda.step[a]   = -1;
+            dda.tMax[a]   = t + ((float)(dda.cell[a] * cellSize) - p) / d[a];
+            dda.tDelta[a] = -(float)cellSize / d[a];
+        }
+        else
+            dda.tMax[a] = floatInf;
+    }
+
+    return dda;
+}
+
+// Переходит в следующую клетку. Возвращает ось перехода.
+int BrickDdaStep_(BrickDda_& dda, float& t) {
+    int a = 0;
+    if (dda.tMax[1] < dda.tMax[a])
+        a = 1;
+    if (dda.tMax[2] < dda.tMax[a])
+        a = 2;
+
+    t = dda.tMax[a];
+    dda.cell[a] += dda.step[a];
+    dda.tMax[a] += dda.tDelta[a];
+    return a;
+}
+
+// То же, что VoxelGridRaycast, но в два уровня:
+// пустые кирпичи пролетаются целиком, по клеткам шагаем только внутри непустых.
+VoxelRaycastHit BrickMapRaycast(
+    const BrickMap& map,
+    Vector3         origin,
+    Vector3         direction,
+    float           maxDistance
+) {
+    VoxelRaycastHit result = {};
+
+    const Vector3 local = origin - ToVector3(map.origin);
+    const float*  o     = &local.x;
+    const float*  d     = &direction.x;
+
+    const int bricksMin[3] = {0, 0, 0};
+    const int bricksMax[3] = {map.size.x, map.size.y, map.size.z};
+
+    // Обрезаем луч по AABB карты.
+    float tEnter    = 0;
+    float tExit     = maxDistance;
+    int   enterAxis = -1;
+    FOR_RANGE (int, a, 3) {
+        const float extent = (float)(bricksMax[a] * BRICK_SIZE);
+        if (d[a] == 0) {
+            if ((o[a] < 0) || (o[a] > extent))
+                return result;
+            continue;
+        }
+
+        float t0 = -o[a] / d[a];
+        float t1 = (extent - o[a]) / d[a];
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        if (t0 > tEnter) {
+            tEnter    = t0;
+            enterAxis = a;
+        }
+        tExit = Min(tExit, t1);
+    }
+    if (tEnter > tExit)
+        return result;
+
+    auto  outer     = BrickDdaStart_(o, d, tEnter, BRICK_SIZE, bricksMin, bricksMax);
+    float t         = tEnter;
+    int   outerAxis = enterAxis;
+
+    while (t <= tExit) {
+        const int* b     = outer.cell;
+        const auto brick = map.bricks[(b[2] * map.size.y + b[1]) * map.size.x + b[0]];
+
+        // Где луч выходит из кирпича.
+        const float tBrickExit
+            = Min(tExit, Min(outer.tMax[0], Min(outer.tMax[1], outer.tMax[2])));
+
+        if (brick != 0) {
+            const int cellsMin[3] = {
+                b[0] * BRICK_SIZE,
+                b[1] * BRICK_SIZE,
+                b[2] * BRICK_SIZE,
+            };
+            const int cellsMax[3] = {
+                cellsMin[0] + BRICK_SIZE,
+                cellsMin[1] + BRICK_SIZE,
+                cellsMin[2] + BRICK_SIZE,
+            };
+
+            auto  inner     = BrickDdaStart_(o, d, t, 1, cellsMin, cellsMax);
+            float tInner    = t;
+            int   innerAxis = outerAxis;
+
+            while (tInner <= tBrickExit) {
+                const int* c = inner.cell;
+
+                const bool solid
+                    = (brick & BRICK_UNIFORM)
+                      || (map.cells[(brick - 1) * BRICK_CELLS
+                                    + BrickCellIndex_(c[0], c[1], c[2])]
+                          != 0);
+
+                if (solid) {
+                    result.hit      = true;
+                    result.distance = tInner;
+                    result.point    = origin + direction * tInner;
+                    result.cell     = {
+                        map.origin.x + c[0],
+                        map.origin.y + c[1],
+                        map.origin.z + c[2],
+                    };
+                    if (innerAxis != -1)
+                        (&result.normal.x)[innerAxis] = (float)-inner.step[innerAxis];
+                    return result;
+                }
+
+                innerAxis = BrickDdaStep_(inner, tInner);
+                if ((c[innerAxis] < cellsMin[innerAxis])
+                    || (c[innerAxis] >= cellsMax[innerAxis]))
+                    break;
+            }
+        }
+
+        outerAxis = BrickDdaStep_(outer, t);
+        if ((b[outerAxis] < bricksMin[outerAxis])
+            || (b[outerAxis] >= bricksMax[outerAxis]))
+            break;
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Brick Map (GPU).
+//----------------------------------------------------------------------------------
+// Карта заливается в два SSBO как есть: bricks - u32 на кирпич,
+// cells - байты клеток, упакованные по 4 в uint (little endian).
+// Пример чтения - CellValue в world_raymarch_fragment.glsl.
+const int BRICK_MAP_BRICKS_BINDING = 5;
+const int BRICK_MAP_CELLS_BINDING  = 6;
+
+struct GpuBrickMap {
+    unsigned int bricks = 0;
+    unsigned int cells  = 0;
+};
+
+GpuBrickMap LoadGpuBrickMap(const BrickMap& map) {
+    // Хотя бы по одному слову, чтобы не заводить буферы нулевого размера.
+    const u32 empty = 0;
+
+    const int bricksSize = BrickMapBricksCount(map) * (int)sizeof(u32);
+    const int cellsSize  = map.cellsBricks * BRICK_CELLS;
+
+    GpuBrickMap result = {};
+    result.bricks      = rlLoadShaderBuffer(
+        (unsigned int)Max((int)sizeof(u32), bricksSize),
+        (bricksSize > 0) ? (const void*)map.bricks : &empty,
+        RL_STATIC_DRAW
+    );
+    result.cells = rlLoadShaderBuffer(
+        (unsigned int)Max((int)sizeof(u32), cellsSize),
+        (cellsSize > 0) ? (const void*)map.cells : &empty,
+        RL_STATIC_DRAW
+    );
+    return result;
+}
+
+void UnloadGpuBrickMap(GpuBrickMap& map) {
+    if (map.bricks != 0)
+        rlUnloadShaderBuffer(map.bricks);
+    if (map.cells != 0)
+        rlUnloadShaderBuffer(map.cells);
+    map = {};
+}
+
+void BindGpuBrickMap(const GpuBrickMap& map) {
+    rlBindShaderBuffer(map.bricks, BRICK_MAP_BRICKS_BINDING);
+    rlBindShaderBuffer(map.cells, BRICK_MAP_CELLS_BINDING);
+}
+
+//----------------------------------------------------------------------------------
+// Brick Map Serialization.
+//----------------------------------------------------------------------------------
+// Формат файла (little endian):
+//
+// u32  BRICK_MAP_MAGIC
+// i32  origin.x, origin.y, origin.z
+// i32  size.x, size.y, size.z
+// i32  cellsBricks
+// u32  bricks[size.x * size.y * size.z]
+// u8   cells[cellsBricks * BRICK_CELLS]
+const u32 BRICK_MAP_MAGIC = 0x314B5242;  // "BRK1".
+
+struct BrickMapHeader_ {
+    u32        magic       = BRICK_MAP_MAGIC;
+    Vector3Int origin      = {};
+    Vector3Int size        = {};
+    int        cellsBricks = 0;
+};
+static_assert(sizeof(BrickMapHeader_) == 32);
+
+std::vector<u8> SerializeBrickMap(const BrickMap& map) {
+    BrickMapHeader_ header = {};
+    header.origin          = map.origin;
+    header.size            = map.size;
+    header.cellsBricks     = map.cellsBricks;
+
+    const int bricksSize = BrickMapBricksCount(map) * (int)sizeof(u32);
+    const int cellsSize  = map.cellsBricks * BRICK_CELLS;
+
+    std::vector<u8> result(sizeof(header) + bricksSize + cellsSize);
+    memcpy(result.data(), &header, sizeof(header));
+    if (bricksSize > 0)
+        memcpy(result.data() + sizeof(header), map.bricks, bricksSize);
+    if (cellsSize > 0)
+        memcpy(result.data() + sizeof(header) + bricksSize, map.cells, cellsSize);
+
+    return result;
+}
+
+// Возвращает false, если данные битые. out при этом не трогается.
+bool DeserializeBrickMap(const u8* data, int dataSize, BrickMap& out) {
+    BrickMapHeader_ header = {};
+    if (dataSize < (int)sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != BRICK_MAP_MAGIC)
+        return false;
+    if ((header.size.x < 0) || (header.size.y < 0) || (header.size.z < 0)
+        || (header.cellsBricks < 0))
+        return false;
+
+    const i64 bricksCount = (i64)header.size.x * header.size.y * header.size.z;
+    const i64 bricksSize  = bricksCount * (i64)sizeof(u32);
+    const i64 cellsSize   = (i64)header.cellsBricks * BRICK_CELLS;
+    if ((i64)sizeof(header) + bricksSize + cellsSize != dataSize)
+        return false;
+
+    BrickMap map    = {};
+    map.origin      = header.origin;
+    map.size        = header.size;
+    map.cellsBricks = header.cellsBricks;
+    map.bricks      = (u32*)RL_MALLOC(Max(1, bricksSize));
+    map.cells       = (u8*)RL_MALLOC(Max(1, cellsSize));
+    memcpy(map.bricks, data + sizeof(header), bricksSize);
+    memcpy(map.cells, data + sizeof(header) + bricksSize, cellsSize);
+
+    // Индексы кирпичей не должны указывать за пределы cells.
+    FOR_RANGE (int, i, (int)bricksCount) {
+        const auto brick = map.bricks[i];
+        if (!(brick & BRICK_UNIFORM) && (brick > (u32)map.cellsBricks)) {
+            FreeBrickMap(map);
+            return false;
+        }
+    }
+
+    out = map;
+    return true;
+}
+
+TEST_CASE ("BrickMap") {
+    // Пол 40x40 толщиной 10 (однородные кирпичи внутри),
+    // столбы и парящие блоки разных цветов.
+    std::vector<CubeVoxel> cubes;
+    auto                   random = MakeRandom(3);
+
+    FOR_RANGE (int, x, 40) {
+        FOR_RANGE (int, z, 40) {
+            FOR_RANGE (int, y, 10) {
+                cubes.push_back({{x - 20, y - 10, z - 13}, 1});
+            }
+        }
+    }
+    FOR_RANGE (int, i, 60) {
+        const int x = (int)(RandomU32(random) % 40) - 20;
+        const int y = (int)(RandomU32(random) % 30);
+        const int z = (int)(RandomU32(random) % 40) - 13;
+        cubes.push_back({{x, y, z}, (int)(RandomU32(random) % 100)});
+    }
+
+    auto grid = MakeVoxelGrid(cubes.data(), (int)cubes.size());
+    auto map  = MakeBrickMap(cubes.data(), (int)cubes.size());
+    defer {
+        FreeBrickMap(map);
+        FreeVoxelGrid(grid);
+    };
+
+    Assert(map.origin.x % BRICK_SIZE == 0);
+    Assert(map.origin.y % BRICK_SIZE == 0);
+    Assert(map.origin.z % BRICK_SIZE == 0);
+    Assert(map.cellsBricks < BrickMapBricksCount(map));
+
+    const Vector3Int from = {grid.origin.x - 2, grid.origin.y - 2, grid.origin.z - 2};
+    const Vector3Int to   = {
+        grid.origin.x + grid.size.x + 2,
+        grid.origin.y + grid.size.y + 2,
+        grid.origin.z + grid.size.z + 2,
+    };
+
+    SUBCASE ("Point lookup matches VoxelGrid") {
+        bool same = true;
+        for (int z = from.z; z < to.z; z++) {
+            for (int y = from.y; y < to.y; y++) {
+                for (int x = from.x; x < to.x; x++)
+                    same &= BrickMapGet(map, x, y, z) == VoxelGridGet(grid, x, y, z);
+            }
+        }
+        Assert(same);
+    }
+
+    SUBCASE ("Bounds match VoxelGrid") {
+        const auto bounds = BrickMapBounds(map);
+        Assert(bounds.min.x == (float)grid.origin.x);
+        Assert(bounds.min.y == (float)grid.origin.y);
+        Assert(bounds.min.z == (float)grid.origin.z);
+        Assert(bounds.max.x == (float)(grid.origin.x + grid.size.x));
+        Assert(bounds.max.y == (float)(grid.origin.y + grid.size.y));
+        Assert(bounds.max.z == (float)(grid.origin.z + grid.size.z));
+    }
+
+    SUBCASE ("Solid cells in a box match VoxelGrid") {
+        // Коробка частично вне карты, задевает однородные кирпичи пола.
+        const Vector3Int boxFrom = {-30, -4, -5};
+        const Vector3Int boxTo   = {3, 12, 9};
+
+        int  expected = 0;
+        bool inside   = true;
+        for (int z = boxFrom.z; z <= boxTo.z; z++) {
+            for (int y = boxFrom.y; y <= boxTo.y; y++) {
+                for (int x = boxFrom.x; x <= boxTo.x; x++)
+                    expected += VoxelGridIsSolid(grid, x, y, z);
+            }
+        }
+
+        int visited = 0;
+        ForEachBrickMapSolidCell(map, boxFrom, boxTo, [&](Vector3Int cell) {
+            inside &= (cell.x >= boxFrom.x) && (cell.x <= boxTo.x)  //
+                      && (cell.y >= boxFrom.y) && (cell.y <= boxTo.y)
+                      && (cell.z >= boxFrom.z) && (cell.z <= boxTo.z)
+                      && VoxelGridIsSolid(grid, cell.x, cell.y, cell.z);
+            visited++;
+            return true;
+        });
+        Assert(inside);
+        Assert(visited == expected);
+
+        // Остановка по false.
+        visited = 0;
+        ForEachBrickMapSolidCell(map, boxFrom, boxTo, [&](Vector3Int) {
+            visited++;
+            return false;
+        });
+        Assert(visited == 1);
+    }
+
+    SUBCASE ("Raycast matches VoxelGrid") {
+        int mismatches = 0;
+        int hits       = 0;
+        FOR_RANGE (int, i, 2000) {
+            const Vector3 origin = {
+                RandomFloat(random, (float)from.x, (float)to.x),
+                RandomFloat(random, (float)from.y, (float)to.y + 20),
+                RandomFloat(random, (float)from.z, (float)to.z),
+            };
+            const Vector3 direction = Vector3Normalize({
+                RandomFloat(random, -1, 1),
+                RandomFloat(random, -1, 1),
+                RandomFloat(random, -1, 1),
+            });
+
+            const auto a = BrickMapRaycast(map, origin, direction, 100);
+            const auto b = VoxelGridRaycast(grid, origin, direction, 100);
+
+            hits += a.hit;
+            const bool sameCell = (a.cell.x == b.cell.x)  //
+                                  && (a.cell.y == b.cell.y)
+                                  && (a.cell.z == b.cell.z);
+            if ((a.hit != b.hit) || !sameCell || (fabsf(a.distance - b.distance) > 0.001f)
+                || !Vector3Equals(a.normal, b.normal))
+                mismatches++;
+        }
+        Assert(hits > 500);
+        Assert(mismatches == 0);
+    }
+
+    SUBCASE ("Cubes round trip") {
+        std::vector<CubeVoxel> cubesBack;
+        GetBrickMapCubes(map, cubesBack);
+        Assert(BrickMapCubesCount(map) == (int)cubesBack.size());
+
+        int maxColor = 0;
+        for (const auto& cube : cubes)
+            maxColor = Max(maxColor, cube.colorIndex);
+        Assert(BrickMapMaxValue(map) == maxColor + 1);
+
+        auto gridBack = MakeVoxelGrid(cubesBack.data(), (int)cubesBack.size());
+        defer {
+            FreeVoxelGrid(gridBack);
+        };
+
+        Assert(cubesBack.size() == cubes.size());
+        Assert(gridBack.origin.x == grid.origin.x);
+        Assert(gridBack.origin.y == grid.origin.y);
+        Assert(gridBack.origin.z == grid.origin.z);
+
+        const int cellsCount = grid.size.x * grid.size.y * grid.size.z;
+        Assert(memcmp(gridBack.cells, grid.cells, cellsCount) == 0);
+    }
+
+    SUBCASE ("Serialization") {
+        auto data = SerializeBrickMap(map);
+
+        BrickMap loaded = {};
+        Assert(DeserializeBrickMap(data.data(), (int)data.size(), loaded));
+        defer {
+            FreeBrickMap(loaded);
+        };
+
+        Assert(BrickMapMemorySize(loaded) == BrickMapMemorySize(map));
+        Assert(memcmp(loaded.cells, map.cells, map.cellsBricks * BRICK_CELLS) == 0);
+        Assert(BrickMapGet(loaded, 0, -1, 0) == BrickMapGet(map, 0, -1, 0));
+
+        // Обрезанный файл.
+        BrickMap broken = {};
+        Assert_False(DeserializeBrickMap(data.data(), (int)data.size() - 1, broken));
+
+        // Индекс кирпича за пределами cells.
+        auto corrupted = data;
+        const u32 index = (u32)map.cellsBricks + 1;
+        memcpy(corrupted.data() + sizeof(BrickMapHeader_), &index, sizeof(index));
+        Assert_False(
+            DeserializeBrickMap(corrupted.data(), (int)corrupted.size(), broken)
+        );
+    }
+}
@@ -0,0 +1,658 @@
+//----------------------------------------------------------------------------------
+// Chunk Meshes.
+//----------------------------------------------------------------------------------
+// Меши мира для растеризации. Мир режется на чанки CHUNK_SIZE^3 клеток,
+// у каждого чанка - свой диапазон вертексов в общем массиве.
+// Чанки выровнены по мировым координатам, как и кирпичи BrickMap.
+//
+// В меш попадают только грани твёрдых клеток, соседние с пустыми.
+// Вертексы не индексированы: 6 вертексов (2 полигона) на грань,
+// против часовой стрелки, если смотреть снаружи.
+//
+// LOD-ы. Для LOD l клетки чанка объединяются в блоки 2^l x 2^l x 2^l.
+// Блок твёрдый, если твёрдая хоть одна его клетка (цвет - самый частый),
+// поэтому LOD покрывает всё, что покрывает LOD 0, и силуэты не рассыпаются.
+// Граней на LOD l примерно в 4^l раз меньше.
+//
+// Ambient occlusion запекается в вертексы: у каждого угла грани смотрим
+// 3 клетки перед гранью (2 по сторонам и 1 по диагонали). См. ChunkVertexAo_.
+// Квад режется по диагонали с большей суммой AO, иначе затемнение
+// растягивается вдоль диагонали и зависит от ориентации грани.
+//
+// Швы между чанками разных LOD-ов. Грань на границе чанка выкидывается,
+// только если все клетки LOD 0 за ней твёрдые. Любой LOD соседа их покрывает,
+// поэтому дыр на границе нет при любом сочетании LOD-ов.
+const int CHUNK_SIZE = 16;
+const int CHUNK_LODS = 4;  // Блоки 1, 2, 4, 8 клеток.
+static_assert((CHUNK_SIZE >> (CHUNK_LODS - 1)) >= 1);
+
+// Координаты чанков в ChunkVertex - 10 бит со знаком.
+const int CHUNK_COORD_BITS = 10;
+const int CHUNK_COORD_MAX  = (1 << (CHUNK_COORD_BITS - 1)) - 1;
+
+// Упакованный вертекс, 8 байт. Распаковывается в chunk_vertex.glsl.
+//
+// packed: биты 0-14  - позиция в чанке, по 5 бит на ось (0..CHUNK_SIZE),
+//         биты 15-17 - грань (индекс в chunkFaceNormals_),
+//         биты 18-19 - AO: 0 - угол зажат, 3 - открыт,
+//         биты 20-27 - индекс цвета в палитре.
+// chunk:  координаты чанка (в чанках), по CHUNK_COORD_BITS бит со знаком на ось.
+struct ChunkVertex {
+    u32 packed = 0;
+    u32 chunk  = 0;
+};
+static_assert(sizeof(ChunkVertex) == 8);
+static_assert(CHUNK_SIZE < 32);
+
+u32 PackChunkCoords_(Vector3Int chunk) {
+    const u32 mask = (1u << CHUNK_COORD_BITS) - 1;
+    return ((u32)chunk.x & mask)                               //
+           | (((u32)chunk.y & mask) << CHUNK_COORD_BITS)       //
+           | (((u32)chunk.z & mask) << (2 * CHUNK_COORD_BITS));
+}
+
+ChunkVertex PackChunkVertex_(
+    u32        chunk,
+    Vector3Int local,
+    int        face,
+    int        ao,
+    int        colorIndex
+) {
+    ChunkVertex result = {};
+    result.packed      = (u32)local.x | ((u32)local.y << 5) | ((u32)local.z << 10)
+                    | ((u32)face << 15) | ((u32)ao << 18) | ((u32)colorIndex << 20);
+    result.chunk = chunk;
+    return result;
+}
+
+Vector3 ChunkVertexPosition(const ChunkVertex& vertex) {
+    auto coord = [&](int i) {
+        // Сдвиг влево и арифметический вправо - знаковое расширение.
+        const int shift = 32 - CHUNK_COORD_BITS;
+        const int chunk = (int)(vertex.chunk << (shift - i * CHUNK_COORD_BITS)) >> shift;
+        const int local = (int)(vertex.packed >> (i * 5)) & 31;
+        return (float)(chunk * CHUNK_SIZE + local);
+    };
+    return {coord(0), coord(1), coord(2)};
+}
+
+int ChunkVertexFace(const ChunkVertex& vertex) {
+    return (int)(vertex.packed >> 15) & 7;
+}
+
+int ChunkVertexAo(const ChunkVertex& vertex) {
+    return (int)(vertex.packed >> 18) & 3;
+}
+
+int ChunkVertexColorIndex(const ChunkVertex& vertex) {
+    return (int)(vertex.packed >> 20) & 255;
+}
+
+// Раскладка совпадает с std430 структурой в chunk_cull_compute.glsl.
+struct ChunkMesh {
+    Vector3 boundsMin = {};  // AABB вертексов всех LOD-ов.
+    u32     unused0_  = 0;
+    Vector3 boundsMax = {};
+    u32     unused1_  = 0;
+
+    // Диапазоны вертексов в ChunkMeshes::vertices для каждого LOD-а.
+    u32 first[CHUNK_LODS] = {};
+    u32 count[CHUNK_LODS] = {};
+};
+static_assert(sizeof(ChunkMesh) == 64);
+
+struct ChunkMeshes {
+    // Вертексы чанка лежат подряд: LOD 0, LOD 1 и т.д.
+    // Так чанк можно целиком перенести в другой буфер. См. chunk_streaming.cpp.
+    std::vector<ChunkVertex> vertices = {};
+    std::vector<ChunkMesh>   chunks   = {};  // Только непустые.
+
+    int lodVerticesCount[CHUNK_LODS] = {};
+};
+
+// Вертексы всех LOD-ов чанка.
+u32 ChunkMeshVerticesCount(const ChunkMesh& chunk) {
+    u32 result = 0;
+    FOR_RANGE (int, lod, CHUNK_LODS) {
+        result += chunk.count[lod];
+    }
+    return result;
+}
+
+const Vector3Int chunkFaceNormals_[6] = {
+    {1, 0, 0},
+    {-1, 0, 0},
+    {0, 1, 0},
+    {0, -1, 0},
+    {0, 0, 1},
+    {0, 0, -1},
+};
+
+// Углы грани в базисе (tangent, bitangent), против часовой стрелки.
+const Vector2 chunkFaceCorners_[4] = {
+    {-1, -1},
+    {1, -1},
+    {1, 1},
+    {-1, 1},
+};
+
+// Два полигона квада: по диагонали 0-2 и по диагонали 1-3.
+const int chunkFaceTriangles_[2][6] = {
+    {0, 1, 2, 0, 2, 3},
+    {1, 2, 3, 1, 3, 0},
+};
+
+// cross(tangent, bitangent) == normal, поэтому грань смотрит наружу.
+void ChunkFaceBasis_(int face, Vector3Int& tangent, Vector3Int& bitangent) {
+    const auto& n = chunkFaceNormals_[face];
+    tangent       = (n.y != 0) ? Vector3Int{1, 0, 0} : Vector3Int{0, 1, 0};
+    bitangent     = {
+        n.y * tangent.z - n.z * tangent.y,
+        n.z * tangent.x - n.x * tangent.z,
+        n.x * tangent.y - n.y * tangent.x,
+    };
+}
+
+// 0..3, 3 - угол ничем не зажат.
+int ChunkVertexAo_(bool side1, bool side2, bool corner) {
+    if (side1 && side2)
+        return 0;
+    return 3 - (side1 + side2 + corner);
+}
+
+// Грань куба с ребром size и минимальным углом в blockMin (в клетках от начала чанка).
+// chunk - см. PackChunkCoords_. ao - для углов chunkFaceCorners_.
+void AddChunkFace_(
+    std::vector<ChunkVertex>& vertices,
+    u32                       chunk,
+    Vector3Int                blockMin,
+    int                       size,
+    int                       face,
+    int                       colorIndex,
+    const int*                ao
+) {
+    Vector3Int tangent   = {};
+    Vector3Int bitangent = {};
+    ChunkFaceBasis_(face, tangent, bitangent);
+
+    const auto& n = chunkFaceNormals_[face];
+
+    const bool flip = (ao[0] + ao[2]) < (ao[1] + ao[3]);
+    for (int corner : chunkFaceTriangles_[flip]) {
+        const int qx = (int)chunkFaceCorners_[corner].x;
+        const int qy = (int)chunkFaceCorners_[corner].y;
+
+        // Угол куба в [-1, 1]^3 -> [0, size]^3.
+        auto axis = [&](int n, int t, int b) {
+            return (n + t * qx + b * qy + 1) / 2 * size;
+        };
+        const Vector3Int local = {
+            blockMin.x + axis(n.x, tangent.x, bitangent.x),
+            blockMin.y + axis(n.y, tangent.y, bitangent.y),
+            blockMin.z + axis(n.z, tangent.z, bitangent.z),
+        };
+        vertices.push_back(PackChunkVertex_(chunk, local, face, ao[corner], colorIndex));
+    }
+}
+
+// Клетки чанка + слой соседей с каждой стороны.
+const int CHUNK_CELLS_SIDE_ = CHUNK_SIZE + 2;
+
+int ChunkCellIndex_(int x, int y, int z) {
+    return ((z + 1) * CHUNK_CELLS_SIDE_ + y + 1) * CHUNK_CELLS_SIDE_ + x + 1;
+}
+
+// Блоки LOD-а из клеток чанка. lodSide = CHUNK_SIZE >> lod.
+void DownsampleChunk_(const u8* cells, int lod, u8* blocks) {
+    const int scale   = 1 << lod;
+    const int lodSide = CHUNK_SIZE >> lod;
+
+    FOR_RANGE (int, bz, lodSide) {
+        FOR_RANGE (int, by, lodSide) {
+            FOR_RANGE (int, bx, lodSide) {
+                int counts[128] = {};
+                int result      = 0;
+
+                FOR_RANGE (int, z, scale) {
+                    FOR_RANGE (int, y, scale) {
+                        FOR_RANGE (int, x, scale) {
+                            const int value = cells[ChunkCellIndex_(
+                                bx * scale + x, by * scale + y, bz * scale + z
+                            )];
+                            if (value == 0)
+                                continue;
+
+                            counts[value]++;
+                            if ((result == 0) || (counts[value] > counts[result]))
+                                result = value;
+                        }
+                    }
+                }
+
+                blocks[(bz * lodSide + by) * lodSide + bx] = (u8)result;
+            }
+        }
+    }
+}
+
+// Все ли клетки LOD 0 за гранью блока (слой толщиной в клетку) твёрдые.
+bool ChunkFaceCovered_(const u8* cells, Vector3Int block, int lod, int face) {
+    const int   scale = 1 << lod;
+    const auto& n     = chunkFaceNormals_[face];
+
+    // Клетка блока, ближайшая к (-inf, -inf, -inf), сдвинутая за грань.
+    const Vector3Int from = {
+        block.x * scale + ((n.x > 0) ? scale : n.x),
+        block.y * scale + ((n.y > 0) ? scale : n.y),
+        block.z * scale + ((n.z > 0) ? scale : n.z),
+    };
+    const Vector3Int size = {
+        (n.x != 0) ? 1 : scale,
+        (n.y != 0) ? 1 : scale,
+        (n.z != 0) ? 1 : scale,
+    };
+
+    FOR_RANGE (int, z, size.z) {
+        FOR_RANGE (int, y, size.y) {
+            FOR_RANGE (int, x, size.x) {
+                if (cells[ChunkCellIndex_(from.x + x, from.y + y, from.z + z)] == 0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void BuildChunkLod_(
+    const u8*                 cells,
+    Vector3Int                chunkOrigin,
+    int                       lod,
+    std::vector<ChunkVertex>& vertices,
+    ChunkMesh&                chunk
+) {
+    const int scale   = 1 << lod;
+    const int lodSide = CHUNK_SIZE >> lod;
+
+    u8 blocks[CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE];
+    DownsampleChunk_(cells, lod, blocks);
+
+    auto block = [&](int x, int y, int z) {
+        return blocks[(z * lodSide + y) * lodSide + x];
+    };
+
+    // Для AO. За границей чанка блоков нет - берём клетку LOD 0 за границей,
+    // ближайшую к середине блока. Для LOD 0 это ровно сосед.
+    auto solid = [&](Vector3Int p) {
+        const bool inside = (p.x >= 0) && (p.y >= 0) && (p.z >= 0) && (p.x < lodSide)
+                            && (p.y < lodSide) && (p.z < lodSide);
+        if (inside)
+            return block(p.x, p.y, p.z) != 0;
+
+        auto cell = [&](int b) {
+            if (b < 0)
+                return -1;
+            if (b >= lodSide)
+                return CHUNK_SIZE;
+            return b * scale + scale / 2;
+        };
+        return cells[ChunkCellIndex_(cell(p.x), cell(p.y), cell(p.z))] != 0;
+    };
+
+    const u32 chunkCoords = PackChunkCoords_({
+        chunkOrigin.x / CHUNK_SIZE,
+        chunkOrigin.y / CHUNK_SIZE,
+        chunkOrigin.z / CHUNK_SIZE,
+    });
+
+    chunk.first[lod] = (u32)vertices.size();
+
+    FOR_RANGE (int, z, lodSide) {
+        FOR_RANGE (int, y, lodSide) {
+            FOR_RANGE (int, x, lodSide) {
+                const u8 value = block(x, y, z);
+                if (value == 0)
+                    continue;
+
+                const Vector3 center = {
+                    (float)(chunkOrigin.x + x * scale) + (float)scale * 0.5f,
+                    (float)(chunkOrigin.y + y * scale) + (float)scale * 0.5f,
+                    (float)(chunkOrigin.z + z * scale) + (float)scale * 0.5f,
+                };
+
+                FOR_RANGE (int, face, 6) {
+                    const auto&      n        = chunkFaceNormals_[face];
+                    const Vector3Int neighbor = {x + n.x, y + n.y, z + n.z};
+
+                    const bool inside = (neighbor.x >= 0) && (neighbor.y >= 0)
+                                        && (neighbor.z >= 0) && (neighbor.x < lodSide)
+                                        && (neighbor.y < lodSide)
+                                        && (neighbor.z < lodSide);
+                    const bool hidden
+                        = inside ? (block(neighbor.x, neighbor.y, neighbor.z) != 0)
+                                 : ChunkFaceCovered_(cells, {x, y, z}, lod, face);
+                    if (hidden)
+                        continue;
+
+                    Vector3Int tangent   = {};
+                    Vector3Int bitangent = {};
+                    ChunkFaceBasis_(face, tangent, bitangent);
+
+                    int ao[4] = {};
+                    FOR_RANGE (int, i, 4) {
+                        const int  qx = (int)chunkFaceCorners_[i].x;
+                        const int  qy = (int)chunkFaceCorners_[i].y;
+                        const auto t  = Vector3Int{
+                            tangent.x * qx, tangent.y * qx, tangent.z * qx
+                        };
+                        const auto b = Vector3Int{
+                            bitangent.x * qy, bitangent.y * qy, bitangent.z * qy
+                        };
+
+                        const auto& p = neighbor;
+                        ao[i]         = ChunkVertexAo_(
+                            solid({p.x + t.x, p.y + t.y, p.z + t.z}),
+                            solid({p.x + b.x, p.y + b.y, p.z + b.z}),
+                            solid({p.x + t.x + b.x, p.y + t.y + b.y, p.z + t.z + b.z})
+                        );
+                    }
+
+                    AddChunkFace_(
+                        vertices,
+                        chunkCoords,
+                        {x * scale, y * scale, z * scale},
+                        scale,
+                        face,
+                        value - 1,
+                        ao
+                    );
+
+                    const auto lo   = center - ToVector3((float)scale * 0.5f);
+                    const auto hi   = center + ToVector3((float)scale * 0.5f);
+                    chunk.boundsMin = Vector3Min(chunk.boundsMin, lo);
+                    chunk.boundsMax = Vector3Max(chunk.boundsMax, hi);
+                }
+            }
+        }
+    }
+
+    chunk.count[lod] = (u32)vertices.size() - chunk.first[lod];
+}
+
+// Клетки чанка с соседями, см. ChunkCellIndex_.
+const int CHUNK_CELLS_COUNT = CHUNK_CELLS_SIDE_ * CHUNK_CELLS_SIDE_ * CHUNK_CELLS_SIDE_;
+
+// Мировые координаты первой клетки первого чанка (from) и граница (to, не включая).
+// Шаг - CHUNK_SIZE.
+void GetBrickMapChunkRange(const BrickMap& map, Vector3Int& from, Vector3Int& to) {
+    from = {
+        Floor(map.origin.x, CHUNK_SIZE),
+        Floor(map.origin.y, CHUNK_SIZE),
+        Floor(map.origin.z, CHUNK_SIZE),
+    };
+    to = {
+        map.origin.x + map.size.x * BRICK_SIZE,
+        map.origin.y + map.size.y * BRICK_SIZE,
+        map.origin.z + map.size.z * BRICK_SIZE,
+    };
+
+    // Иначе координаты чанков не влезут в ChunkVertex::chunk.
+    const int chunkCoordLimit = (CHUNK_COORD_MAX + 1) * CHUNK_SIZE;
+    Assert(Min(from.x, Min(from.y, from.z)) >= -chunkCoordLimit);
+    Assert(Max(to.x, Max(to.y, to.z)) <= chunkCoordLimit);
+}
+
+// Копирует в cells (CHUNK_CELLS_COUNT) клетки чанка вместе со слоем соседей.
+// Возвращает false, если в самом чанке пусто.
+bool GatherChunkCells(const BrickMap& map, Vector3Int chunkOrigin, u8* cells) {
+    bool empty = true;
+
+    for (int z = -1; z <= CHUNK_SIZE; z++) {
+        for (int y = -1; y <= CHUNK_SIZE; y++) {
+            for (int x = -1; x <= CHUNK_SIZE; x++) {
+                const u8 value = BrickMapGet(
+                    map, chunkOrigin.x + x, chunkOrigin.y + y, chunkOrigin.z + z
+                );
+                cells[ChunkCellIndex_(x, y, z)] = value;
+
+                const bool inside = (x >= 0) && (y >= 0) && (z >= 0) && (x < CHUNK_SIZE)
+                                    && (y < CHUNK_SIZE) && (z < CHUNK_SIZE);
+                if (inside && (value != 0))
+                    empty = false;
+            }
+        }
+    }
+    return !empty;
+}
+
+// Меш чанка из клеток (см. GatherChunkCells). Вертексы всех LOD-ов
+// дописываются в конец vertices подряд. Возвращает false, если граней нет.
+bool BuildChunkMesh(
+    const u8*                 cells,
+    Vector3Int                chunkOrigin,
+    std::vector<ChunkVertex>& vertices,
+    ChunkMesh&                chunk
+) {
+    chunk           = {};
+    chunk.boundsMin = ToVector3(floatInf);
+    chunk.boundsMax = ToVector3(-floatInf);
+
+    u32 count = 0;
+    FOR_RANGE (int, lod, CHUNK_LODS) {
+        BuildChunkLod_(cells, chunkOrigin, lod, vertices, chunk);
+        count += chunk.count[lod];
+    }
+    return count > 0;
+}
+
+ChunkMeshes BuildChunkMeshes(const BrickMap& map) {
+    ChunkMeshes result = {};
+    if (map.bricks == nullptr)
+        return result;
+
+    Vector3Int from = {};
+    Vector3Int to   = {};
+    GetBrickMapChunkRange(map, from, to);
+
+    u8 cells[CHUNK_CELLS_COUNT];
+
+    for (int cz = from.z; cz < to.z; cz += CHUNK_SIZE) {
+        for (int cy = from.y; cy < to.y; cy += CHUNK_SIZE) {
+            for (int cx = from.x; cx < to.x; cx += CHUNK_SIZE) {
+                if (!GatherChunkCells(map, {cx, cy, cz}, cells))
+                    continue;
+
+                ChunkMesh chunk = {};
+                if (BuildChunkMesh(cells, {cx, cy, cz}, result.vertices, chunk))
+                    result.chunks.push_back(chunk);
+            }
+        }
+    }
+
+    for (const auto& chunk : result.chunks) {
+        FOR_RANGE (int, lod, CHUNK_LODS) {
+            result.lodVerticesCount[lod] += (int)chunk.count[lod];
+        }
+    }
+
+    return result;
+}
+
+TEST_CASE ("BuildChunkMeshes") {
+    SUBCASE ("Single cube") {
+        CubeVoxel cubes[] = {{{3, 4, 5}, 1}};
+        auto      map     = MakeBrickMap(cubes, 1);
+        defer {
+            FreeBrickMap(map);
+        };
+
+        auto meshes = BuildChunkMeshes(map);
+        Assert(meshes.chunks.size() == 1);
+        Assert(meshes.vertices.size() == 36 * CHUNK_LODS);
+        Assert(meshes.lodVerticesCount[0] == 36);
+
+        // Bounds покрывают все LOD-ы. На последнем куб занимает блок 8^3.
+        const auto& chunk = meshes.chunks[0];
+        Assert(chunk.first[0] == 0);
+        Assert(chunk.count[0] == 36);
+        Assert(Vector3Equals(chunk.boundsMin, {0, 0, 0}));
+        Assert(Vector3Equals(chunk.boundsMax, {8, 8, 8}));
+
+        Assert(ChunkVertexColorIndex(meshes.vertices[0]) == 1);
+
+        // Полигоны смотрят наружу.
+        bool outward = true;
+        const Vector3 center = {3.5f, 4.5f, 5.5f};
+        FOR_RANGE (int, i, 12) {
+            const auto a      = ChunkVertexPosition(meshes.vertices[i * 3]);
+            const auto b      = ChunkVertexPosition(meshes.vertices[i * 3 + 1]);
+            const auto c      = ChunkVertexPosition(meshes.vertices[i * 3 + 2]);
+            const auto normal = Vector3CrossProduct(b - a, c - a);
+            outward &= Vector3DotProduct(normal, (a + b + c) / 3.0f - center) > 0;
+
+            const int face = ChunkVertexFace(meshes.vertices[i * 3]);
+            outward &= Vector3DotProduct(normal, ToVector3(chunkFaceNormals_[face])) > 0;
+        }
+        Assert(outward);
+    }
+
+    SUBCASE ("Hidden faces across chunk borders") {
+        // Два куба по разные стороны границы чанков и один внутри.
+        CubeVoxel cubes[] = {
+            {{CHUNK_SIZE - 1, 0, 0}, 0},
+            {{CHUNK_SIZE, 0, 0}, 0},
+            {{CHUNK_SIZE + 1, 0, 0}, 1},
+        };
+        auto map = MakeBrickMap(cubes, 3);
+        defer {
+            FreeBrickMap(map);
+        };
+
+        auto meshes = BuildChunkMeshes(map);
+        Assert(meshes.chunks.size() == 2);
+        // 3 куба в ряд - 3 * 6 - 4 грани.
+        Assert(meshes.lodVerticesCount[0] == 14 * 6);
+        Assert(meshes.chunks[0].count[0] == 5 * 6);
+        const auto& first = meshes.chunks[0];
+        Assert(
+            meshes.chunks[1].first[0]
+            == first.first[CHUNK_LODS - 1] + first.count[CHUNK_LODS - 1]
+        );
+        Assert(meshes.chunks[1].count[0] == 9 * 6);
+        Assert(FloatEquals(meshes.chunks[1].boundsMin.x, CHUNK_SIZE));
+    }
+
+    SUBCASE ("Ambient occlusion") {
+        // Пол 3 x 1 x 3 и куб на нём в углу (1, 1, 1).
+        std::vector<CubeVoxel> cubes;
+        FOR_RANGE (int, x, 3) {
+            FOR_RANGE (int, z, 3) {
+                cubes.push_back({{x, 0, z}, 0});
+            }
+        }
+        cubes.push_back({{1, 1, 1}, 0});
+        auto map = MakeBrickMap(cubes.data(), (int)cubes.size());
+        defer {
+            FreeBrickMap(map);
+        };
+
+        auto meshes = BuildChunkMeshes(map);
+
+        // Минимальный AO вертексов в углу у куба и в дальнем углу пола.
+        int nearCube = 3;
+        int farAo    = 3;
+        FOR_RANGE (int, i, meshes.lodVerticesCount[0]) {
+            const auto position = ChunkVertexPosition(meshes.vertices[i]);
+            const int  ao       = ChunkVertexAo(meshes.vertices[i]);
+            if (Vector3Equals(position, {1, 1, 1}))
+                nearCube = Min(nearCube, ao);
+            if (Vector3Equals(position, {0, 1, 0}))
+                farAo = Min(farAo, ao);
+        }
+        Assert(nearCube < 3);
+        Assert(farAo == 3);
+
+        // Один тёмный угол - диагональ квада через два других.
+        const int ao[4] = {0, 3, 3, 3};
+        std::vector<ChunkVertex> vertices;
+        AddChunkFace_(vertices, 0, {0, 0, 0}, 1, 2, 0, ao);
+        int darkCount = 0;
+        for (auto& v : vertices)
+            darkCount += (ChunkVertexAo(v) == 0);
+        Assert(darkCount == 1);
+    }
+
+    SUBCASE ("Packing") {
+        const u32  chunk  = PackChunkCoords_({-3, 0, CHUNK_COORD_MAX});
+        const auto vertex = PackChunkVertex_(chunk, {CHUNK_SIZE, 0, 7}, 5, 2, 126);
+
+        Assert(Vector3Equals(
+            ChunkVertexPosition(vertex),
+            {-2 * CHUNK_SIZE, 0, (float)(CHUNK_COORD_MAX * CHUNK_SIZE + 7)}
+        ));
+        Assert(ChunkVertexFace(vertex) == 5);
+        Assert(ChunkVertexAo(vertex) == 2);
+        Assert(ChunkVertexColorIndex(vertex) == 126);
+    }
+
+    SUBCASE ("LODs") {
+        // Шар радиуса 12.
+        std::vector<CubeVoxel> cubes;
+        FOR_RANGE (int, z, 32) {
+            FOR_RANGE (int, y, 32) {
+                FOR_RANGE (int, x, 32) {
+                    const Vector3 p = {x - 15.5f, y - 15.5f, z - 15.5f};
+                    if (Vector3Length(p) < 12)
+                        cubes.push_back({{x, y, z}, 0});
+                }
+            }
+        }
+        auto map = MakeBrickMap(cubes.data(), (int)cubes.size());
+        defer {
+            FreeBrickMap(map);
+        };
+
+        auto meshes = BuildChunkMeshes(map);
+        Assert(meshes.chunks.size() == 8);
+
+        // Вертексов меньше хотя бы вдвое на каждом следующем LOD-е.
+        for (int lod = 1; lod < CHUNK_LODS; lod++)
+            Assert(meshes.lodVerticesCount[lod] * 2 < meshes.lodVerticesCount[lod - 1]);
+
+        // LOD-ы чанка идут подряд.
+        const auto& last = meshes.chunks.back();
+        Assert(last.first[CHUNK_LODS - 1] + last.count[CHUNK_LODS - 1]
+               == meshes.vertices.size());
+        for (const auto& chunk : meshes.chunks) {
+            for (int lod = 1; lod < CHUNK_LODS; lod++)
+                Assert(chunk.first[lod] == chunk.first[lod - 1] + chunk.count[lod - 1]);
+        }
+    }
+
+    SUBCASE ("Seams") {
+        // Плита 32 x height x 16 через границу чанков по x.
+        auto lod1Faces = [&](int height) {
+            std::vector<CubeVoxel> cubes;
+            FOR_RANGE (int, x, 2 * CHUNK_SIZE) {
+                FOR_RANGE (int, y, height) {
+                    FOR_RANGE (int, z, CHUNK_SIZE) {
+                        cubes.push_back({{x, y, z}, 0});
+                    }
+                }
+            }
+            auto map = MakeBrickMap(cubes.data(), (int)cubes.size());
+            defer {
+                FreeBrickMap(map);
+            };
+
+            auto meshes = BuildChunkMeshes(map);
+            Assert(meshes.chunks.size() == 2);
+            return (int)meshes.chunks[0].count[1] / 6;
+        };
+
+        // Блоки 2x2x2 на границе: за гранью целиком твёрдые клетки - грань не нужна.
+        // 64 сверху + 64 снизу + 8 на -x + 2 * 8 по z.
+        Assert(lod1Faces(2) == 152);
+        // Плита в одну клетку: блок выше соседей, грань на границе остаётся.
+        Assert(lod1Faces(1) == 160);
+    }
+}
@@ -0,0 +1,503 @@
+//----------------------------------------------------------------------------------
+// Depth Pyramid.
+//----------------------------------------------------------------------------------
+// Hi-Z: мипы буфера глубины, где каждый тексел - самая дальняя глубина под ним.
+// Уровень 0 - половина разрешения буфера глубины (размеры округляются вверх),
+// последний уровень - 1x1. Строится depth_pyramid_compute.glsl.
+struct DepthPyramid {
+    unsigned int texture = 0;  // R32F, levels мипов.
+    int          width   = 0;  // Размер уровня 0.
+    int          height  = 0;
+    int          levels  = 0;
+
+    // Размер буфера глубины, из которого строилась пирамида.
+    int sourceWidth  = 0;
+    int sourceHeight = 0;
+};
+
+void UnloadDepthPyramid(DepthPyramid& pyramid) {
+    if (pyramid.texture != 0)
+        rlUnloadTexture(pyramid.texture);
+    pyramid = {};
+}
+
+void ResizeDepthPyramid_(DepthPyramid& pyramid, int sourceWidth, int sourceHeight) {
+    if ((pyramid.sourceWidth == sourceWidth) && (pyramid.sourceHeight == sourceHeight))
+        return;
+
+    UnloadDepthPyramid(pyramid);
+
+    pyramid.sourceWidth  = sourceWidth;
+    pyramid.sourceHeight = sourceHeight;
+    pyramid.width        = CeilDivision(sourceWidth, 2);
+    pyramid.height       = CeilDivision(sourceHeight, 2);
+
+    pyramid.levels = 1;
+    while (Max(pyramid.width, pyramid.height) > (1 << (pyramid.levels - 1)))
+        pyramid.levels++;
+
+    gl.genTextures(1, &pyramid.texture);
+    gl.bindTexture(GL_TEXTURE_2D, pyramid.texture);
+    gl.texStorage2D(
+        GL_TEXTURE_2D, pyramid.levels, GL_R32F, pyramid.width, pyramid.height
+    );
+    gl.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl.bindTexture(GL_TEXTURE_2D, 0);
+}
+
+// depthTexture - текстура глубины отрисованного кадра размером width x height.
+void BuildDepthPyramid(
+    DepthPyramid& pyramid,
+    unsigned int  shader,
+    unsigned int  depthTexture,
+    int           width,
+    int           height
+) {
+    ResizeDepthPyramid_(pyramid, width, height);
+
+    rlEnableShader(shader);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(depthTexture);
+
+    int sourceSize[2] = {width, height};
+    int levelSize[2]  = {pyramid.width, pyramid.height};
+
+    FOR_RANGE (int, level, pyramid.levels) {
+        const int fromDepth = (level == 0);
+        rlSetUniform(0, &fromDepth, RL_SHADER_UNIFORM_INT, 1);
+        rlSetUniform(1, sourceSize, RL_SHADER_UNIFORM_IVEC2, 1);
+        rlSetUniform(2, levelSize, RL_SHADER_UNIFORM_IVEC2, 1);
+
+        if (level > 0) {
+            gl.bindImageTexture(
+                0, pyramid.texture, level - 1, 0, 0, GL_READ_ONLY, GL_R32F
+            );
+        }
+        gl.bindImageTexture(1, pyramid.texture, level, 0, 0, GL_WRITE_ONLY, GL_R32F);
+
+        rlComputeShaderDispatch(
+            CeilDivision(levelSize[0], 8), CeilDivision(levelSize[1], 8), 1
+        );
+        gl.memoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        sourceSize[0] = levelSize[0];
+        sourceSize[1] = levelSize[1];
+        levelSize[0]  = CeilDivision(levelSize[0], 2);
+        levelSize[1]  = CeilDivision(levelSize[1], 2);
+    }
+
+    // Дальше пирамиду читают через sampler.
+    gl.memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    rlDisableTexture();
+    rlDisableShader();
+}
+
+//----------------------------------------------------------------------------------
+// Chunk Renderer.
+//----------------------------------------------------------------------------------
+// Рисует чанки одним glMultiDrawArraysIndirect.
+//
+// Чанки добавляются и убираются по одному (см. chunk_streaming.cpp).
+// Буферы заводятся сразу на maxChunks слотов и maxVertices вертексов:
+// чанк занимает слот в chunks и непрерывный диапазон в vertices.
+// Пустой слот - ChunkMesh с нулевыми count, отбор его пропускает.
+//
+// Каждый кадр chunk_cull_compute.glsl отбирает чанки: AABB проверяется на frustum
+// и на пирамиду глубины прошлого кадра. Команды видимых чанков пишутся в
+// GL_DRAW_INDIRECT_BUFFER, CPU про видимость ничего не знает.
+//
+// Пирамида прошлого кадра - значит, чанк, который только что открылся
+// (развернулись, отошла стена), появится на кадр позже.
+//
+// LOD чанка тоже выбирается там, по расстоянию до камеры. См. chunkLodDistance.
+//
+// Нужен GL 4.3, его проверяет RequireGL43 при старте.
+const int CHUNK_CULL_GROUP_SIZE = 64;
+
+// Ближе - LOD 0. Каждое удвоение расстояния - следующий LOD.
+// Блок LOD-а l в 2^l клеток на расстоянии chunkLodDistance * 2^(l-1)
+// виден примерно под тем же углом, что клетка на chunkLodDistance / 2.
+const float chunkLodDistance = 48.0f;
+
+// Раскладка совпадает с DrawArraysIndirectCommand.
+struct ChunkDrawCommand_ {
+    u32 count         = 0;
+    u32 instanceCount = 0;
+    u32 first         = 0;
+    u32 baseInstance  = 0;
+};
+
+// Раскладка совпадает с ssbo2 в chunk_cull_compute.glsl.
+struct ChunkCullStats_ {
+    u32 visibleChunks   = 0;
+    u32 visibleVertices = 0;
+};
+
+// Свободный диапазон вертексов.
+struct ChunkVertexRange_ {
+    u32 first = 0;
+    u32 count = 0;
+};
+
+struct ChunkRenderer {
+    int maxChunks   = 0;
+    int maxVertices = 0;
+
+    int chunksCount   = 0;  // Занятые слоты.
+    int slotsCount    = 0;  // Слоты дальше никогда не занимались. По ним идёт отбор.
+    int verticesCount = 0;  // Занятые вертексы.
+
+    std::vector<ChunkMesh> meshes    = {};  // Копия буфера chunks.
+    std::vector<int>       freeSlots = {};  // Только меньше slotsCount.
+    // По возрастанию first, соседние склеены.
+    std::vector<ChunkVertexRange_> freeVertices = {};
+
+    unsigned int vertices = 0;  // SSBO ChunkVertex[maxVertices].
+    unsigned int chunks   = 0;  // SSBO ChunkMesh[maxChunks].
+    unsigned int commands = 0;  // SSBO ChunkDrawCommand_[maxChunks].
+    // Статистика читается через GPU_TIMER_LATENCY кадров, чтобы не ждать GPU.
+    unsigned int statsBuffers[GPU_TIMER_LATENCY] = {};
+    unsigned int vao                             = 0;
+
+    Shader       shader        = {};
+    unsigned int cullShader    = 0;
+    unsigned int pyramidShader = 0;
+
+    DepthPyramid pyramid               = {};
+    Matrix       pyramidViewProjection = {};
+    bool         pyramidValid          = false;
+
+    bool occlusionCulling = true;
+
+    int frame           = 0;
+    int visibleChunks   = 0;  // Последние готовые значения.
+    int visibleVertices = 0;
+};
+
+// First fit. Возвращает first или -1, если непрерывного места нет.
+i64 AllocateChunkVertices_(std::vector<ChunkVertexRange_>& free, u32 count) {
+    FOR_RANGE (int, i, (int)free.size()) {
+        auto& range = free[i];
+        if (range.count < count)
+            continue;
+
+        const u32 first = range.first;
+        range.first += count;
+        range.count -= count;
+        if (range.count == 0)
+            free.erase(free.begin() + i);
+        return first;
+    }
+    return -1;
+}
+
+void FreeChunkVertices_(std::vector<ChunkVertexRange_>& free, u32 first, u32 count) {
+    if (count == 0)
+        return;
+
+    int i = 0;
+    while ((i < (int)free.size()) && (free[i].first < first))
+        i++;
+    free.insert(free.begin() + i, {first, count});
+
+    // Склейка с правым, потом с левым соседом.
+    const bool last = (i + 1 == (int)free.size());
+    if (!last && (free[i].first + free[i].count == free[i + 1].first)) {
+        free[i].count += free[i + 1].count;
+        free.erase(free.begin() + i + 1);
+    }
+    if ((i > 0) && (free[i - 1].first + free[i - 1].count == free[i].first)) {
+        free[i - 1].count += free[i].count;
+        free.erase(free.begin() + i);
+    }
+}
+
+// Учёт слотов без GPU. Буферы остаются нулевыми - так его используют тесты.
+void InitChunkRendererSlots_(ChunkRenderer& renderer, int maxChunks, int maxVertices) {
+    renderer.maxChunks   = Max(1, maxChunks);
+    renderer.maxVertices = Max(1, maxVertices);
+
+    renderer.chunksCount   = 0;
+    renderer.slotsCount    = 0;
+    renderer.verticesCount = 0;
+
+    renderer.meshes.assign(renderer.maxChunks, {});
+    renderer.freeSlots.clear();
+    renderer.freeVertices = {{0, (u32)renderer.maxVertices}};
+}
+
+ChunkRenderer LoadChunkRenderer(int maxChunks, int maxVertices) {
+    ChunkRenderer renderer = {};
+    InitChunkRendererSlots_(renderer, maxChunks, maxVertices);
+
+    renderer.vertices = rlLoadShaderBuffer(
+        renderer.maxVertices * sizeof(ChunkVertex), nullptr, RL_DYNAMIC_DRAW
+    );
+    renderer.chunks = rlLoadShaderBuffer(
+        renderer.maxChunks * sizeof(ChunkMesh), renderer.meshes.data(), RL_DYNAMIC_DRAW
+    );
+    renderer.commands = rlLoadShaderBuffer(
+        renderer.maxChunks * sizeof(ChunkDrawCommand_), nullptr, RL_DYNAMIC_COPY
+    );
+    for (auto& buffer : renderer.statsBuffers)
+        buffer = rlLoadShaderBuffer(sizeof(ChunkCullStats_), nullptr, RL_DYNAMIC_READ);
+
+    renderer.vao    = rlLoadVertexArray();
+    renderer.shader = LoadCachedShader(
+        "resources/screens/gameplay/chunk_vertex.glsl",
+        "resources/screens/gameplay/chunk_fragment.glsl"
+    );
+    renderer.cullShader
+        = LoadCachedComputeShader("resources/screens/gameplay/chunk_cull_compute.glsl");
+    renderer.pyramidShader = LoadCachedComputeShader(
+        "resources/screens/gameplay/depth_pyramid_compute.glsl"
+    );
+
+    return renderer;
+}
+
+void UnloadChunkRenderer(ChunkRenderer& renderer) {
+    UnloadDepthPyramid(renderer.pyramid);
+
+    rlUnloadShaderProgram(renderer.pyramidShader);
+    rlUnloadShaderProgram(renderer.cullShader);
+    UnloadShader(renderer.shader);
+    rlUnloadVertexArray(renderer.vao);
+
+    for (auto buffer : renderer.statsBuffers)
+        rlUnloadShaderBuffer(buffer);
+    rlUnloadShaderBuffer(renderer.commands);
+    rlUnloadShaderBuffer(renderer.chunks);
+    rlUnloadShaderBuffer(renderer.vertices);
+
+    renderer = {};
+}
+
+// chunk - меш из BuildChunkMesh, first отсчитываются от начала vertices.
+// Возвращает слот или -1, если не хватило слотов или места в буфере вертексов.
+int AddChunk(
+    ChunkRenderer&                  renderer,
+    ChunkMesh                       chunk,
+    const std::vector<ChunkVertex>& vertices
+) {
+    const u32 count = ChunkMeshVerticesCount(chunk);
+    Assert(count > 0);
+    Assert(chunk.first[0] + count <= vertices.size());
+
+    int slot = -1;
+    if (!renderer.freeSlots.empty())
+        slot = renderer.freeSlots.back();
+    else if (renderer.slotsCount < renderer.maxChunks)
+        slot = renderer.slotsCount;
+    if (slot < 0)
+        return -1;
+
+    const auto first = AllocateChunkVertices_(renderer.freeVertices, count);
+    if (first < 0)
+        return -1;
+
+    if (slot == renderer.slotsCount)
+        renderer.slotsCount++;
+    else
+        renderer.freeSlots.pop_back();
+
+    // LOD-ы чанка лежат подряд, см. ChunkMeshes::vertices.
+    const u32 from = chunk.first[0];
+    FOR_RANGE (int, lod, CHUNK_LODS) {
+        chunk.first[lod] = chunk.first[lod] - from + (u32)first;
+    }
+
+    renderer.meshes[slot] = chunk;
+    renderer.chunksCount++;
+    renderer.verticesCount += (int)count;
+
+    if (renderer.vertices != 0) {
+        rlUpdateShaderBuffer(
+            renderer.vertices,
+            vertices.data() + from,
+            count * sizeof(ChunkVertex),
+            (u32)first * sizeof(ChunkVertex)
+        );
+        rlUpdateShaderBuffer(
+            renderer.chunks, &chunk, sizeof(ChunkMesh), slot * sizeof(ChunkMesh)
+        );
+        const auto uploaded = count * sizeof(ChunkVertex) + sizeof(ChunkMesh);
+        TelemetryAdd(TelemetryMetric::UPLOADED_BYTES, (float)uploaded);
+    }
+    return slot;
+}
+
+void RemoveChunk(ChunkRenderer& renderer, int slot) {
+    Assert(slot >= 0);
+    Assert(slot < renderer.slotsCount);
+
+    auto&     chunk = renderer.meshes[slot];
+    const u32 count = ChunkMeshVerticesCount(chunk);
+    Assert(count > 0);
+
+    FreeChunkVertices_(renderer.freeVertices, chunk.first[0], count);
+    renderer.freeSlots.push_back(slot);
+    renderer.chunksCount--;
+    renderer.verticesCount -= (int)count;
+
+    chunk = {};
+    if (renderer.chunks != 0) {
+        rlUpdateShaderBuffer(
+            renderer.chunks, &chunk, sizeof(ChunkMesh), slot * sizeof(ChunkMesh)
+        );
+        TelemetryAdd(TelemetryMetric::UPLOADED_BYTES, (float)sizeof(ChunkMesh));
+    }
+}
+
+void CullChunks_(ChunkRenderer& renderer, Matrix viewProjection, Vector3 cameraPosition) {
+    const auto statsBuffer = renderer.statsBuffers[renderer.frame % GPU_TIMER_LATENCY];
+
+    // Этот буфер писался GPU_TIMER_LATENCY кадров назад.
+    if (renderer.frame >= GPU_TIMER_LATENCY) {
+        ChunkCullStats_ stats = {};
+        rlReadShaderBuffer(statsBuffer, &stats, sizeof(stats), 0);
+        renderer.visibleChunks   = (int)stats.visibleChunks;
+        renderer.visibleVertices = (int)stats.visibleVertices;
+    }
+    renderer.frame++;
+
+    const int  pyramidValid  = renderer.occlusionCulling && renderer.pyramidValid;
+    const auto pyramidLevels = renderer.pyramid.levels;
+    const auto pyramidScale  = Vector2(
+        (float)renderer.pyramid.sourceWidth / 2.0f,
+        (float)renderer.pyramid.sourceHeight / 2.0f
+    );
+
+    rlEnableShader(renderer.cullShader);
+    rlBindShaderBuffer(renderer.chunks, 0);
+    rlBindShaderBuffer(renderer.commands, 1);
+    rlBindShaderBuffer(statsBuffer, 2);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(renderer.pyramid.texture);
+
+    rlSetUniform(1, &renderer.slotsCount, RL_SHADER_UNIFORM_INT, 1);
+    rlSetUniformMatrix(2, viewProjection);
+    rlSetUniformMatrix(3, renderer.pyramidViewProjection);
+    rlSetUniform(4, &pyramidValid, RL_SHADER_UNIFORM_INT, 1);
+    rlSetUniform(5, &pyramidScale, RL_SHADER_UNIFORM_VEC2, 1);
+    rlSetUniform(6, &pyramidLevels, RL_SHADER_UNIFORM_INT, 1);
+    rlSetUniform(7, &cameraPosition, RL_SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(8, &chunkLodDistance, RL_SHADER_UNIFORM_FLOAT, 1);
+
+    const int groups = CeilDivision(renderer.slotsCount, CHUNK_CULL_GROUP_SIZE);
+
+    // Обнуление команд прошлого кадра.
+    const int clearOnly = 1;
+    rlSetUniform(0, &clearOnly, RL_SHADER_UNIFORM_INT, 1);
+    rlComputeShaderDispatch(groups, 1, 1);
+    gl.memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    const int cull = 0;
+    rlSetUniform(0, &cull, RL_SHADER_UNIFORM_INT, 1);
+    rlComputeShaderDispatch(groups, 1, 1);
+    gl.memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    rlDisableTexture();
+    rlDisableShader();
+}
+
+// Зовётся внутри BeginMode3D. palette - SSBO, vec4 на цвет.
+// NOTE: рисует мимо батча rlgl, поэтому перед вызовом - rlDrawRenderBatchActive.
+void DrawChunks(
+    ChunkRenderer& renderer,
+    unsigned int   palette,
+    Matrix         viewProjection,
+    Vector3        cameraPosition
+) {
+    if (renderer.chunksCount == 0)
+        return;
+
+    CullChunks_(renderer, viewProjection, cameraPosition);
+
+    rlEnableShader(renderer.shader.id);
+    rlSetUniformMatrix(0, viewProjection);
+    rlSetUniform(1, &cameraPosition, RL_SHADER_UNIFORM_VEC3, 1);
+    rlBindShaderBuffer(renderer.vertices, 0);
+    rlBindShaderBuffer(palette, 1);
+    rlEnableVertexArray(renderer.vao);
+
+    gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.commands);
+    gl.multiDrawArraysIndirect(GL_TRIANGLES, nullptr, renderer.slotsCount, 0);
+    gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    TelemetryAdd(TelemetryMetric::DRAW_CALLS, 1);
+
+    rlDisableVertexArray();
+    rlDisableShader();
+}
+
+// Зовётся после отрисовки всего, что закрывает обзор (мира),
+// с буфером глубины этого кадра. Пирамида пригодится в следующем кадре.
+void UpdateChunkOcclusion(
+    ChunkRenderer& renderer,
+    unsigned int   depthTexture,
+    int            width,
+    int            height,
+    Matrix         viewProjection
+) {
+    if (!renderer.occlusionCulling) {
+        renderer.pyramidValid = false;
+        return;
+    }
+
+    rlDrawRenderBatchActive();
+    BuildDepthPyramid(
+        renderer.pyramid, renderer.pyramidShader, depthTexture, width, height
+    );
+
+    renderer.pyramidViewProjection = viewProjection;
+    renderer.pyramidValid          = true;
+}
+
+TEST_CASE ("ChunkRenderer") {
+    SUBCASE ("Vertex ranges") {
+        std::vector<ChunkVertexRange_> free = {{0, 100}};
+
+        Assert(AllocateChunkVertices_(free, 30) == 0);
+        Assert(AllocateChunkVertices_(free, 30) == 30);
+        Assert(AllocateChunkVertices_(free, 30) == 60);
+        Assert(AllocateChunkVertices_(free, 30) == -1);
+
+        // Свободны 0..30 и 60..100, но 50 подряд нет.
+        FreeChunkVertices_(free, 0, 30);
+        FreeChunkVertices_(free, 60, 30);
+        Assert(free.size() == 2);
+        Assert(AllocateChunkVertices_(free, 50) == -1);
+
+        FreeChunkVertices_(free, 30, 30);
+        Assert(free.size() == 1);
+        Assert(free[0].first == 0);
+        Assert(free[0].count == 100);
+    }
+
+    SUBCASE ("Slots") {
+        ChunkRenderer renderer = {};
+        InitChunkRendererSlots_(renderer, 2, 100);
+
+        std::vector<ChunkVertex> vertices(60);
+        ChunkMesh                chunk = {};
+        chunk.first[0]                 = 10;
+        chunk.count[0]                 = 30;
+        chunk.first[1]                 = 40;
+        chunk.count[1]                 = 10;
+
+        Assert(AddChunk(renderer, chunk, vertices) == 0);
+        Assert(AddChunk(renderer, chunk, vertices) == 1);
+        Assert(AddChunk(renderer, chunk, vertices) == -1);
+        Assert(renderer.meshes[1].first[0] == 40);
+        Assert(renderer.meshes[1].first[1] == 70);
+        Assert(renderer.verticesCount == 80);
+
+        RemoveChunk(renderer, 0);
+        Assert(renderer.chunksCount == 1);
+        Assert(renderer.meshes[0].count[0] == 0);
+        Assert(AddChunk(renderer, chunk, vertices) == 0);
+        Assert(renderer.slotsCount == 2);
+    }
+}
@@ -0,0 +1,787 @@
+//----------------------------------------------------------------------------------
+// Chunked Level.
+//----------------------------------------------------------------------------------
+// Уровень, порезанный на чанки (см. chunk_mesh.cpp), для стриминга.
+// Каждый чанк читается и распаковывается отдельно от остальных.
+//
+// Формат файла (little endian):
+//
+// u32                CHUNKED_LEVEL_MAGIC
+// i32                chunksCount
+// ChunkedLevelEntry  entries[chunksCount]
+// u8                 data[]  - клетки чанков, см. CompressChunkCells_
+//
+// Хранятся только непустые чанки. Клеток CHUNK_CELLS_COUNT - вместе со слоем
+// соседей, поэтому меш чанка строится без соседних чанков.
+const u32 CHUNKED_LEVEL_MAGIC = 0x314B4843;  // "CHK1".
+
+struct ChunkedLevelHeader_ {
+    u32 magic       = CHUNKED_LEVEL_MAGIC;
+    int chunksCount = 0;
+};
+static_assert(sizeof(ChunkedLevelHeader_) == 8);
+
+struct ChunkedLevelEntry {
+    Vector3Int coords = {};  // В чанках.
+    u32        offset = 0;   // От начала файла.
+    u32        size   = 0;
+};
+static_assert(sizeof(ChunkedLevelEntry) == 20);
+
+struct ChunkedLevel {
+    std::vector<ChunkedLevelEntry> entries = {};
+
+    // Индексы entries на сетке чанков (-1 - чанка нет). Сетка - AABB всех чанков.
+    Vector3Int       coordsMin  = {};
+    Vector3Int       coordsSize = {};
+    std::vector<int> indices    = {};
+
+    // Клетки лежат либо в памяти целиком (view), либо читаются из файла по запросу.
+    // view указывает в data или в чужую память (LoadChunkedLevelFromView).
+    const u8*       view = nullptr;
+    std::vector<u8> data = {};
+    FILE*           file = nullptr;
+};
+
+// RLE: пары (длина 1..255, значение). Уровень - это в основном пустота
+// и однородные куски, чанк ужимается в десятки раз.
+void CompressChunkCells_(const u8* cells, std::vector<u8>& out) {
+    int i = 0;
+    while (i < CHUNK_CELLS_COUNT) {
+        const u8 value = cells[i];
+
+        int run = 1;
+        while ((i + run < CHUNK_CELLS_COUNT) && (run < 255) && (cells[i + run] == value))
+            run++;
+
+        out.push_back((u8)run);
+        out.push_back(value);
+        i += run;
+    }
+}
+
+// Возвращает false, если данные битые.
+bool DecompressChunkCells_(const u8* data, int size, u8* cells) {
+    if (size % 2 != 0)
+        return false;
+
+    int count = 0;
+    for (int i = 0; i < size; i += 2) {
+        const int run = (unsigned char)data[i];
+        if ((run == 0) || (count + run > CHUNK_CELLS_COUNT))
+            return false;
+
+        memset(cells + count, data[i + 1], run);
+        count += run;
+    }
+    return count == CHUNK_CELLS_COUNT;
+}
+
+std::vector<u8> SerializeChunkedLevel(const BrickMap& map) {
+    std::vector<ChunkedLevelEntry> entries;
+    std::vector<u8>                cellsData;
+
+    if (map.bricks != nullptr) {
+        Vector3Int from = {};
+        Vector3Int to   = {};
+        GetBrickMapChunkRange(map, from, to);
+
+        u8 cells[CHUNK_CELLS_COUNT];
+
+        for (int cz = from.z; cz < to.z; cz += CHUNK_SIZE) {
+            for (int cy = from.y; cy < to.y; cy += CHUNK_SIZE) {
+                for (int cx = from.x; cx < to.x; cx += CHUNK_SIZE) {
+                    if (!GatherChunkCells(map, {cx, cy, cz}, cells))
+                        continue;
+
+                    ChunkedLevelEntry entry = {};
+                    entry.coords = {cx / CHUNK_SIZE, cy / CHUNK_SIZE, cz / CHUNK_SIZE};
+                    entry.offset = (u32)cellsData.size();
+                    CompressChunkCells_(cells, cellsData);
+                    entry.size = (u32)cellsData.size() - entry.offset;
+
+                    entries.push_back(entry);
+                }
+            }
+        }
+    }
+
+    ChunkedLevelHeader_ header = {};
+    header.chunksCount         = (int)entries.size();
+
+    const int entriesSize = (int)(entries.size() * sizeof(ChunkedLevelEntry));
+    const int dataOffset  = (int)sizeof(header) + entriesSize;
+    for (auto& entry : entries)
+        entry.offset += dataOffset;
+
+    std::vector<u8> result(dataOffset + cellsData.size());
+    memcpy(result.data(), &header, sizeof(header));
+    if (entriesSize > 0)
+        memcpy(result.data() + sizeof(header), entries.data(), entriesSize);
+    if (!cellsData.empty())
+        memcpy(result.data() + dataOffset, cellsData.data(), cellsData.size());
+
+    return result;
+}
+
+// data - начало файла, где лежат заголовок и entries. totalSize - размер всего файла.
+bool ParseChunkedLevelIndex_(
+    const u8*     data,
+    i64           dataSize,
+    i64           totalSize,
+    ChunkedLevel& level
+) {
+    ChunkedLevelHeader_ header = {};
+    if (dataSize < (i64)sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+
+    if ((header.magic != CHUNKED_LEVEL_MAGIC) || (header.chunksCount < 0))
+        return false;
+
+    const i64 entriesSize = (i64)header.chunksCount * (i64)sizeof(ChunkedLevelEntry);
+    if ((i64)sizeof(header) + entriesSize > dataSize)
+        return false;
+
+    level.entries.resize(header.chunksCount);
+    if (entriesSize > 0)
+        memcpy(level.entries.data(), data + sizeof(header), entriesSize);
+
+    Vector3Int coordsMax = {-1, -1, -1};
+    level.coordsMin      = {};
+    FOR_RANGE (int, i, header.chunksCount) {
+        const auto& entry = level.entries[i];
+        if ((i64)entry.offset + entry.size > totalSize)
+            return false;
+
+        const auto& c = entry.coords;
+        if (i == 0) {
+            level.coordsMin = c;
+            coordsMax       = c;
+        }
+        level.coordsMin = {
+            Min(level.coordsMin.x, c.x),
+            Min(level.coordsMin.y, c.y),
+            Min(level.coordsMin.z, c.z),
+        };
+        coordsMax = {Max(coordsMax.x, c.x), Max(coordsMax.y, c.y), Max(coordsMax.z, c.z)};
+    }
+
+    // Координаты чанков ограничены CHUNK_COORD_BITS, сетка не бывает огромной.
+    const int coordsLimit = 2 * (CHUNK_COORD_MAX + 1);
+    level.coordsSize      = {
+        coordsMax.x - level.coordsMin.x + 1,
+        coordsMax.y - level.coordsMin.y + 1,
+        coordsMax.z - level.coordsMin.z + 1,
+    };
+    if (Max(level.coordsSize.x, Max(level.coordsSize.y, level.coordsSize.z))
+        > coordsLimit)
+        return false;
+
+    const auto& size = level.coordsSize;
+    level.indices.assign((size_t)size.x * size.y * size.z, -1);
+    FOR_RANGE (int, i, header.chunksCount) {
+        const auto& c = level.entries[i].coords;
+        const int   x = c.x - level.coordsMin.x;
+        const int   y = c.y - level.coordsMin.y;
+        const int   z = c.z - level.coordsMin.z;
+        level.indices[((size_t)z * size.y + y) * size.x + x] = i;
+    }
+    return true;
+}
+
+// Уровень целиком в памяти. Возвращает false, если данные битые.
+bool LoadChunkedLevelFromMemory(std::vector<u8> data, ChunkedLevel& out) {
+    ChunkedLevel level = {};
+    if (!ParseChunkedLevelIndex_(data.data(), data.size(), data.size(), level))
+        return false;
+
+    level.data = std::move(data);
+    level.view = level.data.data();
+    out        = std::move(level);
+    return true;
+}
+
+// Уровень в чужой памяти (например, в отображённом архиве, см. ResourceView),
+// без копии. view должен жить до UnloadChunkedLevel.
+bool LoadChunkedLevelFromView(const u8* view, int size, ChunkedLevel& out) {
+    ChunkedLevel level = {};
+    if (!ParseChunkedLevelIndex_(view, size, size, level))
+        return false;
+
+    level.view = view;
+    out        = std::move(level);
+    return true;
+}
+
+// Читает только заголовок и entries, клетки - по запросу (ReadChunkedLevelCells).
+// Файл остаётся открытым до UnloadChunkedLevel.
+bool LoadChunkedLevel(const char* path, ChunkedLevel& out) {
+    std::error_code error;
+    const auto      totalSize = (i64)std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    ChunkedLevelHeader_ header = {};
+    std::vector<u8>     index(sizeof(header));
+
+    bool ok = fread(index.data(), sizeof(header), 1, file) == 1;
+    if (ok) {
+        memcpy(&header, index.data(), sizeof(header));
+        ok = (header.chunksCount >= 0)
+             && (header.chunksCount <= totalSize / (i64)sizeof(ChunkedLevelEntry));
+    }
+    if (ok) {
+        const auto entriesSize = (size_t)header.chunksCount * sizeof(ChunkedLevelEntry);
+        index.resize(sizeof(header) + entriesSize);
+        ok = (entriesSize == 0)
+             || (fread(index.data() + sizeof(header), entriesSize, 1, file) == 1);
+    }
+
+    ChunkedLevel level = {};
+    if (ok)
+        ok = ParseChunkedLevelIndex_(index.data(), index.size(), totalSize, level);
+    if (!ok) {
+        fclose(file);
+        return false;
+    }
+
+    level.file = file;
+    out        = std::move(level);
+    return true;
+}
+
+// Сколько памяти занимают entries, indices и клетки, если они в памяти (не view).
+i64 ChunkedLevelMemorySize(const ChunkedLevel& level) {
+    return (i64)level.data.capacity()
+           + (i64)(level.entries.capacity() * sizeof(ChunkedLevelEntry))
+           + (i64)(level.indices.capacity() * sizeof(int));
+}
+
+void UnloadChunkedLevel(ChunkedLevel& level) {
+    if (level.file != nullptr)
+        fclose(level.file);
+    level = {};
+}
+
+// Индекс в entries или -1.
+int ChunkedLevelFind(const ChunkedLevel& level, Vector3Int coords) {
+    const auto& size = level.coordsSize;
+
+    const int x = coords.x - level.coordsMin.x;
+    const int y = coords.y - level.coordsMin.y;
+    const int z = coords.z - level.coordsMin.z;
+    if ((x < 0) || (y < 0) || (z < 0) || (x >= size.x) || (y >= size.y)
+        || (z >= size.z))
+        return -1;
+
+    return level.indices[((size_t)z * size.y + y) * size.x + x];
+}
+
+// Клетки чанка (CHUNK_CELLS_COUNT) в cells. scratch - под сжатые данные.
+// NOTE: файл читается без блокировок - звать только из одного потока.
+bool ReadChunkedLevelCells(
+    ChunkedLevel&    level,
+    int              index,
+    std::vector<u8>& scratch,
+    u8*              cells
+) {
+    const auto& entry = level.entries[index];
+
+    if (level.file == nullptr) {
+        return DecompressChunkCells_(level.view + entry.offset, (int)entry.size, cells);
+    }
+
+    scratch.resize(Max(1, (int)entry.size));
+    if (fseek(level.file, (long)entry.offset, SEEK_SET) != 0)
+        return false;
+    if (fread(scratch.data(), 1, entry.size, level.file) != entry.size)
+        return false;
+    return DecompressChunkCells_(scratch.data(), (int)entry.size, cells);
+}
+
+//----------------------------------------------------------------------------------
+// Chunk Streaming.
+//----------------------------------------------------------------------------------
+// Держит в ChunkRenderer только чанки вокруг игрока.
+//
+// Область вокруг игрока - капсула: отрезок от position до точки упреждения
+// position + velocity * lookaheadTime, радиус loadRadius. На 28 м/с игрок
+// пролетает чанк за полсекунды - без упреждения он влетал бы в пустоту.
+//
+// Каждый кадр (UpdateChunkStreaming, главный поток):
+// 1. Выгружаются чанки дальше unloadRadius от отрезка. unloadRadius > loadRadius -
+//    гистерезис, иначе чанк на границе грузился бы и выгружался каждые пару кадров.
+// 2. Если поток закончил пачку - её меши заливаются в ChunkRenderer.
+// 3. Потоку отдаётся новая пачка: недостающие чанки в капсуле,
+//    ближайшие к отрезку - первыми.
+//
+// Поток читает, распаковывает и строит меши. GL трогает только главный поток.
+//
+// Бюджет памяти (memoryBudget) - буферы ChunkRenderer, они заводятся сразу
+// на весь бюджет (см. ChunkStreamerMaxVertices). Не влезло - выгружаются
+// самые дальние чанки, если они дальше нового.
+//
+// Стримятся только меши. Коллизии, запросы к миру и частицы читают BrickMap
+// всего уровня: боты летают по всей карте, и их физика не должна зависеть
+// от того, где игрок. BrickMap хранит клетки только у кирпичей с поверхностью
+// (см. brick_map.cpp) и на порядки меньше мешей. Её память и индекс
+// ChunkedLevel - pinnedBytes - вычитаются из бюджета до буферов ChunkRenderer.
+const int CHUNK_SLOT_UNLOADED_ = -1;
+const int CHUNK_SLOT_LOADING_  = -2;
+const int CHUNK_SLOT_EMPTY_    = -3;  // Загружен, но граней нет. В ChunkRenderer его нет.
+
+struct ChunkStreamResult_ {
+    int       index  = 0;  // В ChunkedLevel::entries.
+    bool      broken = false;
+    bool      empty  = true;
+    ChunkMesh mesh   = {};  // first отсчитываются от ChunkStreamBatch_::vertices.
+};
+
+// Пока поток работает, главный поток пачку не трогает.
+struct ChunkStreamBatch_ {
+    std::vector<int>                requests = {};  // Индексы в ChunkedLevel::entries.
+    std::vector<ChunkStreamResult_> results  = {};
+    std::vector<ChunkVertex>        vertices = {};
+    std::vector<u8>                 scratch  = {};
+};
+
+struct ChunkStreamCandidate_ {
+    float score = 0;
+    int   index = 0;  // В ChunkedLevel::entries.
+};
+
+struct ChunkStreamer {
+    ChunkedLevel level = {};
+
+    float loadRadius    = 96.0f;
+    float unloadRadius  = 128.0f;
+    float lookaheadTime = 1.0f;      // Секунды.
+    int   memoryBudget  = 64 << 20;  // Байты.
+    int   batchSize     = 16;        // Чанков за одну задачу потока.
+
+    // Байты уровня, которые не стримятся (BrickMap на CPU и GPU). Без level -
+    // его ChunkStreamerMaxVertices считает сам.
+    i64 pinnedBytes = 0;
+
+    // По level.entries: слот в ChunkRenderer или CHUNK_SLOT_*.
+    std::vector<int> slots    = {};
+    std::vector<int> resident = {};  // Индексы чанков со слотом или CHUNK_SLOT_EMPTY_.
+
+    // Кандидаты на загрузку в UpdateChunkStreaming. Память заводится
+    // в StartChunkStreamer на все чанки - кадр ничего не аллоцирует.
+    std::vector<ChunkStreamCandidate_> candidates = {};
+
+    // Бюджет кончился на чанке с такой оценкой. Пока что-нибудь не выгрузится,
+    // чанки не ближе этого не запрашиваются - иначе читались бы каждый кадр заново.
+    float budgetScore = floatInf;
+
+    WorkerThread      worker = {};
+    ChunkStreamBatch_ batch  = {};
+
+    int loadedChunks   = 0;  // За всё время.
+    int unloadedChunks = 0;
+};
+
+// Сколько вертексов ChunkRenderer-а влезает в бюджет после pinnedBytes,
+// индекса уровня и мешей и команд на каждый чанк уровня.
+int ChunkStreamerMaxVertices(const ChunkStreamer& streamer) {
+    // ChunkMesh - на GPU и копия на CPU.
+    const i64 perChunk = 2 * sizeof(ChunkMesh) + sizeof(ChunkDrawCommand_);
+    const i64 chunks   = (i64)streamer.level.entries.size();
+    const i64 pinned   = streamer.pinnedBytes + ChunkedLevelMemorySize(streamer.level);
+    const i64 rest     = streamer.memoryBudget - pinned - perChunk * chunks;
+    return (int)Max((i64)0, rest / (i64)sizeof(ChunkVertex));
+}
+
+void ChunkStreamJob_(void* userData) {
+    ALLOCATION_ZONE("chunk stream job");
+    auto& streamer = *(ChunkStreamer*)userData;
+    auto& batch    = streamer.batch;
+
+    batch.results.clear();
+    batch.vertices.clear();
+
+    u8 cells[CHUNK_CELLS_COUNT];
+
+    for (int index : batch.requests) {
+        ChunkStreamResult_ result = {};
+        result.index              = index;
+
+        if (ReadChunkedLevelCells(streamer.level, index, batch.scratch, cells)) {
+            const auto& c      = streamer.level.entries[index].coords;
+            const auto  origin = Vector3Int{
+                c.x * CHUNK_SIZE, c.y * CHUNK_SIZE, c.z * CHUNK_SIZE
+            };
+            result.empty = !BuildChunkMesh(cells, origin, batch.vertices, result.mesh);
+        }
+        else
+            result.broken = true;
+
+        batch.results.push_back(result);
+    }
+}
+
+// level уже загружен.
+void StartChunkStreamer(ChunkStreamer& streamer) {
+    streamer.slots.assign(streamer.level.entries.size(), CHUNK_SLOT_UNLOADED_);
+    streamer.resident.clear();
+    streamer.resident.reserve(streamer.level.entries.size());
+    streamer.candidates.clear();
+    streamer.candidates.reserve(streamer.level.entries.size());
+    streamer.batch.requests.reserve(streamer.batchSize);
+    streamer.batch.results.reserve(streamer.batchSize);
+    streamer.budgetScore = floatInf;
+    StartWorkerThread(streamer.worker, ChunkStreamJob_, &streamer);
+}
+
+void StopChunkStreamer(ChunkStreamer& streamer) {
+    StopWorkerThread(streamer.worker);
+    UnloadChunkedLevel(streamer.level);
+
+    streamer.slots.clear();
+    streamer.resident.clear();
+    streamer.candidates.clear();
+    streamer.batch = {};
+}
+
+float DistanceToSegment_(Vector3 point, Vector3 a, Vector3 b) {
+    const auto  ab        = b - a;
+    const float lengthSqr = Vector3LengthSqr(ab);
+
+    float t = 0;
+    if (lengthSqr > 0)
+        t = Clamp(Vector3DotProduct(point - a, ab) / lengthSqr, 0, 1);
+    return Vector3Distance(point, a + ab * t);
+}
+
+// Меньше - важнее.
+float ChunkStreamScore_(const ChunkedLevelEntry& entry, Vector3 position, Vector3 ahead) {
+    const auto center = (ToVector3(entry.coords) + ToVector3(0.5f)) * (float)CHUNK_SIZE;
+    return DistanceToSegment_(center, position, ahead);
+}
+
+void UnloadStreamedChunk_(ChunkStreamer& streamer, ChunkRenderer& renderer, int i) {
+    const int index = streamer.resident[i];
+    auto&     slot  = streamer.slots[index];
+    if (slot >= 0)
+        RemoveChunk(renderer, slot);
+    slot = CHUNK_SLOT_UNLOADED_;
+
+    streamer.resident[i] = streamer.resident.back();
+    streamer.resident.pop_back();
+
+    streamer.unloadedChunks++;
+    streamer.budgetScore = floatInf;
+}
+
+// Выгружает самый дальний чанк со слотом, если он дальше score.
+bool EvictFarthestChunk_(
+    ChunkStreamer& streamer,
+    ChunkRenderer& renderer,
+    Vector3        position,
+    Vector3        ahead,
+    float          score
+) {
+    int   farthest      = -1;
+    float farthestScore = score;
+    FOR_RANGE (int, i, (int)streamer.resident.size()) {
+        const int index = streamer.resident[i];
+        if (streamer.slots[index] < 0)
+            continue;
+
+        const float s = ChunkStreamScore_(streamer.level.entries[index], position, ahead);
+        if (s > farthestScore) {
+            farthest      = i;
+            farthestScore = s;
+        }
+    }
+
+    if (farthest < 0)
+        return false;
+    UnloadStreamedChunk_(streamer, renderer, farthest);
+    return true;
+}
+
+// Зовётся раз в кадр на главном потоке.
+void UpdateChunkStreaming(
+    ChunkStreamer& streamer,
+    ChunkRenderer& renderer,
+    Vector3        position,
+    Vector3        velocity
+) {
+    ALLOCATION_ZONE("chunk streaming");
+    if (streamer.slots.empty())
+        return;
+
+    const auto& level = streamer.level;
+    const auto  ahead = position + velocity * streamer.lookaheadTime;
+
+    auto score = [&](int index) {
+        return ChunkStreamScore_(level.entries[index], position, ahead);
+    };
+
+    {  // Выгрузка.
+        int i = 0;
+        while (i < (int)streamer.resident.size()) {
+            if (score(streamer.resident[i]) > streamer.unloadRadius)
+                UnloadStreamedChunk_(streamer, renderer, i);
+            else
+                i++;
+        }
+    }
+
+    if (!WorkerThreadPoll(streamer.worker))
+        return;
+
+    auto& batch = streamer.batch;
+
+    // Готовая пачка.
+    for (const auto& result : batch.results) {
+        const int index = result.index;
+        auto&     slot  = streamer.slots[index];
+        Assert(slot == CHUNK_SLOT_LOADING_);
+
+        if (result.broken) {
+            const auto& c = level.entries[index].coords;
+            TraceLog(LOG_WARNING, "Broken chunk %d, %d, %d", c.x, c.y, c.z);
+        }
+
+        const float s = score(index);
+        if (s > streamer.unloadRadius) {
+            // Пока читали, игрок улетел.
+            slot = CHUNK_SLOT_UNLOADED_;
+            continue;
+        }
+
+        if (result.empty) {
+            slot = CHUNK_SLOT_EMPTY_;
+            streamer.resident.push_back(index);
+            continue;
+        }
+
+        int added = AddChunk(renderer, result.mesh, batch.vertices);
+        while ((added < 0) && EvictFarthestChunk_(streamer, renderer, position, ahead, s))
+            added = AddChunk(renderer, result.mesh, batch.vertices);
+
+        if (added < 0) {
+            slot                 = CHUNK_SLOT_UNLOADED_;
+            streamer.budgetScore = Min(streamer.budgetScore, s);
+            continue;
+        }
+
+        slot = added;
+        streamer.resident.push_back(index);
+        streamer.loadedChunks++;
+    }
+    batch.results.clear();
+    batch.requests.clear();
+
+    // Новая пачка. Перебираются чанки в AABB капсулы.
+    const float radius = streamer.loadRadius;
+
+    auto toChunk = [](float v) {
+        return (int)floorf(v / (float)CHUNK_SIZE);
+    };
+    const auto lo = Vector3Min(position, ahead) - ToVector3(radius);
+    const auto hi = Vector3Max(position, ahead) + ToVector3(radius);
+
+    const auto& coordsMin = level.coordsMin;
+    const auto& size      = level.coordsSize;
+    const int   fromX     = Max(toChunk(lo.x), coordsMin.x);
+    const int   fromY     = Max(toChunk(lo.y), coordsMin.y);
+    const int   fromZ     = Max(toChunk(lo.z), coordsMin.z);
+    const int   toX       = Min(toChunk(hi.x), coordsMin.x + size.x - 1);
+    const int   toY       = Min(toChunk(hi.y), coordsMin.y + size.y - 1);
+    const int   toZ       = Min(toChunk(hi.z), coordsMin.z + size.z - 1);
+
+    auto& candidates = streamer.candidates;
+    candidates.clear();
+
+    for (int z = fromZ; z <= toZ; z++) {
+        for (int y = fromY; y <= toY; y++) {
+            for (int x = fromX; x <= toX; x++) {
+                const int index = ChunkedLevelFind(level, {x, y, z});
+                if ((index < 0) || (streamer.slots[index] != CHUNK_SLOT_UNLOADED_))
+                    continue;
+
+                const float s = score(index);
+                if ((s <= radius) && (s < streamer.budgetScore))
+                    candidates.push_back({s, index});
+            }
+        }
+    }
+    if (candidates.empty())
+        return;
+
+    const int count = Min((int)candidates.size(), streamer.batchSize);
+    std::partial_sort(
+        candidates.begin(),
+        candidates.begin() + count,
+        candidates.end(),
+        [](const ChunkStreamCandidate_& a, const ChunkStreamCandidate_& b) {
+            return a.score < b.score;
+        }
+    );
+
+    FOR_RANGE (int, i, count) {
+        const int index = candidates[i].index;
+        streamer.slots[index] = CHUNK_SLOT_LOADING_;
+        batch.requests.push_back(index);
+    }
+    WorkerThreadKick(streamer.worker);
+}
+
+TEST_CASE ("ChunkStreaming") {
+    // По кубу в каждом из 10 чанков вдоль x.
+    std::vector<CubeVoxel> cubes;
+    FOR_RANGE (int, i, 10) {
+        cubes.push_back({{i * CHUNK_SIZE + 3, 4, 5}, i % 3});
+    }
+    auto map = MakeBrickMap(cubes.data(), (int)cubes.size());
+    defer {
+        FreeBrickMap(map);
+    };
+
+    ChunkedLevel level = {};
+    Assert(LoadChunkedLevelFromMemory(SerializeChunkedLevel(map), level));
+    Assert(level.entries.size() == 10);
+
+    SUBCASE ("Cells round trip") {
+        u8              cells[CHUNK_CELLS_COUNT];
+        u8              read[CHUNK_CELLS_COUNT];
+        std::vector<u8> scratch;
+
+        FOR_RANGE (int, i, 10) {
+            const int index = ChunkedLevelFind(level, {i, 0, 0});
+            Assert(index >= 0);
+            Assert(GatherChunkCells(map, {i * CHUNK_SIZE, 0, 0}, cells));
+            Assert(ReadChunkedLevelCells(level, index, scratch, read));
+            Assert(memcmp(cells, read, sizeof(cells)) == 0);
+        }
+        Assert(ChunkedLevelFind(level, {10, 0, 0}) == -1);
+        Assert(ChunkedLevelFind(level, {0, 1, 0}) == -1);
+
+        // Из чужой памяти - те же клетки.
+        const auto   data = SerializeChunkedLevel(map);
+        ChunkedLevel view = {};
+        Assert(LoadChunkedLevelFromView(data.data(), (int)data.size(), view));
+        const int last = ChunkedLevelFind(view, {9, 0, 0});
+        Assert(ReadChunkedLevelCells(view, last, scratch, read));
+        Assert(memcmp(cells, read, sizeof(cells)) == 0);
+
+        // Почти пустой чанк сжимается в десятки раз.
+        Assert(level.entries[0].size * 50 < CHUNK_CELLS_COUNT);
+
+        // Битые данные.
+        std::vector<u8> packed;
+        CompressChunkCells_(cells, packed);
+        Assert(!DecompressChunkCells_(packed.data(), (int)packed.size() - 2, read));
+        packed[0] = 0;
+        Assert(!DecompressChunkCells_(packed.data(), (int)packed.size(), read));
+
+        auto brokenData = SerializeChunkedLevel(map);
+        brokenData[0]   = 0;
+        ChunkedLevel broken = {};
+        Assert_False(LoadChunkedLevelFromMemory(brokenData, broken));
+    }
+
+    SUBCASE ("Budget") {
+        ChunkStreamer streamer = {};
+        streamer.level         = std::move(level);
+        streamer.memoryBudget  = 1 << 20;
+
+        // Индекс уровня уже в бюджете.
+        const int full    = ChunkStreamerMaxVertices(streamer);
+        const i64 perMesh = 10 * (2 * sizeof(ChunkMesh) + sizeof(ChunkDrawCommand_));
+        Assert(
+            full
+            == (int)(((1 << 20) - perMesh - ChunkedLevelMemorySize(streamer.level))
+                     / (i64)sizeof(ChunkVertex))
+        );
+
+        // BrickMap вычитается из того же бюджета.
+        streamer.pinnedBytes = 1000 * sizeof(ChunkVertex);
+        Assert(ChunkStreamerMaxVertices(streamer) == full - 1000);
+
+        streamer.pinnedBytes = 2 << 20;
+        Assert(ChunkStreamerMaxVertices(streamer) == 0);
+
+        UnloadChunkedLevel(streamer.level);
+    }
+
+    SUBCASE ("Streaming") {
+        ChunkStreamer streamer = {};
+        streamer.level         = std::move(level);
+        streamer.loadRadius    = 40;
+        streamer.unloadRadius  = 60;
+        streamer.batchSize     = 2;
+
+        ChunkRenderer renderer = {};
+        InitChunkRendererSlots_(renderer, 10, 10000);
+
+        StartChunkStreamer(streamer);
+
+        auto settle = [&](Vector3 position, Vector3 velocity) {
+            FOR_RANGE (int, i, 20) {
+                UpdateChunkStreaming(streamer, renderer, position, velocity);
+                WorkerThreadWait(streamer.worker);
+            }
+        };
+        auto loaded = [&](int x) {
+            return streamer.slots[ChunkedLevelFind(streamer.level, {x, 0, 0})] >= 0;
+        };
+
+        {  // Кадры с кандидатами и готовыми пачками ничего не аллоцируют.
+            auto& t = allocationTracker;
+            EndAllocationFrame(t);
+            FOR_RANGE (int, i, 2) {
+                UpdateChunkStreaming(streamer, renderer, {8, 8, 8}, {});
+                WorkerThreadWait(streamer.worker);
+            }
+            EndAllocationFrame(t);
+
+            int zone = -1;
+            FOR_RANGE (int, i, Min(t.zonesCount.load(), ALLOCATION_ZONES_MAX)) {
+                const auto name = t.zoneNames[i];
+                if ((name != nullptr) && (strcmp(name, "chunk streaming") == 0))
+                    zone = i;
+            }
+            Assert(zone > 0);
+            Assert(t.zonesLastFrame[zone].allocations == 0);
+            Assert(renderer.chunksCount == 2);
+        }
+
+        // Центры чанков - через 16 от 8. В радиусе 40 - чанки 0, 1, 2.
+        settle({8, 8, 8}, {});
+        Assert(renderer.chunksCount == 3);
+        Assert((loaded(0) && loaded(2) && !loaded(3)));
+
+        // Гистерезис: сдвинулись на 16 - чанк 0 (теперь в 32) остаётся.
+        settle({24, 8, 8}, {});
+        Assert((loaded(0) && loaded(3)));
+
+        settle({150, 8, 8}, {});
+        Assert((!loaded(0) && !loaded(5) && loaded(7) && loaded(9)));
+
+        // Упреждение: летим к началу - грузится то, что впереди.
+        settle({150, 8, 8}, {-80, 0, 0});
+        Assert((loaded(3) && loaded(9)));
+
+        // Бюджет: места на 2 чанка - остаются ближайшие.
+        settle({1000, 8, 8}, {});
+        Assert(renderer.chunksCount == 0);
+        InitChunkRendererSlots_(renderer, 10, 2 * 36 * CHUNK_LODS);
+        settle({8, 8, 8}, {});
+        Assert(renderer.chunksCount == 2);
+        Assert((loaded(0) && loaded(1) && !loaded(2)));
+
+        StopChunkStreamer(streamer);
+    }
+
+    UnloadChunkedLevel(level);
+}
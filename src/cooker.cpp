@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "main.cpp"
+
+//----------------------------------------------------------------------------------
+// Cooker.
+//----------------------------------------------------------------------------------
+// Готовит ассеты игры, см. cooking.cpp. CMake запускает его один раз целью cook,
+// а потом для каждой цели с --pack-only - только упаковать её архив.
+//
+// cooker <src> <cooked> [--pack <archive>] [--pack-only] [--force] [--threads N]
+//
+// <src>    - папка с resources и assets (src проекта).
+// <cooked> - куда класть результат. Это же кеш для следующих запусков.
+// archive  - resources.pak рядом с исполняемым файлом игры, см. archive.cpp.
+//            Пересобирается, только если манифест новее архива.
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf(
+            "Usage: cooker <src> <cooked> [--pack <archive>] [--pack-only] [--force] "
+            "[--threads N]\n"
+        );
+        return 1;
+    }
+
+    bool        force        = false;
+    bool        packOnly     = false;
+    int         threadsCount = 0;
+    const char* archivePath  = nullptr;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (strcmp(argv[i], "--pack-only") == 0)
+            packOnly = true;
+        else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+            threadsCount = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--pack") == 0) && (i + 1 < argc))
+            archivePath = argv[++i];
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    if (!packOnly) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto stats = CookAssets(argv[1], argv[2], threadsCount, force);
+        const auto end   = std::chrono::steady_clock::now();
+
+        printf(
+            "Cooked %d, up to date %d, failed %d in %.2f s\n",
+            stats.cooked,
+            stats.skipped,
+            stats.failed,
+            std::chrono::duration<double>(end - start).count()
+        );
+        if (stats.failed > 0)
+            return 1;
+    }
+
+    if (archivePath != nullptr) {
+        namespace fs = std::filesystem;
+
+        const auto      manifestPath = fs::path(argv[2]) / COOK_MANIFEST_NAME;
+        std::error_code error;
+        const auto      archiveTime = fs::last_write_time(archivePath, error);
+
+        // Несколько целей (игра, бенчмарки) пакуют одну папку cooked,
+        // поэтому свежесть архива проверяется по манифесту.
+        if (force || error || (archiveTime < fs::last_write_time(manifestPath, error))) {
+            if (!PackArchive(argv[2], archivePath)) {
+                printf("Failed to pack %s\n", archivePath);
+                return 1;
+            }
+            printf("Packed %s\n", archivePath);
+        }
+    }
+    return 0;
+}
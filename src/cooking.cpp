@@ -0,0 +1,619 @@
+//----------------------------------------------------------------------------------
+// Asset Cooking.
+//----------------------------------------------------------------------------------
+// Исходники ассетов -> файлы, которые читает игра. Запускается через cooker.cpp.
+//
+// Задача (CookJob) - один вход и один или несколько выходов:
+// - уровни (cookLevels_, MagicaVoxel JSON) -> level.txt, level.palette, level.bricks,
+//   level.chunks;
+// - *.wav -> WAV с частотой микшера raylib (COOK_SAMPLE_RATE),
+//   чтобы LoadSound не ресемплировал на загрузке;
+// - остальное в resources (GLSL, картинки, музыка) копируется как есть.
+//   GLSL компилирует драйвер, бинарники кешируются уже в игре, см. shader_cache.cpp.
+//
+// Готовые файлы упаковываются в один архив (PackArchive), его игра
+// отображает в память, см. archive.cpp.
+//
+// Инкрементальность. Ключ задачи - Hash64 от содержимого входа, вида задачи
+// и COOK_VERSION. Ключи выходов пишутся в манифест (COOK_MANIFEST_NAME
+// в выходной папке). Если все выходы задачи на месте и их ключи совпадают,
+// задача пропускается. COOK_VERSION поднимается при изменении любого формата.
+//
+// Задачи независимы и выполняются параллельно.
+const char* COOK_MANIFEST_NAME = "cook_manifest.txt";
+const u64   COOK_VERSION       = 2;
+const int   COOK_SAMPLE_RATE   = 44100;
+
+// Уровни. Выход - путь в resources без расширения.
+const struct {
+    const char* input;
+    const char* output;
+} cookLevels_[] = {
+    {"assets/unnamed_mesh1.vox", "screens/gameplay/level"},
+};
+
+enum class CookKind {
+    COPY,
+    SOUND,
+    LEVEL,
+};
+
+struct CookJob {
+    CookKind                 kind    = CookKind::COPY;
+    std::string              input   = {};
+    std::vector<std::string> outputs = {};  // Относительно выходной папки.
+
+    u64  key     = 0;
+    bool skipped = false;
+    bool failed  = false;
+};
+
+struct CookManifestEntry {
+    std::string output = {};
+    u64         key    = 0;
+};
+
+// Отсортирован по output.
+using CookManifest = std::vector<CookManifestEntry>;
+
+struct CookStats {
+    int cooked  = 0;
+    int skipped = 0;
+    int failed  = 0;
+};
+
+// Строки "<ключ hex> <output>".
+CookManifest ParseCookManifest(const char* text) {
+    CookManifest result;
+    if (text == nullptr)
+        return result;
+
+    const char* at = text;
+    while (*at != '\0') {
+        const char* lineEnd = strchr(at, '\n');
+        if (lineEnd == nullptr)
+            lineEnd = at + strlen(at);
+
+        char*     keyEnd = nullptr;
+        const u64 key    = strtoull(at, &keyEnd, 16);
+        if ((keyEnd != at) && (keyEnd < lineEnd) && (*keyEnd == ' ')) {
+            std::string output((const char*)keyEnd + 1, lineEnd);
+            if (!output.empty() && (output.back() == '\r'))
+                output.pop_back();
+            result.push_back({output, key});
+        }
+
+        at = (*lineEnd == '\0') ? lineEnd : lineEnd + 1;
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.output < b.output;
+    });
+    return result;
+}
+
+std::string SerializeCookManifest(const CookManifest& manifest) {
+    std::string result;
+    for (const auto& entry : manifest) {
+        result += TextFormat("%016llx ", (unsigned long long)entry.key);
+        result += entry.output;
+        result += '\n';
+    }
+    return result;
+}
+
+// Ключ output или 0, если его нет.
+u64 CookManifestFind(const CookManifest& manifest, const std::string& output) {
+    auto it = std::lower_bound(
+        manifest.begin(),
+        manifest.end(),
+        output,
+        [](const CookManifestEntry& entry, const std::string& value) {
+            return entry.output < value;
+        }
+    );
+    if ((it == manifest.end()) || (it->output != output))
+        return 0;
+    return it->key;
+}
+
+//----------------------------------------------------------------------------------
+// Vox Levels.
+//----------------------------------------------------------------------------------
+// Уровни экспортируются из редактора в JSON:
+//
+// {"palette": [0xRRGGBB, ...], "layers": [{"voxels": [[x, y, z, colorIndex], ...]}]}
+//
+// Остальные поля пропускаются. Разбор - минимальный JSON без DOM.
+struct VoxLevel {
+    std::vector<Color>     palette = {};
+    std::vector<CubeVoxel> cubes   = {};
+};
+
+struct JsonReader_ {
+    const char* at  = nullptr;
+    const char* end = nullptr;
+};
+
+void JsonSkipSpace_(JsonReader_& r) {
+    while ((r.at < r.end) && ((*r.at == ' ') || (*r.at == '\n') || (*r.at == '\r')
+                              || (*r.at == '\t')))
+        r.at++;
+}
+
+bool JsonConsume_(JsonReader_& r, char c) {
+    JsonSkipSpace_(r);
+    if ((r.at >= r.end) || (*r.at != c))
+        return false;
+    r.at++;
+    return true;
+}
+
+// Экранирование не разворачивается - ключам формата оно не нужно.
+bool JsonReadString_(JsonReader_& r, std::string& out) {
+    if (!JsonConsume_(r, '"'))
+        return false;
+
+    out.clear();
+    while ((r.at < r.end) && (*r.at != '"')) {
+        if ((*r.at == '\\') && (r.at + 1 < r.end))
+            out += *r.at++;
+        out += *r.at++;
+    }
+    return JsonConsume_(r, '"');
+}
+
+bool JsonReadNumber_(JsonReader_& r, double& out) {
+    JsonSkipSpace_(r);
+    if (r.at >= r.end)
+        return false;
+
+    // strtod не знает про r.end, поэтому текст кончается нулём. См. ParseVoxLevel.
+    char* numberEnd = nullptr;
+    out             = strtod(r.at, &numberEnd);
+    if ((numberEnd == r.at) || (numberEnd > r.end))
+        return false;
+    r.at = numberEnd;
+    return true;
+}
+
+// Вызывает element() для каждого элемента массива.
+template <typename F>
+bool JsonReadArray_(JsonReader_& r, F&& element) {
+    if (!JsonConsume_(r, '['))
+        return false;
+    if (JsonConsume_(r, ']'))
+        return true;
+
+    do {
+        if (!element())
+            return false;
+    } while (JsonConsume_(r, ','));
+    return JsonConsume_(r, ']');
+}
+
+// Вызывает value(key) для каждого поля объекта, value читает значение.
+template <typename F>
+bool JsonReadObject_(JsonReader_& r, F&& value) {
+    if (!JsonConsume_(r, '{'))
+        return false;
+    if (JsonConsume_(r, '}'))
+        return true;
+
+    std::string key;
+    do {
+        if (!JsonReadString_(r, key) || !JsonConsume_(r, ':') || !value(key))
+            return false;
+    } while (JsonConsume_(r, ','));
+    return JsonConsume_(r, '}');
+}
+
+bool JsonSkipValue_(JsonReader_& r) {
+    JsonSkipSpace_(r);
+    if (r.at >= r.end)
+        return false;
+
+    switch (*r.at) {
+    case '{':
+        return JsonReadObject_(r, [&](const std::string&) { return JsonSkipValue_(r); });
+    case '[':
+        return JsonReadArray_(r, [&]() { return JsonSkipValue_(r); });
+    case '"': {
+        std::string value;
+        return JsonReadString_(r, value);
+    }
+    }
+
+    // Число, true, false, null.
+    const char* start = r.at;
+    while ((r.at < r.end) && (strchr(",]} \n\r\t", *r.at) == nullptr))
+        r.at++;
+    return r.at != start;
+}
+
+// text[size] - нулевой байт.
+bool ParseVoxLevel(const char* text, int size, VoxLevel& out) {
+    JsonReader_ r = {text, text + size};
+    VoxLevel    level;
+
+    auto readVoxel = [&]() {
+        double values[4] = {};
+        int    count     = 0;
+        bool   ok        = JsonReadArray_(r, [&]() {
+            double value = 0;
+            if (!JsonReadNumber_(r, value) || (count >= 4))
+                return false;
+            values[count++] = value;
+            return true;
+        });
+        if (!ok || (count != 4))
+            return false;
+
+        CubeVoxel cube  = {};
+        cube.pos        = {(int)values[0], (int)values[1], (int)values[2]};
+        cube.colorIndex = (int)values[3];
+        level.cubes.push_back(cube);
+        return true;
+    };
+
+    auto readLayer = [&]() {
+        return JsonReadObject_(r, [&](const std::string& key) {
+            if (key == "voxels")
+                return JsonReadArray_(r, readVoxel);
+            return JsonSkipValue_(r);
+        });
+    };
+
+    auto readColor = [&]() {
+        double value = 0;
+        if (!JsonReadNumber_(r, value))
+            return false;
+
+        const auto rgb = (u32)value;
+        level.palette.push_back(Color{
+            (unsigned char)((rgb >> 16) & 0xFF),
+            (unsigned char)((rgb >> 8) & 0xFF),
+            (unsigned char)(rgb & 0xFF),
+            255,
+        });
+        return true;
+    };
+
+    const bool ok = JsonReadObject_(r, [&](const std::string& key) {
+        if (key == "palette")
+            return JsonReadArray_(r, readColor);
+        if (key == "layers")
+            return JsonReadArray_(r, readLayer);
+        return JsonSkipValue_(r);
+    });
+    if (!ok)
+        return false;
+
+    out = std::move(level);
+    return true;
+}
+
+// Палитра в формате начала level.txt. Отдельным файлом - для загрузки
+// из level.bricks, чтобы не читать весь level.txt.
+std::string SerializeLevelPalette(const VoxLevel& level) {
+    std::string result;
+    result += TextFormat("%d\n", (int)level.palette.size());
+    for (auto color : level.palette)
+        result += TextFormat("%d %d %d\n", color.r, color.g, color.b);
+    return result;
+}
+
+// Формат, который читает InitGameplayScreen.
+std::string SerializeLevelText(const VoxLevel& level) {
+    std::string result = SerializeLevelPalette(level);
+
+    result += TextFormat("%d\n", (int)level.cubes.size());
+    for (const auto& cube : level.cubes) {
+        const auto& p = cube.pos;
+        result += TextFormat("%d %d %d %d\n", p.x, p.y, p.z, cube.colorIndex);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Cooking.
+//----------------------------------------------------------------------------------
+bool WriteCookOutput_(const std::string& path, const void* data, size_t size) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    return SaveFileData(path.c_str(), (void*)data, (int)size);
+}
+
+bool CookLevel_(const u8* data, int size, const std::string* outputs) {
+    // Данные LoadFileData не кончаются нулём.
+    const std::string json(data, size);
+
+    VoxLevel level;
+    if (!ParseVoxLevel(json.c_str(), (int)json.size(), level))
+        return false;
+
+    const auto text    = SerializeLevelText(level);
+    const auto palette = SerializeLevelPalette(level);
+    auto       bricks  = MakeBrickMap(level.cubes.data(), (int)level.cubes.size());
+    defer {
+        FreeBrickMap(bricks);
+    };
+    const auto bricksData = SerializeBrickMap(bricks);
+    const auto chunksData = SerializeChunkedLevel(bricks);
+
+    return WriteCookOutput_(outputs[0], text.data(), text.size())
+           && WriteCookOutput_(outputs[1], palette.data(), palette.size())
+           && WriteCookOutput_(outputs[2], bricksData.data(), bricksData.size())
+           && WriteCookOutput_(outputs[3], chunksData.data(), chunksData.size());
+}
+
+bool CookSound_(const u8* data, int size, const std::string& output) {
+    auto wave = LoadWaveFromMemory(".wav", (const unsigned char*)data, size);
+    if (wave.data == nullptr)
+        return false;
+    defer {
+        UnloadWave(wave);
+    };
+
+    if (wave.sampleRate == COOK_SAMPLE_RATE)
+        return WriteCookOutput_(output, data, size);
+
+    WaveFormat(&wave, COOK_SAMPLE_RATE, (int)wave.sampleSize, (int)wave.channels);
+    std::error_code error;
+    std::filesystem::create_directories(
+        std::filesystem::path(output).parent_path(), error
+    );
+    return ExportWave(wave, output.c_str());
+}
+
+// Все задачи для sourceDir (там лежат resources и assets).
+std::vector<CookJob> CollectCookJobs(const char* sourceDir) {
+    namespace fs = std::filesystem;
+
+    std::vector<CookJob> jobs;
+    const fs::path       source = sourceDir;
+
+    for (const auto& level : cookLevels_) {
+        CookJob job = {};
+        job.kind    = CookKind::LEVEL;
+        job.input   = (source / level.input).generic_string();
+        for (auto extension : {".txt", ".palette", ".bricks", ".chunks"})
+            job.outputs.push_back(std::string(level.output) + extension);
+        jobs.push_back(job);
+    }
+
+    // Выходы, которые уже готовят уровни. Например, level.txt лежит
+    // и в resources - его делает cli.py generate, но приоритет у уровня.
+    std::vector<std::string> claimed;
+    for (const auto& job : jobs)
+        claimed.insert(claimed.end(), job.outputs.begin(), job.outputs.end());
+
+    std::error_code error;
+    const auto      resources = source / "resources";
+    for (const auto& entry : fs::recursive_directory_iterator(resources, error)) {
+        if (!entry.is_regular_file())
+            continue;
+
+        const auto output = entry.path().lexically_relative(resources).generic_string();
+        if (std::find(claimed.begin(), claimed.end(), output) != claimed.end())
+            continue;
+
+        CookJob job = {};
+        job.kind    = CookKind::COPY;
+        if (entry.path().extension() == ".wav")
+            job.kind = CookKind::SOUND;
+        job.input = entry.path().generic_string();
+        job.outputs.push_back(output);
+        jobs.push_back(job);
+    }
+
+    // Порядок обхода папок от системы не зависит.
+    std::sort(jobs.begin(), jobs.end(), [](const auto& a, const auto& b) {
+        return a.outputs[0] < b.outputs[0];
+    });
+    return jobs;
+}
+
+// Выполняет задачу, если её выходы устарели. Зовётся из нескольких потоков.
+void CookJob_(
+    CookJob&            job,
+    const std::string&  outputDir,
+    const CookManifest& manifest,
+    bool                force
+) {
+    int  size = 0;
+    auto data = (u8*)LoadFileData(job.input.c_str(), &size);
+    defer {
+        UnloadFileData((unsigned char*)data);
+    };
+    if (data == nullptr) {
+        job.failed = true;
+        return;
+    }
+
+    job.key = Hash64(&COOK_VERSION, sizeof(COOK_VERSION));
+    job.key = Hash64(&job.kind, sizeof(job.kind), job.key);
+    job.key = Hash64(data, size, job.key);
+
+    std::vector<std::string> paths;
+    bool                     upToDate = !force;
+    for (const auto& output : job.outputs) {
+        paths.push_back(outputDir + "/" + output);
+        upToDate &= (CookManifestFind(manifest, output) == job.key)
+                    && FileExists(paths.back().c_str());
+    }
+    if (upToDate) {
+        job.skipped = true;
+        return;
+    }
+
+    bool ok = false;
+    switch (job.kind) {
+    case CookKind::COPY:
+        ok = WriteCookOutput_(paths[0], data, size);
+        break;
+    case CookKind::SOUND:
+        ok = CookSound_(data, size, paths[0]);
+        break;
+    case CookKind::LEVEL:
+        ok = CookLevel_(data, size, paths.data());
+        break;
+    }
+    job.failed = !ok;
+}
+
+// threadsCount <= 0 - по количеству ядер.
+// force - готовить всё, не глядя в манифест.
+CookStats CookAssets(
+    const char* sourceDir,
+    const char* outputDir,
+    int         threadsCount,
+    bool        force
+) {
+    const std::string output       = outputDir;
+    const std::string manifestPath = output + "/" + COOK_MANIFEST_NAME;
+
+    CookManifest manifest;
+    if (FileExists(manifestPath.c_str())) {
+        char* text = LoadFileText(manifestPath.c_str());
+        manifest   = ParseCookManifest(text);
+        UnloadFileText(text);
+    }
+
+    auto jobs = CollectCookJobs(sourceDir);
+
+    // Задачи очень разные по размеру (уровень против шейдера),
+    // поэтому потоки разбирают их по одной.
+    std::atomic<int> nextJob = 0;
+    threadsCount = ParallelForThreadsCount(threadsCount);
+    ParallelFor(threadsCount, threadsCount, [&](int, int) {
+        while (true) {
+            const int i = nextJob++;
+            if (i >= (int)jobs.size())
+                break;
+            CookJob_(jobs[i], output, manifest, force);
+        }
+    });
+
+    CookStats    stats = {};
+    CookManifest cooked;
+    for (const auto& job : jobs) {
+        if (job.failed) {
+            TraceLog(LOG_ERROR, "COOK: Failed to cook %s", job.input.c_str());
+            stats.failed++;
+            // Без записи в манифесте задача повторится на следующем запуске.
+            continue;
+        }
+
+        if (job.skipped)
+            stats.skipped++;
+        else
+            stats.cooked++;
+        for (const auto& path : job.outputs)
+            cooked.push_back({path, job.key});
+    }
+
+    std::sort(cooked.begin(), cooked.end(), [](const auto& a, const auto& b) {
+        return a.output < b.output;
+    });
+    // Манифест переписывается, только если изменился: по его времени
+    // изменения cooker решает, пора ли пересобрать архив.
+    const auto text = SerializeCookManifest(cooked);
+    if (text != SerializeCookManifest(manifest))
+        WriteCookOutput_(manifestPath, text.data(), text.size());
+
+    return stats;
+}
+
+// Всё из манифеста outputDir -> архив (см. archive.cpp).
+// Файлы, которых в манифесте нет (например, от удалённых ассетов), не попадают.
+bool PackArchive(const char* outputDir, const char* archivePath) {
+    const std::string output       = outputDir;
+    const std::string manifestPath = output + "/" + COOK_MANIFEST_NAME;
+    if (!FileExists(manifestPath.c_str()))
+        return false;
+
+    char*      text     = LoadFileText(manifestPath.c_str());
+    const auto manifest = ParseCookManifest(text);
+    UnloadFileText(text);
+
+    std::vector<ArchiveFile> files;
+    for (const auto& entry : manifest) {
+        int  size = 0;
+        auto data = (u8*)LoadFileData((output + "/" + entry.output).c_str(), &size);
+        if (data == nullptr)
+            return false;
+
+        ArchiveFile file = {};
+        file.path        = entry.output;
+        file.data.assign(data, data + size);
+        UnloadFileData((unsigned char*)data);
+
+        // .chunks и музыка читаются прямо из архива (ResourceView) - без сжатия.
+        const auto extension = std::filesystem::path(file.path).extension();
+        file.compress        = (extension != ".chunks") && (extension != ".ogg");
+        files.push_back(std::move(file));
+    }
+
+    // Пишем рядом и подменяем одним rename. Иначе прерванная запись оставит
+    // обрезанный архив, который по времени выглядит свежее манифеста.
+    const auto        archive  = BuildArchive(files);
+    const std::string tempPath = std::string(archivePath) + ".tmp";
+    if (!WriteCookOutput_(tempPath, archive.data(), archive.size()))
+        return false;
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, archivePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+TEST_CASE ("Cooking") {
+    SUBCASE ("Vox level") {
+        const char* text = R"({
+            "name": "voxels",
+            "palette": [16711680, 65280],
+            "layers": [
+                {"name": "a", "hidden": false, "voxels": [[1, 2, 3, 0], [4, 5, 6, 1]]},
+                {"voxels": []},
+                {"voxels": [[-1, 0, 0, 1]], "extra": {"voxels": "nope"}}
+            ]
+        })";
+
+        VoxLevel level;
+        Assert(ParseVoxLevel(text, (int)strlen(text), level));
+        Assert(level.palette.size() == 2);
+        Assert(level.palette[0].r == 255);
+        Assert(level.palette[1].g == 255);
+        Assert(level.cubes.size() == 3);
+        Assert(level.cubes[1].pos.z == 6);
+        Assert(level.cubes[2].pos.x == -1);
+        Assert(level.cubes[2].colorIndex == 1);
+
+        Assert(
+            SerializeLevelText(level)
+            == "2\n255 0 0\n0 255 0\n3\n1 2 3 0\n4 5 6 1\n-1 0 0 1\n"
+        );
+        Assert(SerializeLevelPalette(level) == "2\n255 0 0\n0 255 0\n");
+
+        const char* broken = R"({"palette": [1, 2], "layers": [{"voxels": [[1, 2]]}]})";
+        Assert_False(ParseVoxLevel(broken, (int)strlen(broken), level));
+    }
+
+    SUBCASE ("Manifest") {
+        CookManifest manifest = {
+            {"a/b.glsl", 0x1234},
+            {"c d.wav", 0xFFFFFFFFFFFFFFFFull},
+        };
+        const auto parsed = ParseCookManifest(SerializeCookManifest(manifest).c_str());
+        Assert(parsed.size() == 2);
+        Assert(CookManifestFind(parsed, "a/b.glsl") == 0x1234);
+        Assert(CookManifestFind(parsed, "c d.wav") == 0xFFFFFFFFFFFFFFFFull);
+        Assert(CookManifestFind(parsed, "missing") == 0);
+
+        Assert(ParseCookManifest("garbage\n\n0001 x\r\n").size() == 1);
+    }
+}
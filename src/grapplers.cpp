@@ -0,0 +1,576 @@
+//----------------------------------------------------------------------------------
+// Movement.
+//----------------------------------------------------------------------------------
+// Модель движения, общая для игрока и ботов: шаги на земле и в воздухе, dash,
+// верёвка, уступы. Игрок и боты отличаются только тем, откуда берётся управление.
+
+struct MovementConfig {
+    float airSpeed      = 2.0f;
+    float speed         = 10.0f;   // m / s
+    float jumpImpulse   = 80.0f;   // m
+    float gravity       = -10.0f;  // m / s / s
+    float velocityDecay = 0.1f;
+    float mass          = 10.0f;  // kg
+
+    // Размеры коллайдера. position - это точка между ступнями.
+    float halfWidth   = 0.3f;   // m
+    float height      = 1.8f;   // m
+    float groundProbe = 0.05f;  // m
+
+    float boostAmount = 3.3f;
+    float maxVelocity = 28.0f;
+    float dashImpulse = 200.0f;
+};
+
+constexpr MovementConfig movementConfig = {};
+
+Vector3 ApplyImpulse(Vector3 direction, float mass, float forceValue) {
+    return direction * (forceValue / mass);
+}
+
+Vector3 HorizontalAxisOf(Vector3 value) {
+    return Vector3Normalize(Vector3CrossProduct(value, Vector3Up));
+}
+
+BoundingBox GetMovementBox(Vector3 position) {
+    const float w = movementConfig.halfWidth;
+    return {
+        position + Vector3(-w, 0, -w),
+        position + Vector3(w, movementConfig.height, w),
+    };
+}
+
+// Двигает коллайдер на delta, упираясь в воксели.
+// Скорость вдоль нормалей контактов гасится, контакты накапливаются в contacts.
+void MoveThroughVoxels(
+    const BrickMap&  bricks,
+    Vector3&         position,
+    Vector3&         velocity,
+    VoxelContacts&   contacts,
+    Vector3          delta
+) {
+    VoxelContacts c = {};
+    position += SweepBoxThroughVoxels(bricks, GetMovementBox(position), delta, &c);
+
+    const auto& normal = c.normal;
+    if (normal.x * velocity.x < 0)
+        velocity.x = 0;
+    if (normal.y * velocity.y < 0)
+        velocity.y = 0;
+    if (normal.z * velocity.z < 0)
+        velocity.z = 0;
+
+    if (normal.x != 0)
+        contacts.normal.x = normal.x;
+    if (normal.y != 0)
+        contacts.normal.y = normal.y;
+    if (normal.z != 0)
+        contacts.normal.z = normal.z;
+    contacts.ledge |= c.ledge;
+}
+
+bool IsStandingOnVoxels(const BrickMap& bricks, Vector3 position) {
+    VoxelContacts contacts = {};
+    SweepBoxThroughVoxels(
+        bricks,
+        GetMovementBox(position),
+        Vector3Down * movementConfig.groundProbe,
+        &contacts
+    );
+    return contacts.normal.y > 0;
+}
+
+// Затухание и ограничение скорости в воздухе.
+Vector3 DecayAirborneVelocity(Vector3 velocity, float dt) {
+    velocity = Vector3ExponentialDecay(
+        velocity, Vector3Zero(), movementConfig.velocityDecay, dt
+    );
+    return Vector3Normalize(velocity)
+           * Min(movementConfig.maxVelocity, Vector3Length(velocity));
+}
+
+// Шаг на земле. walk - горизонтальное направление ходьбы, длина - доля speed
+// (нулевое - стоим на месте).
+// Возвращает true, если после шага тело в воздухе: прыгнуло или сошло с уступа.
+bool MoveGrounded(
+    const BrickMap&  bricks,
+    Vector3&         position,
+    Vector3&         velocity,
+    VoxelContacts&   contacts,
+    Vector3          walk,
+    bool             jump,
+    float            dt
+) {
+    const auto& config = movementConfig;
+
+    velocity.x = walk.x * config.speed;
+    velocity.z = walk.z * config.speed;
+    if (jump)
+        velocity += ApplyImpulse(Vector3Up, config.mass, config.jumpImpulse);
+
+    MoveThroughVoxels(bricks, position, velocity, contacts, velocity * dt);
+    return jump || !IsStandingOnVoxels(bricks, position);
+}
+
+// Управление в воздухе и гравитация.
+// control - куда тянет управление, длина - доля airSpeed. boost усиливает управление.
+Vector3 AccelerateAirborne(Vector3 velocity, Vector3 control, bool boost, float dt) {
+    const auto& config = movementConfig;
+
+    auto d = control * (config.airSpeed * dt);
+    if (boost)
+        d *= config.boostAmount;
+
+    velocity += d;
+    velocity.y += dt * config.gravity;
+    return velocity;
+}
+
+// Dash: вся скорость разворачивается в direction, и туда же - импульс.
+Vector3 DashVelocity(Vector3 velocity, Vector3 direction) {
+    const auto& config = movementConfig;
+    return direction * Vector3Length(velocity)
+           + ApplyImpulse(direction, config.mass, config.dashImpulse);
+}
+
+// Шаг в воздухе: затухание скорости и движение.
+void MoveAirborne(
+    const BrickMap&  bricks,
+    Vector3&         position,
+    Vector3&         velocity,
+    VoxelContacts&   contacts,
+    float            dt
+) {
+    velocity = DecayAirborneVelocity(velocity, dt);
+    MoveThroughVoxels(bricks, position, velocity, contacts, velocity * dt);
+}
+
+// Скорость тела, качающегося на верёвке. ropeDirection - от тела к точке опоры.
+// Скорость раскладывается по касательной к дуге в вертикальной плоскости верёвки
+// и по горизонтальной оси, перпендикулярной верёвке.
+Vector3 SwingVelocityAroundRope(Vector3 velocity, Vector3 ropeDirection) {
+    auto axis     = HorizontalAxisOf(ropeDirection);
+    auto angle    = -Vector3Angle(Vector3Up, ropeDirection);
+    auto pRotated = Vector3Normalize(
+        Vector3RotateByAxisAngle({ropeDirection.x, 0, ropeDirection.z}, axis, angle)
+    );
+
+    return pRotated * Vector3DotProduct(pRotated, velocity)
+           + axis * Vector3DotProduct(axis, velocity);
+}
+
+TEST_CASE ("SwingVelocityAroundRope") {
+    float velocities[] = {-1, 1};
+    for (float yvelocity : velocities) {
+        SUBCASE(
+            TextFormat("y velocity is %f, y rope direction is %f", yvelocity, -yvelocity)
+        ) {
+            const Vector3 vel = {0, yvelocity, 0};
+
+            auto tPosXPosZ = SwingVelocityAroundRope(vel, {1, -yvelocity, 1});
+            auto tPosXNegZ = SwingVelocityAroundRope(vel, {1, -yvelocity, -1});
+            auto tNegXPosZ = SwingVelocityAroundRope(vel, {-1, -yvelocity, 1});
+            auto tNegXNegZ = SwingVelocityAroundRope(vel, {-1, -yvelocity, -1});
+
+            Assert(tPosXPosZ.x > 0);
+            Assert(tPosXPosZ.z > 0);
+
+            Assert(tPosXNegZ.x > 0);
+            Assert(tPosXNegZ.z < 0);
+
+            Assert(tNegXPosZ.x < 0);
+            Assert(tNegXPosZ.z > 0);
+
+            Assert(tNegXNegZ.x < 0);
+            Assert(tNegXNegZ.z < 0);
+
+            auto tPosX = SwingVelocityAroundRope(vel, {1, -yvelocity, 0});
+            auto tNegX = SwingVelocityAroundRope(vel, {-1, -yvelocity, 0});
+            auto tPosZ = SwingVelocityAroundRope(vel, {0, -yvelocity, 1});
+            auto tNegZ = SwingVelocityAroundRope(vel, {0, -yvelocity, -1});
+
+            Assert(tPosX.x > 0);
+            Assert(FloatEquals(tPosX.z, 0));
+
+            Assert(tNegX.x < 0);
+            Assert(FloatEquals(tNegX.z, 0));
+
+            Assert(tPosZ.z > 0);
+            Assert(FloatEquals(tPosZ.x, 0));
+
+            Assert(tNegZ.z < 0);
+            Assert(FloatEquals(tNegZ.x, 0));
+
+            Assert(yvelocity * tPosXPosZ.y > 0);
+            Assert(yvelocity * tPosXNegZ.y > 0);
+            Assert(yvelocity * tNegXPosZ.y > 0);
+            Assert(yvelocity * tNegXNegZ.y > 0);
+            Assert(yvelocity * tPosX.y > 0);
+            Assert(yvelocity * tNegX.y > 0);
+            Assert(yvelocity * tPosZ.y > 0);
+            Assert(yvelocity * tNegZ.y > 0);
+        }
+    }
+}
+
+// Натяжение верёвки: не даём отойти от pivot дальше length.
+// Возвращает true, если верёвка натянулась и скорость пошла по дуге вокруг pivot.
+bool ConstrainToRope(
+    const BrickMap&  bricks,
+    Vector3&         position,
+    Vector3&         velocity,
+    VoxelContacts&   contacts,
+    Vector3          pivot,
+    float            length
+) {
+    if (Vector3Distance(position, pivot) <= length)
+        return false;
+
+    const auto target = pivot + Vector3Normalize(position - pivot) * length;
+    MoveThroughVoxels(bricks, position, velocity, contacts, target - position);
+
+    velocity = SwingVelocityAroundRope(velocity, pivot - position);
+    return true;
+}
+
+// Залезание на уступ (contacts.ledge): вертикальная скорость заменяется прыжком.
+Vector3 ClimbLedgeVelocity(Vector3 velocity) {
+    const auto& config = movementConfig;
+
+    velocity.y = 0;
+    return velocity + ApplyImpulse(Vector3Up, config.mass, config.jumpImpulse);
+}
+
+//----------------------------------------------------------------------------------
+// Grapplers.
+//----------------------------------------------------------------------------------
+// Боты, которые двигаются по тем же правилам, что и игрок:
+// ходят, прыгают, цепляются верёвкой, делают dash и boost.
+// Нужны как нагрузка для симуляции, raycast-ов и частиц.
+//
+// Данные хранятся в SoA массивах фиксированного размера. Боты друг от друга
+// не зависят, поэтому UpdateGrapplers раскидывает их диапазонами по потокам.
+//
+// Верёвка бота - просто маятник вокруг точки зацепа, без оборачивания вокруг вокселей.
+const int MAX_GRAPPLERS = 4096;
+
+enum class GrapplerStates {
+    GROUNDED = 0,
+    AIRBORNE,
+};
+
+struct Grapplers {
+    int count;
+
+    float x[MAX_GRAPPLERS];
+    float y[MAX_GRAPPLERS];
+    float z[MAX_GRAPPLERS];
+    float velX[MAX_GRAPPLERS];
+    float velY[MAX_GRAPPLERS];
+    float velZ[MAX_GRAPPLERS];
+
+    GrapplerStates state[MAX_GRAPPLERS];
+    // Упёрся в стену на прошлом тике.
+    bool blocked[MAX_GRAPPLERS];
+
+    bool  ropeActive[MAX_GRAPPLERS];
+    float ropeX[MAX_GRAPPLERS];
+    float ropeY[MAX_GRAPPLERS];
+    float ropeZ[MAX_GRAPPLERS];
+    float ropeLength[MAX_GRAPPLERS];
+
+    // AI.
+    float        targetX[MAX_GRAPPLERS];
+    float        targetY[MAX_GRAPPLERS];
+    float        targetZ[MAX_GRAPPLERS];
+    float        thinkTimer[MAX_GRAPPLERS];  // Когда сменить цель.
+    double       lastDashTime[MAX_GRAPPLERS];
+    bool         dashed[MAX_GRAPPLERS];  // Сделал dash на текущем тике.
+    bool         boosting[MAX_GRAPPLERS];
+
+    // У каждого бота свой поток, чтобы диапазоны ботов можно было
+    // обновлять параллельно. Потоки выводятся из одного, см. SpawnGrapplers.
+    Random random[MAX_GRAPPLERS];
+
+    // Границы уровня, внутри которых выбираются цели. См. SpawnGrapplers.
+    BoundingBox bounds;
+};
+
+const float grapplerTargetReachedDistance = 3.0f;
+const float grapplerGrappleDistance       = 20.0f;
+const float grapplerGrappleConeHalfAngle  = 10 * DEG2RAD;
+const float grapplerDashCooldown          = 3.0f;
+
+Vector3 GrapplerGetPosition(const Grapplers& g, int i) {
+    return {g.x[i], g.y[i], g.z[i]};
+}
+
+Vector3 GrapplerGetVelocity_(const Grapplers& g, int i) {
+    return {g.velX[i], g.velY[i], g.velZ[i]};
+}
+
+float GrapplerRandom01_(Grapplers& g, int i) {
+    return RandomFloat01(g.random[i]);
+}
+
+void GrapplerPickTarget_(Grapplers& g, int i) {
+    const auto& b = g.bounds;
+
+    g.targetX[i]    = Lerp(b.min.x, b.max.x, GrapplerRandom01_(g, i));
+    g.targetY[i]    = Lerp(b.min.y, b.max.y, GrapplerRandom01_(g, i));
+    g.targetZ[i]    = Lerp(b.min.z, b.max.z, GrapplerRandom01_(g, i));
+    g.thinkTimer[i] = 5.0f + GrapplerRandom01_(g, i) * 10.0f;
+}
+
+// Боты появляются над случайными точками уровня и падают вниз.
+// Seed потока каждого бота берётся из random.
+void SpawnGrapplers(Grapplers& g, const BrickMap& bricks, int count, Random& random) {
+    Assert(count >= 0);
+
+    g.bounds      = BrickMapBounds(bricks);
+    const auto& b = g.bounds;
+
+    const int newCount = Min(g.count + count, MAX_GRAPPLERS);
+    for (int i = g.count; i < newCount; i++) {
+        const u64 seed = ((u64)RandomU32(random) << 32) | RandomU32(random);
+        g.random[i]    = MakeRandom(seed);
+
+        g.x[i] = Lerp(b.min.x, b.max.x, GrapplerRandom01_(g, i));
+        g.y[i] = b.max.y + 1;
+        g.z[i] = Lerp(b.min.z, b.max.z, GrapplerRandom01_(g, i));
+
+        g.velX[i]         = 0;
+        g.velY[i]         = 0;
+        g.velZ[i]         = 0;
+        g.state[i]        = GrapplerStates::AIRBORNE;
+        g.blocked[i]      = false;
+        g.ropeActive[i]   = false;
+        g.lastDashTime[i] = -doubleInf;
+        g.dashed[i]       = false;
+        g.boosting[i]     = false;
+
+        GrapplerPickTarget_(g, i);
+    }
+    g.count = newCount;
+}
+
+void ClearGrapplers(Grapplers& g) {
+    g.count = 0;
+}
+
+void UpdateGrappler_(Grapplers& g, const World& world, int i, float dt, double time) {
+    const auto& config = movementConfig;
+    const auto& bricks = *world.bricks;
+
+    auto          position = GrapplerGetPosition(g, i);
+    auto          velocity = GrapplerGetVelocity_(g, i);
+    VoxelContacts contacts = {};
+
+    g.dashed[i]   = false;
+    g.boosting[i] = false;
+
+    {  // AI. Выбор цели.
+        g.thinkTimer[i] -= dt;
+
+        const Vector3 target = {g.targetX[i], g.targetY[i], g.targetZ[i]};
+        if ((g.thinkTimer[i] <= 0)
+            || (Vector3Distance(position, target) < grapplerTargetReachedDistance))
+            GrapplerPickTarget_(g, i);
+    }
+
+    const Vector3 target    = {g.targetX[i], g.targetY[i], g.targetZ[i]};
+    const auto    toTarget  = target - position;
+    const auto    direction = Vector3Normalize(Vector3(toTarget.x, 0, toTarget.z));
+
+    if (g.state[i] == GrapplerStates::GROUNDED) {
+        // Цель выше или упёрлись в стену - прыгаем.
+        const bool jump = (toTarget.y > 2.0f) || g.blocked[i];
+        if (MoveGrounded(bricks, position, velocity, contacts, direction, jump, dt))
+            g.state[i] = GrapplerStates::AIRBORNE;
+    }
+    else {
+        {  // Управление в воздухе. Boost, если цель выше.
+            g.boosting[i] = toTarget.y > 0;
+
+            auto control = direction;
+            if (g.boosting[i])
+                control.y += 1;
+
+            velocity = AccelerateAirborne(velocity, control, g.boosting[i], dt);
+        }
+
+        {  // Dash.
+            const bool ready = time - g.lastDashTime[i] > grapplerDashCooldown;
+            if (ready && !g.ropeActive[i] && (Vector3Length(toTarget) > 15.0f)
+                && (GrapplerRandom01_(g, i) < 0.01f))
+            {
+                velocity          = DashVelocity(velocity, Vector3Normalize(toTarget));
+                g.lastDashTime[i] = time;
+                g.dashed[i]       = true;
+            }
+        }
+
+        {  // Верёвка.
+            const Vector3 anchor = {g.ropeX[i], g.ropeY[i], g.ropeZ[i]};
+
+            if (!g.ropeActive[i]) {
+                // Падаем - пробуем зацепиться за что-нибудь над целью.
+                if ((velocity.y < 0) && (GrapplerRandom01_(g, i) < 0.05f)) {
+                    const auto eye = position + Vector3Up * config.height;
+                    const auto dir = Vector3Normalize(
+                        toTarget + Vector3Up * (Vector3Length(toTarget) * 0.5f)
+                    );
+                    auto hit = WorldRaycast(world, {eye, dir, grapplerGrappleDistance});
+
+                    // Промахнулись - ищем поверхность в конусе вокруг луча.
+                    if (!hit.hit) {
+                        hit = WorldConeCast(
+                            world,
+                            eye,
+                            dir,
+                            grapplerGrappleConeHalfAngle,
+                            grapplerGrappleDistance
+                        );
+                    }
+
+                    if (hit.hit && (hit.distance > 0)) {
+                        g.ropeActive[i] = true;
+                        g.ropeX[i]      = hit.point.x;
+                        g.ropeY[i]      = hit.point.y;
+                        g.ropeZ[i]      = hit.point.z;
+                        g.ropeLength[i] = Vector3Distance(hit.point, position);
+                    }
+                }
+            }
+            else {
+                // Отпускаем, когда точка зацепа осталась позади на пути к цели.
+                const auto toAnchor = anchor - position;
+                if ((velocity.y > 0)
+                    && (toAnchor.x * direction.x + toAnchor.z * direction.z < 0))
+                    g.ropeActive[i] = false;
+            }
+        }
+
+        MoveAirborne(bricks, position, velocity, contacts, dt);
+
+        if (g.ropeActive[i]) {
+            const Vector3 anchor = {g.ropeX[i], g.ropeY[i], g.ropeZ[i]};
+            const float   length = g.ropeLength[i];
+            ConstrainToRope(bricks, position, velocity, contacts, anchor, length);
+        }
+
+        if (contacts.ledge)  // Залезание на уступ.
+            velocity = ClimbLedgeVelocity(velocity);
+
+        if (contacts.normal.y > 0) {
+            g.state[i]      = GrapplerStates::GROUNDED;
+            g.ropeActive[i] = false;
+        }
+    }
+
+    g.blocked[i] = (contacts.normal.x != 0) || (contacts.normal.z != 0);
+
+    g.x[i]    = position.x;
+    g.y[i]    = position.y;
+    g.z[i]    = position.z;
+    g.velX[i] = velocity.x;
+    g.velY[i] = velocity.y;
+    g.velZ[i] = velocity.z;
+}
+
+// Ботов на поток не меньше этого - иначе раздача по потокам дороже самих ботов.
+const int grapplersPerThreadMin = 16;
+
+// Обновляет всех ботов. Диапазоны ботов раскидываются по потокам пула
+// (см. ParallelFor). threadsCount <= 0 - по количеству ядер.
+void UpdateGrapplers(
+    Grapplers&   g,
+    const World& world,
+    float        dt,
+    double       time,
+    int          threadsCount = 0
+) {
+    threadsCount = Min(
+        ParallelForThreadsCount(threadsCount), Max(1, g.count / grapplersPerThreadMin)
+    );
+
+    ParallelFor(g.count, threadsCount, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            UpdateGrappler_(g, world, i, dt, time);
+    });
+}
+
+// Данные для отрисовки: xyz - позиция, w - 0 на земле, 1 в воздухе, 2 на верёвке.
+void GetGrapplerInstances(const Grapplers& g, Vector4* out) {
+    FOR_RANGE (int, i, g.count) {
+        float w = 0;
+        if (g.state[i] == GrapplerStates::AIRBORNE)
+            w = g.ropeActive[i] ? 2.0f : 1.0f;
+
+        out[i] = {g.x[i], g.y[i], g.z[i], w};
+    }
+}
+
+TEST_CASE ("UpdateGrapplers") {
+    // Пол 16x16 и столб 1x8x1 посередине.
+    std::vector<CubeVoxel> cubes = {};
+    FOR_RANGE (int, x, 16) {
+        FOR_RANGE (int, z, 16) {
+            cubes.push_back({{x, 0, z}, 0});
+        }
+    }
+    FOR_RANGE (int, y, 8) {
+        cubes.push_back({{8, y + 1, 8}, 1});
+    }
+
+    auto bricks = MakeBrickMap(cubes.data(), (int)cubes.size());
+    defer {
+        FreeBrickMap(bricks);
+    };
+
+    const World world = {&bricks};
+
+    static Grapplers g = {};
+    ClearGrapplers(g);
+    auto random = MakeRandom(1);
+    SpawnGrapplers(g, bricks, 64, random);
+    Assert(g.count == 64);
+
+    {  // Тот же seed - те же боты.
+        static Grapplers same = {};
+        ClearGrapplers(same);
+        auto sameRandom = MakeRandom(1);
+        SpawnGrapplers(same, bricks, 64, sameRandom);
+        Assert(memcmp(same.x, g.x, 64 * sizeof(float)) == 0);
+        Assert(memcmp(same.targetZ, g.targetZ, 64 * sizeof(float)) == 0);
+    }
+
+    // Те же боты, но без потоков.
+    static Grapplers serial = {};
+    ClearGrapplers(serial);
+    auto serialRandom = MakeRandom(1);
+    SpawnGrapplers(serial, bricks, 64, serialRandom);
+
+    const float dt = 1.0f / 60.0f;
+    FOR_RANGE (int, tick, 600) {
+        UpdateGrapplers(g, world, dt, tick * dt, 4);
+        UpdateGrapplers(serial, world, dt, tick * dt, 1);
+    }
+
+    // Потоки не меняют результат.
+    Assert(memcmp(serial.x, g.x, 64 * sizeof(float)) == 0);
+    Assert(memcmp(serial.y, g.y, 64 * sizeof(float)) == 0);
+    Assert(memcmp(serial.z, g.z, 64 * sizeof(float)) == 0);
+
+    bool finite      = true;
+    bool aboveFloor  = true;
+    int  groundedAny = 0;
+    FOR_RANGE (int, i, g.count) {
+        finite &= std::isfinite(g.x[i]) && std::isfinite(g.y[i]) && std::isfinite(g.z[i]);
+        aboveFloor &= g.y[i] > -voxelSkin * 2;
+        groundedAny += g.state[i] == GrapplerStates::GROUNDED;
+    }
+    Assert(finite);
+    Assert(aboveFloor);
+    Assert(groundedAny > 0);
+}
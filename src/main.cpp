@@ -1,10 +1,25 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <memory>
+#include <new>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 // NOLINTBEGIN(bugprone-suspicious-include)
 #include "raylib_hack_windows.cpp"
 // NOLINTEND(bugprone-suspicious-include)
 
+#include "allocation_hooks.h"
 #include "raylib.h"
 #include "raymath.h"
 #include "rlgl.h"
@@ -22,8 +37,30 @@
 
 #include "base.cpp"
 #include "math.cpp"
+#include "random.cpp"
+#include "batch_math.cpp"
 #include "memory_arena.cpp"
+#include "arena_containers.cpp"
+#include "allocation_tracker.cpp"
+#include "memory_registry.cpp"
+#include "threading.cpp"
+#include "archive.cpp"
+#include "telemetry.cpp"
+#include "opengl.cpp"
+#include "shader_cache.cpp"
+#include "stream_buffer.cpp"
 #include "debug_text.cpp"
+#include "world.cpp"
+#include "brick_map.cpp"
+#include "chunk_mesh.cpp"
+#include "chunk_renderer.cpp"
+#include "chunk_streaming.cpp"
+#include "cooking.cpp"
+#include "sdf.cpp"
+#include "world_query.cpp"
+#include "rope.cpp"
+#include "grapplers.cpp"
+#include "trail.cpp"
 
 #include "screens.cpp"
 #include "screen_gameplay.cpp"
@@ -62,22 +99,37 @@ void DrawTransition();
 // Update and draw one frame
 void UpdateDrawFrame(Arena& arena);
 
-#ifndef TESTS
-int main() {
+#if !defined(TESTS) && !defined(BENCHMARKS) && !defined(COOKER)
+// game [--record <replay>] [--no-frame-allocations]
+//
+// --record - записать ввод с начала уровня в файл для `benchmarks --replay`.
+// --no-frame-allocations - кадры геймплея с выделениями в куче - в лог,
+// в Debug - Assert. См. allocation_tracker.cpp.
+int main(int argc, char** argv) {
     // Initialization
     //---------------------------------------------------------
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--record") == 0) && (i + 1 < argc))
+            RecordGameplay(argv[++i]);
+        else if (strcmp(argv[i], "--no-frame-allocations") == 0)
+            allocationTracker.forbidFrameAllocations = true;
+    }
 
     // ref: https://www.reddit.com/r/raylib/comments/a19a67/resizable_window_questions/
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 
+    // Ресурсы из resources.pak (см. cooker), без него - из папки resources.
+    MountResourceArchive("resources.pak");
+
     InitWindow(800, 450, "raylib game template");
+    RequireGL43();
     MaximizeWindow();
 
     InitAudioDevice();  // Initialize audio device
 
     // Load global data (assets that must be available in all screens, i.e. font)
     font   = LoadFont("resources/mecha.png");
-    music  = LoadMusicStream("resources/ambient.ogg");
+    music  = LoadResourceMusic("resources/ambient.ogg");
     fxCoin = LoadSound("resources/coin.wav");
 
     SetMusicVolume(music, 1.0f);
@@ -86,6 +138,8 @@ int main() {
     Arena arena = {};
     arena.size  = 4096;
     arena.base  = (u8*)(RL_MALLOC(arena.size));
+    const int arenaPool
+        = RegisterArena(memoryRegistry, arena, "screens", MemorySubsystem::GLOBAL);
 
     // Setup and init first screen
     // currentScreen = GameScreen::TITLE;
@@ -127,6 +181,7 @@ int main() {
         break;
     }
 
+    UnregisterMemoryPool(memoryRegistry, arenaPool);
     RL_FREE(arena.base);
 
     // Unload global data loaded
@@ -137,6 +192,8 @@ int main() {
     CloseAudioDevice();  // Close audio context
 
     CloseWindow();  // Close window and OpenGL context
+
+    UnmountResourceArchive();
     //--------------------------------------------------------------------------------------
 
     return 0;
@@ -277,6 +334,7 @@ void UpdateDrawFrame(Arena& arena) {
     // Update
     //----------------------------------------------------------------------------------
     UpdateMusicStream(music);  // NOTE: Music keeps playing between screens
+    UpdateMemoryRegistry(memoryRegistry);
 
     if (IsKeyPressed(KEY_F11))
         ToggleBorderlessWindowed();
@@ -2,7 +2,8 @@ struct Arena {
     size_t      used;
     size_t      size;
     u8*         base;
-    const char* name;
+    const char* name;  // См. RegisterArena.
+    size_t      highWater;
 };
 
 #define AllocateFor(arena, type) rcast<type*>(Allocate_(arena, sizeof(type)))
@@ -26,11 +27,10 @@ struct Arena {
 
 #define DeallocateArray(arena, type, count) Deallocate_(arena, sizeof(type) * (count))
 
-//
-// TODO: Introduce the notion of `alignment` here!
-// NOTE: Refer to Casey's memory allocation functions
-// https://youtu.be/MvDUe2evkHg?list=PLEMXAbCVnmY6Azbmzj3BiC3QRYHE9QoG7&t=2121
-//
+#define AllocateAlignedArray(arena, type, count) \
+    rcast<type*>(AllocateAligned_(arena, sizeof(type) * (count), alignof(type)))
+
+// Без выравнивания. Выровненный адрес - AllocateAligned_.
 u8* Allocate_(Arena& arena, size_t size) {
     Assert(size > 0);
     Assert(arena.size >= size);
@@ -38,9 +38,20 @@ u8* Allocate_(Arena& arena, size_t size) {
 
     u8* result = arena.base + arena.used;
     arena.used += size;
+
+    arena.highWater = Max(arena.highWater, arena.used);
     return result;
 }
 
+// Как Allocate_, но адрес кратен alignment. Отступ тоже занимает арену.
+u8* AllocateAligned_(Arena& arena, size_t size, size_t alignment) {
+    const auto   address = (uintptr_t)(arena.base + arena.used);
+    const size_t padding = (alignment - address % alignment) % alignment;
+    if (padding > 0)
+        Allocate_(arena, padding);
+    return Allocate_(arena, size);
+}
+
 u8* AllocateZeros_(Arena& arena, size_t size) {
     auto result = Allocate_(arena, size);
     memset(result, 0, size);
@@ -53,6 +64,23 @@ void Deallocate_(Arena& arena, size_t size) {
     arena.used -= size;
 }
 
+Arena MakeArena(size_t size) {
+    Arena arena = {};
+    arena.size  = size;
+    arena.base  = (u8*)(RL_MALLOC(size));
+    return arena;
+}
+
+void FreeArena(Arena& arena) {
+    RL_FREE(arena.base);
+    arena = {};
+}
+
+// Всё, что было выделено из арены, освобождается разом.
+void ResetArena(Arena& arena) {
+    arena.used = 0;
+}
+
 // TEMP_USAGE используется для временного использования арены.
 // При вызове TEMP_USAGE запоминается текущее количество занятого
 // пространства арены, которое обратно устанавливается при выходе из scope.
@@ -0,0 +1,338 @@
+//----------------------------------------------------------------------------------
+// Memory Registry.
+//----------------------------------------------------------------------------------
+// Сколько памяти держит каждая подсистема на CPU и на GPU, и пик за всё время.
+// Превышение бюджета сразу пишется в лог. По пикам подбираются бюджеты,
+// размеры арен и пула вершин чанков под целевые машины.
+//
+// Память учитывается двумя способами:
+// - MemoryResized - подсистема сама сообщает, сколько байт держит сейчас;
+// - пулы (RegisterArena, RegisterMemoryPool) - подсистема держит capacity целиком,
+//   а used и его пик показывают, сколько из неё реально нужно.
+//
+// Всё - только с главного потока.
+//
+// Использование:
+//
+//     const auto level   = MemorySubsystem::LEVEL;
+//     i64        tracked = 0;
+//     MemoryResized(memoryRegistry, level, MemoryKind::GPU, tracked, size);
+//     ...
+//     MemoryResized(memoryRegistry, level, MemoryKind::GPU, tracked, 0);
+//
+//     DumpMemoryRegistry(memoryRegistry);
+//
+enum class MemorySubsystem {
+    GLOBAL = 0,  // Арена экранов, см. main.cpp.
+    LEVEL,       // Воксели, brick map, SDF, палитра.
+    CHUNKS,      // Клетки чанков, меши и их таблицы на GPU.
+    PARTICLES,
+    EFFECTS,     // Грапплеры, трейл.
+    AUDIO,
+    DEBUG,       // Отладочные линии.
+    COUNT,
+};
+
+const char* memorySubsystemNames[] = {
+    "global",
+    "level",
+    "chunks",
+    "particles",
+    "effects",
+    "audio",
+    "debug",
+};
+static_assert(sizeof(memorySubsystemNames) / sizeof(memorySubsystemNames[0])
+              == (int)MemorySubsystem::COUNT);
+
+enum class MemoryKind {
+    CPU = 0,
+    GPU,
+    COUNT,
+};
+
+const char* memoryKindNames[] = {"cpu", "gpu"};
+static_assert(sizeof(memoryKindNames) / sizeof(memoryKindNames[0])
+              == (int)MemoryKind::COUNT);
+
+const i64 MEMORY_KB = 1 << 10;
+const i64 MEMORY_MB = 1 << 20;
+
+// Байты, {CPU, GPU}. 0 - без бюджета.
+const i64 memoryBudgetsDefault[(int)MemorySubsystem::COUNT][(int)MemoryKind::COUNT] = {
+    {64 * MEMORY_KB, 0},                 // GLOBAL
+    {256 * MEMORY_MB, 256 * MEMORY_MB},  // LEVEL
+    {64 * MEMORY_MB, 80 * MEMORY_MB},    // CHUNKS. Пул - ChunkStreamer::memoryBudget.
+    {0, 4 * MEMORY_MB},                  // PARTICLES
+    {0, 1 * MEMORY_MB},                  // EFFECTS
+    {64 * MEMORY_MB, 0},                 // AUDIO
+    {16 * MEMORY_MB, 0},                 // DEBUG
+};
+
+struct MemoryUsage {
+    i64  used       = 0;
+    i64  highWater  = 0;
+    i64  budget     = 0;  // 0 - без бюджета.
+    bool overBudget = false;
+};
+
+// Арена или другой буфер, выделенный заранее целиком.
+struct MemoryPool {
+    const char*     name      = nullptr;
+    MemorySubsystem subsystem = {};
+    MemoryKind      kind      = {};
+    i64             capacity  = 0;  // 0 - пул выгружен.
+    i64             used      = 0;
+    i64             highWater = 0;  // Переживает выгрузку, см. RegisterMemoryPool.
+
+    const Arena* arena = nullptr;  // used берётся из арены.
+};
+
+const int MEMORY_POOLS_MAX = 32;
+
+struct MemoryRegistry {
+    MemoryUsage usage[(int)MemorySubsystem::COUNT][(int)MemoryKind::COUNT] = {};
+
+    MemoryPool pools[MEMORY_POOLS_MAX] = {};
+    int        poolsCount              = 0;
+};
+
+MemoryRegistry MakeMemoryRegistry() {
+    MemoryRegistry result = {};
+    FOR_RANGE (int, s, (int)MemorySubsystem::COUNT) {
+        FOR_RANGE (int, k, (int)MemoryKind::COUNT) {
+            result.usage[s][k].budget = memoryBudgetsDefault[s][k];
+        }
+    }
+    return result;
+}
+
+globalVar MemoryRegistry memoryRegistry = MakeMemoryRegistry();
+
+void CheckMemoryBudget_(MemoryRegistry& r, MemorySubsystem subsystem, MemoryKind kind) {
+    auto& u     = r.usage[(int)subsystem][(int)kind];
+    u.highWater = Max(u.highWater, u.used);
+
+    const bool overBudget = (u.budget > 0) && (u.used > u.budget);
+    if (overBudget && !u.overBudget) {
+        TraceLog(
+            LOG_WARNING,
+            "MEMORY: %s %s over budget: %.1f of %.1f MB",
+            memorySubsystemNames[(int)subsystem],
+            memoryKindNames[(int)kind],
+            (double)u.used / MEMORY_MB,
+            (double)u.budget / MEMORY_MB
+        );
+    }
+    u.overBudget = overBudget;
+}
+
+// tracked - сколько байт этот владелец сообщил в прошлый раз, обновляется.
+// bytes = 0 - владелец всё освободил.
+void MemoryResized(
+    MemoryRegistry& r,
+    MemorySubsystem subsystem,
+    MemoryKind      kind,
+    i64&            tracked,
+    i64             bytes
+) {
+    Assert(bytes >= 0);
+
+    auto& u = r.usage[(int)subsystem][(int)kind];
+    u.used += bytes - tracked;
+    tracked = bytes;
+    Assert(u.used >= 0);
+
+    CheckMemoryBudget_(r, subsystem, kind);
+}
+
+void SetMemoryBudget(
+    MemoryRegistry& r,
+    MemorySubsystem subsystem,
+    MemoryKind      kind,
+    i64             budget
+) {
+    r.usage[(int)subsystem][(int)kind].budget = budget;
+    CheckMemoryBudget_(r, subsystem, kind);
+}
+
+// Пул с тем же именем переиспользуется: пик копится между загрузками уровня.
+int RegisterMemoryPool(
+    MemoryRegistry& r,
+    const char*     name,
+    MemorySubsystem subsystem,
+    MemoryKind      kind,
+    i64             capacity
+) {
+    int pool = -1;
+    FOR_RANGE (int, i, r.poolsCount) {
+        if (strcmp(r.pools[i].name, name) == 0)
+            pool = i;
+    }
+    if (pool == -1) {
+        Assert(r.poolsCount < MEMORY_POOLS_MAX);
+        pool          = r.poolsCount++;
+        r.pools[pool] = {};
+    }
+
+    auto& p = r.pools[pool];
+    Assert(p.capacity == 0);
+
+    p.name      = name;
+    p.subsystem = subsystem;
+    p.kind      = kind;
+    p.used      = 0;
+    p.arena     = nullptr;
+    MemoryResized(r, subsystem, kind, p.capacity, capacity);
+    return pool;
+}
+
+void SetMemoryPoolUsed(MemoryRegistry& r, int pool, i64 used) {
+    auto& p     = r.pools[pool];
+    p.used      = used;
+    p.highWater = Max(p.highWater, used);
+}
+
+void UnregisterMemoryPool(MemoryRegistry& r, int pool) {
+    auto& p = r.pools[pool];
+    MemoryResized(r, p.subsystem, p.kind, p.capacity, 0);
+    p.used  = 0;
+    p.arena = nullptr;
+}
+
+// Заодно даёт арене имя. used и пик арены подтягивает UpdateMemoryRegistry.
+int RegisterArena(
+    MemoryRegistry& r,
+    Arena&          arena,
+    const char*     name,
+    MemorySubsystem subsystem
+) {
+    arena.name = name;
+
+    const int pool = RegisterMemoryPool(r, name, subsystem, MemoryKind::CPU, arena.size);
+    r.pools[pool].arena = &arena;
+    return pool;
+}
+
+// Раз в кадр.
+void UpdateMemoryRegistry(MemoryRegistry& r) {
+    FOR_RANGE (int, i, r.poolsCount) {
+        auto& p = r.pools[i];
+        if (p.arena == nullptr)
+            continue;
+
+        p.used      = (i64)p.arena->used;
+        p.highWater = Max(p.highWater, (i64)p.arena->highWater);
+    }
+}
+
+// Звук после LoadSound - уже в формате устройства.
+i64 SoundMemorySize(const Sound& sound) {
+    return (i64)sound.frameCount * sound.stream.channels * sound.stream.sampleSize / 8;
+}
+
+// Сначала подсистемы, потом пулы.
+int MemoryReportRowsCount(const MemoryRegistry& r) {
+    return (int)MemorySubsystem::COUNT * (int)MemoryKind::COUNT + r.poolsCount;
+}
+
+// nullptr - строка пустая, её не показываем. Результат - из TextFormat.
+const char* MemoryReportRow(const MemoryRegistry& r, int row) {
+    const int usageRows = (int)MemorySubsystem::COUNT * (int)MemoryKind::COUNT;
+    if (row < usageRows) {
+        const int   s = row / (int)MemoryKind::COUNT;
+        const int   k = row % (int)MemoryKind::COUNT;
+        const auto& u = r.usage[s][k];
+        if (u.highWater == 0)
+            return nullptr;
+
+        return TextFormat(
+            "%-9s %s %8.1f MB, peak %8.1f MB, budget %6.0f MB%s",
+            memorySubsystemNames[s],
+            memoryKindNames[k],
+            (double)u.used / MEMORY_MB,
+            (double)u.highWater / MEMORY_MB,
+            (double)u.budget / MEMORY_MB,
+            u.overBudget ? " OVER" : ""
+        );
+    }
+
+    const auto& p = r.pools[row - usageRows];
+    return TextFormat(
+        "  %-18s %s %8.1f KB, peak %8.1f KB of %8.1f KB",
+        p.name,
+        memoryKindNames[(int)p.kind],
+        (double)p.used / MEMORY_KB,
+        (double)p.highWater / MEMORY_KB,
+        (double)p.capacity / MEMORY_KB
+    );
+}
+
+void DumpMemoryRegistry(const MemoryRegistry& r) {
+    FOR_RANGE (int, i, MemoryReportRowsCount(r)) {
+        if (auto row = MemoryReportRow(r, i))
+            TraceLog(LOG_INFO, "MEMORY: %s", row);
+    }
+}
+
+TEST_CASE ("MemoryRegistry") {
+    static MemoryRegistry r = {};
+    r                       = MakeMemoryRegistry();
+
+    const auto level = MemorySubsystem::LEVEL;
+    const auto gpu   = MemoryKind::GPU;
+    const auto cpu   = MemoryKind::CPU;
+    auto&      u     = r.usage[(int)level][(int)gpu];
+
+    // Два владельца в одной подсистеме.
+    i64 a = 0;
+    i64 b = 0;
+    MemoryResized(r, level, gpu, a, 100);
+    MemoryResized(r, level, gpu, b, 50);
+    MemoryResized(r, level, gpu, a, 30);
+    Assert(a == 30);
+    Assert(u.used == 80);
+    Assert(u.highWater == 150);
+    Assert(r.usage[(int)level][(int)cpu].used == 0);
+
+    // Превышение бюджета и возврат в него.
+    SetMemoryBudget(r, level, gpu, 100);
+    Assert_False(u.overBudget);
+    MemoryResized(r, level, gpu, b, 200);
+    Assert(u.overBudget);
+    MemoryResized(r, level, gpu, b, 0);
+    Assert_False(u.overBudget);
+    Assert(u.used == 30);
+    Assert(u.highWater == 230);
+
+    // Арена: занятое и пик подтягиваются в UpdateMemoryRegistry.
+    u8    memory[64] = {};
+    Arena arena      = {};
+    arena.size       = sizeof(memory);
+    arena.base       = memory;
+
+    const int pool = RegisterArena(r, arena, "test arena", MemorySubsystem::GLOBAL);
+    Assert(strcmp(arena.name, "test arena") == 0);
+    Assert(r.usage[(int)MemorySubsystem::GLOBAL][(int)cpu].used == 64);
+    {
+        TEMP_USAGE(arena);
+        AllocateArray(arena, u8, 40);
+    }
+    AllocateArray(arena, u8, 8);
+    UpdateMemoryRegistry(r);
+    Assert(r.pools[pool].used == 8);
+    Assert(r.pools[pool].highWater == 40);
+    Assert(MemoryReportRow(r, MemoryReportRowsCount(r) - 1) != nullptr);
+
+    // Повторная регистрация под тем же именем - тот же пул, пик сохраняется.
+    UnregisterMemoryPool(r, pool);
+    Assert(r.usage[(int)MemorySubsystem::GLOBAL][(int)cpu].used == 0);
+    Assert(RegisterMemoryPool(r, "test arena", MemorySubsystem::GLOBAL, cpu, 16) == pool);
+    SetMemoryPoolUsed(r, pool, 4);
+    Assert(r.pools[pool].highWater == 40);
+    Assert(r.poolsCount == 1);
+
+    // Пустые подсистемы в отчёт не попадают.
+    Assert(MemoryReportRow(r, (int)MemorySubsystem::AUDIO * 2) == nullptr);
+    Assert(MemoryReportRow(r, (int)level * 2 + (int)gpu) != nullptr);
+}
@@ -0,0 +1,399 @@
+//----------------------------------------------------------------------------------
+// OpenGL functions that rlgl doesn't expose.
+//----------------------------------------------------------------------------------
+// rlgl покрывает не всё, что нам нужно (persistent mapping, fence-ы и т.д.).
+// Недостающие функции достаём сами через glfwGetProcAddress после создания контекста.
+//
+// Если функция недоступна (старый драйвер, web), указатель остаётся nullptr,
+// и вызывающий код обязан откатиться на путь через rlgl.
+
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_NEAREST 0x2600
+#define GL_R32F 0x822E
+#define GL_READ_ONLY 0x88B8
+#define GL_WRITE_ONLY 0x88B9
+
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_TRIANGLES 0x0004
+
+#define GL_TEXTURE_3D 0x806F
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_TEXTURE_WRAP_R 0x8072
+#define GL_LINEAR 0x2601
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_RED 0x1903
+#define GL_SHORT 0x1402
+#define GL_R16_SNORM 0x8F98
+
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MINOR_VERSION 0x821C
+
+#define GL_LINK_STATUS 0x8B82
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+
+#if defined(_WIN32)
+#    define GL_APIENTRY_ __stdcall
+#else
+#    define GL_APIENTRY_
+#endif
+
+using GLsync_ = struct GLsync_Opaque_*;
+using GLProc_ = void (*)();
+
+#if !defined(PLATFORM_WEB)
+// NOTE: GLFW собирается внутри raylib, поэтому функция доступна при линковке.
+extern "C" GLProc_ glfwGetProcAddress(const char* procname);
+#endif
+
+globalVar struct GLFunctions_ {
+    bool loaded = false;
+
+    void(GL_APIENTRY_* getIntegerv)(unsigned int pname, int* data)   = nullptr;
+    const unsigned char*(GL_APIENTRY_* getString)(unsigned int name) = nullptr;
+
+    void(GL_APIENTRY_* genBuffers)(int n, unsigned int* buffers)          = nullptr;
+    void(GL_APIENTRY_* deleteBuffers)(int n, const unsigned int* buffers) = nullptr;
+    void(GL_APIENTRY_* bindBuffer)(unsigned int target, unsigned int buffer) = nullptr;
+    void(GL_APIENTRY_* bindBufferRange)(
+        unsigned int target,
+        unsigned int index,
+        unsigned int buffer,
+        ptrdiff_t    offset,
+        ptrdiff_t    size
+    ) = nullptr;
+
+    // GL 4.4 / ARB_buffer_storage.
+    void(GL_APIENTRY_* bufferStorage)(
+        unsigned int target,
+        ptrdiff_t    size,
+        const void*  data,
+        unsigned int flags
+    ) = nullptr;
+    void*(GL_APIENTRY_* mapBufferRange)(
+        unsigned int target,
+        ptrdiff_t    offset,
+        ptrdiff_t    length,
+        unsigned int access
+    ) = nullptr;
+    unsigned char(GL_APIENTRY_* unmapBuffer)(unsigned int target) = nullptr;
+
+    GLsync_(GL_APIENTRY_* fenceSync)(unsigned int condition, unsigned int flags)
+        = nullptr;
+    unsigned int(GL_APIENTRY_* clientWaitSync)(
+        GLsync_      sync,
+        unsigned int flags,
+        uint64_t     timeout
+    ) = nullptr;
+    void(GL_APIENTRY_* deleteSync)(GLsync_ sync) = nullptr;
+
+    // GL 4.2. rlComputeShaderDispatch барьер не ставит.
+    void(GL_APIENTRY_* memoryBarrier)(unsigned int barriers) = nullptr;
+
+    // 3D текстуры. rlgl умеет только 2D и кубмапы.
+    void(GL_APIENTRY_* genTextures)(int n, unsigned int* textures)             = nullptr;
+    void(GL_APIENTRY_* bindTexture)(unsigned int target, unsigned int texture) = nullptr;
+    void(GL_APIENTRY_* texParameteri)(unsigned int target, unsigned int pname, int param)
+        = nullptr;
+    void(GL_APIENTRY_* pixelStorei)(unsigned int pname, int param) = nullptr;
+    void(GL_APIENTRY_* texImage3D)(
+        unsigned int target,
+        int          level,
+        int          internalFormat,
+        int          width,
+        int          height,
+        int          depth,
+        int          border,
+        unsigned int format,
+        unsigned int type,
+        const void*  data
+    ) = nullptr;
+
+    // GL 4.2. Текстуры с фиксированным набором мипов и запись в них из compute.
+    void(GL_APIENTRY_* texStorage2D)(
+        unsigned int target,
+        int          levels,
+        unsigned int internalFormat,
+        int          width,
+        int          height
+    ) = nullptr;
+    void(GL_APIENTRY_* bindImageTexture)(
+        unsigned int  unit,
+        unsigned int  texture,
+        int           level,
+        unsigned char layered,
+        int           layer,
+        unsigned int  access,
+        unsigned int  format
+    ) = nullptr;
+
+    // GL 4.3. Команды отрисовки берутся из GL_DRAW_INDIRECT_BUFFER.
+    void(GL_APIENTRY_* multiDrawArraysIndirect)(
+        unsigned int mode,
+        const void*  indirect,
+        int          drawCount,
+        int          stride
+    ) = nullptr;
+
+    // GL 4.1 / ARB_get_program_binary. Линковка программ в обход rlgl,
+    // чтобы выставить GL_PROGRAM_BINARY_RETRIEVABLE_HINT до glLinkProgram.
+    unsigned int(GL_APIENTRY_* createProgram)()                                 = nullptr;
+    void(GL_APIENTRY_* attachShader)(unsigned int program, unsigned int shader) = nullptr;
+    void(GL_APIENTRY_* detachShader)(unsigned int program, unsigned int shader) = nullptr;
+    void(GL_APIENTRY_* deleteShader)(unsigned int shader)                       = nullptr;
+    void(GL_APIENTRY_* linkProgram)(unsigned int program)                       = nullptr;
+    void(GL_APIENTRY_* getProgramiv)(
+        unsigned int program,
+        unsigned int pname,
+        int*         params
+    ) = nullptr;
+    void(GL_APIENTRY_* programParameteri)(
+        unsigned int program,
+        unsigned int pname,
+        int          value
+    ) = nullptr;
+    void(GL_APIENTRY_* getProgramBinary)(
+        unsigned int  program,
+        int           bufSize,
+        int*          length,
+        unsigned int* binaryFormat,
+        void*         binary
+    ) = nullptr;
+    void(GL_APIENTRY_* programBinary)(
+        unsigned int program,
+        unsigned int binaryFormat,
+        const void*  binary,
+        int          length
+    ) = nullptr;
+
+    // GL 3.3. Замеры времени на GPU.
+    void(GL_APIENTRY_* genQueries)(int n, unsigned int* ids)             = nullptr;
+    void(GL_APIENTRY_* deleteQueries)(int n, const unsigned int* ids)    = nullptr;
+    void(GL_APIENTRY_* beginQuery)(unsigned int target, unsigned int id) = nullptr;
+    void(GL_APIENTRY_* endQuery)(unsigned int target)                    = nullptr;
+    void(GL_APIENTRY_* getQueryObjectiv)(unsigned int id, unsigned int pname, int* params)
+        = nullptr;
+    void(GL_APIENTRY_* getQueryObjectui64v)(
+        unsigned int id,
+        unsigned int pname,
+        uint64_t*    params
+    ) = nullptr;
+} gl;
+
+// Должна вызываться после InitWindow.
+void LoadGLFunctions() {
+    if (gl.loaded)
+        return;
+    gl.loaded = true;
+
+#if !defined(PLATFORM_WEB)
+#    define LOAD_GL_FUNCTION_(member, name) \
+        gl.member = rcast<decltype(gl.member)>(glfwGetProcAddress(name))
+
+    LOAD_GL_FUNCTION_(getIntegerv, "glGetIntegerv");
+    LOAD_GL_FUNCTION_(getString, "glGetString");
+    LOAD_GL_FUNCTION_(genBuffers, "glGenBuffers");
+    LOAD_GL_FUNCTION_(deleteBuffers, "glDeleteBuffers");
+    LOAD_GL_FUNCTION_(bindBuffer, "glBindBuffer");
+    LOAD_GL_FUNCTION_(bindBufferRange, "glBindBufferRange");
+    LOAD_GL_FUNCTION_(bufferStorage, "glBufferStorage");
+    LOAD_GL_FUNCTION_(mapBufferRange, "glMapBufferRange");
+    LOAD_GL_FUNCTION_(unmapBuffer, "glUnmapBuffer");
+    LOAD_GL_FUNCTION_(fenceSync, "glFenceSync");
+    LOAD_GL_FUNCTION_(clientWaitSync, "glClientWaitSync");
+    LOAD_GL_FUNCTION_(deleteSync, "glDeleteSync");
+    LOAD_GL_FUNCTION_(memoryBarrier, "glMemoryBarrier");
+    LOAD_GL_FUNCTION_(genTextures, "glGenTextures");
+    LOAD_GL_FUNCTION_(bindTexture, "glBindTexture");
+    LOAD_GL_FUNCTION_(texParameteri, "glTexParameteri");
+    LOAD_GL_FUNCTION_(pixelStorei, "glPixelStorei");
+    LOAD_GL_FUNCTION_(texImage3D, "glTexImage3D");
+    LOAD_GL_FUNCTION_(texStorage2D, "glTexStorage2D");
+    LOAD_GL_FUNCTION_(bindImageTexture, "glBindImageTexture");
+    LOAD_GL_FUNCTION_(multiDrawArraysIndirect, "glMultiDrawArraysIndirect");
+    LOAD_GL_FUNCTION_(createProgram, "glCreateProgram");
+    LOAD_GL_FUNCTION_(attachShader, "glAttachShader");
+    LOAD_GL_FUNCTION_(detachShader, "glDetachShader");
+    LOAD_GL_FUNCTION_(deleteShader, "glDeleteShader");
+    LOAD_GL_FUNCTION_(linkProgram, "glLinkProgram");
+    LOAD_GL_FUNCTION_(getProgramiv, "glGetProgramiv");
+    LOAD_GL_FUNCTION_(programParameteri, "glProgramParameteri");
+    LOAD_GL_FUNCTION_(getProgramBinary, "glGetProgramBinary");
+    LOAD_GL_FUNCTION_(programBinary, "glProgramBinary");
+    LOAD_GL_FUNCTION_(genQueries, "glGenQueries");
+    LOAD_GL_FUNCTION_(deleteQueries, "glDeleteQueries");
+    LOAD_GL_FUNCTION_(beginQuery, "glBeginQuery");
+    LOAD_GL_FUNCTION_(endQuery, "glEndQuery");
+    LOAD_GL_FUNCTION_(getQueryObjectiv, "glGetQueryObjectiv");
+    LOAD_GL_FUNCTION_(getQueryObjectui64v, "glGetQueryObjectui64v");
+
+#    undef LOAD_GL_FUNCTION_
+#endif
+}
+
+bool GLSupportsPersistentMapping() {
+    return (gl.getIntegerv != nullptr)         //
+           && (gl.genBuffers != nullptr)       //
+           && (gl.deleteBuffers != nullptr)    //
+           && (gl.bindBuffer != nullptr)       //
+           && (gl.bindBufferRange != nullptr)  //
+           && (gl.bufferStorage != nullptr)    //
+           && (gl.mapBufferRange != nullptr)   //
+           && (gl.unmapBuffer != nullptr)      //
+           && (gl.fenceSync != nullptr)        //
+           && (gl.clientWaitSync != nullptr)   //
+           && (gl.deleteSync != nullptr);
+}
+
+bool GLSupportsTextures3D() {
+    return (gl.genTextures != nullptr)       //
+           && (gl.bindTexture != nullptr)    //
+           && (gl.texParameteri != nullptr)  //
+           && (gl.pixelStorei != nullptr)    //
+           && (gl.texImage3D != nullptr);
+}
+
+bool GLSupportsIndirectCulling() {
+    return (gl.memoryBarrier != nullptr)           //
+           && (gl.bindBuffer != nullptr)           //
+           && (gl.genTextures != nullptr)          //
+           && (gl.bindTexture != nullptr)          //
+           && (gl.texParameteri != nullptr)        //
+           && (gl.texStorage2D != nullptr)         //
+           && (gl.bindImageTexture != nullptr)     //
+           && (gl.multiDrawArraysIndirect != nullptr);
+}
+
+// Хоть один формат бинарников - драйвер может не поддерживать ни одного.
+bool GLSupportsProgramBinaries() {
+    const bool functions = (gl.getIntegerv != nullptr)          //
+                           && (gl.getString != nullptr)         //
+                           && (gl.createProgram != nullptr)     //
+                           && (gl.attachShader != nullptr)      //
+                           && (gl.detachShader != nullptr)      //
+                           && (gl.deleteShader != nullptr)      //
+                           && (gl.linkProgram != nullptr)       //
+                           && (gl.getProgramiv != nullptr)      //
+                           && (gl.programParameteri != nullptr) //
+                           && (gl.getProgramBinary != nullptr)  //
+                           && (gl.programBinary != nullptr);
+    if (!functions)
+        return false;
+
+    int formats = 0;
+    gl.getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+bool GLSupportsTimerQueries() {
+    return (gl.genQueries != nullptr)           //
+           && (gl.deleteQueries != nullptr)     //
+           && (gl.beginQuery != nullptr)        //
+           && (gl.endQuery != nullptr)          //
+           && (gl.getQueryObjectiv != nullptr)  //
+           && (gl.getQueryObjectui64v != nullptr);
+}
+
+// Мир рисуется через SSBO, compute-шейдеры и glMultiDrawArraysIndirect
+// (шейдеры - #version 430), запасного пути нет. Без GL 4.3 игра не запускается.
+void RequireGL43() {
+    LoadGLFunctions();
+
+    int major = 0;
+    int minor = 0;
+    if (gl.getIntegerv != nullptr) {
+        gl.getIntegerv(GL_MAJOR_VERSION, &major);
+        gl.getIntegerv(GL_MINOR_VERSION, &minor);
+    }
+
+    const bool version = (major > 4) || ((major == 4) && (minor >= 3));
+    if (!version || !GLSupportsIndirectCulling())
+        TraceLog(LOG_FATAL, "OpenGL 4.3 is required, got %d.%d", major, minor);
+}
+
+//----------------------------------------------------------------------------------
+// GPU Timer.
+//----------------------------------------------------------------------------------
+// Время, которое GPU потратил на команды между GpuTimerBegin и GpuTimerEnd.
+//
+// Результат запроса забирается через GPU_TIMER_LATENCY кадров, когда он уже готов,
+// поэтому CPU никогда не ждёт GPU. milliseconds - последний готовый замер.
+//
+// NOTE: rlgl копит отрисовку в батч. Перед GpuTimerBegin и GpuTimerEnd
+// нужно звать rlDrawRenderBatchActive, иначе замер уедет не туда.
+const int GPU_TIMER_LATENCY = 3;
+
+struct GpuTimer {
+    unsigned int queries[GPU_TIMER_LATENCY] = {};
+
+    int    frame        = 0;
+    double milliseconds = 0;
+};
+
+void GpuTimerBegin(GpuTimer& timer) {
+    if (!GLSupportsTimerQueries())
+        return;
+
+    if (timer.queries[0] == 0)
+        gl.genQueries(GPU_TIMER_LATENCY, timer.queries);
+
+    const auto query = timer.queries[timer.frame % GPU_TIMER_LATENCY];
+
+    if (timer.frame >= GPU_TIMER_LATENCY) {
+        int available = 0;
+        gl.getQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            uint64_t nanoseconds = 0;
+            gl.getQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            timer.milliseconds = (double)nanoseconds / 1000000.0;
+        }
+    }
+
+    gl.beginQuery(GL_TIME_ELAPSED, query);
+}
+
+void GpuTimerEnd(GpuTimer& timer) {
+    if (!GLSupportsTimerQueries())
+        return;
+
+    gl.endQuery(GL_TIME_ELAPSED);
+    timer.frame++;
+}
+
+void FreeGpuTimer(GpuTimer& timer) {
+    if (timer.queries[0] != 0)
+        gl.deleteQueries(GPU_TIMER_LATENCY, timer.queries);
+    timer = {};
+}
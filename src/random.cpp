@@ -0,0 +1,229 @@
+//----------------------------------------------------------------------------------
+// Random.
+//----------------------------------------------------------------------------------
+// Генераторы случайных чисел с явным состоянием (xoshiro128+).
+//
+// В отличие от GetRandomValue (libc rand()) у каждой подсистемы свой поток
+// со своим seed-ом, поэтому результат зависит только от seed-а и количества вызовов -
+// это нужно для воспроизведения и тестов.
+//
+// Random      - один поток, для единичных чисел.
+// RandomBatch - RANDOM_BATCH_LANES независимых потоков, которые продвигаются разом.
+//               Заполняет массивы через SSE2.
+//
+// ref: https://prng.di.unimi.it/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define RANDOM_SSE2_ 1
+#    include <emmintrin.h>
+#else
+#    define RANDOM_SSE2_ 0
+#endif
+
+// Для получения начальных состояний из одного seed-а.
+u64 SplitMix64(u64& state) {
+    u64 z = (state += 0x9E3779B97F4A7C15ull);
+    z     = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z     = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+u32 RotateLeft32_(u32 x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+// Старшие 23 бита -> мантисса числа из [1, 2) -> [0, 1).
+float U32ToFloat01_(u32 value) {
+    const u32 bits   = (value >> 9) | 0x3F800000u;
+    float     result = 0;
+    memcpy(&result, &bits, sizeof(result));
+    return result - 1.0f;
+}
+
+struct Random {
+    u32 s[4];
+};
+
+Random MakeRandom(u64 seed) {
+    Random result = {};
+    FOR_RANGE (int, i, 2) {
+        const u64 v         = SplitMix64(seed);
+        result.s[i * 2]     = (u32)v;
+        result.s[i * 2 + 1] = (u32)(v >> 32);
+    }
+    return result;
+}
+
+u32 RandomU32(Random& r) {
+    auto&     s      = r.s;
+    const u32 result = s[0] + s[3];
+    const u32 t      = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotateLeft32_(s[3], 11);
+
+    return result;
+}
+
+// [0, 1).
+float RandomFloat01(Random& r) {
+    return U32ToFloat01_(RandomU32(r));
+}
+
+// [from, to).
+float RandomFloat(Random& r, float from, float to) {
+    return from + (to - from) * RandomFloat01(r);
+}
+
+const int RANDOM_BATCH_LANES = 4;
+
+struct RandomBatch {
+    // Состояния потоков, по компоненте на массив.
+    alignas(16) u32 s0[RANDOM_BATCH_LANES];
+    alignas(16) u32 s1[RANDOM_BATCH_LANES];
+    alignas(16) u32 s2[RANDOM_BATCH_LANES];
+    alignas(16) u32 s3[RANDOM_BATCH_LANES];
+};
+
+RandomBatch MakeRandomBatch(u64 seed) {
+    RandomBatch result = {};
+    FOR_RANGE (int, i, RANDOM_BATCH_LANES) {
+        const u64 a  = SplitMix64(seed);
+        const u64 b  = SplitMix64(seed);
+        result.s0[i] = (u32)a;
+        result.s1[i] = (u32)(a >> 32);
+        result.s2[i] = (u32)b;
+        result.s3[i] = (u32)(b >> 32);
+    }
+    return result;
+}
+
+// Заполняет out числами из [from, to).
+// Последовательность не зависит от того, есть ли SSE2.
+// Если count не кратен RANDOM_BATCH_LANES, лишние числа последнего шага выбрасываются.
+void RandomFillFloats(RandomBatch& r, float* out, int count, float from, float to) {
+    Assert(count >= 0);
+
+    const float range = to - from;
+    int         i     = 0;
+
+#if RANDOM_SSE2_
+    auto s0 = _mm_load_si128((const __m128i*)r.s0);
+    auto s1 = _mm_load_si128((const __m128i*)r.s1);
+    auto s2 = _mm_load_si128((const __m128i*)r.s2);
+    auto s3 = _mm_load_si128((const __m128i*)r.s3);
+
+    const auto one       = _mm_set1_epi32(0x3F800000);
+    const auto fromV     = _mm_set1_ps(from);
+    const auto rangeV    = _mm_set1_ps(range);
+    const auto oneFloatV = _mm_set1_ps(1.0f);
+
+    for (; i + RANDOM_BATCH_LANES <= count; i += RANDOM_BATCH_LANES) {
+        const auto value = _mm_add_epi32(s0, s3);
+        const auto t     = _mm_slli_epi32(s1, 9);
+
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+        auto f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(value, 9), one));
+        f      = _mm_sub_ps(f, oneFloatV);
+        _mm_storeu_ps(out + i, _mm_add_ps(fromV, _mm_mul_ps(rangeV, f)));
+    }
+
+    _mm_store_si128((__m128i*)r.s0, s0);
+    _mm_store_si128((__m128i*)r.s1, s1);
+    _mm_store_si128((__m128i*)r.s2, s2);
+    _mm_store_si128((__m128i*)r.s3, s3);
+#endif
+
+    // Хвост (и всё, если SSE2 нет) - по одному шагу всех потоков за раз.
+    while (i < count) {
+        u32 values[RANDOM_BATCH_LANES];
+        FOR_RANGE (int, lane, RANDOM_BATCH_LANES) {
+            Random lr = {{r.s0[lane], r.s1[lane], r.s2[lane], r.s3[lane]}};
+            values[lane] = RandomU32(lr);
+            r.s0[lane]   = lr.s[0];
+            r.s1[lane]   = lr.s[1];
+            r.s2[lane]   = lr.s[2];
+            r.s3[lane]   = lr.s[3];
+        }
+
+        FOR_RANGE (int, lane, RANDOM_BATCH_LANES) {
+            if (i < count)
+                out[i++] = from + range * U32ToFloat01_(values[lane]);
+        }
+    }
+}
+
+TEST_CASE ("Random") {
+    SUBCASE ("Same seed - same sequence") {
+        auto a = MakeRandom(42);
+        auto b = MakeRandom(42);
+        auto c = MakeRandom(43);
+
+        bool same      = true;
+        bool different = false;
+        FOR_RANGE (int, i, 100) {
+            const auto va = RandomU32(a);
+            same &= va == RandomU32(b);
+            different |= va != RandomU32(c);
+        }
+        Assert(same);
+        Assert(different);
+    }
+
+    SUBCASE ("Range and mean") {
+        auto r = MakeRandom(1);
+
+        bool   inRange = true;
+        double sum     = 0;
+        FOR_RANGE (int, i, 10000) {
+            const float v = RandomFloat(r, -2, 3);
+            inRange &= (v >= -2) && (v < 3);
+            sum += v;
+        }
+        Assert(inRange);
+        Assert(fabs(sum / 10000 - 0.5) < 0.1);
+    }
+
+    SUBCASE ("Batch") {
+        const int count = 1003;  // Не кратно RANDOM_BATCH_LANES.
+
+        float values[count];
+        auto  batch = MakeRandomBatch(7);
+        RandomFillFloats(batch, values, count, 10, 20);
+
+        bool   inRange = true;
+        double sum     = 0;
+        for (float v : values) {
+            inRange &= (v >= 10) && (v < 20);
+            sum += v;
+        }
+        Assert(inRange);
+        Assert(fabs(sum / count - 15) < 0.5);
+
+        // Каждая дорожка - обычный xoshiro128+ со своим состоянием.
+        auto   batch2       = MakeRandomBatch(7);
+        Random lane1        = {{batch2.s0[1], batch2.s1[1], batch2.s2[1], batch2.s3[1]}};
+        bool   sameAsScalar = true;
+        FOR_RANGE (int, i, count / RANDOM_BATCH_LANES) {
+            const float expected = 10 + 10 * RandomFloat01(lane1);
+            sameAsScalar &= values[i * RANDOM_BATCH_LANES + 1] == expected;
+        }
+        Assert(sameAsScalar);
+
+        // Порции, кратные RANDOM_BATCH_LANES, дают ту же последовательность.
+        auto  batch3 = MakeRandomBatch(7);
+        float first[count];
+        RandomFillFloats(batch3, first, 400, 10, 20);
+        RandomFillFloats(batch3, first + 400, count - 400, 10, 20);
+        Assert(memcmp(first, values, count * sizeof(float)) == 0);
+    }
+}
@@ -0,0 +1,154 @@
+#version 430
+
+// Отбор чанков для glMultiDrawArraysIndirect.
+//
+// Чанк рисуется, если его AABB пересекает frustum и не закрыт пирамидой
+// глубины прошлого кадра. AABB проецируется матрицей прошлого кадра, поэтому
+// сравнение честное, но то, что только что открылось, появится на кадр позже.
+//
+// Команды видимых чанков пишутся подряд с начала commands.
+// Остальные команды обнуляются проходом с clearOnly = 1 и ничего не рисуют.
+//
+// LOD выбирается по расстоянию от камеры до AABB: LOD 0 ближе lodDistance,
+// дальше каждое удвоение расстояния - следующий LOD.
+
+layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+#define CHUNK_LODS 4
+
+// См. ChunkMesh.
+struct ChunkMesh {
+    vec3 boundsMin;
+    uint unused0;
+    vec3 boundsMax;
+    uint unused1;
+    uint first[CHUNK_LODS];
+    uint count[CHUNK_LODS];
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+};
+
+layout(std430, binding=0) readonly buffer ssbo0 { ChunkMesh chunks[]; };
+layout(std430, binding=1) buffer ssbo1 { DrawCommand commands[]; };
+layout(std430, binding=2) buffer ssbo2 {
+    uint visibleChunks;
+    uint visibleVertices;
+};
+
+// См. depth_pyramid_compute.glsl.
+layout(binding=0) uniform sampler2D depthPyramid;
+
+layout (location=0) uniform int clearOnly;
+layout (location=1) uniform int chunksCount;
+layout (location=2) uniform mat4 viewProjection;
+layout (location=3) uniform mat4 pyramidViewProjection;
+// 0 - пирамиды ещё нет, проверяется только frustum.
+layout (location=4) uniform int pyramidValid;
+// Размер экрана прошлого кадра в текселах уровня 0 (половина разрешения).
+layout (location=5) uniform vec2 pyramidScale;
+layout (location=6) uniform int pyramidLevels;
+layout (location=7) uniform vec3 cameraPosition;
+layout (location=8) uniform float lodDistance;
+
+vec3 Corner(vec3 boundsMin, vec3 boundsMax, int i)
+{
+    return mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+}
+
+// Чанк снаружи, если все 8 углов снаружи одной и той же плоскости.
+bool InsideFrustum(vec3 boundsMin, vec3 boundsMax)
+{
+    ivec3 below = ivec3(0);
+    ivec3 above = ivec3(0);
+    for (int i = 0; i < 8; i++) {
+        vec4 p = viewProjection * vec4(Corner(boundsMin, boundsMax, i), 1);
+        below += ivec3(lessThan(p.xyz, vec3(-p.w)));
+        above += ivec3(greaterThan(p.xyz, vec3(p.w)));
+    }
+    return all(lessThan(below, ivec3(8))) && all(lessThan(above, ivec3(8)));
+}
+
+bool Occluded(vec3 boundsMin, vec3 boundsMax)
+{
+    vec2 uvMin = vec2(1);
+    vec2 uvMax = vec2(0);
+    float nearest = 1;
+
+    for (int i = 0; i < 8; i++) {
+        vec4 p = pyramidViewProjection * vec4(Corner(boundsMin, boundsMax, i), 1);
+        // Пересекает плоскость камеры - считаем видимым.
+        if (p.w <= 0.0001)
+            return false;
+
+        vec3 ndc = p.xyz / p.w;
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    uvMin = clamp(uvMin, vec2(0), vec2(1));
+    uvMax = clamp(uvMax, vec2(0), vec2(1));
+
+    // Уровень, на котором прямоугольник занимает не больше 2x2 текселов.
+    vec2 size = (uvMax - uvMin) * pyramidScale;
+    int level = int(ceil(log2(max(max(size.x, size.y), 1))));
+    level = clamp(level, 0, pyramidLevels - 1);
+
+    ivec2 levelSize = textureSize(depthPyramid, level);
+    ivec2 a = clamp(ivec2(uvMin * pyramidScale) >> level, ivec2(0), levelSize - 1);
+    ivec2 b = clamp(ivec2(uvMax * pyramidScale) >> level, ivec2(0), levelSize - 1);
+
+    float farthest = max(
+        max(texelFetch(depthPyramid, a, level).r,
+            texelFetch(depthPyramid, ivec2(b.x, a.y), level).r),
+        max(texelFetch(depthPyramid, ivec2(a.x, b.y), level).r,
+            texelFetch(depthPyramid, b, level).r)
+    );
+    return nearest > farthest;
+}
+
+int SelectLod(vec3 boundsMin, vec3 boundsMax)
+{
+    float distance = length(clamp(cameraPosition, boundsMin, boundsMax) - cameraPosition);
+    if (distance < lodDistance)
+        return 0;
+    return min(int(log2(distance / lodDistance)) + 1, CHUNK_LODS - 1);
+}
+
+void main()
+{
+    int i = int(gl_GlobalInvocationID.x);
+
+    if (clearOnly != 0) {
+        if (i < chunksCount)
+            commands[i] = DrawCommand(0u, 0u, 0u, 0u);
+        if (i == 0) {
+            visibleChunks = 0u;
+            visibleVertices = 0u;
+        }
+        return;
+    }
+
+    if (i >= chunksCount)
+        return;
+
+    ChunkMesh chunk = chunks[i];
+    if (!InsideFrustum(chunk.boundsMin, chunk.boundsMax))
+        return;
+    if ((pyramidValid != 0) && Occluded(chunk.boundsMin, chunk.boundsMax))
+        return;
+
+    int lod = SelectLod(chunk.boundsMin, chunk.boundsMax);
+    uint count = chunk.count[lod];
+    if (count == 0u)
+        return;
+
+    uint slot = atomicAdd(visibleChunks, 1u);
+    atomicAdd(visibleVertices, count);
+    commands[slot] = DrawCommand(count, 1u, chunk.first[lod], 0u);
+}
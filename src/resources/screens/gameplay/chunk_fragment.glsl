@@ -0,0 +1,19 @@
+#version 430
+
+in vec3 fragPosition;
+in vec3 fragColor;
+flat in vec3 fragNormal;
+
+layout (location=1) uniform vec3 cameraPosition;
+
+out vec4 finalColor;
+
+void main()
+{
+    // Чёрные рёбра, как в world_raymarch_fragment.glsl.
+    vec3 toEdge = 0.5 - abs(fract(fragPosition) - 0.5) + abs(fragNormal);
+    float edgeWidth = 0.02 + distance(fragPosition, cameraPosition) * 0.001;
+    bool edge = min(toEdge.x, min(toEdge.y, toEdge.z)) < edgeWidth;
+
+    finalColor = edge ? vec4(0, 0, 0, 1) : vec4(fragColor, 1);
+}
@@ -0,0 +1,55 @@
+#version 430
+
+// Меш чанков мира. Вертексы берутся из SSBO по gl_VertexID:
+// у glMultiDrawArraysIndirect он уже включает first команды.
+
+#define CHUNK_SIZE 16
+#define CHUNK_COORD_BITS 10
+
+layout (location=0) uniform mat4 viewProjection;
+
+// См. ChunkVertex.
+struct ChunkVertex {
+    uint packed;
+    uint chunk;
+};
+layout(std430, binding=0) readonly buffer ssbo0 { ChunkVertex vertices[]; };
+layout(std430, binding=1) readonly buffer ssbo1 { vec4 palette[]; };
+
+const vec3 faceNormals[6] = vec3[6](
+    vec3(1, 0, 0),
+    vec3(-1, 0, 0),
+    vec3(0, 1, 0),
+    vec3(0, -1, 0),
+    vec3(0, 0, 1),
+    vec3(0, 0, -1)
+);
+
+out vec3 fragPosition;
+out vec3 fragColor;
+flat out vec3 fragNormal;
+
+void main()
+{
+    ChunkVertex vertex = vertices[gl_VertexID];
+
+    uvec3 local = uvec3(vertex.packed, vertex.packed >> 5, vertex.packed >> 10) & 31u;
+    uint face = (vertex.packed >> 15) & 7u;
+    float ao = float((vertex.packed >> 18) & 3u) / 3.0;
+    uint colorIndex = (vertex.packed >> 20) & 255u;
+
+    // bitfieldExtract для int расширяет знак.
+    int chunk = int(vertex.chunk);
+    ivec3 chunkCoords = ivec3(
+        bitfieldExtract(chunk, 0, CHUNK_COORD_BITS),
+        bitfieldExtract(chunk, CHUNK_COORD_BITS, CHUNK_COORD_BITS),
+        bitfieldExtract(chunk, 2 * CHUNK_COORD_BITS, CHUNK_COORD_BITS)
+    );
+    vec3 position = vec3(chunkCoords * CHUNK_SIZE) + vec3(local);
+
+    fragPosition = position;
+    fragColor = palette[colorIndex].rgb * mix(0.45, 1.0, ao);
+    fragNormal = faceNormals[face];
+
+    gl_Position = viewProjection * vec4(position, 1);
+}
@@ -0,0 +1,40 @@
+#version 430
+
+// Один уровень пирамиды глубины (Hi-Z). Тексел - самая дальняя глубина
+// из 2x2 текселов предыдущего уровня. Уровень 0 строится из буфера глубины.
+//
+// Размеры уровней округляются вверх, поэтому тексел (x, y) уровня L
+// покрывает текселы [x * 2^L, (x + 1) * 2^L) уровня 0 целиком.
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(binding=0) uniform sampler2D depth;
+layout(r32f, binding=0) readonly uniform image2D source;
+layout(r32f, binding=1) writeonly uniform image2D destination;
+
+// 1 - читаем depth, 0 - source.
+layout (location=0) uniform int fromDepth;
+layout (location=1) uniform ivec2 sourceSize;
+layout (location=2) uniform ivec2 destinationSize;
+
+float Load(ivec2 p)
+{
+    p = min(p, sourceSize - 1);
+    if (fromDepth != 0)
+        return texelFetch(depth, p, 0).r;
+    return imageLoad(source, p).r;
+}
+
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, destinationSize)))
+        return;
+
+    ivec2 s = p * 2;
+    float farthest = max(
+        max(Load(s), Load(s + ivec2(1, 0))),
+        max(Load(s + ivec2(0, 1)), Load(s + ivec2(1, 1)))
+    );
+    imageStore(destination, p, vec4(farthest));
+}
@@ -0,0 +1,10 @@
+#version 430
+
+in vec3 fragColor;
+
+out vec4 finalColor;
+
+void main()
+{
+    finalColor = vec4(fragColor, 1);
+}
@@ -0,0 +1,56 @@
+#version 430
+
+// Куб бота. Вертексы не передаются - 36 вертексов (6 граней по 2 полигона)
+// генерируются по gl_VertexID, позиция бота берётся из SSBO по gl_InstanceID.
+
+layout (location=0) uniform mat4 projectionMatrix;
+layout (location=1) uniform mat4 viewMatrix;
+// x - половина ширины, y - высота коллайдера.
+layout (location=2) uniform vec2 boxSize;
+
+// xyz - позиция (точка между ступнями), w - состояние:
+// 0 - на земле, 1 - в воздухе, 2 - на верёвке.
+layout(std430, binding=0) buffer ssbo0 { vec4 instances[]; };
+
+out vec3 fragColor;
+
+const vec3 normals[6] = vec3[](
+    vec3(1, 0, 0), vec3(-1, 0, 0),
+    vec3(0, 1, 0), vec3(0, -1, 0),
+    vec3(0, 0, 1), vec3(0, 0, -1)
+);
+
+// Два полигона грани против часовой стрелки в базисе (tangent, bitangent).
+const vec2 quad[6] = vec2[](
+    vec2(-1, -1), vec2(1, -1), vec2(1, 1),
+    vec2(-1, -1), vec2(1, 1), vec2(-1, 1)
+);
+
+const vec3 stateColors[3] = vec3[](
+    vec3(0.9, 0.8, 0.3),
+    vec3(0.3, 0.7, 0.9),
+    vec3(0.9, 0.3, 0.3)
+);
+
+void main()
+{
+    vec3 normal = normals[gl_VertexID / 6];
+    vec3 tangent = (abs(normal.y) > 0.5) ? vec3(1, 0, 0) : vec3(0, 1, 0);
+    // cross(tangent, bitangent) == normal, поэтому грань смотрит наружу.
+    vec3 bitangent = cross(normal, tangent);
+
+    vec2 q = quad[gl_VertexID % 6];
+    vec3 local = normal + tangent * q.x + bitangent * q.y;  // [-1, 1]^3
+
+    vec4 instance = instances[gl_InstanceID];
+    vec3 position = instance.xyz + vec3(
+        local.x * boxSize.x,
+        (local.y + 1) * 0.5 * boxSize.y,
+        local.z * boxSize.x
+    );
+
+    float light = 0.6 + 0.4 * max(dot(normal, normalize(vec3(0.3, 1, 0.5))), 0);
+    fragColor = stateColors[int(instance.w)] * light;
+
+    gl_Position = projectionMatrix * viewMatrix * vec4(position, 1);
+}
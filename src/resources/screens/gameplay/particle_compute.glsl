@@ -2,6 +2,12 @@
 // NOTE: Оставил комменты из примера.
 // ref: https://github.com/arceryz/raylib-gpu-particles/blob/master/Shaders/particle_compute.glsl
 //
+// Частицы живут только на GPU. За кадр этот шейдер:
+// 1. Записывает новые частицы кадра (spawns) в их ячейки кольца.
+// 2. Двигает остальные и сталкивает их с вокселями мира:
+//    компонента скорости, по оси которой частица влетела в воксель, отражается.
+//    Частицы, оказавшиеся внутри вокселя, убиваются.
+//
 
 // Version 430 supports compute shaders.
 #version 430
@@ -23,15 +29,98 @@ layout (local_size_x = 1024, local_size_y = 1, local_size_z = 1) in;
 //
 layout(std430, binding=0) buffer ssbo0 { vec4 positions[]; };
 layout(std430, binding=1) buffer ssbo1 { vec4 velocities[]; };
+layout(std430, binding=2) buffer ssbo2 { float timesOfCreation[]; };
+
+// См. ParticleSpawn. position.w - время создания.
+struct ParticleSpawn {
+    vec4 position;
+    vec4 velocity;
+};
+layout(std430, binding=3) readonly buffer ssbo3 { ParticleSpawn spawns[]; };
+
+// Brick map уровня, см. LoadGpuBrickMap.
+layout(std430, binding=5) readonly buffer ssbo5 { uint bricks[]; };
+layout(std430, binding=6) readonly buffer ssbo6 { uint cells[]; };
 
 // Uniform values are the way in which we can modify the shader efficiently.
 // These can be updated every frame efficiently.
 // We use layout(location=...) but you can also leave it and query the location in Raylib.
-layout(location=0) uniform float time;
-layout(location=1) uniform float timeScale;
-layout(location=2) uniform float dt;
+layout(location=0) uniform float dt;
+// Новые частицы занимают ячейки [spawnsFirst, spawnsFirst + spawnsCount) по кольцу.
+layout(location=1) uniform int spawnsFirst;
+layout(location=2) uniform int spawnsCount;
+layout(location=3) uniform ivec3 mapOrigin;
+layout(location=4) uniform ivec3 mapSize;  // В кирпичах.
+layout(location=5) uniform float restitution;
+
+// Время создания, при котором particle_fragment.glsl частицу уже не рисует.
+const float deadTimeOfCreation = -1000000;
+
+const int BRICK_SIZE_SHIFT = 3;
+const int BRICK_SIZE = 1 << BRICK_SIZE_SHIFT;
+const int BRICK_CELLS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+const uint BRICK_UNIFORM = 0x80000000u;
+
+// Как BrickMapIsSolid.
+bool VoxelOccupied(vec3 position) {
+    ivec3 cell = ivec3(floor(position)) - mapOrigin;
+    ivec3 b = cell >> BRICK_SIZE_SHIFT;
+    if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(b, mapSize)))
+        return false;
+
+    uint brick = bricks[(b.z * mapSize.y + b.y) * mapSize.x + b.x];
+    if (brick == 0u)
+        return false;
+    if ((brick & BRICK_UNIFORM) != 0u)
+        return (brick & 0xFFu) != 0u;
+
+    ivec3 c = cell & (BRICK_SIZE - 1);
+    int byteIndex = int(brick - 1u) * BRICK_CELLS
+        + (c.z * BRICK_SIZE + c.y) * BRICK_SIZE + c.x;
+    return ((cells[byteIndex >> 2] >> ((byteIndex & 3) * 8)) & 0xFFu) != 0u;
+}
 
 void main() {
-    uint index = gl_GlobalInvocationID.x;
-    positions[index].xyz += velocities[index].xyz * (dt * timeScale);
+    int index = int(gl_GlobalInvocationID.x);
+    int count = int(gl_NumWorkGroups.x * gl_WorkGroupSize.x);
+
+    int spawnIndex = (index - spawnsFirst + count) % count;
+    if (spawnIndex < spawnsCount) {
+        ParticleSpawn spawn = spawns[spawnIndex];
+        positions[index] = vec4(spawn.position.xyz, 0);
+        velocities[index] = spawn.velocity;
+        timesOfCreation[index] = spawn.position.w;
+        return;
+    }
+
+    vec3 position = positions[index].xyz;
+    vec3 velocity = velocities[index].xyz;
+
+    if (VoxelOccupied(position)) {
+        velocities[index].xyz = vec3(0);
+        timesOfCreation[index] = deadTimeOfCreation;
+        return;
+    }
+
+    vec3 next = position + velocity * dt;
+    if (VoxelOccupied(next)) {
+        // Отражаем компоненты по осям, вдоль которых влетели в воксель.
+        bvec3 hit = bvec3(
+            VoxelOccupied(vec3(next.x, position.y, position.z)),
+            VoxelOccupied(vec3(position.x, next.y, position.z)),
+            VoxelOccupied(vec3(position.x, position.y, next.z))
+        );
+        // Влетели точно в угол - отражаем все компоненты.
+        if (!any(hit))
+            hit = bvec3(true);
+
+        velocity = mix(velocity, -velocity * restitution, vec3(hit));
+
+        next = position + velocity * dt;
+        if (VoxelOccupied(next))
+            next = position;
+    }
+
+    positions[index].xyz = next;
+    velocities[index].xyz = velocity;
 }
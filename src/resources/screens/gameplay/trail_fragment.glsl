@@ -0,0 +1,15 @@
+#version 430
+
+in float fragAlpha;
+in float fragSide;
+
+layout (location=7) uniform vec3 color;
+
+out vec4 finalColor;
+
+void main()
+{
+    // К краям ленты прозрачнее.
+    float edge = 1 - abs(fragSide);
+    finalColor = vec4(color, fragAlpha * edge);
+}
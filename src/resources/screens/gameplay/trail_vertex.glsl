@@ -0,0 +1,70 @@
+#version 430
+
+// Лента следа. Вертексы не передаются - по 6 вертексов (2 полигона)
+// на отрезок между соседними точками генерируются по gl_VertexID.
+// Лента поворачивается к камере и сужается к концу по мере старения точек.
+
+layout (location=0) uniform mat4 projectionMatrix;
+layout (location=1) uniform mat4 viewMatrix;
+layout (location=2) uniform vec3 cameraPosition;
+layout (location=3) uniform float currentTime;
+layout (location=4) uniform float width;
+layout (location=5) uniform float lifetime;
+layout (location=6) uniform int pointsCount;
+
+// См. TrailPoint.
+struct TrailPoint {
+    vec3  position;
+    float time;
+    int   strip;
+};
+layout(std430, binding=0) buffer ssbo0 { TrailPoint points[]; };
+
+out float fragAlpha;
+out float fragSide;
+
+// Для каждого вертекса отрезка: x - какая из двух точек (0 / 1), y - сторона ленты.
+const vec2 corners[6] = vec2[](
+    vec2(0, -1), vec2(1, -1), vec2(1, 1),
+    vec2(0, -1), vec2(1, 1), vec2(0, 1)
+);
+
+void main()
+{
+    int segment = gl_VertexID / 6;
+    vec2 corner = corners[gl_VertexID % 6];
+
+    // Отрезок между разными полосами вырождается в точку.
+    if (points[segment].strip != points[segment + 1].strip) {
+        gl_Position = vec4(0, 0, 0, 1);
+        fragAlpha = 0;
+        fragSide = 0;
+        return;
+    }
+
+    int i = segment + int(corner.x);
+    TrailPoint point = points[i];
+
+    // Касательная - по соседям из той же полосы.
+    int prev = max(i - 1, 0);
+    int next = min(i + 1, pointsCount - 1);
+    if (points[prev].strip != point.strip)
+        prev = i;
+    if (points[next].strip != point.strip)
+        next = i;
+    vec3 tangent = points[next].position - points[prev].position;
+
+    vec3 side = cross(tangent, cameraPosition - point.position);
+    if (dot(side, side) < 0.000001)
+        side = vec3(0, 1, 0);
+    side = normalize(side);
+
+    float age = clamp((currentTime - point.time) / lifetime, 0, 1);
+    float halfWidth = 0.5 * width * (1 - age);
+
+    fragAlpha = 1 - age;
+    fragSide = corner.y;
+
+    vec3 position = point.position + side * corner.y * halfWidth;
+    gl_Position = projectionMatrix * viewMatrix * vec4(position, 1);
+}
@@ -0,0 +1,159 @@
+#version 430
+
+// Мир без мешей: луч из камеры через пиксель идёт по brick map-е (см. brick_map.cpp).
+//
+// Обход в два уровня, как в BrickMapRaycast: пустые кирпичи пролетаются целиком,
+// однородные дают попадание сразу, по клеткам шагаем только внутри остальных.
+// Цена зависит от разрешения экрана, а не от количества кубов.
+//
+// Глубина пишется в gl_FragDepth, поэтому частицы, верёвки и боты,
+// нарисованные после, корректно перекрываются миром.
+
+in vec2 fragNdc;
+
+// См. LoadGpuBrickMap.
+layout(std430, binding=5) readonly buffer ssbo5 { uint bricks[]; };
+layout(std430, binding=6) readonly buffer ssbo6 { uint cells[]; };
+// Цвет клетки со значением v - palette[v - 1].
+layout(std430, binding=7) readonly buffer ssbo7 { vec4 palette[]; };
+
+layout (location=0) uniform mat4 viewProjection;
+layout (location=1) uniform mat4 inverseViewProjection;
+layout (location=2) uniform vec3 cameraPosition;
+layout (location=3) uniform ivec3 mapOrigin;
+layout (location=4) uniform ivec3 mapSize;  // В кирпичах.
+layout (location=5) uniform float maxDistance;
+
+out vec4 finalColor;
+
+const int BRICK_SIZE = 8;
+const int BRICK_CELLS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+const uint BRICK_UNIFORM = 0x80000000u;
+
+// Ограничение на количество шагов, чтобы один пиксель не подвесил кадр.
+const int MAX_STEPS = 1024;
+
+uint CellValue(uint brick, ivec3 cell)
+{
+    if ((brick & BRICK_UNIFORM) != 0u)
+        return brick & 0xFFu;
+
+    ivec3 c = cell & (BRICK_SIZE - 1);
+    int byteIndex = int(brick - 1u) * BRICK_CELLS
+        + (c.z * BRICK_SIZE + c.y) * BRICK_SIZE + c.x;
+    return (cells[byteIndex >> 2] >> ((byteIndex & 3) * 8)) & 0xFFu;
+}
+
+// Ось, вдоль которой луч раньше всего выйдет из текущей клетки.
+int NextAxis(vec3 tMax)
+{
+    if ((tMax.x < tMax.y) && (tMax.x < tMax.z))
+        return 0;
+    return (tMax.y < tMax.z) ? 1 : 2;
+}
+
+void Shade(vec3 origin, vec3 direction, float t, ivec3 cell, vec3 normal, uint value)
+{
+    // Координаты относительно mapOrigin - у больших миров так точнее.
+    vec3 local = origin + direction * t;
+
+    // Чёрные рёбра, как у DrawCubeWiresV в растеризованном пути.
+    vec3 toEdge = 0.5 - abs(local - vec3(cell) - 0.5) + abs(normal);
+    float edgeWidth = 0.02 + t * 0.001;
+    bool edge = min(toEdge.x, min(toEdge.y, toEdge.z)) < edgeWidth;
+
+    finalColor = edge ? vec4(0, 0, 0, 1) : vec4(palette[value - 1u].rgb, 1);
+
+    vec4 clip = viewProjection * vec4(local + vec3(mapOrigin), 1);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+}
+
+void main()
+{
+    vec4 near = inverseViewProjection * vec4(fragNdc, -1, 1);
+    vec4 far = inverseViewProjection * vec4(fragNdc, 1, 1);
+
+    vec3 origin = cameraPosition - vec3(mapOrigin);
+    vec3 direction = normalize(far.xyz / far.w - near.xyz / near.w);
+
+    // Нулевые компоненты заменяем на очень маленькие, чтобы не делить на 0.
+    direction = mix(direction, vec3(1e-6), lessThan(abs(direction), vec3(1e-6)));
+    vec3 inverseDirection = 1 / direction;
+    ivec3 step = ivec3(sign(direction));
+
+    // Обрезаем луч по AABB карты.
+    vec3 extent = vec3(mapSize * BRICK_SIZE);
+    vec3 t0 = -origin * inverseDirection;
+    vec3 t1 = (extent - origin) * inverseDirection;
+    vec3 tNear = min(t0, t1);
+    vec3 tFar = max(t0, t1);
+
+    float t = max(max(tNear.x, tNear.y), max(tNear.z, 0));
+    float tExit = min(min(tFar.x, tFar.y), min(tFar.z, maxDistance));
+    if (t > tExit)
+        discard;
+
+    vec3 normal = vec3(0);
+    if (t > 0) {
+        int axis = 2;
+        if ((tNear.x >= tNear.y) && (tNear.x >= tNear.z))
+            axis = 0;
+        else if (tNear.y >= tNear.z)
+            axis = 1;
+        normal[axis] = -step[axis];
+    }
+
+    vec3 p = origin + direction * t;
+    ivec3 brick = clamp(ivec3(floor(p / BRICK_SIZE)), ivec3(0), mapSize - 1);
+    vec3 brickDelta = abs(inverseDirection) * BRICK_SIZE;
+    vec3 brickBorder = vec3((brick + max(step, 0)) * BRICK_SIZE);
+    vec3 brickMax = t + (brickBorder - p) * inverseDirection;
+
+    int steps = 0;
+    while ((t <= tExit) && (steps < MAX_STEPS)) {
+        uint value = bricks[(brick.z * mapSize.y + brick.y) * mapSize.x + brick.x];
+        float brickExit = min(tExit, min(brickMax.x, min(brickMax.y, brickMax.z)));
+
+        if (value != 0u) {
+            vec3 q = origin + direction * t;
+            ivec3 cellsMin = brick * BRICK_SIZE;
+            ivec3 cell = clamp(ivec3(floor(q)), cellsMin, cellsMin + BRICK_SIZE - 1);
+            vec3 cellMax = t + (vec3(cell + max(step, 0)) - q) * inverseDirection;
+            vec3 cellNormal = normal;
+            float tCell = t;
+
+            while ((tCell <= brickExit) && (steps < MAX_STEPS)) {
+                uint v = CellValue(value, cell);
+                if (v != 0u) {
+                    Shade(origin, direction, tCell, cell, cellNormal, v);
+                    return;
+                }
+
+                int axis = NextAxis(cellMax);
+                tCell = cellMax[axis];
+                cell[axis] += step[axis];
+                cellMax[axis] += abs(inverseDirection[axis]);
+                cellNormal = vec3(0);
+                cellNormal[axis] = -step[axis];
+                steps++;
+
+                int local = cell[axis] - cellsMin[axis];
+                if ((local < 0) || (local >= BRICK_SIZE))
+                    break;
+            }
+        }
+
+        int axis = NextAxis(brickMax);
+        t = brickMax[axis];
+        brick[axis] += step[axis];
+        brickMax[axis] += brickDelta[axis];
+        normal = vec3(0);
+        normal[axis] = -step[axis];
+        steps++;
+
+        if ((brick[axis] < 0) || (brick[axis] >= mapSize[axis]))
+            break;
+    }
+
+    discard;
+}
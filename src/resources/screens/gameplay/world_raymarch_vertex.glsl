@@ -0,0 +1,14 @@
+#version 430
+
+// Полноэкранный треугольник. Вертексы не передаются - генерируются по gl_VertexID:
+// (-1, -1), (3, -1), (-1, 3).
+
+out vec2 fragNdc;
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2 - 1;
+
+    fragNdc = position;
+    gl_Position = vec4(position, 0, 1);
+}
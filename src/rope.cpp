@@ -0,0 +1,483 @@
+//----------------------------------------------------------------------------------
+// Ropes.
+//----------------------------------------------------------------------------------
+// Верёвка состоит из двух частей:
+//
+// 1. Цепочка точек оборачивания (pivots). Первая - место зацепа, остальные -
+//    рёбра вокселей, за которые верёвка зацепилась по пути к игроку.
+//    Они определяются raycast-ами по сетке и задают геймплейное ограничение:
+//    игрок качается вокруг последней точки на оставшейся длине верёвки.
+//
+// 2. Визуальная симуляция - ROPE_POINTS точек, Verlet + position-based ограничения
+//    на расстояния между соседними точками. Точки, соответствующие pivot-ам,
+//    закрепляются, свободные точки выталкиваются из вокселей.
+//
+// Данные всех верёвок хранятся в SoA массивах фиксированного размера:
+// у верёвки r точки лежат в [r * ROPE_POINTS, (r + 1) * ROPE_POINTS).
+const int MAX_ROPES                  = 8;
+const int ROPE_POINTS                = 32;
+const int ROPE_MAX_PIVOTS            = 16;
+const int ROPE_CONSTRAINT_ITERATIONS = 8;
+
+const float ropeSimulationStep = 1.0f / 120.0f;
+const float ropeDamping        = 0.98f;
+const float ropeGravity        = -10.0f;
+// Насколько отодвигаем точку оборачивания от ребра вокселя наружу.
+const float ropeWrapOffset = 0.05f;
+
+struct Ropes {
+    float x[MAX_ROPES * ROPE_POINTS];
+    float y[MAX_ROPES * ROPE_POINTS];
+    float z[MAX_ROPES * ROPE_POINTS];
+    float prevX[MAX_ROPES * ROPE_POINTS];
+    float prevY[MAX_ROPES * ROPE_POINTS];
+    float prevZ[MAX_ROPES * ROPE_POINTS];
+    // 0 - точка закреплена, 1 - свободна.
+    float invMass[MAX_ROPES * ROPE_POINTS];
+
+    float pivotX[MAX_ROPES * ROPE_MAX_PIVOTS];
+    float pivotY[MAX_ROPES * ROPE_MAX_PIVOTS];
+    float pivotZ[MAX_ROPES * ROPE_MAX_PIVOTS];
+    // Нормаль плоскости изгиба в момент оборачивания.
+    // Когда изгиб меняет знак - верёвка разворачивается обратно.
+    Vector3 pivotBend[MAX_ROPES * ROPE_MAX_PIVOTS];
+
+    bool    active[MAX_ROPES];
+    float   length[MAX_ROPES];
+    int     pivotsCount[MAX_ROPES];
+    Vector3 end[MAX_ROPES];  // Куда крепится свободный конец (рука).
+
+    float accumulator;
+};
+
+Vector3 RopeGetPivot_(const Ropes& ropes, int rope, int pivot) {
+    const int i = rope * ROPE_MAX_PIVOTS + pivot;
+    return {ropes.pivotX[i], ropes.pivotY[i], ropes.pivotZ[i]};
+}
+
+void RopeSetPoint_(Ropes& ropes, int i, Vector3 p) {
+    ropes.x[i]     = p.x;
+    ropes.y[i]     = p.y;
+    ropes.z[i]     = p.z;
+    ropes.prevX[i] = p.x;
+    ropes.prevY[i] = p.y;
+    ropes.prevZ[i] = p.z;
+}
+
+void RopeAttach(Ropes& ropes, int rope, Vector3 anchor, Vector3 end, float length) {
+    Assert(rope >= 0);
+    Assert(rope < MAX_ROPES);
+
+    ropes.active[rope]      = true;
+    ropes.length[rope]      = length;
+    ropes.end[rope]         = end;
+    ropes.pivotsCount[rope] = 1;
+
+    const int p        = rope * ROPE_MAX_PIVOTS;
+    ropes.pivotX[p]    = anchor.x;
+    ropes.pivotY[p]    = anchor.y;
+    ropes.pivotZ[p]    = anchor.z;
+    ropes.pivotBend[p] = {};
+
+    FOR_RANGE (int, i, ROPE_POINTS) {
+        const float t = (float)i / (float)(ROPE_POINTS - 1);
+        RopeSetPoint_(ropes, rope * ROPE_POINTS + i, Vector3Lerp(anchor, end, t));
+    }
+}
+
+void RopeDetach(Ropes& ropes, int rope) {
+    ropes.active[rope] = false;
+}
+
+void RopeSetEnd(Ropes& ropes, int rope, Vector3 end) {
+    ropes.end[rope] = end;
+}
+
+// Последняя точка оборачивания - вокруг неё сейчас качается игрок.
+Vector3 RopeGetPivot(const Ropes& ropes, int rope) {
+    return RopeGetPivot_(ropes, rope, ropes.pivotsCount[rope] - 1);
+}
+
+// Длина верёвки за вычетом той её части, что уже намотана на воксели.
+float RopeGetFreeLength(const Ropes& ropes, int rope) {
+    float result = ropes.length[rope];
+    FOR_RANGE (int, i, ropes.pivotsCount[rope] - 1) {
+        result -= Vector3Distance(
+            RopeGetPivot_(ropes, rope, i), RopeGetPivot_(ropes, rope, i + 1)
+        );
+    }
+    return Max(0.0f, result);
+}
+
+// Ближайшая к отрезку [a, b] точка на рёбрах клетки.
+Vector3 ClosestPointOnCellEdges_(Vector3Int cell, Vector3 a, Vector3 b) {
+    const auto base = ToVector3(cell);
+
+    Vector3 result   = base;
+    float   bestDist = floatInf;
+
+    // 12 рёбер: по 4 вдоль каждой оси.
+    FOR_RANGE (int, axis, 3) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+
+        FOR_RANGE (int, corner, 4) {
+            Vector3 e0 = base;
+            (&e0.x)[u] += (float)(corner & 1);
+            (&e0.x)[v] += (float)(corner >> 1);
+
+            Vector3 e1 = e0;
+            (&e1.x)[axis] += 1;
+
+            // Ближайшие точки двух отрезков.
+            // ref: Ericson, Real-Time Collision Detection, 5.1.9.
+            const auto d1 = b - a;
+            const auto d2 = e1 - e0;
+            const auto r  = a - e0;
+            const auto aa = Vector3DotProduct(d1, d1);
+            const auto ee = Vector3DotProduct(d2, d2);
+            const auto f  = Vector3DotProduct(d2, r);
+            const auto c  = Vector3DotProduct(d1, r);
+            const auto bb = Vector3DotProduct(d1, d2);
+
+            float s = 0;
+            float t = 0;
+            if (aa <= 0.000001f) {
+                // Отрезок выродился в точку a.
+                t = Clamp(f / ee, 0, 1);
+            }
+            else {
+                const auto denom = aa * ee - bb * bb;
+                if (denom > 0.000001f)
+                    s = Clamp((bb * f - c * ee) / denom, 0, 1);
+
+                t = (bb * s + f) / ee;
+                if (t < 0) {
+                    t = 0;
+                    s = Clamp(-c / aa, 0, 1);
+                }
+                else if (t > 1) {
+                    t = 1;
+                    s = Clamp((bb - c) / aa, 0, 1);
+                }
+            }
+
+            const auto p1   = a + d1 * s;
+            const auto p2   = e0 + d2 * t;
+            const auto dist = Vector3DistanceSqr(p1, p2);
+            if (dist < bestDist) {
+                bestDist = dist;
+                result   = p2;
+            }
+        }
+    }
+
+    return result;
+}
+
+bool RopeSegmentIsBlocked_(
+    const BrickMap&  bricks,
+    Vector3          from,
+    Vector3          to,
+    VoxelRaycastHit* outHit
+) {
+    const auto d    = to - from;
+    const auto dist = Vector3Length(d);
+    if (dist <= ropeWrapOffset)
+        return false;
+
+    const auto hit = BrickMapRaycast(bricks, from, d / dist, dist - ropeWrapOffset);
+    if (outHit != nullptr)
+        *outHit = hit;
+    return hit.hit;
+}
+
+// Оборачивание верёвки вокруг вокселей и разворачивание обратно.
+//
+// point - точка, к которой привязана верёвка (игрок),
+// prevPoint - где она была на предыдущем шаге (когда верёвка ещё не пересекала воксели).
+void RopeUpdateWraps(
+    Ropes&           ropes,
+    int              rope,
+    const BrickMap&  bricks,
+    Vector3          point,
+    Vector3          prevPoint
+) {
+    Assert(ropes.active[rope]);
+
+    const int base  = rope * ROPE_MAX_PIVOTS;
+    auto&     count = ropes.pivotsCount[rope];
+
+    {  // Разворачивание.
+        while (count > 1) {
+            const auto a = RopeGetPivot_(ropes, rope, count - 2);
+            const auto b = RopeGetPivot_(ropes, rope, count - 1);
+
+            const auto bend = Vector3CrossProduct(b - a, point - b);
+            if (Vector3DotProduct(bend, ropes.pivotBend[base + count - 1]) > 0)
+                break;
+
+            // Изгиб сменил знак. Разворачиваемся, только если от предыдущей точки
+            // до игрока ничего не мешает.
+            if (RopeSegmentIsBlocked_(bricks, a, point, nullptr))
+                break;
+
+            count--;
+        }
+    }
+
+    {  // Оборачивание.
+        FOR_RANGE (int, attempt, 4) {
+            if (count >= ROPE_MAX_PIVOTS)
+                break;
+
+            const auto pivot = RopeGetPivot_(ropes, rope, count - 1);
+
+            VoxelRaycastHit hit = {};
+            if (!RopeSegmentIsBlocked_(bricks, pivot, point, &hit))
+                break;
+            if (hit.distance == 0)
+                break;
+
+            // Ищем момент, когда верёвка впервые задела воксель,
+            // двигая её конец от prevPoint к point.
+            float clear   = 0;
+            float blocked = 1;
+            if (!RopeSegmentIsBlocked_(bricks, pivot, prevPoint, nullptr)) {
+                FOR_RANGE (int, i, 10) {
+                    const float mid = (clear + blocked) / 2;
+
+                    const auto p = Vector3Lerp(prevPoint, point, mid);
+
+                    VoxelRaycastHit midHit = {};
+                    if (RopeSegmentIsBlocked_(bricks, pivot, p, &midHit)
+                        && (midHit.distance > 0))
+                    {
+                        blocked = mid;
+                        hit     = midHit;
+                    }
+                    else
+                        clear = mid;
+                }
+            }
+
+            // Цепляем верёвку за ребро вокселя, которого она едва коснулась.
+            const auto touching   = Vector3Lerp(prevPoint, point, blocked);
+            const auto edgePoint  = ClosestPointOnCellEdges_(hit.cell, pivot, touching);
+            const auto cellCenter = ToVector3(hit.cell) + Vector3One() * 0.5f;
+            const auto newPivot
+                = edgePoint + Vector3Normalize(edgePoint - cellCenter) * ropeWrapOffset;
+
+            const auto bend = Vector3CrossProduct(newPivot - pivot, point - newPivot);
+            if (Vector3LengthSqr(bend) < 0.000001f)
+                break;
+
+            const int i        = base + count;
+            ropes.pivotX[i]    = newPivot.x;
+            ropes.pivotY[i]    = newPivot.y;
+            ropes.pivotZ[i]    = newPivot.z;
+            ropes.pivotBend[i] = bend;
+            count++;
+
+            // Для следующего pivot-а верёвка "была" там, где коснулась этого ребра.
+            prevPoint = Vector3Lerp(prevPoint, point, clear);
+        }
+    }
+}
+
+// Verlet интеграция и ограничения на расстояния между точками.
+void SimulateRope_(Ropes& ropes, const BrickMap& bricks, int rope, float dt) {
+    const int from = rope * ROPE_POINTS;
+    const int to   = from + ROPE_POINTS;
+
+    float* x  = ropes.x;
+    float* y  = ropes.y;
+    float* z  = ropes.z;
+    float* px = ropes.prevX;
+    float* py = ropes.prevY;
+    float* pz = ropes.prevZ;
+    float* w  = ropes.invMass;
+
+    {  // Закрепляем точки на pivot-ах пропорционально длине пути вдоль верёвки.
+        const int pivotsCount = ropes.pivotsCount[rope];
+
+        float pathLength = 0;
+        FOR_RANGE (int, i, pivotsCount - 1) {
+            pathLength += Vector3Distance(
+                RopeGetPivot_(ropes, rope, i), RopeGetPivot_(ropes, rope, i + 1)
+            );
+        }
+        pathLength += Vector3Distance(RopeGetPivot(ropes, rope), ropes.end[rope]);
+
+        for (int i = from; i < to; i++)
+            w[i] = 1;
+
+        float walked = 0;
+        FOR_RANGE (int, i, pivotsCount) {
+            const auto p = RopeGetPivot_(ropes, rope, i);
+            if (i > 0)
+                walked += Vector3Distance(RopeGetPivot_(ropes, rope, i - 1), p);
+
+            const float t = walked / Max(pathLength, 0.0001f);
+
+            int index = (int)roundf(t * (ROPE_POINTS - 1));
+            index     = Min(index, ROPE_POINTS - 2);
+
+            RopeSetPoint_(ropes, from + index, p);
+            w[from + index] = 0;
+        }
+
+        RopeSetPoint_(ropes, to - 1, ropes.end[rope]);
+        w[to - 1] = 0;
+    }
+
+    {  // Verlet.
+        const float g = ropeGravity * dt * dt;
+
+        for (int i = from; i < to; i++) {
+            const float vx = (x[i] - px[i]) * ropeDamping;
+            const float vy = (y[i] - py[i]) * ropeDamping;
+            const float vz = (z[i] - pz[i]) * ropeDamping;
+
+            px[i] = x[i];
+            py[i] = y[i];
+            pz[i] = z[i];
+
+            x[i] += vx * w[i];
+            y[i] += (vy + g) * w[i];
+            z[i] += vz * w[i];
+        }
+    }
+
+    const float restLength = ropes.length[rope] / (float)(ROPE_POINTS - 1);
+
+    FOR_RANGE (int, iteration, ROPE_CONSTRAINT_ITERATIONS) {
+        for (int i = from; i < to - 1; i++) {
+            const float wSum = w[i] + w[i + 1];
+            if (wSum == 0)
+                continue;
+
+            const float dx = x[i + 1] - x[i];
+            const float dy = y[i + 1] - y[i];
+            const float dz = z[i + 1] - z[i];
+            const float d  = sqrtf(dx * dx + dy * dy + dz * dz);
+
+            // Верёвка не сопротивляется сжатию.
+            if (d <= restLength)
+                continue;
+
+            const float k = (d - restLength) / (d * wSum);
+
+            x[i] += dx * k * w[i];
+            y[i] += dy * k * w[i];
+            z[i] += dz * k * w[i];
+            x[i + 1] -= dx * k * w[i + 1];
+            y[i + 1] -= dy * k * w[i + 1];
+            z[i + 1] -= dz * k * w[i + 1];
+        }
+    }
+
+    // Выталкиваем свободные точки из вокселей через ближайшую грань.
+    for (int i = from; i < to; i++) {
+        if (w[i] == 0)
+            continue;
+
+        const int cx = (int)floorf(x[i]);
+        const int cy = (int)floorf(y[i]);
+        const int cz = (int)floorf(z[i]);
+        if (!BrickMapIsSolid(bricks, cx, cy, cz))
+            continue;
+
+        float* p[3]    = {x + i, y + i, z + i};
+        int    cell[3] = {cx, cy, cz};
+
+        int   bestAxis  = 0;
+        float bestDelta = floatInf;
+        FOR_RANGE (int, a, 3) {
+            const float down = (float)cell[a] - *p[a] - ropeWrapOffset;
+            const float up   = (float)(cell[a] + 1) - *p[a] + ropeWrapOffset;
+            const float d    = (fabsf(down) < fabsf(up)) ? down : up;
+            if (fabsf(d) < fabsf(bestDelta)) {
+                bestDelta = d;
+                bestAxis  = a;
+            }
+        }
+        *p[bestAxis] += bestDelta;
+    }
+}
+
+// Симуляция всех активных верёвок с фиксированным шагом ropeSimulationStep.
+void SimulateRopes(Ropes& ropes, const BrickMap& bricks, float dt) {
+    ropes.accumulator = Min(ropes.accumulator + dt, 8 * ropeSimulationStep);
+
+    while (ropes.accumulator >= ropeSimulationStep) {
+        ropes.accumulator -= ropeSimulationStep;
+
+        FOR_RANGE (int, rope, MAX_ROPES) {
+            if (ropes.active[rope])
+                SimulateRope_(ropes, bricks, rope, ropeSimulationStep);
+        }
+    }
+}
+
+void DrawRopePoints(const Ropes& ropes, int rope, bool wires) {
+    const Color color  = {211, 202, 181, 255};
+    const float radius = 0.1f;
+    const int   sides  = 8;
+
+    const int from = rope * ROPE_POINTS;
+    FOR_RANGE (int, i, ROPE_POINTS - 1) {
+        const int  j  = from + i;
+        const auto p0 = Vector3(ropes.x[j], ropes.y[j], ropes.z[j]);
+        const auto p1 = Vector3(ropes.x[j + 1], ropes.y[j + 1], ropes.z[j + 1]);
+
+        DrawCylinderEx(p0, p1, radius, radius, sides, color);
+        if (wires)
+            DrawCylinderWiresEx(p0, p1, radius, radius, sides, BLACK);
+    }
+}
+
+TEST_CASE ("RopeUpdateWraps") {
+    // Столб высотой 3 на (0, *, 0).
+    CubeVoxel cubes[] = {
+        {{0, 0, 0}, 0},
+        {{0, 1, 0}, 0},
+        {{0, 2, 0}, 0},
+    };
+    auto bricks = MakeBrickMap(cubes, 3);
+    defer {
+        FreeBrickMap(bricks);
+    };
+
+    // NOTE: Ropes большая, на стеке ей не место.
+    auto ropes = (Ropes*)RL_CALLOC(1, sizeof(Ropes));
+    defer {
+        RL_FREE(ropes);
+    };
+
+    const Vector3 anchor = {-3, 1.5f, 0.5f};
+    RopeAttach(*ropes, 0, anchor, {-3, 1.5f, 3}, 10);
+
+    // Игрок обходит столб, верёвка цепляется за оба его ребра со стороны +z.
+    RopeUpdateWraps(*ropes, 0, bricks, {3, 1.5f, 0.5f}, {-3, 1.5f, 3});
+    Assert(ropes->pivotsCount[0] == 3);
+
+    const auto pivot = RopeGetPivot(*ropes, 0);
+    Assert(pivot.x > 0.9f);
+    Assert(pivot.x < 1.1f);
+    Assert(pivot.z > 0.9f);
+    Assert(pivot.z < 1.1f);
+    Assert(RopeGetFreeLength(*ropes, 0) < 10 - Vector3Distance(anchor, pivot) + 0.001f);
+
+    // Возвращается обратно - верёвка разматывается.
+    RopeUpdateWraps(*ropes, 0, bricks, {-3, 1.5f, 3}, {3, 1.5f, 0.5f});
+    Assert(ropes->pivotsCount[0] == 1);
+    Assert(FloatEquals(RopeGetFreeLength(*ropes, 0), 10));
+
+    // Отрезок нулевой длины - ближайшая к точке точка рёбер.
+    const Vector3 point = {0.3f, 2, -1};
+    const auto    edge  = ClosestPointOnCellEdges_({0, 0, 0}, point, point);
+    Assert(FloatEquals(edge.x, 0.3f));
+    Assert(FloatEquals(edge.y, 1));
+    Assert(FloatEquals(edge.z, 0));
+}
@@ -5,24 +5,181 @@ static constexpr int fpsValues[] = {60, 20, 40};
 // Forward declarations.
 //----------------------------------------------------------------------------------
 struct PlayerState;
+
+void BeginSimulationOutput();
+void PublishGameplaySnapshot();
+void ConsumeGameplaySnapshot();
+void TrackGameplayMemory_();
 //----------------------------------------------------------------------------------
 
 const int PARTICLES_PER_SHADER_INSTANCE = 1024;
 const int NUMBER_OF_INSTANCES           = 16;
 const int NUM_PARTICLES = PARTICLES_PER_SHADER_INSTANCE * NUMBER_OF_INSTANCES;
 
-float GetRandomFloat(float from, float to) {
-    return from + (to - from) * (float)GetRandomValue(0, INT_MAX) / INT_MAX;
+// Сколько частица видна. Совпадает с opaqueDuration + fadeDuration
+// в particle_fragment.glsl.
+const float particleLifetime = 14.0f;
+
+// Доля скорости, которая остаётся у частицы после отскока от вокселя.
+const float particleRestitution = 0.4f;
+
+// Индекс верёвки игрока в gdata.ropes.
+const int PLAYER_ROPE = 0;
+
+// Конус, в котором ищется точка зацепа, если луч взгляда промахнулся.
+const float aimAssistHalfAngle = 2 * DEG2RAD;
+
+// Seed потока случайных чисел для частиц. Одинаковый seed и ввод - одинаковые частицы.
+const u64 particlesRandomSeed = 1;
+
+// Seed потока, из которого выводятся потоки ботов. См. SpawnGrapplers.
+const u64 grapplersRandomSeed = 2;
+
+// Дальше от игрока dash-и ботов не дают частиц.
+const float grapplerDashParticlesDistance = 60.0f;
+
+// Как рисуется мир (F7).
+//
+// RASTERIZED - меши чанков, отобранные на GPU. См. chunk_renderer.cpp.
+// RAYMARCHED - полноэкранный проход по brick map-е в world_raymarch_fragment.glsl.
+//              Цена зависит от разрешения, а не от количества кубов.
+enum class WorldRenderPath {
+    RASTERIZED = 0,
+    RAYMARCHED,
+    COUNT,
+};
+
+const char* worldRenderPathNames[] = {"rasterized", "raymarched"};
+static_assert(sizeof(worldRenderPathNames) / sizeof(worldRenderPathNames[0])
+              == (int)WorldRenderPath::COUNT);
+
+// Как часто пересчитываются перцентили на экране (F9). Сортировка
+// TELEMETRY_FRAMES кадров каждый кадр сама попала бы в телеметрию.
+const double telemetryReportPeriod = 0.5;
+
+// Телеметрия сохраняется сюда при выходе и по F10.
+const char* TELEMETRY_CSV_PATH = "telemetry.csv";
+
+// Дальше этого расстояния RAYMARCHED путь мир не рисует.
+const float raymarchMaxDistance = 1000.0f;
+
+const int PALETTE_BINDING = 7;
+
+// Больше кубов level.txt не грузит - это уже битый файл, а не уровень.
+// Из level.bricks кубы не разворачиваются, там предела нет.
+const int LEVEL_CUBES_MAX = 1 << 24;
+
+// NOTE: u8 в BrickMap знаковый, поэтому в палитре не может быть больше 127 цветов.
+const int LEVEL_COLORS_MAX = 127;
+
+// Арена уровня - ровно под палитру и кубы, с отступами на выравнивание.
+size_t LevelArenaSize(int colorsCount, int cubesCount) {
+    return colorsCount * sizeof(Color) + alignof(Color)  //
+           + cubesCount * sizeof(CubeVoxel) + alignof(CubeVoxel);
 }
 
-float GetRandomFloat01() {
-    return GetRandomFloat(0, 1);
+TEST_CASE ("LevelArenaSize") {
+    for (int colorsCount : {0, 1, 3, LEVEL_COLORS_MAX}) {
+        for (int cubesCount : {0, 1, 7, 1000}) {
+            auto arena = MakeArena(LevelArenaSize(colorsCount, cubesCount));
+            MakeFixedArray<Color>(arena, colorsCount);
+            MakeFixedArray<CubeVoxel>(arena, cubesCount);
+            Assert(arena.used <= arena.size);
+            FreeArena(arena);
+        }
+    }
 }
 
-struct CubeVoxel {
-    Vector3Int pos;
-    int        colorIndex;
-};
+// Палитра - в начале level.txt и в level.palette: количество, потом r g b.
+// При битом количестве палитра пустая.
+std::vector<Color> ParseLevelPalette_(std::istream& iss) {
+    int colorsCount = 0;
+    iss >> colorsCount;
+    if (!iss || colorsCount < 0 || colorsCount > LEVEL_COLORS_MAX) {
+        TraceLog(LOG_ERROR, "Level: bad colors count %d", colorsCount);
+        colorsCount = 0;
+    }
+
+    std::vector<Color> colors(colorsCount);
+    for (auto& color : colors) {
+        int r = 0;
+        int g = 0;
+        int b = 0;
+        iss >> r;
+        iss >> g;
+        iss >> b;
+        color.r = (unsigned char)r;
+        color.g = (unsigned char)g;
+        color.b = (unsigned char)b;
+        color.a = 255;
+    }
+    return colors;
+}
+
+// Уровень из level.bricks. Индексы палитры проверяются по клеткам карты,
+// кубы не разворачиваются. Возвращает false, если файл битый или в нём
+// есть цвет вне палитры. out при этом не трогается.
+bool LoadLevelBricks_(const u8* data, int dataSize, int colorsCount, BrickMap& out) {
+    BrickMap map = {};
+    if (!DeserializeBrickMap(data, dataSize, map))
+        return false;
+
+    const int maxValue = BrickMapMaxValue(map);
+    if (maxValue > colorsCount) {
+        TraceLog(LOG_ERROR, "Level: color index %d is out of palette", maxValue - 1);
+        FreeBrickMap(map);
+        return false;
+    }
+
+    out = map;
+    return true;
+}
+
+TEST_CASE ("LoadLevelBricks_") {
+    // Больше LEVEL_CUBES_MAX кубов: 33x32x32 однородных кирпичей цвета 1
+    // и один кирпич с клетками цветов 0 и 2.
+    BrickMap map    = {};
+    map.size        = {33, 32, 32};
+    map.cellsBricks = 1;
+    map.bricks      = (u32*)RL_MALLOC(BrickMapBricksCount(map) * sizeof(u32));
+    map.cells       = (u8*)RL_MALLOC(BRICK_CELLS);
+    defer {
+        FreeBrickMap(map);
+    };
+    FOR_RANGE (int, i, BrickMapBricksCount(map)) {
+        map.bricks[i] = BRICK_UNIFORM | 2;
+    }
+    map.bricks[0] = 1;
+    memset(map.cells, 1, BRICK_CELLS);
+    map.cells[5] = 3;
+
+    const auto data = SerializeBrickMap(map);
+
+    BrickMap loaded = {};
+    Assert(LoadLevelBricks_(data.data(), (int)data.size(), 3, loaded));
+    Assert(BrickMapCubesCount(loaded) > LEVEL_CUBES_MAX);
+    Assert(BrickMapCubesCount(loaded) == BrickMapBricksCount(map) * BRICK_CELLS);
+    Assert(BrickMapGet(loaded, 5, 0, 0) == 3);
+    FreeBrickMap(loaded);
+
+    // Цвет 2 вне палитры из двух цветов.
+    Assert_False(LoadLevelBricks_(data.data(), (int)data.size(), 2, loaded));
+    Assert(loaded.bricks == nullptr);
+
+    // Обрезанный файл.
+    Assert_False(LoadLevelBricks_(data.data(), (int)data.size() - 1, 3, loaded));
+
+    std::istringstream palette("2\n255 0 0\n0 255 0\n");
+    const auto         colors = ParseLevelPalette_(palette);
+    Assert(colors.size() == 2);
+    Assert(colors[1].g == 255);
+
+    std::istringstream broken("-1\n");
+    Assert(ParseLevelPalette_(broken).empty());
+}
+
+// Временные отладочные линии (F3 - очистить). Самые старые затираются.
+const int DEBUG_LINES_MAX = 4096;
 
 globalVar struct DashConfig_ {
     float amountToGenerate = 737;
@@ -35,6 +192,124 @@ globalVar struct DashConfig_ {
     float maxLivingDuration = 9.9f;
 } dashConfig;
 
+//----------------------------------------------------------------------------------
+// Simulation / Rendering split.
+//----------------------------------------------------------------------------------
+// Симуляция (игрок, верёвки, выпускание частиц) не трогает ни ввод, ни звук,
+// ни GPU. Она получает GameplayInput, а результат тика отдаёт в GameplaySnapshot.
+// Отрисовка читает только снапшот.
+//
+// Благодаря этому симуляцию можно запускать в отдельном потоке (F4):
+// пока главный поток рисует снапшот тика N, поток симуляции считает тик N + 1.
+// Время кадра становится max(симуляция, отрисовка) вместо их суммы
+// ценой одного кадра задержки.
+
+enum class GameplaySounds {
+    JUMP = 0,
+    BOOST,
+    DASH,
+    GRAPPLE,
+    GRAPPLE_BACK,
+    COUNT,
+};
+
+// Ввод за кадр. Собирается на главном потоке в CaptureGameplayInput.
+struct GameplayInput {
+    float  dt   = 0;
+    double time = 0;
+
+    Vector2 mouseDelta = {};
+    Vector2 movement   = {};
+
+    bool jumpPressed    = false;
+    bool boostDown      = false;
+    bool dashPressed    = false;
+    bool grapplePressed = false;
+
+    bool        gizmosEnabled = false;
+    DashConfig_ dashConfig    = {};
+
+    int  grapplersToSpawn = 0;
+    bool clearGrapplers   = false;
+};
+
+// Запись ввода с начала геймплея: тот же ввод с того же старта даёт
+// ту же симуляцию. Для сравнения сборок на одинаковой нагрузке (benchmarks --replay).
+//
+// Файл:
+// u32            GAMEPLAY_REPLAY_MAGIC
+// i32            sizeof(GameplayInput) - запись другой сборки с другим вводом не читается
+// i32            inputsCount
+// GameplayInput  inputs[inputsCount]
+const u32 GAMEPLAY_REPLAY_MAGIC = 0x314C5052;  // "RPL1".
+
+static_assert(std::is_trivially_copyable_v<GameplayInput>);
+
+struct GameplayReplayHeader_ {
+    u32 magic       = GAMEPLAY_REPLAY_MAGIC;
+    int inputSize   = sizeof(GameplayInput);
+    int inputsCount = 0;
+};
+
+struct GameplayReplay {
+    std::vector<GameplayInput> inputs = {};
+
+    int    next       = 0;  // Воспроизведение идёт по кругу.
+    double timeOffset = 0;  // input.time записи -> GetTime() воспроизведения.
+};
+
+// Раскладка совпадает с ParticleSpawn в particle_compute.glsl.
+struct ParticleSpawn {
+    Vector4 position = {};  // w - время создания.
+    Vector4 velocity = {};
+};
+
+struct ParticleSpawnBatch_ {
+    double time  = 0;
+    int    count = 0;
+};
+
+struct DebugLine_ {
+    Vector3 from  = {};
+    Vector3 to    = {};
+    Color   color = {};
+};
+
+// Всё, что нужно отрисовке от тика симуляции.
+struct GameplaySnapshot {
+    int tick = 0;
+
+    Vector3 position         = {};
+    Vector3 velocity         = {};
+    Vector3 lookingDirection = {};
+    bool    isAirborne       = false;
+
+    bool    collided           = false;
+    bool    ropeActivated      = false;
+    Vector3 lookingAtCollision = {};
+
+    double lastDashTime             = -doubleInf;
+    double buttonGrapplePressedTime = -doubleInf;
+    double buttonJumpPressedTime    = -doubleInf;
+    double buttonBoostPressedTime   = -doubleInf;
+    double buttonDashPressedTime    = -doubleInf;
+
+    Ropes ropes = {};
+
+    std::vector<Vector4> grapplers = {};  // См. GetGrapplerInstances.
+
+    std::vector<TrailPoint> boostTrail = {};  // От самой старой точки к новой.
+
+    // События тика. Применяются на главном потоке в ConsumeGameplaySnapshot.
+    std::vector<ParticleSpawn> particleSpawns = {};
+    std::vector<Vector3>       linesToDraw    = {};
+    std::vector<Color>         colorsOfLines  = {};
+
+    GameplaySounds sounds[(int)GameplaySounds::COUNT] = {};
+    int            soundsCount                        = 0;
+    float          boostVolume                        = 0;
+};
+
 globalVar struct GData_ {
     int  currentFPSValueIndex = 0;
     bool gizmosEnabled        = true;
@@ -53,23 +328,97 @@ globalVar struct GData_ {
     int    fxFootstepsCount = {};
     Sound* fxFootsteps      = {};
 
-    std::vector<CubeVoxel> cubes  = {};
-    std::vector<Color>     colors = {};
+    // Уровень. cubes и colors - в levelArena, уходят вместе с ней.
+    Arena                 levelArena     = {};
+    int                   levelArenaPool = -1;
+    FixedArray<CubeVoxel> cubes          = {};
+    FixedArray<Color>     colors         = {};
+    BrickMap              bricks         = {};  // Коллизии, запросы, частицы.
+
+    Ropes     ropes     = {};
+    Grapplers grapplers = {};
+
+    // Расстояния от ботов до игрока на текущем тике. См. SimulateGameplay.
+    float grapplerDistances[MAX_GRAPPLERS] = {};
 
-    std::vector<Vector3> linesToDraw   = {};
-    std::vector<Color>   colorsOfLines = {};
+    // Принадлежит симуляции.
+    RandomBatch particlesRandom = {};
+    Random      grapplersRandom = {};
+    Trail       boostTrail      = {};
+
+    Arena                  debugArena     = {};
+    int                    debugArenaPool = -1;
+    RingBuffer<DebugLine_> debugLines     = {};
+
+    // Симуляция.
+    GameplayInput input       = {};  // Ввод текущего тика. Принадлежит симуляции.
+    GameplayInput queuedInput = {};  // Ввод для тика, запускаемого в потоке симуляции.
+    int           simTick     = 0;
+
+    bool         pipelined = false;
+    WorkerThread simThread = {};
+
+    TripleBuffer<GameplaySnapshot> snapshots    = {};
+    int                            consumedTick = -1;
+
+    double simMilliseconds = 0;  // Последний тик. Пишется симуляцией.
+
+    // Ввод берётся из replay, а не с клавиатуры. См. PlayGameplayReplay.
+    GameplayReplay replay = {};
+
+    // Запись ввода, сохраняется в UnloadGameplayScreen. См. RecordGameplay.
+    std::string                recordPath = {};
+    std::vector<GameplayInput> recorded   = {};
+
+    // Перцентили телеметрии (F9). Пересчитываются раз в telemetryReportPeriod.
+    TelemetryPercentiles telemetryReport[(int)TelemetryMetric::COUNT] = {};
+
+    bool   telemetryOverlay    = false;
+    double telemetryReportTime = -doubleInf;
+
+    // Байты, сообщённые в memoryRegistry. См. TrackGameplayMemory_.
+    i64  trackedMemory[(int)MemorySubsystem::COUNT][(int)MemoryKind::COUNT] = {};
+    int  chunkVerticesPool = -1;
+    bool memoryOverlay     = false;
 
     // Particles.
     // ref: https://github.com/arceryz/raylib-gpu-particles/blob/master/main.c
-    Shader       particleShader = {};
-    unsigned int ssbo0          = 0;
-    unsigned int ssbo1          = 0;
-    unsigned int ssbo2          = 0;
-    // Данные частиц, время жизни которых закончилось,
-    // перемещаются в правые части массивов.
-    Vector4*     positions                   = nullptr;
-    Vector4*     velocities                  = nullptr;
-    float*       timesOfCreation             = nullptr;
+    Shader       particleShader          = {};
+    unsigned int particleComputeShader   = 0;
+    unsigned int particlePositions       = 0;
+    unsigned int particleVelocities      = 0;
+    unsigned int particleTimesOfCreation = 0;
+    StreamBuffer particleSpawns          = {};
+
+    // Новые частицы, которые ещё не залиты на GPU.
+    std::vector<ParticleSpawn> particleSpawnsQueue = {};
+
+    // Сколько частиц создано за последние particleLifetime секунд.
+    // Частицы, застрявшие в вокселях, умирают раньше - это оценка сверху.
+    std::vector<ParticleSpawnBatch_> particleBatches = {};
+    int                              liveParticles   = 0;
+
+    World world = {};  // Запросы к bricks. См. world_query.cpp.
+
+    Shader       grapplerShader    = {};
+    StreamBuffer grapplerInstances = {};
+
+    Shader       trailShader = {};
+    StreamBuffer trailPoints = {};
+
+    WorldRenderPath worldRenderPath = WorldRenderPath::RASTERIZED;
+    Shader          raymarchShader  = {};
+    GpuBrickMap     gpuBricks       = {};
+    unsigned int    palette         = 0;  // SSBO, vec4 на цвет. См. PALETTE_BINDING.
+    ChunkRenderer   chunkRenderer   = {};
+    ChunkStreamer   chunkStreamer   = {};  // Наполняет chunkRenderer.
+
+    // Сцена рисуется в свою текстуру: её глубина нужна для пирамиды (F8).
+    RenderTexture2D sceneTarget = {};
+
+    // Время на GPU, потраченное на мир, для каждого WorldRenderPath.
+    GpuTimer worldTimers[(int)WorldRenderPath::COUNT] = {};
+
     int          nextToGenerateParticleIndex = 0;
     unsigned int particleVao                 = 0;
 } gdata;
@@ -84,6 +433,9 @@ globalVar struct GPlayer_ {
 
     PlayerState* currentState = nullptr;
 
+    // Контакты с вокселями за текущий кадр.
+    VoxelContacts contacts = {};
+
     bool    collided           = false;
     Vector3 lookingAtCollision = {};
 
@@ -107,23 +459,43 @@ globalVar struct GPlayer_ {
 
     inline static const float boostSoundInterval = 0.13f;
 
-    inline static const float airSpeed      = 2.0f;
-    inline static const float speed         = 10.0f;   // m / s
-    inline static const float jumpImpulse   = 80.0f;   // m
-    inline static const float gravity       = -10.0f;  // m / s / s
-    inline static const float velocityDecay = 0.1f;
-    inline static const float mass          = 10.0f;  // kg
-
-    inline static const float boostAmount = 3.3f;
-    inline static const float maxVelocity = 28.0f;
-    inline static const float dashImpulse = 200.0f;
+    // Остальное - в MovementConfig, общем с ботами.
+    inline static const float maxVelocity = movementConfig.maxVelocity;
 
-    inline static const float particlesAmountPerSecond = 800.0f;
+    // Основная часть эффекта буста - след (см. Trail), частицы - редкие искры поверх.
+    inline static const float sparklesPerSecond = 40.0f;
+    // Дробная часть искр, которые не успели заспавниться на прошлых тиках.
+    float sparklesToSpawn = 0;
 } gplayer;
 
 //----------------------------------------------------------------------------------
 // Gameplay Functions Definition.
 //----------------------------------------------------------------------------------
+
+// Снапшот, в который симуляция пишет результат текущего тика.
+GameplaySnapshot& SimulationOutput() {
+    return TripleBufferWriteBuffer(gdata.snapshots);
+}
+
+void QueueSound(GameplaySounds sound) {
+    auto& output = SimulationOutput();
+    Assert(output.soundsCount < (int)GameplaySounds::COUNT);
+    output.sounds[output.soundsCount++] = sound;
+}
+
+void QueueParticleSpawn(Vector3 position, Vector3 velocity, float timeOfCreation) {
+    SimulationOutput().particleSpawns.push_back(
+        {{position.x, position.y, position.z, timeOfCreation}, ToVector4(velocity)}
+    );
+}
+
+void QueueLine(Vector3 from, Vector3 to, Color color) {
+    auto& output = SimulationOutput();
+    output.linesToDraw.push_back(from);
+    output.linesToDraw.push_back(to);
+    output.colorsOfLines.push_back(color);
+}
+
 Vector2 GetPlayerMovementControlVector() {
     Vector2 result = {};
 
@@ -140,37 +512,18 @@ Vector2 GetPlayerMovementControlVector() {
     return result;
 }
 
-Vector3 ApplyImpulse(Vector3 direction, float mass, float forceValue) {
-    return direction * (forceValue / mass);
-}
-
-Vector3 HorizontalAxisOf(Vector3 value) {
-    return Vector3Normalize(Vector3CrossProduct(value, Vector3Up));
-}
-
 Vector3 DisplaceToTheSide(Vector3 value, float displacement) {
     return value + HorizontalAxisOf(value) * displacement;
 }
 
-void DrawRope(Vector3 from, Vector3 to) {
-    const Color color    = {211, 202, 181, 255};
-    const auto  distance = Vector3Distance(to, from);
-
-    const int   slices = 16;
-    const float radius = 0.1f;
-
-    Mesh  cylinderMesh = GenMeshCylinder(radius, distance, slices);
-    Model model        = LoadModelFromMesh(cylinderMesh);
-    Assert(IsModelReady(model));
-
-    const auto axis  = HorizontalAxisOf(to - from);
-    const auto angle = -Vector3Angle(to - from, Vector3Up);
-
-    DrawModelEx(model, from, axis, angle * RAD2DEG, Vector3One(), color);
-    if (gdata.gizmosEnabled)
-        DrawModelWiresEx(model, from, axis, angle * RAD2DEG, Vector3One(), BLACK);
-
-    UnloadModel(model);
+// Куда крепится свободный конец верёвки (визуально).
+Vector3 GetPlayerRopeEnd() {
+    Vector3 result = gplayer.position;
+    // Смещаем в сторону.
+    result += HorizontalAxisOf(gplayer.lookingDirection) * 2.0f;
+    // Смещаем вниз.
+    result -= Vector3Up * 0.5f;
+    return result;
 }
 
 //----------------------------------------------------------------------------------
@@ -204,6 +557,7 @@ void SwitchState(PlayerStates state) {
 //----------------------------------------------------------------------------------
 PlayerState_OnEnter_Function(Grounded_OnEnter) {
     gplayer.ropeActivated = false;
+    RopeDetach(gdata.ropes, PLAYER_ROPE);
 }
 
 PlayerState_OnExit_Function(Grounded_OnExit) {}
@@ -212,7 +566,7 @@ PlayerState_Update_Function(Grounded_Update) {
     {  // Player camera rotation.
         const float sensitivity = 1.0f / 300.0f;
 
-        const auto delta = GetMouseDelta();
+        const auto delta = gdata.input.mouseDelta;
 
         // verticalRotationBorder - Ограничение для того, чтобы,
         // поднимая камеру вверх, мы не начали смотреть перевёрнуто себе за спину.
@@ -237,38 +591,40 @@ PlayerState_Update_Function(Grounded_Update) {
         gplayer.lookingDirection = direction;
     }
 
+    Vector3 walk = {};
     {  // Player movement direction calculation.
-        gplayer.velocity.x = 0;
-        gplayer.velocity.z = 0;
-
         const Vector2 lookingHorizontalDirection
             = {gplayer.lookingDirection.x, gplayer.lookingDirection.z};
 
-        const auto controlVector = GetPlayerMovementControlVector();
+        const auto controlVector = gdata.input.movement;
 
         if (controlVector.x != 0 || controlVector.y != 0) {
             const auto angle = atan2f(controlVector.y, controlVector.x);
 
-            const auto dHoriz = Vector2Rotate(lookingHorizontalDirection, PI / 2 + angle)
-                                * gplayer.speed;
+            const auto dHoriz = Vector2Rotate(lookingHorizontalDirection, PI / 2 + angle);
 
-            gplayer.velocity += Vector3(dHoriz.x, 0, dHoriz.y);
+            walk = Vector3(dHoriz.x, 0, dHoriz.y);
         }
     }
 
-    {  // Jumping.
-        if (IsKeyPressed(KEY_SPACE)) {
-            gplayer.buttonJumpPressedTime = GetTime();
-            gplayer.velocity
-                += ApplyImpulse(Vector3Up, gplayer.mass, gplayer.jumpImpulse);
-
-            SwitchState(PlayerStates::AIRBORNE);
-            PlaySound(gdata.fxJump);
-        }
+    const bool jump = gdata.input.jumpPressed;
+    if (jump) {
+        gplayer.buttonJumpPressedTime = gdata.input.time;
+        QueueSound(GameplaySounds::JUMP);
     }
 
-    {  // Movement.
-        gplayer.position += gplayer.velocity * dt;
+    {  // Movement. Переход в Airborne состояние, если прыгнули или сошли с уступа.
+        const bool airborne = MoveGrounded(
+            gdata.bricks,
+            gplayer.position,
+            gplayer.velocity,
+            gplayer.contacts,
+            walk,
+            jump,
+            dt
+        );
+        if (airborne)
+            SwitchState(PlayerStates::AIRBORNE);
     }
 }
 
@@ -286,111 +642,11 @@ int signof(float value) {
     return 0;
 }
 
-Vector3 TransformVelocityBasedOnRopeDirection(Vector3 velocity, Vector3 ropeDirection) {
-    if (gdata.gizmosEnabled) {
-        gdata.linesToDraw.push_back(gplayer.position);
-        gdata.linesToDraw.push_back(
-            gplayer.position + Vector3Normalize(gplayer.ropePos - gplayer.position) * 0.2f
-        );
-        gdata.colorsOfLines.push_back(WHITE);
-
-        gdata.linesToDraw.push_back(gplayer.ropePos);
-        gdata.linesToDraw.push_back(
-            gplayer.ropePos + Vector3Normalize(gplayer.position - gplayer.ropePos) * 0.2f
-        );
-        gdata.colorsOfLines.push_back(WHITE);
-    }
-
-    auto axis     = HorizontalAxisOf(ropeDirection);
-    auto angle    = -Vector3Angle(Vector3Up, ropeDirection);
-    auto pRotated = Vector3Normalize(
-        Vector3RotateByAxisAngle({ropeDirection.x, 0, ropeDirection.z}, axis, angle)
-    );
-
-    auto result = pRotated * Vector3DotProduct(pRotated, velocity)
-                  + axis * Vector3DotProduct(axis, velocity);
-
-    if (gdata.gizmosEnabled) {
-        gdata.linesToDraw.push_back(gplayer.position + Vector3Normalize(result));
-        gdata.linesToDraw.push_back(gplayer.position);
-        gdata.colorsOfLines.push_back(GREEN);
-    }
-
-    return result;
-}
-
-TEST_CASE ("TransformVelocityBasedOnRopeDirection") {
-    float velocities[] = {-1, 1};
-    for (float yvelocity : velocities) {
-        SUBCASE(
-            TextFormat("y velocity is %f, y rope direction is %f", yvelocity, -yvelocity)
-        ) {
-            const Vector3 vel = {0, yvelocity, 0};
-
-            auto tPosXPosZ
-                = TransformVelocityBasedOnRopeDirection(vel, {1, -yvelocity, 1});
-            auto tPosXNegZ
-                = TransformVelocityBasedOnRopeDirection(vel, {1, -yvelocity, -1});
-            auto tNegXPosZ
-                = TransformVelocityBasedOnRopeDirection(vel, {-1, -yvelocity, 1});
-            auto tNegXNegZ
-                = TransformVelocityBasedOnRopeDirection(vel, {-1, -yvelocity, -1});
-
-            Assert(tPosXPosZ.x > 0);
-            Assert(tPosXPosZ.z > 0);
-
-            Assert(tPosXNegZ.x > 0);
-            Assert(tPosXNegZ.z < 0);
-
-            Assert(tNegXPosZ.x < 0);
-            Assert(tNegXPosZ.z > 0);
-
-            Assert(tNegXNegZ.x < 0);
-            Assert(tNegXNegZ.z < 0);
-
-            auto tPosX = TransformVelocityBasedOnRopeDirection(vel, {1, -yvelocity, 0});
-            auto tNegX = TransformVelocityBasedOnRopeDirection(vel, {-1, -yvelocity, 0});
-            auto tPosZ = TransformVelocityBasedOnRopeDirection(vel, {0, -yvelocity, 1});
-            auto tNegZ = TransformVelocityBasedOnRopeDirection(vel, {0, -yvelocity, -1});
-
-            Assert(tPosX.x > 0);
-            Assert(FloatEquals(tPosX.z, 0));
-
-            Assert(tNegX.x < 0);
-            Assert(FloatEquals(tNegX.z, 0));
-
-            Assert(tPosZ.z > 0);
-            Assert(FloatEquals(tPosZ.x, 0));
-
-            Assert(tNegZ.z < 0);
-            Assert(FloatEquals(tNegZ.x, 0));
-
-            Assert(yvelocity * tPosXPosZ.y > 0);
-            Assert(yvelocity * tPosXNegZ.y > 0);
-            Assert(yvelocity * tNegXPosZ.y > 0);
-            Assert(yvelocity * tNegXNegZ.y > 0);
-            Assert(yvelocity * tPosX.y > 0);
-            Assert(yvelocity * tNegX.y > 0);
-            Assert(yvelocity * tPosZ.y > 0);
-            Assert(yvelocity * tNegZ.y > 0);
-        }
-    }
-}
-
-void UpdateSSBO(
-    unsigned int ssboID,
-    void*        data,
-    int          dataElementSize,
-    int          ssboElementsCount
-) {
-    rlUpdateShaderBuffer(ssboID, data, dataElementSize * ssboElementsCount, 0);
-}
-
 PlayerState_Update_Function(Airborne_Update) {
     {  // Player camera rotation.
         const float sensitivity = 1.0f / 300.0f;
 
-        const auto delta = GetMouseDelta();
+        const auto delta = gdata.input.mouseDelta;
 
         // verticalRotationBorder - Ограничение для того, чтобы,
         // поднимая камеру вверх, мы не начали смотреть перевёрнуто себе за спину.
@@ -416,49 +672,41 @@ PlayerState_Update_Function(Airborne_Update) {
     }
 
     {  // Player movement direction calculation.
-        auto controlVector = GetPlayerMovementControlVector();
+        auto controlVector = gdata.input.movement;
         controlVector.y *= -1;
 
         auto axis = HorizontalAxisOf(gplayer.lookingDirection);
 
         // TODO: Возможно, стоит ограничивать только ограничения по
         // направлению обратному гравитации, когда игрок не использует буст.
-        if (!IsKeyDown(KEY_V))
+        if (!gdata.input.boostDown)
             controlVector.y = Max(0, controlVector.y);
 
-        auto d = gplayer.lookingDirection * (controlVector.y * gplayer.airSpeed * dt)
-                 + axis * (controlVector.x * gplayer.airSpeed * dt);
+        const auto control = gplayer.lookingDirection * controlVector.y  //
+                             + axis * controlVector.x;
 
-        if (IsKeyDown(KEY_V)) {
-            const auto t = GetTime();
+        const bool boost = gdata.input.boostDown;
+        if (boost) {
+            const auto t = gdata.input.time;
             if (t - gplayer.lastBoostTime > gplayer.boostSoundInterval) {
-                PlaySound(gdata.fxBoost);
+                QueueSound(GameplaySounds::BOOST);
                 gplayer.lastBoostTime = t;
             }
 
             gplayer.buttonBoostPressedTime = t;
-            d *= gplayer.boostAmount;
         }
 
-        gplayer.velocity += d;
-    }
-
-    {  // Gravity.
-        gplayer.velocity.y += dt * gplayer.gravity;
+        // Вместе с гравитацией.
+        gplayer.velocity = AccelerateAirborne(gplayer.velocity, control, boost, dt);
     }
 
     {  // Dashing.
-        if (IsMouseButtonPressed(1)) {
-            auto l           = Vector3Length(gplayer.velocity);
-            gplayer.velocity = gplayer.lookingDirection * l;
+        if (gdata.input.dashPressed) {
+            gplayer.velocity = DashVelocity(gplayer.velocity, gplayer.lookingDirection);
 
-            gplayer.velocity += ApplyImpulse(
-                gplayer.lookingDirection, gplayer.mass, gplayer.dashImpulse
-            );
-
-            gplayer.lastDashTime          = GetTime();
-            gplayer.buttonDashPressedTime = GetTime();
-            PlaySound(gdata.fxDash);
+            gplayer.lastDashTime          = gdata.input.time;
+            gplayer.buttonDashPressedTime = gdata.input.time;
+            QueueSound(GameplaySounds::DASH);
 
             // Particles.
             {
@@ -470,133 +718,165 @@ PlayerState_Update_Function(Airborne_Update) {
 
                 // int amountToGenerate = MIN(300, NUM_PARTICLES);
 
-                auto time = (float)GetTime();
+                auto  time   = (float)gdata.input.time;
+                auto& config = gdata.input.dashConfig;
+                auto& random = gdata.particlesRandom;
+
+                const int amount = (int)config.amountToGenerate;
+                const int CHUNK  = 256;
 
-                FOR_RANGE (int, i, (int)dashConfig.amountToGenerate) {
-                    int ii = gdata.nextToGenerateParticleIndex % NUM_PARTICLES;
+                const auto backward = -Vector3Normalize(gplayer.velocity);
 
-                    gdata.positions[ii] = ToVector4(gplayer.position);
+                // Случайные числа генерируются порциями.
+                float angles[CHUNK];
+                float rolls[CHUNK];
+                float factors[CHUNK];
 
-                    auto t2 = GetRandomFloat01() * 2 - 1;
-                    auto a = Lerp(dashConfig.minAngle, dashConfig.maxAngle, t2) * DEG2RAD;
+                // Направления частиц (SoA) - поворачиваются разом через Batch Math.
+                float dx[CHUNK];
+                float dy[CHUNK];
+                float dz[CHUNK];
 
-                    auto particleVelocity = -Vector3Normalize(gplayer.velocity);
-                    particleVelocity = Vector3RotateByAxisAngle(particleVelocity, v1, a);
-                    particleVelocity = Vector3RotateByAxisAngle(
-                        particleVelocity, gplayer.velocity, GetRandomFloat(0, 2 * PI)
-                    );
+                for (int begin = 0; begin < amount; begin += CHUNK) {
+                    const int n = Min(CHUNK, amount - begin);
+                    RandomFillFloats(random, angles, n, -1, 1);
+                    RandomFillFloats(random, rolls, n, 0, 2 * PI);
+                    RandomFillFloats(random, factors, n, 0, 1);
 
-                    auto t = GetRandomFloat01();
+                    FOR_RANGE (int, i, n) {
+                        angles[i]
+                            = Lerp(config.minAngle, config.maxAngle, angles[i]) * DEG2RAD;
+                        dx[i] = backward.x;
+                        dy[i] = backward.y;
+                        dz[i] = backward.z;
+                    }
 
-                    auto livingDuration = Lerp(
-                        dashConfig.maxLivingDuration, dashConfig.minLivingDuration, t
-                    );
+                    BatchRotateByAxisAngle(dx, dy, dz, n, v1, angles);
+                    BatchRotateByAxisAngle(dx, dy, dz, n, gplayer.velocity, rolls);
 
-                    auto v = particleVelocity
-                             * Lerp(dashConfig.minVelocity, dashConfig.maxVelocity, t);
-                    gdata.velocities[ii] = ToVector4(v);
+                    FOR_RANGE (int, i, n) {
+                        const auto t = factors[i];
 
-                    auto timeOfCreation       = time - 14 + livingDuration;
-                    gdata.timesOfCreation[ii] = timeOfCreation;
+                        auto livingDuration
+                            = Lerp(config.maxLivingDuration, config.minLivingDuration, t);
 
-                    gdata.nextToGenerateParticleIndex++;
-                    if (gdata.nextToGenerateParticleIndex >= NUM_PARTICLES)
-                        gdata.nextToGenerateParticleIndex -= NUM_PARTICLES;
+                        auto v = Vector3(dx[i], dy[i], dz[i])
+                                 * Lerp(config.minVelocity, config.maxVelocity, t);
+
+                        auto timeOfCreation = time - 14 + livingDuration;
+                        QueueParticleSpawn(gplayer.position, v, timeOfCreation);
+                    }
                 }
             }
         }
     }
 
-    SetSoundVolume(gdata.fxBoost, Vector3Length(gplayer.velocity) / gplayer.maxVelocity);
+    SimulationOutput().boostVolume
+        = Vector3Length(gplayer.velocity) / gplayer.maxVelocity;
 
     // Выпускание / забирание троса.
-    if (IsMouseButtonPressed(0)) {
+    if (gdata.input.grapplePressed) {
         if (gplayer.ropeActivated) {
             gplayer.ropeActivated = false;
-            PlaySound(gdata.fxGrappleBack);
-            gplayer.buttonGrapplePressedTime = GetTime();
+            RopeDetach(gdata.ropes, PLAYER_ROPE);
+            QueueSound(GameplaySounds::GRAPPLE_BACK);
+            gplayer.buttonGrapplePressedTime = gdata.input.time;
         }
         else if (gplayer.collided) {
             gplayer.ropeActivated = true;
             gplayer.ropePos       = gplayer.lookingAtCollision;
             gplayer.ropeLength    = Vector3Distance(gplayer.ropePos, gplayer.position);
-            PlaySound(gdata.fxGrapple);
-            gplayer.buttonGrapplePressedTime = GetTime();
+            RopeAttach(
+                gdata.ropes,
+                PLAYER_ROPE,
+                gplayer.ropePos,
+                GetPlayerRopeEnd(),
+                gplayer.ropeLength
+            );
+            QueueSound(GameplaySounds::GRAPPLE);
+            gplayer.buttonGrapplePressedTime = gdata.input.time;
         }
     }
 
     {  // Movement.
-        // Decaying velocity.
-        gplayer.velocity = Vector3ExponentialDecay(
-            gplayer.velocity, Vector3Zero(), gplayer.velocityDecay, dt
-        );
-
-        // Clamping velocity.
-        gplayer.velocity = Vector3Normalize(gplayer.velocity)
-                           * Min(gplayer.maxVelocity, Vector3Length(gplayer.velocity));
-
         auto& position = gplayer.position;
 
         const auto oldPos = position;
-        position += gplayer.velocity * dt;
+        MoveAirborne(gdata.bricks, position, gplayer.velocity, gplayer.contacts, dt);
 
         if (gplayer.ropeActivated) {
-            auto& ropePos = gplayer.ropePos;
-
-            float newDist = Vector3Distance(position, ropePos);
-
-            bool newDistanceIsSufficient = newDist <= gplayer.ropeLength;
-            if (!newDistanceIsSufficient) {
-                position
-                    = ropePos + Vector3Normalize(position - ropePos) * gplayer.ropeLength;
+            // Верёвка может быть намотана на воксели.
+            // Игрок качается вокруг последней точки оборачивания.
+            RopeUpdateWraps(gdata.ropes, PLAYER_ROPE, gdata.bricks, position, oldPos);
+
+            const auto pivot      = RopeGetPivot(gdata.ropes, PLAYER_ROPE);
+            const auto freeLength = RopeGetFreeLength(gdata.ropes, PLAYER_ROPE);
+
+            const bool taut = ConstrainToRope(
+                gdata.bricks,
+                position,
+                gplayer.velocity,
+                gplayer.contacts,
+                pivot,
+                freeLength
+            );
 
-                gplayer.velocity = TransformVelocityBasedOnRopeDirection(
-                    gplayer.velocity, ropePos - position
-                );
+            if (taut && gdata.input.gizmosEnabled) {
+                const auto toPivot = Vector3Normalize(gplayer.ropePos - position);
+                QueueLine(position, position + toPivot * 0.2f, WHITE);
+                QueueLine(gplayer.ropePos, gplayer.ropePos - toPivot * 0.2f, WHITE);
+                QueueLine(position + Vector3Normalize(gplayer.velocity), position, GREEN);
             }
         }
 
-        // Particles generation.
-        if (IsKeyDown(KEY_V)) {
-            float k = Vector3Length(gplayer.velocity) / gplayer.maxVelocity;
+        // Boost trail and sparkles.
+        if (gdata.input.boostDown) {
+            auto t = (float)gdata.input.time;
 
-            int amountToGenerate = int(k * dt * gplayer.particlesAmountPerSecond) + 1;
-            amountToGenerate     = Min(amountToGenerate, NUM_PARTICLES);
+            TrailPush(gdata.boostTrail, position, t);
 
-            auto t = (float)GetTime();
+            float k = Vector3Length(gplayer.velocity) / gplayer.maxVelocity;
+            gplayer.sparklesToSpawn += k * dt * gplayer.sparklesPerSecond;
+
+            // NOTE: amountToGenerate тут небольшой - влезает в одну порцию.
+            const int   CHUNK = 16;
+            const float scale = 0.2f;
+
+            int amountToGenerate = Min((int)gplayer.sparklesToSpawn, CHUNK);
+            gplayer.sparklesToSpawn -= (float)amountToGenerate;
+
+            float velocities[CHUNK * 3];
+            float factors[CHUNK];
+            RandomFillFloats(
+                gdata.particlesRandom,
+                velocities,
+                amountToGenerate * 3,
+                -0.5f * scale,
+                0.5f * scale
+            );
+            RandomFillFloats(gdata.particlesRandom, factors, amountToGenerate, 0, 1);
 
             FOR_RANGE (int, i, amountToGenerate) {
-                int ii = gdata.nextToGenerateParticleIndex % NUM_PARTICLES;
-
-                auto p
-                    = Vector3Lerp(oldPos, position, float(i) / float(amountToGenerate));
-
-                gdata.positions[ii]  = Vector4(p.x, p.y, p.z, 0);
-                const float scale    = 0.2f;
-                gdata.velocities[ii] = Vector4(
-                    GetRandomFloat(-0.5, 0.5) * scale,
-                    GetRandomFloat(-0.5, 0.5) * scale,
-                    GetRandomFloat(-0.5, 0.5) * scale,
-                    0
-                );
-                gdata.timesOfCreation[ii] = t;
+                auto p = Vector3Lerp(oldPos, position, factors[i]);
 
-                gdata.nextToGenerateParticleIndex++;
-                if (gdata.nextToGenerateParticleIndex >= NUM_PARTICLES)
-                    gdata.nextToGenerateParticleIndex -= NUM_PARTICLES;
+                const float* v = velocities + i * 3;
+                QueueParticleSpawn(p, {v[0], v[1], v[2]}, t);
             }
         }
     }
 
-    {  // Переход в Grounded состояние.
-        if (gplayer.position.y < 0) {
-            gplayer.position.y = 0;
+    {  // Залезание на уступ.
+        if (gplayer.contacts.ledge && gdata.input.jumpPressed) {
+            gplayer.buttonJumpPressedTime = gdata.input.time;
+            gplayer.velocity              = ClimbLedgeVelocity(gplayer.velocity);
 
-            if (gplayer.velocity.y < 0)
-                gplayer.velocity.y = 0;
+            QueueSound(GameplaySounds::JUMP);
+        }
+    }
 
+    {  // Переход в Grounded состояние.
+        if (gplayer.contacts.normal.y > 0)
             SwitchState(PlayerStates::GROUNDED);
-        }
     }
 }
 
@@ -648,7 +928,7 @@ void InitGameplayScreen(Arena& arena) {
     gdata.camera.projection = CAMERA_PERSPECTIVE;
 
     {  // Particles.
-        gdata.particleShader = LoadShader(
+        gdata.particleShader = LoadCachedShader(
             "resources/screens/gameplay/particle_vertex.glsl",
             "resources/screens/gameplay/particle_fragment.glsl"
         );
@@ -665,31 +945,28 @@ void InitGameplayScreen(Arena& arena) {
         //
         // Number of particles should be a multiple of 1024, our workgroup size
         // (set in shader).
-        gdata.positions       = (Vector4*)RL_MALLOC(sizeof(Vector4) * NUM_PARTICLES);
-        gdata.velocities      = (Vector4*)RL_MALLOC(sizeof(Vector4) * NUM_PARTICLES);
-        gdata.timesOfCreation = (float*)RL_MALLOC(sizeof(float) * NUM_PARTICLES);
-
-        FOR_RANGE (int, i, NUM_PARTICLES) {
-            gdata.positions[i]       = Vector4Zero();
-            gdata.velocities[i]      = Vector4Zero();
-            gdata.timesOfCreation[i] = -100.0f;
-        }
+        std::vector<Vector4> zeros(NUM_PARTICLES, Vector4Zero());
+        std::vector<float>   timesOfCreation(NUM_PARTICLES, -100.0f);
 
         // Load three buffers: Position, Velocity and Starting Position.
-        // Read/Write=RL_DYNAMIC_COPY.
-        gdata.ssbo0 = rlLoadShaderBuffer(
-            NUM_PARTICLES * sizeof(Vector4), gdata.positions, RL_DYNAMIC_COPY
-        );
-        gdata.ssbo1 = rlLoadShaderBuffer(
-            NUM_PARTICLES * sizeof(Vector4), gdata.velocities, RL_DYNAMIC_COPY
-        );
-        gdata.ssbo2 = rlLoadShaderBuffer(
-            NUM_PARTICLES * sizeof(float), gdata.timesOfCreation, RL_DYNAMIC_COPY
-        );
-
-        Assert(gdata.ssbo0 != 0);
-        Assert(gdata.ssbo1 != 0);
-        Assert(gdata.ssbo2 != 0);
+        // Они живут только на GPU: двигает частицы particle_compute.glsl,
+        // а с CPU заливаются только новые частицы - см. UpdateParticles.
+        LoadGLFunctions();
+        const int vectorsSize = NUM_PARTICLES * sizeof(Vector4);
+        const int floatsSize  = NUM_PARTICLES * sizeof(float);
+        gdata.particlePositions
+            = rlLoadShaderBuffer(vectorsSize, zeros.data(), RL_DYNAMIC_COPY);
+        gdata.particleVelocities
+            = rlLoadShaderBuffer(vectorsSize, zeros.data(), RL_DYNAMIC_COPY);
+        gdata.particleTimesOfCreation
+            = rlLoadShaderBuffer(floatsSize, timesOfCreation.data(), RL_DYNAMIC_COPY);
+
+        gdata.particleSpawns = MakeStreamBuffer(NUM_PARTICLES * sizeof(ParticleSpawn));
+        gdata.particleSpawnsQueue.clear();
+        gdata.nextToGenerateParticleIndex = 0;
+
+        gdata.particleComputeShader
+            = LoadCachedComputeShader("resources/screens/gameplay/particle_compute.glsl");
 
         // For instancing we need a Vertex Array Object.
         // Raylib Mesh* is inefficient for millions of particles.
@@ -706,37 +983,103 @@ void InitGameplayScreen(Arena& arena) {
         }
         // rlDisableVertexArray();
     }
+
+    {  // Grapplers.
+        gdata.grapplerShader = LoadCachedShader(
+            "resources/screens/gameplay/grappler_vertex.glsl",
+            "resources/screens/gameplay/grappler_fragment.glsl"
+        );
+        gdata.grapplerInstances = MakeStreamBuffer(MAX_GRAPPLERS * sizeof(Vector4));
+        ClearGrapplers(gdata.grapplers);
+    }
+
+    {  // Boost trail.
+        gdata.trailShader = LoadCachedShader(
+            "resources/screens/gameplay/trail_vertex.glsl",
+            "resources/screens/gameplay/trail_fragment.glsl"
+        );
+        gdata.trailPoints = MakeStreamBuffer(TRAIL_CAPACITY * sizeof(TrailPoint));
+        TrailClear(gdata.boostTrail);
+        gplayer.sparklesToSpawn = 0;
+    }
+
+    {  // Raymarched world.
+        gdata.raymarchShader = LoadCachedShader(
+            "resources/screens/gameplay/world_raymarch_vertex.glsl",
+            "resources/screens/gameplay/world_raymarch_fragment.glsl"
+        );
+    }
     // ------------------------------------------------------------
 
+    {  // Отладочные линии.
+        const auto size      = DEBUG_LINES_MAX * sizeof(DebugLine_) + alignof(DebugLine_);
+        gdata.debugArena     = MakeArena(size);
+        gdata.debugArenaPool = RegisterArena(
+            memoryRegistry, gdata.debugArena, "debug lines", MemorySubsystem::DEBUG
+        );
+        gdata.debugLines = MakeRingBuffer<DebugLine_>(gdata.debugArena, DEBUG_LINES_MAX);
+    }
+
     {  // Loading level.
-        char* data = LoadFileText("resources/screens/gameplay/level.txt");
-
-        std::istringstream iss(data);
-
-        int colorsCount = 0;
-        iss >> colorsCount;
-        gdata.colors.reserve(colorsCount);
-
-        FOR_RANGE (int, i, colorsCount) {
-            int r = 0;
-            int g = 0;
-            int b = 0;
-            iss >> r;
-            iss >> g;
-            iss >> b;
-            gdata.colors.push_back(Color{
-                (unsigned char)r,
-                (unsigned char)g,
-                (unsigned char)b,
-                255,
-            });
+        // Запечённый уровень - level.bricks и его палитра level.palette. Кубы из него
+        // не разворачиваются, размер уровня ограничен только памятью под brick map.
+        // Без них (или если они битые) уровень читается из level.txt: сначала
+        // количества, потом под них заводится арена.
+        // Битый уровень не грузится: в лог пишется ошибка, уровень остаётся пустым.
+        const char* palettePath = "resources/screens/gameplay/level.palette";
+        const char* bricksPath  = "resources/screens/gameplay/level.bricks";
+
+        std::vector<Color> colors;
+        bool               fromBricks = false;
+        if (ResourceExists(palettePath) && ResourceExists(bricksPath)) {
+            char*              paletteText = LoadFileText(palettePath);
+            std::istringstream paletteStream(paletteText);
+            colors = ParseLevelPalette_(paletteStream);
+            UnloadFileText(paletteText);
+
+            int  bricksDataSize = 0;
+            auto bricksData     = LoadFileData(bricksPath, &bricksDataSize);
+
+            fromBricks = LoadLevelBricks_(
+                (u8*)bricksData, bricksDataSize, (int)colors.size(), gdata.bricks
+            );
+            if (!fromBricks)
+                TraceLog(LOG_WARNING, "Broken %s, using level.txt", bricksPath);
+
+            UnloadFileData(bricksData);
         }
 
+        char* data = nullptr;
+        if (!fromBricks)
+            data = LoadFileText("resources/screens/gameplay/level.txt");
+
+        std::istringstream iss((data != nullptr) ? data : "");
+
         int cubesCount = 0;
-        iss >> cubesCount;
-        gdata.cubes.reserve(cubesCount);
+        if (!fromBricks) {
+            colors = ParseLevelPalette_(iss);
+            iss >> cubesCount;
+        }
 
-        FOR_RANGE (int, i, cubesCount) {
+        if (cubesCount < 0 || cubesCount > LEVEL_CUBES_MAX) {
+            TraceLog(LOG_ERROR, "Level rejected: bad cubes count %d", cubesCount);
+            cubesCount = 0;
+        }
+
+        const int colorsCount = (int)colors.size();
+
+        auto& levelArena = gdata.levelArena;
+        levelArena       = MakeArena(LevelArenaSize(colorsCount, cubesCount));
+
+        gdata.levelArenaPool
+            = RegisterArena(memoryRegistry, levelArena, "level", MemorySubsystem::LEVEL);
+
+        gdata.colors = MakeFixedArray<Color>(levelArena, colorsCount);
+        for (const auto& color : colors)
+            FixedArrayAdd(gdata.colors, color);
+
+        gdata.cubes = MakeFixedArray<CubeVoxel>(levelArena, cubesCount);
+        while (gdata.cubes.count < gdata.cubes.capacity) {
             int x          = 0;
             int y          = 0;
             int z          = 0;
@@ -750,21 +1093,594 @@ void InitGameplayScreen(Arena& arena) {
             cube.pos        = Vector3Int(x, y, z);
             cube.colorIndex = colorIndex;
 
-            gdata.cubes.push_back(cube);
+            FixedArrayAdd(gdata.cubes, cube);
+        }
+
+        if (!iss) {
+            TraceLog(LOG_ERROR, "Level rejected: level.txt is truncated");
+            gdata.cubes.count = 0;
         }
 
-        UnloadFileText(data);
+        for (const auto& cube : gdata.cubes) {
+            if (cube.colorIndex < 0 || cube.colorIndex >= colorsCount) {
+                TraceLog(LOG_ERROR, "Level rejected: color index %d", cube.colorIndex);
+                gdata.cubes.count = 0;
+                break;
+            }
+        }
+
+        if (data != nullptr)
+            UnloadFileText(data);
+
+        // Плотной сетки на весь уровень нет: коллизии, запросы к миру и частицы
+        // (на GPU) читают brick map, её размер зависит от поверхности, а не объёма.
+        if (gdata.bricks.bricks == nullptr)
+            gdata.bricks = MakeBrickMap(gdata.cubes.items, gdata.cubes.count);
+
+        gdata.world = {&gdata.bricks};
+
+        gdata.gpuBricks = LoadGpuBrickMap(gdata.bricks);
+
+        // Меши чанков стримятся вокруг игрока. level.chunks читается прямо
+        // из отображённого архива, без архива - из файла. Если запечённого
+        // level.chunks нет, уровень режется на чанки в памяти.
+        auto&       streamer   = gdata.chunkStreamer;
+        const char* chunksPath = "resources/screens/gameplay/level.chunks";
+        const u8*   chunksView = nullptr;
+        int         chunksSize = 0;
+        bool        chunksLoaded = false;
+        if (ResourceView(chunksPath, chunksView, chunksSize)) {
+            chunksLoaded
+                = LoadChunkedLevelFromView(chunksView, chunksSize, streamer.level);
+        }
+        else if (FileExists(chunksPath))
+            chunksLoaded = LoadChunkedLevel(chunksPath, streamer.level);
+        if (!chunksLoaded) {
+            auto data = SerializeChunkedLevel(gdata.bricks);
+            LoadChunkedLevelFromMemory(std::move(data), streamer.level);
+            chunksPath = "memory";
+        }
+
+        // Коллизии не стримятся (см. chunk_streaming.cpp) - brick map на CPU
+        // и её копия на GPU занимают часть бюджета чанков.
+        streamer.pinnedBytes = 2 * (i64)BrickMapMemorySize(gdata.bricks);
+        if (ChunkStreamerMaxVertices(streamer) == 0) {
+            TraceLog(
+                LOG_WARNING,
+                "Chunks: budget %d MB is taken by the level (%d MB pinned)",
+                streamer.memoryBudget >> 20,
+                (int)(streamer.pinnedBytes >> 20)
+            );
+        }
+
+        gdata.chunkRenderer = LoadChunkRenderer(
+            (int)streamer.level.entries.size(), ChunkStreamerMaxVertices(streamer)
+        );
+        gdata.chunkVerticesPool = RegisterMemoryPool(
+            memoryRegistry,
+            "chunk vertices",
+            MemorySubsystem::CHUNKS,
+            MemoryKind::GPU,
+            (i64)gdata.chunkRenderer.maxVertices * sizeof(ChunkVertex)
+        );
+        StartChunkStreamer(streamer);
+        TraceLog(
+            LOG_INFO,
+            "Chunks: %d streamed from %s, budget %d MB",
+            (int)streamer.level.entries.size(),
+            chunksPath,
+            streamer.memoryBudget >> 20
+        );
+
+        std::vector<Vector4> palette;
+        for (auto color : gdata.colors)
+            palette.push_back(ColorNormalize(color));
+        palette.resize(Max(1, gdata.colors.count));
+        const auto paletteSize = (unsigned int)(palette.size() * sizeof(Vector4));
+        gdata.palette = rlLoadShaderBuffer(paletteSize, palette.data(), RL_STATIC_DRAW);
+
+        TraceLog(
+            LOG_INFO,
+            "Voxels: %d cubes, brick map %d KB",
+            BrickMapCubesCount(gdata.bricks),
+            BrickMapMemorySize(gdata.bricks) / 1024
+        );
+    }
+
+    TraceLog(
+        LOG_INFO,
+        "Shader cache: %d hits, %d misses, %d rejected",
+        shaderCacheStats.hits,
+        shaderCacheStats.misses,
+        shaderCacheStats.rejected
+    );
+
+    gdata.particlesRandom = MakeRandomBatch(particlesRandomSeed);
+    gdata.grapplersRandom = MakeRandom(grapplersRandomSeed);
+
+    {  // Начальный снапшот, чтобы первому кадру было что рисовать.
+        gdata.simTick      = 0;
+        gdata.consumedTick = -1;
+        BeginSimulationOutput();
+        PublishGameplaySnapshot();
+        ConsumeGameplaySnapshot();
     }
 
+    TrackGameplayMemory_();
+
+    // Прогрев (warmupFrames) считается с начала уровня, загрузка - не в счёт.
+    ResetAllocationFrames(allocationTracker);
+
     DisableCursor();
 }
 
-static int numActiveParticles = 0;
+// Вызывается на главном потоке.
+GameplayInput CaptureGameplayInput(float dt) {
+    GameplayInput input = {};
+    input.dt            = dt;
+    input.time          = GetTime();
+
+    input.mouseDelta = GetMouseDelta();
+    input.movement   = GetPlayerMovementControlVector();
+
+    input.jumpPressed    = IsKeyPressed(KEY_SPACE);
+    input.boostDown      = IsKeyDown(KEY_V);
+    input.dashPressed    = IsMouseButtonPressed(1);
+    input.grapplePressed = IsMouseButtonPressed(0);
+
+    input.gizmosEnabled = gdata.gizmosEnabled;
+    input.dashConfig    = dashConfig;
+
+    if (IsKeyPressed(KEY_F5))
+        input.grapplersToSpawn = 512;
+    input.clearGrapplers = IsKeyPressed(KEY_F6);
+    return input;
+}
+
+std::vector<u8> SerializeGameplayReplay(const std::vector<GameplayInput>& inputs) {
+    GameplayReplayHeader_ header = {};
+    header.inputsCount           = (int)inputs.size();
+
+    const size_t    inputsSize = inputs.size() * sizeof(GameplayInput);
+    std::vector<u8> result(sizeof(header) + inputsSize);
+    memcpy(result.data(), &header, sizeof(header));
+    if (inputsSize > 0)
+        memcpy(result.data() + sizeof(header), inputs.data(), inputsSize);
+    return result;
+}
+
+// Возвращает false, если данные битые или записаны другой сборкой.
+bool DeserializeGameplayReplay(
+    const u8*                   data,
+    int                         size,
+    std::vector<GameplayInput>& out
+) {
+    GameplayReplayHeader_ header = {};
+    if ((data == nullptr) || (size < (int)sizeof(header)))
+        return false;
+    memcpy(&header, data, sizeof(header));
+
+    if ((header.magic != GAMEPLAY_REPLAY_MAGIC)
+        || (header.inputSize != (int)sizeof(GameplayInput)) || (header.inputsCount < 0))
+        return false;
+
+    const i64 inputsSize = (i64)header.inputsCount * (i64)sizeof(GameplayInput);
+    if ((i64)sizeof(header) + inputsSize != size)
+        return false;
+
+    out.resize(header.inputsCount);
+    if (header.inputsCount > 0)
+        memcpy(out.data(), data + sizeof(header), out.size() * sizeof(GameplayInput));
+    return true;
+}
+
+TEST_CASE ("GameplayReplay") {
+    std::vector<GameplayInput> inputs(3);
+    inputs[1].dt          = 0.5f;
+    inputs[1].jumpPressed = true;
+    inputs[2].movement    = {0, 1};
+
+    auto data = SerializeGameplayReplay(inputs);
+
+    std::vector<GameplayInput> read;
+    Assert(DeserializeGameplayReplay(data.data(), (int)data.size(), read));
+    Assert(read.size() == 3);
+    Assert(read[1].dt == 0.5f);
+    Assert(read[1].jumpPressed);
+    Assert(read[2].movement.y == 1);
+
+    // Обрезанный файл и запись сборки с другим GameplayInput.
+    Assert_False(DeserializeGameplayReplay(data.data(), (int)data.size() - 1, read));
+    data[4]++;
+    Assert_False(DeserializeGameplayReplay(data.data(), (int)data.size(), read));
+}
+
+// Ввод пишется с этого момента и сохраняется в path в UnloadGameplayScreen.
+// Звать до InitGameplayScreen, иначе старт записи не совпадёт со стартом уровня.
+void RecordGameplay(const char* path) {
+    gdata.recordPath = path;
+    gdata.recorded.clear();
+}
+
+// Дальше ввод берётся из inputs по кругу, клавиатура и мышь игнорируются.
+void PlayGameplayReplay(std::vector<GameplayInput> inputs) {
+    gdata.replay        = {};
+    gdata.replay.inputs = std::move(inputs);
+}
+
+// time сдвигается так, чтобы запись начиналась с текущего момента. dt - из записи,
+// поэтому симуляция одинакова при любом FPS, а GetTime() отрисовки при другом FPS
+// от времени симуляции уходит (частицы гаснут раньше или позже).
+GameplayInput NextReplayInput_() {
+    auto&     replay = gdata.replay;
+    const int index  = replay.next % (int)replay.inputs.size();
+    replay.next++;
+
+    if (index == 0)
+        replay.timeOffset = GetTime() - replay.inputs[0].time;
+
+    auto input = replay.inputs[index];
+    input.time += replay.timeOffset;
+    return input;
+}
+
+// Очищает события, оставшиеся в снапшоте с тех пор, когда его читала отрисовка.
+void BeginSimulationOutput() {
+    auto& output = SimulationOutput();
+    output.particleSpawns.clear();
+    output.linesToDraw.clear();
+    output.colorsOfLines.clear();
+    output.soundsCount = 0;
+}
+
+// Копирует состояние симуляции в снапшот и отдаёт его отрисовке.
+void PublishGameplaySnapshot() {
+    auto& output = SimulationOutput();
+    output.tick  = gdata.simTick++;
+
+    output.position         = gplayer.position;
+    output.velocity         = gplayer.velocity;
+    output.lookingDirection = gplayer.lookingDirection;
+    output.isAirborne
+        = gplayer.currentState == (gdata.states + (int)PlayerStates::AIRBORNE);
+
+    output.collided           = gplayer.collided;
+    output.ropeActivated      = gplayer.ropeActivated;
+    output.lookingAtCollision = gplayer.lookingAtCollision;
+
+    output.lastDashTime             = gplayer.lastDashTime;
+    output.buttonGrapplePressedTime = gplayer.buttonGrapplePressedTime;
+    output.buttonJumpPressedTime    = gplayer.buttonJumpPressedTime;
+    output.buttonBoostPressedTime   = gplayer.buttonBoostPressedTime;
+    output.buttonDashPressedTime    = gplayer.buttonDashPressedTime;
+
+    output.ropes = gdata.ropes;
+
+    output.grapplers.resize(gdata.grapplers.count);
+    GetGrapplerInstances(gdata.grapplers, output.grapplers.data());
+
+    output.boostTrail.resize(TRAIL_CAPACITY);
+    output.boostTrail.resize(TrailGetPoints(gdata.boostTrail, output.boostTrail.data()));
+
+    TripleBufferPublish(gdata.snapshots);
+}
+
+// Один тик симуляции. Может выполняться в потоке симуляции,
+// поэтому не должен трогать ничего, кроме gplayer, gdata.ropes и SimulationOutput().
+void SimulateGameplay(const GameplayInput& input) {
+    ALLOCATION_ZONE("simulation");
+    const double start = GetTime();
+
+    gdata.input   = input;
+    const auto dt = input.dt;
+
+    BeginSimulationOutput();
+
+    gplayer.contacts = {};
+    gplayer.currentState->Update(dt);
+
+    {  // Boost trail. Точки добавляются в Airborne_Update.
+        const bool isAirborne
+            = gplayer.currentState == (gdata.states + (int)PlayerStates::AIRBORNE);
+        if (!isAirborne || !input.boostDown)
+            TrailBreak(gdata.boostTrail);
+
+        TrailExpire(gdata.boostTrail, (float)input.time);
+    }
+
+    {  // Ropes.
+        if (gplayer.ropeActivated)
+            RopeSetEnd(gdata.ropes, PLAYER_ROPE, GetPlayerRopeEnd());
+
+        SimulateRopes(gdata.ropes, gdata.bricks, dt);
+    }
+
+    {  // Grapplers.
+        auto& grapplers = gdata.grapplers;
+
+        if (input.clearGrapplers)
+            ClearGrapplers(grapplers);
+        if (input.grapplersToSpawn > 0) {
+            SpawnGrapplers(
+                grapplers, gdata.bricks, input.grapplersToSpawn, gdata.grapplersRandom
+            );
+        }
+
+        UpdateGrapplers(grapplers, gdata.world, dt, input.time);
+
+        // Частицы от dash-ей ботов. Только рядом с игроком:
+        // дальних не видно, а частиц на всех не хватит.
+        auto& distances = gdata.grapplerDistances;
+        BatchDistanceToPoint(
+            grapplers.x,
+            grapplers.y,
+            grapplers.z,
+            grapplers.count,
+            gplayer.position,
+            distances
+        );
+
+        FOR_RANGE (int, i, grapplers.count) {
+            if (!grapplers.dashed[i] || (distances[i] > grapplerDashParticlesDistance))
+                continue;
+
+            const int PARTICLES = 16;
+
+            float velocities[PARTICLES * 3];
+            RandomFillFloats(gdata.particlesRandom, velocities, PARTICLES * 3, -1, 1);
+
+            const auto p = GrapplerGetPosition(grapplers, i);
+            FOR_RANGE (int, k, PARTICLES) {
+                const float* v = velocities + k * 3;
+                QueueParticleSpawn(p, {v[0], v[1], v[2]}, (float)input.time);
+            }
+        }
+    }
+
+    {  // Проверяем на коллизии то, куда смотрит игрок.
+        const float maxDistance = 20.0f;
+
+        const auto eye       = gplayer.position + Vector3Up * 2.0f;
+        const auto direction = gplayer.lookingDirection;
+
+        auto hit = WorldRaycast(gdata.world, {eye, direction, maxDistance});
+
+        // Aim assist: луч прошёл мимо, но рядом есть за что зацепиться.
+        if (!hit.hit) {
+            hit = WorldConeCast(
+                gdata.world, eye, direction, aimAssistHalfAngle, maxDistance
+            );
+        }
+
+        gplayer.collided = hit.hit && (hit.distance < maxDistance);
+        if (gplayer.collided)
+            gplayer.lookingAtCollision = hit.point;
+    }
+
+    // До публикации: после неё главный поток может уже читать.
+    gdata.simMilliseconds = (GetTime() - start) * 1000.0;
+    PublishGameplaySnapshot();
+}
+
+void SimulateGameplayJob_(void* /* userData */) {
+    SimulateGameplay(gdata.queuedInput);
+}
+
+Sound GetGameplaySound(GameplaySounds sound) {
+    switch (sound) {
+    case GameplaySounds::JUMP:
+        return gdata.fxJump;
+    case GameplaySounds::BOOST:
+        return gdata.fxBoost;
+    case GameplaySounds::DASH:
+        return gdata.fxDash;
+    case GameplaySounds::GRAPPLE:
+        return gdata.fxGrapple;
+    case GameplaySounds::GRAPPLE_BACK:
+        return gdata.fxGrappleBack;
+    default:
+        INVALID_PATH;
+    }
+    return {};
+}
+
+// Забирает новый снапшот, если он есть, и применяет его события.
+// Вызывается на главном потоке.
+void ConsumeGameplaySnapshot() {
+    if (!TripleBufferAcquire(gdata.snapshots))
+        return;
+
+    auto& snapshot = TripleBufferReadBuffer(gdata.snapshots);
+
+    // Снапшоты забираются строго по одному на тик.
+    // Пропущенный снапшот - это потерянные частицы и звуки.
+    Assert(snapshot.tick == gdata.consumedTick + 1);
+    gdata.consumedTick = snapshot.tick;
+
+    // Заливаются на GPU в UpdateParticles.
+    gdata.particleSpawnsQueue.insert(
+        gdata.particleSpawnsQueue.end(),
+        snapshot.particleSpawns.begin(),
+        snapshot.particleSpawns.end()
+    );
+
+    FOR_RANGE (int, i, (int)snapshot.colorsOfLines.size()) {
+        DebugLine_ line = {};
+        line.from       = snapshot.linesToDraw[i * 2];
+        line.to         = snapshot.linesToDraw[i * 2 + 1];
+        line.color      = snapshot.colorsOfLines[i];
+        RingBufferPush(gdata.debugLines, line);
+    }
+
+    FOR_RANGE (int, i, snapshot.soundsCount) {
+        PlaySound(GetGameplaySound(snapshot.sounds[i]));
+    }
+    SetSoundVolume(gdata.fxBoost, snapshot.boostVolume);
+}
+
+// Заливает на GPU новые частицы и запускает particle_compute.glsl,
+// который двигает частицы и сталкивает их с вокселями. Вызывается на главном потоке.
+void UpdateParticles(float dt) {
+    ALLOCATION_ZONE("particles");
+    auto& spawns = gdata.particleSpawnsQueue;
+
+    // Всё, что не влезает в кольцо, было бы сразу же перезаписано.
+    const int skipped     = Max(0, (int)spawns.size() - NUM_PARTICLES);
+    const int spawnsCount = (int)spawns.size() - skipped;
+    const int spawnsFirst = (gdata.nextToGenerateParticleIndex + skipped) % NUM_PARTICLES;
+
+    if (spawnsCount > 0) {
+        const int size = spawnsCount * sizeof(ParticleSpawn);
+        memcpy(StreamBufferBegin(gdata.particleSpawns), spawns.data() + skipped, size);
+        StreamBufferEnd(gdata.particleSpawns, size);
+    }
+
+    gdata.nextToGenerateParticleIndex
+        = (gdata.nextToGenerateParticleIndex + (int)spawns.size()) % NUM_PARTICLES;
+    spawns.clear();
+
+    {  // Живые частицы для телеметрии.
+        auto&        batches = gdata.particleBatches;
+        const double now     = GetTime();
+        if (spawnsCount > 0) {
+            batches.push_back({now, spawnsCount});
+            gdata.liveParticles += spawnsCount;
+        }
+
+        int expired = 0;
+        while ((expired < (int)batches.size())
+               && (batches[expired].time + particleLifetime < now))
+        {
+            gdata.liveParticles -= batches[expired].count;
+            expired++;
+        }
+        batches.erase(batches.begin(), batches.begin() + expired);
+
+        TelemetrySet(
+            TelemetryMetric::PARTICLES, (float)Min(gdata.liveParticles, NUM_PARTICLES)
+        );
+    }
+
+    const auto& bricks = gdata.bricks;
+
+    rlEnableShader(gdata.particleComputeShader);
+    rlSetUniform(0, &dt, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(1, &spawnsFirst, RL_SHADER_UNIFORM_INT, 1);
+    rlSetUniform(2, &spawnsCount, RL_SHADER_UNIFORM_INT, 1);
+    rlSetUniform(3, &bricks.origin, RL_SHADER_UNIFORM_IVEC3, 1);
+    rlSetUniform(4, &bricks.size, RL_SHADER_UNIFORM_IVEC3, 1);
+    rlSetUniform(5, &particleRestitution, RL_SHADER_UNIFORM_FLOAT, 1);
+
+    rlBindShaderBuffer(gdata.particlePositions, 0);
+    rlBindShaderBuffer(gdata.particleVelocities, 1);
+    rlBindShaderBuffer(gdata.particleTimesOfCreation, 2);
+    StreamBufferBind(gdata.particleSpawns, 3);
+    BindGpuBrickMap(gdata.gpuBricks);
+
+    rlComputeShaderDispatch(NUMBER_OF_INSTANCES, 1, 1);
+    rlDisableShader();
+
+    if (spawnsCount > 0)
+        StreamBufferFence(gdata.particleSpawns);
+
+    // Отрисовка частиц должна увидеть то, что записал compute шейдер.
+    if (gl.memoryBarrier != nullptr)
+        gl.memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// Сообщает memoryRegistry, сколько держит геймплей. После загрузки и раз в кадр:
+// очереди растут. levelArena и debugArena - пулы, они считаются сами.
+void TrackGameplayMemory_() {
+    const auto CPU = MemoryKind::CPU;
+    const auto GPU = MemoryKind::GPU;
+
+    i64 bytes[(int)MemorySubsystem::COUNT][(int)MemoryKind::COUNT] = {};
+
+    auto add = [&](MemorySubsystem subsystem, MemoryKind kind, i64 size) {
+        bytes[(int)subsystem][(int)kind] += size;
+    };
+
+    {  // Уровень.
+        const auto level = MemorySubsystem::LEVEL;
+
+        add(level, CPU, BrickMapMemorySize(gdata.bricks));
+        if (gdata.gpuBricks.bricks != 0)
+            add(level, GPU, BrickMapMemorySize(gdata.bricks));
+        if (gdata.palette != 0)
+            add(level, GPU, (i64)Max(1, gdata.colors.count) * sizeof(Vector4));
+    }
+
+    {  // Чанки. Вертексы - в пуле chunkVerticesPool.
+        const auto  chunks   = MemorySubsystem::CHUNKS;
+        const auto& level    = gdata.chunkStreamer.level;
+        const auto& renderer = gdata.chunkRenderer;
+        const auto  perChunk = sizeof(ChunkMesh) + sizeof(ChunkDrawCommand_);
+
+        add(chunks, CPU, ChunkedLevelMemorySize(level));
+        add(chunks, GPU, (i64)(renderer.maxChunks * perChunk));
+
+        if (gdata.chunkVerticesPool >= 0) {
+            const i64 used = (i64)renderer.verticesCount * sizeof(ChunkVertex);
+            SetMemoryPoolUsed(memoryRegistry, gdata.chunkVerticesPool, used);
+        }
+    }
+
+    {  // Частицы.
+        const auto  particles = MemorySubsystem::PARTICLES;
+        const auto& queue     = gdata.particleSpawnsQueue;
+        const auto& batches   = gdata.particleBatches;
+
+        add(particles, CPU, (i64)(queue.capacity() * sizeof(ParticleSpawn)));
+        add(particles, CPU, (i64)(batches.capacity() * sizeof(ParticleSpawnBatch_)));
+        if (gdata.particlePositions != 0) {
+            const int perParticle = 2 * sizeof(Vector4) + sizeof(float);
+            add(particles, GPU, (i64)NUM_PARTICLES * perParticle);
+        }
+        add(particles, GPU, StreamBufferMemorySize(gdata.particleSpawns));
+    }
+
+    {  // Эффекты.
+        const auto effects = MemorySubsystem::EFFECTS;
+        add(effects, GPU, StreamBufferMemorySize(gdata.grapplerInstances));
+        add(effects, GPU, StreamBufferMemorySize(gdata.trailPoints));
+    }
+
+    {  // Звуки.
+        const auto audio = MemorySubsystem::AUDIO;
+        add(audio, CPU, SoundMemorySize(gdata.fxJump));
+        add(audio, CPU, SoundMemorySize(gdata.fxBoost));
+        add(audio, CPU, SoundMemorySize(gdata.fxDash));
+        add(audio, CPU, SoundMemorySize(gdata.fxGrapple));
+        add(audio, CPU, SoundMemorySize(gdata.fxGrappleBack));
+        if (gdata.fxFootsteps != nullptr) {
+            FOR_RANGE (int, i, 5) {
+                add(audio, CPU, SoundMemorySize(gdata.fxFootsteps[i]));
+            }
+        }
+    }
+
+    FOR_RANGE (int, s, (int)MemorySubsystem::COUNT) {
+        FOR_RANGE (int, k, (int)MemoryKind::COUNT) {
+            MemoryResized(
+                memoryRegistry,
+                (MemorySubsystem)s,
+                (MemoryKind)k,
+                gdata.trackedMemory[s][k],
+                bytes[s][k]
+            );
+        }
+    }
+}
 
 // Gameplay Screen Update logic.
 void UpdateGameplayScreen() {
+    ALLOCATION_ZONE("update");
     const auto dt = GetFrameTime();
 
+    // Дожидаемся тика, запущенного в потоке симуляции в прошлом кадре.
+    WorkerThreadWait(gdata.simThread);
+    ConsumeGameplaySnapshot();
+
     // Press enter or tap to change to ENDING screen.
     // if (IsKeyPressed(KEY_ENTER) || IsGestureDetected(GESTURE_TAP))
     if (IsKeyPressed(KEY_ENTER))
@@ -793,139 +1709,154 @@ void UpdateGameplayScreen() {
     {  // Removing temporary debug lines.
         if (IsKeyPressed(KEY_F3)) {
             gplayer.buttonClearPathsPressedTime = GetTime();
-            gdata.linesToDraw.clear();
-            gdata.colorsOfLines.clear();
+            RingBufferClear(gdata.debugLines);
         }
     }
 
-    gplayer.currentState->Update(dt);
-
-    {  // Проверяем на коллизии то, куда смотрит игрок.
-        const float maxDistance = 20.0f;
-
-        bool    collided             = false;
-        float   minCollisionDistance = floatInf;
-        Vector3 collisionPoint       = {};
-        // Vector3 collisionNormal      = {};
-
-        Ray ray = {gplayer.position + Vector3Up * 2.0f, gplayer.lookingDirection};
-
-        for (const auto& cube : gdata.cubes) {
-            const auto        cubePos = ToVector3(cube.pos);
-            const BoundingBox box     = {cubePos, cubePos + Vector3One()};
+#if !defined(PLATFORM_WEB)
+    {  // Симуляция в отдельном потоке.
+        if (IsKeyPressed(KEY_F4)) {
+            gdata.pipelined = !gdata.pipelined;
 
-            const RayCollision collision = GetRayCollisionBox(ray, box);
-
-            if (collision.hit                          //
-                && (collision.distance < maxDistance)  //
-                && (minCollisionDistance > collision.distance))
-            {
-                minCollisionDistance = collision.distance;
-
-                collisionPoint = collision.point;
-                // collisionNormal = collision.normal;
-
-                collided = true;
-            }
+            if (gdata.pipelined && !gdata.simThread.thread.joinable())
+                StartWorkerThread(gdata.simThread, SimulateGameplayJob_, nullptr);
         }
+    }
+#endif
 
-        if (collided) {
-            gplayer.collided           = true;
-            gplayer.lookingAtCollision = collisionPoint;
-        }
-        else
-            gplayer.collided = false;
+    {  // Телеметрия.
+        if (IsKeyPressed(KEY_F9))
+            gdata.telemetryOverlay = !gdata.telemetryOverlay;
+        if (IsKeyPressed(KEY_F10))
+            SaveTelemetryCsv(telemetry, TELEMETRY_CSV_PATH);
     }
 
-    FOR_RANGE (int, i, NUM_PARTICLES) {
-        gdata.positions[i] += gdata.velocities[i] * dt;
+    {  // Память подсистем.
+        if (IsKeyPressed(KEY_M)) {
+            gdata.memoryOverlay = !gdata.memoryOverlay;
+            if (gdata.memoryOverlay)
+                DumpMemoryRegistry(memoryRegistry);
+        }
     }
 
-    // NOTE: Наверное, оно и не нужно. Всё равно ограничиваем кол-во частиц.
-#if 0
-    {  // Сдвигаем вправо данные частиц, которые "отжили своё время". ("Move Zeros" alg.)
-        int left = 0;
+    {  // Переключение отрисовки мира.
+        if (IsKeyPressed(KEY_F7)) {
+            const int next        = ((int)gdata.worldRenderPath + 1);
+            gdata.worldRenderPath = (WorldRenderPath)(next % (int)WorldRenderPath::COUNT);
+        }
+        if (IsKeyPressed(KEY_F8)) {
+            auto& renderer            = gdata.chunkRenderer;
+            renderer.occlusionCulling = !renderer.occlusionCulling;
+        }
+    }
 
-        const auto t = GetTime();
+    auto input = CaptureGameplayInput(dt);
+    if (!gdata.replay.inputs.empty())
+        input = NextReplayInput_();
+    if (!gdata.recordPath.empty())
+        gdata.recorded.push_back(input);
 
-        FOR_RANGE (int, right, NUM_PARTICLES) {
-            bool isExpired = t - gdata.timesOfCreation[right] > 7.0f;
-            if (isExpired)
-                continue;
+    if (gdata.pipelined) {
+        // Тик, которого дождались в начале кадра. После WorkerThreadKick
+        // simMilliseconds пишет поток симуляции.
+        TelemetrySet(TelemetryMetric::SIM_MS, (float)gdata.simMilliseconds);
 
-            auto& pos1 = gdata.positions[left];
-            auto& pos2 = gdata.positions[right];
-            auto& vel1 = gdata.velocities[left];
-            auto& vel2 = gdata.velocities[right];
-            auto& toc1 = gdata.timesOfCreation[left];
-            auto& toc2 = gdata.timesOfCreation[right];
-
-            std::swap(pos1, pos2);
-            std::swap(vel1, vel2);
-            std::swap(toc1, toc2);
-            left++;
-        }
-
-        numActiveParticles = left;
-        Assert(numActiveParticles <= NUM_PARTICLES);
+        // Отрисовка этого кадра покажет предыдущий тик.
+        gdata.queuedInput = input;
+        WorkerThreadKick(gdata.simThread);
+    }
+    else {
+        SimulateGameplay(input);
+        ConsumeGameplaySnapshot();
+        TelemetrySet(TelemetryMetric::SIM_MS, (float)gdata.simMilliseconds);
     }
-#endif
 
-#if 0
-    // Сортировка частиц от точки "взора" игрока до них.
-    // TODO: better sort
-    {
-        const auto eyePos = gplayer.position + Vector3Up * 2.0f;
+    UpdateParticles(dt);
 
-        FOR_RANGE (int, i, numActiveParticles - 1) {
-            bool swapped = false;
+    {  // Чанки вокруг того, что покажет отрисовка.
+        const auto& snapshot = TripleBufferReadBuffer(gdata.snapshots);
+        UpdateChunkStreaming(
+            gdata.chunkStreamer, gdata.chunkRenderer, snapshot.position, snapshot.velocity
+        );
+    }
 
-            FOR_RANGE (int, j, numActiveParticles - i - 1) {
-                auto& pos1 = gdata.positions[j];
-                auto& pos2 = gdata.positions[j + 1];
+    TrackGameplayMemory_();
+}
 
-                float d1 = Vector3Distance(eyePos, ToVector3(pos1));
-                float d2 = Vector3Distance(eyePos, ToVector3(pos2));
+// Как LoadRenderTexture, но глубина - текстура, а не renderbuffer,
+// чтобы из неё можно было читать. См. UpdateChunkOcclusion.
+RenderTexture2D LoadSceneTarget_(int width, int height) {
+    RenderTexture2D target = {};
 
-                if (d2 > d1) {
-                    auto& vel1 = gdata.velocities[j];
-                    auto& vel2 = gdata.velocities[j + 1];
-                    auto& toc1 = gdata.timesOfCreation[j];
-                    auto& toc2 = gdata.timesOfCreation[j + 1];
+    target.id = rlLoadFramebuffer(width, height);
+    rlEnableFramebuffer(target.id);
 
-                    std::swap(pos1, pos2);
-                    std::swap(vel1, vel2);
-                    std::swap(toc1, toc2);
+    target.texture.id = rlLoadTexture(
+        nullptr, width, height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1
+    );
+    target.texture.width   = width;
+    target.texture.height  = height;
+    target.texture.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    target.texture.mipmaps = 1;
+
+    target.depth.id      = rlLoadTextureDepth(width, height, false);
+    target.depth.width   = width;
+    target.depth.height  = height;
+    target.depth.mipmaps = 1;
+
+    rlFramebufferAttach(
+        target.id,
+        target.texture.id,
+        RL_ATTACHMENT_COLOR_CHANNEL0,
+        RL_ATTACHMENT_TEXTURE2D,
+        0
+    );
+    rlFramebufferAttach(
+        target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0
+    );
+    if (!rlFramebufferComplete(target.id))
+        TraceLog(LOG_WARNING, "Scene framebuffer is not complete");
 
-                    swapped = true;
-                }
-            }
-            if (!swapped)
-                break;
-        }
-    }
-#endif
+    rlDisableFramebuffer();
+    return target;
+}
 
-    UpdateSSBO(gdata.ssbo0, (void*)gdata.positions, sizeof(Vector4), NUM_PARTICLES);
-    UpdateSSBO(gdata.ssbo1, (void*)gdata.velocities, sizeof(Vector4), NUM_PARTICLES);
-    UpdateSSBO(gdata.ssbo2, (void*)gdata.timesOfCreation, sizeof(float), NUM_PARTICLES);
+void UnloadSceneTarget_(RenderTexture2D& target) {
+    // rlUnloadFramebuffer удаляет и текстуру глубины.
+    if (target.id != 0)
+        UnloadRenderTexture(target);
+    target = {};
 }
 
 // Gameplay Screen Draw logic.
 void DrawGameplayScreen() {
+    ALLOCATION_ZONE("draw");
+    const double drawStart = GetTime();
+
     DebugTextReset();
 
+    auto& snapshot = TripleBufferReadBuffer(gdata.snapshots);
+
     const auto screenWidth  = GetScreenWidth();
     const auto screenHeight = GetScreenHeight();
 
-    DrawRectangle(0, 0, screenWidth, screenHeight, BLACK);
+    auto& sceneTarget = gdata.sceneTarget;
+    if ((sceneTarget.texture.width != screenWidth)
+        || (sceneTarget.texture.height != screenHeight))
+    {
+        UnloadSceneTarget_(sceneTarget);
+        sceneTarget = LoadSceneTarget_(screenWidth, screenHeight);
+    }
+
+    BeginTextureMode(sceneTarget);
+    ClearBackground(BLACK);
 
     auto& camera    = gdata.camera;
-    camera.position = gplayer.position + Vector3Up * 2.0f;
-    camera.target   = camera.position + gplayer.lookingDirection * 100.0f;
+    camera.position = snapshot.position + Vector3Up * 2.0f;
+    camera.target   = camera.position + snapshot.lookingDirection * 100.0f;
 
     {  // FOV.
-        const auto dashElapsed          = (float)(GetTime() - gplayer.lastDashTime);
+        const auto dashElapsed          = (float)(GetTime() - snapshot.lastDashTime);
         const bool dashAnimationExpired = dashElapsed
                                           > (gplayer.fromDefaultToDashFovDuration
                                              + gplayer.fromDashToDefaultFovDuration);
@@ -962,33 +1893,132 @@ void DrawGameplayScreen() {
 
     BeginMode3D(camera);
     {  // Drawing world.
-        FOR_RANGE (int, i, gdata.cubes.size()) {
-            const auto& cube = gdata.cubes[i];
-            const auto& pos
-                = Vector3((float)cube.pos.x, (float)cube.pos.y, (float)cube.pos.z);
-            DrawCubeV(
-                pos + Vector3One() / 2.0f, Vector3One(), gdata.colors[cube.colorIndex]
+        auto& timer = gdata.worldTimers[(int)gdata.worldRenderPath];
+
+        const auto viewProjection
+            = MatrixMultiply(GetCameraMatrix(camera), rlGetMatrixProjection());
+
+        rlDrawRenderBatchActive();
+        GpuTimerBegin(timer);
+
+        if (gdata.worldRenderPath == WorldRenderPath::RASTERIZED) {
+            auto& renderer = gdata.chunkRenderer;
+            DrawChunks(renderer, gdata.palette, viewProjection, camera.position);
+            UpdateChunkOcclusion(
+                renderer, sceneTarget.depth.id, screenWidth, screenHeight, viewProjection
             );
-            DrawCubeWiresV(pos + Vector3One() / 2.0f, Vector3One(), BLACK);
+        }
+        else if (gdata.bricks.bricks != nullptr) {
+            const auto& bricks = gdata.bricks;
+
+            auto& shader = gdata.raymarchShader;
+            rlEnableShader(shader.id);
+            SetShaderValueMatrix(shader, 0, viewProjection);
+            SetShaderValueMatrix(shader, 1, MatrixInvert(viewProjection));
+            SetShaderValue(shader, 2, &camera.position, SHADER_UNIFORM_VEC3);
+            SetShaderValue(shader, 3, &bricks.origin, SHADER_UNIFORM_IVEC3);
+            SetShaderValue(shader, 4, &bricks.size, SHADER_UNIFORM_IVEC3);
+            SetShaderValue(shader, 5, &raymarchMaxDistance, SHADER_UNIFORM_FLOAT);
+
+            BindGpuBrickMap(gdata.gpuBricks);
+            rlBindShaderBuffer(gdata.palette, PALETTE_BINDING);
+
+            // Полноэкранный треугольник генерируется в шейдере по gl_VertexID.
+            rlEnableVertexArray(gdata.particleVao);
+            rlDrawVertexArray(0, 3);
+            rlDisableVertexArray();
+            TelemetryAdd(TelemetryMetric::DRAW_CALLS, 1);
+
+            rlDisableShader();
+        }
+
+        GpuTimerEnd(timer);
+    }
+
+    {  // Drawing grapplers.
+        const int count = (int)snapshot.grapplers.size();
+
+        if (count > 0) {
+            const int size = count * sizeof(Vector4);
+            auto      data = StreamBufferBegin(gdata.grapplerInstances);
+            memcpy(data, snapshot.grapplers.data(), size);
+            StreamBufferEnd(gdata.grapplerInstances, size);
+
+            const Vector2 boxSize = {movementConfig.halfWidth, movementConfig.height};
+
+            rlDrawRenderBatchActive();
+            rlEnableShader(gdata.grapplerShader.id);
+            SetShaderValueMatrix(gdata.grapplerShader, 0, rlGetMatrixProjection());
+            SetShaderValueMatrix(gdata.grapplerShader, 1, GetCameraMatrix(camera));
+            SetShaderValue(gdata.grapplerShader, 2, &boxSize, SHADER_UNIFORM_VEC2);
+
+            StreamBufferBind(gdata.grapplerInstances, 0);
+
+            // Вертексы куба генерируются в шейдере по gl_VertexID.
+            rlEnableVertexArray(gdata.particleVao);
+            rlDrawVertexArrayInstanced(0, 36, count);
+            rlDisableVertexArray();
+            TelemetryAdd(TelemetryMetric::DRAW_CALLS, 1);
+
+            StreamBufferFence(gdata.grapplerInstances);
+            rlDisableShader();
         }
     }
 
     DrawGrid(100, 1.0f);
 
     {  // Drawing ropes.
-        if (gplayer.ropeActivated) {
-            Vector3 from = gplayer.position;
-            // Смещаем в сторону.
-            from += HorizontalAxisOf(gplayer.lookingDirection) * 2.0f;
-            // Смещаем вниз.
-            from -= Vector3Up * 0.5f;
-
-            DrawRope(from, gplayer.ropePos);
+        FOR_RANGE (int, rope, MAX_ROPES) {
+            if (snapshot.ropes.active[rope])
+                DrawRopePoints(snapshot.ropes, rope, gdata.gizmosEnabled);
         }
     }
     EndMode3D();
 
     BeginMode3D(camera);
+    {  // Boost trail.
+        const int count = (int)snapshot.boostTrail.size();
+
+        if (count >= 2) {
+            const int size = count * sizeof(TrailPoint);
+            auto      data = StreamBufferBegin(gdata.trailPoints);
+            memcpy(data, snapshot.boostTrail.data(), size);
+            StreamBufferEnd(gdata.trailPoints, size);
+
+            const auto&   trail    = gdata.boostTrail;
+            const auto    time     = (float)GetTime();
+            const float   width    = 0.35f;
+            const Vector3 color    = {0.6f, 0.85f, 1.0f};
+            const auto&   position = camera.position;
+
+            auto& shader = gdata.trailShader;
+            rlEnableShader(shader.id);
+            SetShaderValueMatrix(shader, 0, rlGetMatrixProjection());
+            SetShaderValueMatrix(shader, 1, GetCameraMatrix(camera));
+            SetShaderValue(shader, 2, &position, SHADER_UNIFORM_VEC3);
+            SetShaderValue(shader, 3, &time, SHADER_UNIFORM_FLOAT);
+            SetShaderValue(shader, 4, &width, SHADER_UNIFORM_FLOAT);
+            SetShaderValue(shader, 5, &trail.lifetime, SHADER_UNIFORM_FLOAT);
+            SetShaderValue(shader, 6, &count, SHADER_UNIFORM_INT);
+            SetShaderValue(shader, 7, &color, SHADER_UNIFORM_VEC3);
+
+            StreamBufferBind(gdata.trailPoints, 0);
+
+            // Вертексы ленты генерируются в шейдере по gl_VertexID.
+            rlDisableDepthMask();
+            rlDisableBackfaceCulling();
+            rlEnableVertexArray(gdata.particleVao);
+            rlDrawVertexArray(0, (count - 1) * 6);
+            rlDisableVertexArray();
+            TelemetryAdd(TelemetryMetric::DRAW_CALLS, 1);
+            rlEnableBackfaceCulling();
+            rlEnableDepthMask();
+
+            StreamBufferFence(gdata.trailPoints);
+            rlDisableShader();
+        }
+    }
+
     {  // Particles. Drawing pass.
         const float particleScale = 100.0;
         const auto  NUM_PARTICLES = NUMBER_OF_INSTANCES * PARTICLES_PER_SHADER_INSTANCE;
@@ -1007,9 +2037,9 @@ void DrawGameplayScreen() {
         SetShaderValue(gdata.particleShader, 2, &particleScale, SHADER_UNIFORM_FLOAT);
         SetShaderValue(gdata.particleShader, 3, &time, SHADER_UNIFORM_FLOAT);
 
-        rlBindShaderBuffer(gdata.ssbo0, 0);
-        rlBindShaderBuffer(gdata.ssbo1, 1);
-        rlBindShaderBuffer(gdata.ssbo2, 2);
+        rlBindShaderBuffer(gdata.particlePositions, 0);
+        rlBindShaderBuffer(gdata.particleVelocities, 1);
+        rlBindShaderBuffer(gdata.particleTimesOfCreation, 2);
 
         // Particles drawing. Instancing will duplicate the vertices.
         {
@@ -1018,6 +2048,7 @@ void DrawGameplayScreen() {
             rlEnableVertexArray(gdata.particleVao);
             rlDrawVertexArrayInstanced(0, 3, 2 * NUM_PARTICLES);
             rlDisableVertexArray();
+            TelemetryAdd(TelemetryMetric::DRAW_CALLS, 1);
 
             rlEnableDepthMask();
         }
@@ -1025,23 +2056,32 @@ void DrawGameplayScreen() {
     }
 
     if (gdata.gizmosEnabled) {  // Drawing lines 3D.
-        FOR_RANGE (size_t, i, gdata.linesToDraw.size() / 2) {
-            auto& p1 = gdata.linesToDraw[i * 2];
-            auto& p2 = gdata.linesToDraw[i * 2 + 1];
-            DrawLine3D(p1, p2, gdata.colorsOfLines[i]);
+        FOR_RANGE (int, i, gdata.debugLines.count) {
+            const auto& line = RingBufferGet(gdata.debugLines, i);
+            DrawLine3D(line.from, line.to, line.color);
         }
-        // gdata.linesToDraw.clear();
     }
     EndMode3D();
 
+    EndTextureMode();
+
+    {  // Сцена на экран. Альфа текстуры не важна - рисуем без смешивания.
+        rlDrawRenderBatchActive();
+        rlDisableColorBlend();
+        const Rectangle source = {0, 0, (float)screenWidth, -(float)screenHeight};
+        DrawTextureRec(sceneTarget.texture, source, {0, 0}, WHITE);
+        rlDrawRenderBatchActive();
+        rlEnableColorBlend();
+    }
+
     {  // Cross.
         const int size  = 20;
         const int width = 4;
 
         auto color = WHITE;
-        if (gplayer.collided)
+        if (snapshot.collided)
             color = GREEN;
-        if (gplayer.ropeActivated)
+        if (snapshot.ropeActivated)
             color = RED;
 
         DrawRectangle(
@@ -1065,7 +2105,10 @@ void DrawGameplayScreen() {
     // );
     // DebugTextDraw("Toggle gizmos - F2");
     DebugTextDraw(TextFormat(
-        "pos %.2f %.2f %.2f", gplayer.position.x, gplayer.position.y, gplayer.position.z
+        "pos %.2f %.2f %.2f",
+        snapshot.position.x,
+        snapshot.position.y,
+        snapshot.position.z
     ));
     // DebugTextDraw(TextFormat(
     //     "vel (%.2f) %.2f %.2f %.2f",
@@ -1076,23 +2119,88 @@ void DrawGameplayScreen() {
     // ));
     DebugTextDraw(TextFormat(
         "look %.2f %.2f %.2f",
-        gplayer.lookingDirection.x,
-        gplayer.lookingDirection.y,
-        gplayer.lookingDirection.z
+        snapshot.lookingDirection.x,
+        snapshot.lookingDirection.y,
+        snapshot.lookingDirection.z
     ));
-    DebugTextDraw(TextFormat("alive particles count %i", numActiveParticles));
     DebugTextDraw(TextFormat(
         "gdata.nextToGenerateParticleIndex %i", gdata.nextToGenerateParticleIndex
     ));
     // DebugTextDraw(TextFormat("fov %.2f", camera.fovy));
+    DebugTextDraw(TextFormat(
+        "simulation thread %s (press F4 to toggle)", gdata.pipelined ? "on" : "off"
+    ));
+    DebugTextDraw(TextFormat(
+        "grapplers %i (F5 - spawn, F6 - clear)", (int)snapshot.grapplers.size()
+    ));
+    DebugTextDraw(TextFormat(
+        "world %s, GPU %.2f ms (F7 - switch)",
+        worldRenderPathNames[(int)gdata.worldRenderPath],
+        gdata.worldTimers[(int)gdata.worldRenderPath].milliseconds
+    ));
+    if (gdata.worldRenderPath == WorldRenderPath::RASTERIZED) {
+        const auto& renderer = gdata.chunkRenderer;
+        DebugTextDraw(TextFormat(
+            "chunks %i / %i, vertices %i (F8 - occlusion culling %s)",
+            renderer.visibleChunks,
+            renderer.chunksCount,
+            renderer.visibleVertices,
+            renderer.occlusionCulling ? "on" : "off"
+        ));
+        DebugTextDraw(TextFormat(
+            "streamed chunks %i / %i, vertices %i / %i KB",
+            renderer.chunksCount,
+            (int)gdata.chunkStreamer.level.entries.size(),
+            (int)(renderer.verticesCount * sizeof(ChunkVertex) / 1024),
+            (int)(renderer.maxVertices * sizeof(ChunkVertex) / 1024)
+        ));
+    }
 
-    bool isAirborne
-        = gplayer.currentState == (gdata.states + (int)PlayerStates::AIRBORNE);
+    if (gdata.telemetryOverlay) {
+        if (GetTime() - gdata.telemetryReportTime > telemetryReportPeriod) {
+            gdata.telemetryReportTime = GetTime();
+            FOR_RANGE (int, i, (int)TelemetryMetric::COUNT) {
+                gdata.telemetryReport[i]
+                    = ComputeTelemetryPercentiles(telemetry, (TelemetryMetric)i);
+            }
+        }
+
+        DebugTextDraw(TextFormat(
+            "last %i frames: p50 / p95 / p99 / max (F10 - save %s)",
+            telemetry.count,
+            TELEMETRY_CSV_PATH
+        ));
+        FOR_RANGE (int, i, (int)TelemetryMetric::COUNT) {
+            const auto& p = gdata.telemetryReport[i];
+            DebugTextDraw(TextFormat(
+                "  %s %.2f / %.2f / %.2f / %.2f",
+                telemetryMetricNames[i],
+                p.p50,
+                p.p95,
+                p.p99,
+                p.max
+            ));
+        }
+    }
+    else
+        DebugTextDraw("F9 - telemetry");
+
+    if (gdata.memoryOverlay) {
+        DebugTextDraw("memory: now, peak, budget (M - hide, also in log)");
+        FOR_RANGE (int, i, MemoryReportRowsCount(memoryRegistry)) {
+            if (auto row = MemoryReportRow(memoryRegistry, i))
+                DebugTextDraw(row);
+        }
+    }
+    else
+        DebugTextDraw("M - memory");
 
-    ButtonTextDraw("SPACE - Jump", &gplayer.buttonJumpPressedTime, !isAirborne);
-    ButtonTextDraw("LMB - Grapple", &gplayer.buttonGrapplePressedTime, isAirborne);
-    ButtonTextDraw("RMB - Dash", &gplayer.buttonDashPressedTime, isAirborne);
-    ButtonTextDraw("V - Apply Boost", &gplayer.buttonBoostPressedTime, isAirborne);
+    bool isAirborne = snapshot.isAirborne;
+
+    ButtonTextDraw("SPACE - Jump", &snapshot.buttonJumpPressedTime, !isAirborne);
+    ButtonTextDraw("LMB - Grapple", &snapshot.buttonGrapplePressedTime, isAirborne);
+    ButtonTextDraw("RMB - Dash", &snapshot.buttonDashPressedTime, isAirborne);
+    ButtonTextDraw("V - Apply Boost", &snapshot.buttonBoostPressedTime, isAirborne);
     // ButtonTextDraw("F3 - Clear Gizmos", &gplayer.buttonClearPathsPressedTime);
 
     {  // TODO: remove me
@@ -1180,12 +2288,81 @@ void DrawGameplayScreen() {
             20.0f
         );
     }
+
+    {  // Телеметрия кадра.
+        const auto path     = gdata.worldRenderPath;
+        const auto renderMs = (GetTime() - drawStart) * 1000.0;
+        const auto gpuMs    = gdata.worldTimers[(int)path].milliseconds;
+        TelemetrySet(TelemetryMetric::RENDER_MS, (float)renderMs);
+        TelemetrySet(TelemetryMetric::GPU_WORLD_MS, (float)gpuMs);
+
+        // 6 вертексов на грань, см. chunk_mesh.cpp.
+        if (path == WorldRenderPath::RASTERIZED) {
+            const int faces = gdata.chunkRenderer.visibleVertices / 6;
+            TelemetrySet(TelemetryMetric::VOXEL_FACES, (float)faces);
+        }
+
+        // От конца прошлой отрисовки, включая EndDrawing.
+        const auto allocations = EndAllocationFrame(allocationTracker);
+        TelemetrySet(TelemetryMetric::ALLOCATIONS, (float)allocations.allocations);
+        TelemetrySet(TelemetryMetric::ALLOCATED_BYTES, (float)allocations.bytes);
+
+        TelemetryEndFrame(telemetry, GetTime());
+    }
+
+    // Режим forbidFrameAllocations. Кадр уже в логе, в Debug ещё и падаем.
+    Assert(allocationTracker.framesWithAllocations == 0);
 }
 
 // Gameplay Screen Unload logic.
 void UnloadGameplayScreen() {
     EnableCursor();
 
+    StopWorkerThread(gdata.simThread);
+    gdata.pipelined = false;
+    // Выкидываем тик, который так и не дошёл до отрисовки.
+    TripleBufferAcquire(gdata.snapshots);
+
+    if (!gdata.recordPath.empty()) {
+        const auto data = SerializeGameplayReplay(gdata.recorded);
+        SaveFileData(gdata.recordPath.c_str(), (void*)data.data(), (int)data.size());
+        gdata.recordPath.clear();
+        gdata.recorded.clear();
+    }
+    gdata.replay = {};
+
+    SaveTelemetryCsv(telemetry, TELEMETRY_CSV_PATH);
+
+    // Пики за уровень - по ним подбираются бюджеты.
+    DumpMemoryRegistry(memoryRegistry);
+    FOR_RANGE (int, s, (int)MemorySubsystem::COUNT) {
+        FOR_RANGE (int, k, (int)MemoryKind::COUNT) {
+            MemoryResized(
+                memoryRegistry,
+                (MemorySubsystem)s,
+                (MemoryKind)k,
+                gdata.trackedMemory[s][k],
+                0
+            );
+        }
+    }
+    if (gdata.chunkVerticesPool >= 0)
+        UnregisterMemoryPool(memoryRegistry, gdata.chunkVerticesPool);
+    gdata.chunkVerticesPool = -1;
+
+    // Кубы, палитра и отладочные линии уходят вместе с аренами.
+    gdata.cubes      = {};
+    gdata.colors     = {};
+    gdata.debugLines = {};
+    if (gdata.levelArenaPool >= 0)
+        UnregisterMemoryPool(memoryRegistry, gdata.levelArenaPool);
+    if (gdata.debugArenaPool >= 0)
+        UnregisterMemoryPool(memoryRegistry, gdata.debugArenaPool);
+    gdata.levelArenaPool = -1;
+    gdata.debugArenaPool = -1;
+    FreeArena(gdata.levelArena);
+    FreeArena(gdata.debugArena);
+
     if (gdata.fxFootsteps != nullptr) {
         FOR_RANGE (int, i, 5) {
             UnloadSound(gdata.fxFootsteps[i]);
@@ -1198,15 +2375,35 @@ void UnloadGameplayScreen() {
     UnloadSound(gdata.fxBoost);
 
     UnloadShader(gdata.particleShader);
-    // rlUnloadShaderProgram(gdata.particleComputeShader);
-    // gdata.particleComputeShader = 0;
-
-    RL_FREE(gdata.positions);
-    RL_FREE(gdata.velocities);
-    RL_FREE(gdata.timesOfCreation);
-    gdata.positions       = nullptr;
-    gdata.velocities      = nullptr;
-    gdata.timesOfCreation = nullptr;
+    UnloadShader(gdata.grapplerShader);
+    UnloadShader(gdata.trailShader);
+    rlUnloadShaderProgram(gdata.particleComputeShader);
+    gdata.particleComputeShader = 0;
+
+    FreeBrickMap(gdata.bricks);
+    UnloadGpuBrickMap(gdata.gpuBricks);
+    if (gdata.palette != 0)
+        rlUnloadShaderBuffer(gdata.palette);
+    gdata.palette = 0;
+    UnloadShader(gdata.raymarchShader);
+    StopChunkStreamer(gdata.chunkStreamer);
+    UnloadChunkRenderer(gdata.chunkRenderer);
+    UnloadSceneTarget_(gdata.sceneTarget);
+    FOR_RANGE (int, i, (int)WorldRenderPath::COUNT) {
+        FreeGpuTimer(gdata.worldTimers[i]);
+    }
+    gdata.world = {};
+
+    rlUnloadShaderBuffer(gdata.particlePositions);
+    rlUnloadShaderBuffer(gdata.particleVelocities);
+    rlUnloadShaderBuffer(gdata.particleTimesOfCreation);
+    FreeStreamBuffer(gdata.particleSpawns);
+    FreeStreamBuffer(gdata.grapplerInstances);
+    FreeStreamBuffer(gdata.trailPoints);
+
+    gdata.particlePositions       = 0;
+    gdata.particleVelocities      = 0;
+    gdata.particleTimesOfCreation = 0;
 }
 
 // Gameplay Screen should finish?
@@ -0,0 +1,618 @@
+//----------------------------------------------------------------------------------
+// Signed Distance Field.
+//----------------------------------------------------------------------------------
+// Расстояние до ближайшей поверхности вокселей, запечённое из VoxelGrid:
+// снаружи вокселей - положительное, внутри - отрицательное.
+//
+// Значения хранятся в центрах клеток сетки, которая шире VoxelGrid
+// на SDF_PADDING клеток с каждой стороны. Между центрами - трилинейная интерполяция.
+// Формат - i16 с фиксированной точкой: SDF_SCALE единиц на клетку.
+//
+// Значение в центре клетки - точное расстояние до куба ближайшей клетки другого
+// типа (не до её центра), поэтому у рёбер и углов оно не завышено.
+//
+// Печётся точным евклидовым преобразованием расстояний - тремя проходами
+// одномерного преобразования (по x, y, z) сразу для расстояний до ближайшей
+// занятой клетки и до ближайшей пустой. Первый проход - два прохода по строке сетки,
+// остальные - нижняя огибающая парабол. Первый проход идёт плоскостью z прямо
+// перед вторым, пока плоскость в кеше, последний сразу пишет i16.
+// Плоскости независимы и раскидываются по потокам.
+//
+// ref: Felzenszwalb, Huttenlocher - Distance Transforms of Sampled Functions.
+//
+// Модуль используют только тесты и бенчмарки. Геймплей SDF уровня не держит:
+// коллизии, запросы к миру и частицы идут по BrickMap (см. world_query.cpp),
+// LoadSdfTexture игра не зовёт.
+const int   SDF_PADDING = 4;
+const float SDF_SCALE   = 64.0f;
+
+struct SignedDistanceField {
+    Vector3Int origin = {};  // Мировые координаты клетки с индексом (0, 0, 0).
+    Vector3Int size   = {};
+    i16*       values = nullptr;
+};
+
+// Конечное "бесконечное" расстояние, чтобы в преобразовании не было inf - inf.
+const float sdfFar_ = 1e20f;
+
+// Номер "отсутствующей" клетки в строке - дальше любой клетки сетки.
+const int sdfNoCell_ = 1 << 20;
+
+// Квадрат расстояния вдоль оси от центра клетки до куба клетки через d клеток.
+float SdfAxisDistanceSqr_(int d) {
+    if (d == 0)
+        return 0;
+    if (d >= sdfNoCell_)
+        return sdfFar_;
+
+    const float a = (float)d - 0.5f;
+    return a * a;
+}
+
+// Первый проход (по x) - сразу по строке сетки.
+// row - rowSize клеток сетки, начиная с x = SDF_PADDING. nullptr - строка вне сетки.
+// В out - квадраты расстояний вдоль строки (см. BakeSignedDistanceField).
+void SdfTransformRow_(const u8* row, int rowSize, int count, float* out) {
+    if (row == nullptr) {
+        FOR_RANGE (int, x, count) {
+            out[x] = sdfFar_;
+        }
+        return;
+    }
+
+    auto isSolid = [&](int x) {
+        const int gx = x - SDF_PADDING;
+        return (gx >= 0) && (gx < rowSize) && (row[gx] != 0);
+    };
+
+    // Слева направо - расстояние до ближайшей клетки другого типа слева.
+    int lastSolid = -sdfNoCell_;
+    int lastEmpty = -sdfNoCell_;
+    FOR_RANGE (int, x, count) {
+        if (isSolid(x)) {
+            lastSolid = x;
+            out[x]    = (float)(x - lastEmpty);
+        }
+        else {
+            lastEmpty = x;
+            out[x]    = (float)(x - lastSolid);
+        }
+    }
+
+    // Справа налево - минимум с расстоянием до такой же клетки справа.
+    int nextSolid = count + sdfNoCell_;
+    int nextEmpty = count + sdfNoCell_;
+    for (int x = count - 1; x >= 0; x--) {
+        if (isSolid(x)) {
+            nextSolid = x;
+            out[x]    = -SdfAxisDistanceSqr_(Min((int)out[x], nextEmpty - x));
+        }
+        else {
+            nextEmpty = x;
+            out[x]    = SdfAxisDistanceSqr_(Min((int)out[x], nextSolid - x));
+        }
+    }
+}
+
+// Нижняя огибающая парабол f + (t - vertex)^2. h[i] = f + vertex[i]^2.
+// Парабола i - нижняя на [z[i], z[i + 1]].
+// vertex, h - массивы на count элементов, z - на count + 1.
+struct SdfEnvelope_ {
+    float* vertex = nullptr;
+    float* h      = nullptr;
+    float* z      = nullptr;
+    int    k      = -1;  // Последняя парабола, -1 - огибающая пустая.
+    int    at     = 0;   // Парабола для SdfEnvelopeEvaluateRun_.
+};
+
+// Параболы добавляются в порядке возрастания x.
+void SdfEnvelopeAdd_(SdfEnvelope_& e, float x, float f) {
+    const float hq = f + x * x;
+    if (e.k < 0) {
+        e.k         = 0;
+        e.vertex[0] = x;
+        e.h[0]      = hq;
+        e.z[0]      = -sdfFar_;
+        return;
+    }
+
+    // Пересечение с верхней параболой огибающей. Если оно левее начала
+    // её отрезка - новая парабола закрывает её целиком.
+    int   k = e.k;
+    float s = 0;
+    while (true) {
+        s = (hq - e.h[k]) / (2 * (x - e.vertex[k]));
+        if ((s > e.z[k]) || (k == 0))
+            break;
+        k--;
+    }
+
+    k++;
+    e.vertex[k] = x;
+    e.h[k]      = hq;
+    e.z[k]      = s;
+    e.k         = k;
+}
+
+// Значения клеток [begin, end) одного типа. Отрезки - по возрастанию.
+// Правая точка клетки q - левая точка клетки q + 1.
+void SdfEnvelopeEvaluateRun_(SdfEnvelope_& e, float* line, int begin, int end) {
+    const float* vertex = e.vertex;
+    const float* h      = e.h;
+    const float* z      = e.z;
+    int          at     = e.at;
+
+    float t = (float)begin - 0.5f;
+    while (z[at + 1] < t)
+        at++;
+    float left = t * (t - 2 * vertex[at]) + h[at];
+
+    for (int q = begin; q < end; q++) {
+        t = (float)q + 0.5f;
+        while (z[at + 1] < t)
+            at++;
+        const float right = t * (t - 2 * vertex[at]) + h[at];
+        const float value = line[q];
+
+        line[q] = copysignf(Min(fabsf(value), Min(left, right)), value);
+        left    = right;
+    }
+    e.at = at;
+}
+
+// Конец отрезка клеток того же типа, что и line[begin].
+int SdfRunEnd_(const float* line, int count, int begin) {
+    const bool solid = line[begin] < 0;
+
+    int end = begin + 1;
+    while ((end < count) && ((line[end] < 0) == solid))
+        end++;
+    return end;
+}
+
+// Одномерное преобразование линии сразу для обоих полей: min по p (f[p] + g(q - p)),
+// где g(d) = (|d| - 0.5)^2 для d != 0 и 0 для d = 0 - квадрат расстояния вдоль оси
+// от центра клетки до куба клетки. g - минимум двух парабол с вершинами на гранях
+// клетки, поэтому хватает нижней огибающей обычных парабол f[p] + (t - p)^2,
+// взятой в точках t = q - 0.5 и t = q + 0.5.
+//
+// line - квадраты расстояний со знаком (см. BakeSignedDistanceField), результат
+// пишется туда же. У пустой клетки f - её значение в поле "до занятой",
+// у занятой - 0 (она сама и есть ближайшая). В поле "до пустой" - наоборот.
+// sdfFar_ - расстояние неизвестно, такие параболы не нужны. Не нужны и нулевые
+// внутри отрезка клеток одного типа: снаружи отрезка ближе его концы,
+// а внутри результат этого поля не считается.
+//
+// Линия идёт отрезками клеток одного типа. Обе огибающие строятся за один
+// проход по отрезкам и вычисляются за второй: у каждой клетки - только
+// в поле её типа.
+void SdfTransformLine_(
+    float*        line,
+    int           count,
+    SdfEnvelope_& toSolid,
+    SdfEnvelope_& toEmpty
+) {
+    toSolid.k = -1;
+    toEmpty.k = -1;
+
+    for (int begin = 0, end = 0; begin < count; begin = end) {
+        end = SdfRunEnd_(line, count, begin);
+
+        const bool solid = line[begin] < 0;
+        auto&      own   = solid ? toEmpty : toSolid;
+        auto&      other = solid ? toSolid : toEmpty;
+
+        for (int q = begin; q < end; q++) {
+            const float f = fabsf(line[q]);
+            if (f != sdfFar_)
+                SdfEnvelopeAdd_(own, (float)q, f);
+        }
+
+        SdfEnvelopeAdd_(other, (float)begin, 0);
+        if (end - 1 > begin)
+            SdfEnvelopeAdd_(other, (float)(end - 1), 0);
+    }
+
+    // Линия целиком из sdfFar_ не меняется.
+    if (toSolid.k < 0)
+        return;
+
+    toSolid.z[toSolid.k + 1] = sdfFar_;
+    toEmpty.z[toEmpty.k + 1] = sdfFar_;
+    toSolid.at               = 0;
+    toEmpty.at               = 0;
+
+    for (int begin = 0, end = 0; begin < count; begin = end) {
+        end = SdfRunEnd_(line, count, begin);
+
+        auto& e = (line[begin] < 0) ? toEmpty : toSolid;
+        SdfEnvelopeEvaluateRun_(e, line, begin, end);
+    }
+}
+
+// Квадрат расстояния со знаком (см. BakeSignedDistanceField) - в значение SDF.
+i16 SdfPackValue_(float distanceSqr) {
+    // До куба ближайшей клетки другого типа. Поверхность - между клетками.
+    const float distance = copysignf(sqrtf(fabsf(distanceSqr)), distanceSqr);
+    const float value    = Clamp(distance * SDF_SCALE, -32767.0f, 32767.0f);
+
+    // Округление от нуля, как roundf, но без вызова функции.
+    return (i16)(value + copysignf(0.5f, value));
+}
+
+// Проход преобразования вдоль оси: линии из count значений с шагом stride.
+// Линии, соседние по x, лежат в памяти рядом. Они обрабатываются пачками
+// по sdfLinesBatch_ - так каждая прочитанная кеш-линия используется целиком.
+//
+// Плоскость (planeStride) обрабатывается одним потоком. Перед её линиями
+// зовётся preparePlane(plane) - например, чтобы заполнить плоскость,
+// пока она ещё в кеше.
+//
+// values != nullptr - проход последний: результат сразу пакуется в values
+// (те же индексы, что в data), а data не меняется.
+const int sdfLinesBatch_ = 16;
+
+template <typename F>
+void SdfTransformPass_(
+    float*     data,
+    Vector3Int size,
+    int        count,
+    int        stride,
+    int        planes,
+    int        planeStride,
+    int        threadsCount,
+    i16*       values,
+    F&&        preparePlane
+) {
+    const int batches = CeilDivision(size.x, sdfLinesBatch_);
+
+    ParallelFor(planes, threadsCount, [&](int begin, int end) {
+        std::vector<float> lines(sdfLinesBatch_ * count);
+        std::vector<float> envelopes(6 * count + 2);
+
+        SdfEnvelope_ toSolid = {};
+        toSolid.vertex       = envelopes.data();
+        toSolid.h            = toSolid.vertex + count;
+        toSolid.z            = toSolid.h + count;
+
+        SdfEnvelope_ toEmpty = {};
+        toEmpty.vertex       = toSolid.z + count + 1;
+        toEmpty.h            = toEmpty.vertex + count;
+        toEmpty.z            = toEmpty.h + count;
+
+        for (int work = begin * batches; work < end * batches; work++) {
+            const int plane = work / batches;
+            const int x0    = (work % batches) * sdfLinesBatch_;
+            if (x0 == 0)
+                preparePlane(plane);
+
+            const int linesCount = Min(sdfLinesBatch_, size.x - x0);
+            float*    start      = data + plane * planeStride + x0;
+
+            FOR_RANGE (int, q, count) {
+                FOR_RANGE (int, i, linesCount) {
+                    lines[i * count + q] = start[q * stride + i];
+                }
+            }
+
+            FOR_RANGE (int, i, linesCount) {
+                SdfTransformLine_(lines.data() + i * count, count, toSolid, toEmpty);
+            }
+
+            if (values != nullptr) {
+                i16* packed = values + (start - data);
+                FOR_RANGE (int, q, count) {
+                    FOR_RANGE (int, i, linesCount) {
+                        packed[q * stride + i] = SdfPackValue_(lines[i * count + q]);
+                    }
+                }
+                continue;
+            }
+
+            FOR_RANGE (int, q, count) {
+                FOR_RANGE (int, i, linesCount) {
+                    start[q * stride + i] = lines[i * count + q];
+                }
+            }
+        }
+    });
+}
+
+// threadsCount <= 0 - по количеству ядер.
+SignedDistanceField BakeSignedDistanceField(const VoxelGrid& grid, int threadsCount) {
+    SignedDistanceField sdf = {};
+    sdf.origin              = {
+        grid.origin.x - SDF_PADDING,
+        grid.origin.y - SDF_PADDING,
+        grid.origin.z - SDF_PADDING,
+    };
+    sdf.size = {
+        grid.size.x + 2 * SDF_PADDING,
+        grid.size.y + 2 * SDF_PADDING,
+        grid.size.z + 2 * SDF_PADDING,
+    };
+
+    const auto& size       = sdf.size;
+    const int   cellsCount = size.x * size.y * size.z;
+    sdf.values             = (i16*)RL_MALLOC(cellsCount * sizeof(i16));
+
+    // Квадраты расстояний: у пустой клетки - до ближайшей занятой,
+    // у занятой - до ближайшей пустой, со знаком минус.
+    // У клеток разного типа ненулевое только одно из двух расстояний,
+    // поэтому одного массива хватает на оба.
+    auto data = (float*)RL_MALLOC(cellsCount * sizeof(float));
+    defer {
+        RL_FREE(data);
+    };
+
+    // Первый проход (по x) - построчно в плоскости z, прямо перед проходом по y.
+    auto transformRows = [&](int z) {
+        const int gz = z - SDF_PADDING;
+        FOR_RANGE (int, y, size.y) {
+            const int gy = y - SDF_PADDING;
+
+            const u8* row = nullptr;
+            if ((gy >= 0) && (gy < grid.size.y) && (gz >= 0) && (gz < grid.size.z))
+                row = grid.cells + (gz * grid.size.y + gy) * grid.size.x;
+
+            float* out = data + (z * size.y + y) * size.x;
+            SdfTransformRow_(row, grid.size.x, size.x, out);
+        }
+    };
+
+    const int slice = size.x * size.y;
+    SdfTransformPass_(
+        data, size, size.y, size.x, size.z, slice, threadsCount, nullptr, transformRows
+    );
+    SdfTransformPass_(
+        data, size, size.z, slice, size.y, size.x, threadsCount, sdf.values, [](int) {}
+    );
+
+    return sdf;
+}
+
+void FreeSignedDistanceField(SignedDistanceField& sdf) {
+    RL_FREE(sdf.values);
+    sdf = {};
+}
+
+float SdfGetCell_(const SignedDistanceField& sdf, int x, int y, int z) {
+    return (float)sdf.values[(z * sdf.size.y + y) * sdf.size.x + x] / SDF_SCALE;
+}
+
+float SdfSample(const SignedDistanceField& sdf, Vector3 position) {
+    Assert(sdf.values != nullptr);
+
+    // Относительно центра клетки (0, 0, 0).
+    const Vector3 p = {
+        position.x - (float)sdf.origin.x - 0.5f,
+        position.y - (float)sdf.origin.y - 0.5f,
+        position.z - (float)sdf.origin.z - 0.5f,
+    };
+    const Vector3 clamped = {
+        Clamp(p.x, 0, (float)(sdf.size.x - 1)),
+        Clamp(p.y, 0, (float)(sdf.size.y - 1)),
+        Clamp(p.z, 0, (float)(sdf.size.z - 1)),
+    };
+
+    const int x = Min((int)clamped.x, sdf.size.x - 2);
+    const int y = Min((int)clamped.y, sdf.size.y - 2);
+    const int z = Min((int)clamped.z, sdf.size.z - 2);
+
+    const float tx = clamped.x - (float)x;
+    const float ty = clamped.y - (float)y;
+    const float tz = clamped.z - (float)z;
+
+    const float c00 = Lerp(SdfGetCell_(sdf, x, y, z), SdfGetCell_(sdf, x + 1, y, z), tx);
+    const float c10
+        = Lerp(SdfGetCell_(sdf, x, y + 1, z), SdfGetCell_(sdf, x + 1, y + 1, z), tx);
+    const float c01
+        = Lerp(SdfGetCell_(sdf, x, y, z + 1), SdfGetCell_(sdf, x + 1, y, z + 1), tx);
+    const float c11 = Lerp(
+        SdfGetCell_(sdf, x, y + 1, z + 1), SdfGetCell_(sdf, x + 1, y + 1, z + 1), tx
+    );
+    const float value = Lerp(Lerp(c00, c10, ty), Lerp(c01, c11, ty), tz);
+
+    // Вне сетки все поверхности дальше, чем ближайшая точка сетки,
+    // и не ближе, чем value минус расстояние до неё.
+    const float outside = Vector3Distance(p, clamped);
+    if (outside > 0)
+        return Max(outside, value - outside);
+
+    return value;
+}
+
+// Направление от поверхности (нормаль на поверхности).
+Vector3 SdfGradient(const SignedDistanceField& sdf, Vector3 position) {
+    const float e = 0.5f;
+
+    const Vector3 gradient = {
+        SdfSample(sdf, position + Vector3(e, 0, 0))
+            - SdfSample(sdf, position - Vector3(e, 0, 0)),
+        SdfSample(sdf, position + Vector3(0, e, 0))
+            - SdfSample(sdf, position - Vector3(0, e, 0)),
+        SdfSample(sdf, position + Vector3(0, 0, e))
+            - SdfSample(sdf, position - Vector3(0, 0, e)),
+    };
+    return Vector3Normalize(gradient);
+}
+
+struct SdfTraceHit {
+    bool    hit      = false;
+    float   distance = 0;
+    Vector3 point    = {};
+};
+
+// Sphere tracing: шагаем по лучу на расстояние до ближайшей поверхности.
+// radius > 0 - трассировка сферы этого радиуса.
+SdfTraceHit SdfSphereTrace(
+    const SignedDistanceField& sdf,
+    Vector3                    origin,
+    Vector3                    direction,
+    float                      maxDistance,
+    float                      radius = 0
+) {
+    const float hitEpsilon = 0.01f;
+    const int   maxSteps   = 256;
+
+    direction = Vector3Normalize(direction);
+
+    float t = 0;
+    FOR_RANGE (int, step, maxSteps) {
+        const auto  p        = origin + direction * t;
+        const float distance = SdfSample(sdf, p) - radius;
+
+        if (distance < hitEpsilon) {
+            SdfTraceHit result = {};
+            result.hit         = true;
+            result.distance    = t;
+            result.point       = p;
+            return result;
+        }
+
+        t += distance;
+        if (t > maxDistance)
+            break;
+    }
+
+    return {};
+}
+
+// 3D текстура R16_SNORM с теми же значениями для шейдеров.
+// Расстояние в клетках - texture(sdf, uv).r * 32767 / SDF_SCALE,
+// где uv = (p - origin) / size.
+//
+// 0, если 3D текстуры недоступны.
+unsigned int LoadSdfTexture(const SignedDistanceField& sdf) {
+    if (!GLSupportsTextures3D())
+        return 0;
+
+    unsigned int id = 0;
+    gl.genTextures(1, &id);
+    gl.bindTexture(GL_TEXTURE_3D, id);
+
+    gl.texParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl.texParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl.texParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl.texParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl.texParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    // Строки по 2 байта на значение могут быть не кратны 4.
+    gl.pixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    gl.texImage3D(
+        GL_TEXTURE_3D,
+        0,
+        GL_R16_SNORM,
+        sdf.size.x,
+        sdf.size.y,
+        sdf.size.z,
+        0,
+        GL_RED,
+        GL_SHORT,
+        sdf.values
+    );
+    gl.pixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    gl.bindTexture(GL_TEXTURE_3D, 0);
+    return id;
+}
+
+TEST_CASE ("SignedDistanceField") {
+    CubeVoxel cubes[] = {
+        {{0, 0, 0}, 0},
+        {{1, 0, 0}, 0},
+        {{4, 2, 3}, 0},
+        {{0, 0, 1}, 0},
+    };
+    auto grid = MakeVoxelGrid(cubes, 4);
+    defer {
+        FreeVoxelGrid(grid);
+    };
+
+    auto sdf = BakeSignedDistanceField(grid, 1);
+    defer {
+        FreeSignedDistanceField(sdf);
+    };
+
+    const auto& size       = sdf.size;
+    const int   cellsCount = size.x * size.y * size.z;
+
+    SUBCASE ("Matches brute force") {
+        auto isSolid = [&](int i) {
+            const int x = i % size.x;
+            const int y = (i / size.x) % size.y;
+            const int z = i / (size.x * size.y);
+            return VoxelGridIsSolid(
+                grid, sdf.origin.x + x, sdf.origin.y + y, sdf.origin.z + z
+            );
+        };
+        // От центра клетки a до куба клетки b.
+        auto distanceSqr = [&](int a, int b) {
+            const int dx = a % size.x - b % size.x;
+            const int dy = (a / size.x) % size.y - (b / size.x) % size.y;
+            const int dz = a / (size.x * size.y) - b / (size.x * size.y);
+
+            float result = 0;
+            for (int d : {dx, dy, dz}) {
+                if (d != 0)
+                    result += (fabsf((float)d) - 0.5f) * (fabsf((float)d) - 0.5f);
+            }
+            return result;
+        };
+
+        bool same = true;
+        FOR_RANGE (int, i, cellsCount) {
+            float nearest = floatInf;
+            FOR_RANGE (int, j, cellsCount) {
+                if (isSolid(i) != isSolid(j))
+                    nearest = Min(nearest, distanceSqr(i, j));
+            }
+
+            const float d        = sqrtf(nearest);
+            const float expected = isSolid(i) ? -d : d;
+            const float actual = (float)sdf.values[i] / SDF_SCALE;
+            same &= fabsf(actual - expected) <= 0.5f / SDF_SCALE;
+        }
+        Assert(same);
+    }
+
+    SUBCASE ("Threads don't change the result") {
+        auto sdf2 = BakeSignedDistanceField(grid, 5);
+        defer {
+            FreeSignedDistanceField(sdf2);
+        };
+        Assert(memcmp(sdf.values, sdf2.values, cellsCount * sizeof(i16)) == 0);
+    }
+
+    SUBCASE ("Sample") {
+        // Грань куба (0, 0, 0) - на x = 0.
+        Assert(fabsf(SdfSample(sdf, {-1.0f, 0.5f, 0.5f}) - 1) < 0.01f);
+        Assert(fabsf(SdfSample(sdf, {0, 0.5f, 0.5f})) < 0.01f);
+        Assert(SdfSample(sdf, {0.5f, 0.5f, 0.5f}) < 0);
+
+        // По диагонали от угла куба - расстояние до угла, а не до центра куба.
+        Assert(fabsf(SdfSample(sdf, {-0.5f, -0.5f, -0.5f}) - sqrtf(0.75f)) < 0.01f);
+
+        // Далеко за пределами сетки.
+        Assert(SdfSample(sdf, {-100, 0.5f, 0.5f}) > 90);
+
+        const auto normal = SdfGradient(sdf, {-1.0f, 0.5f, 0.5f});
+        Assert(normal.x < -0.9f);
+    }
+
+    SUBCASE ("Sphere trace") {
+        auto hit = SdfSphereTrace(sdf, {-5, 0.5f, 0.5f}, {1, 0, 0}, 100);
+        Assert(hit.hit);
+        Assert(fabsf(hit.distance - 5) < 0.02f);
+
+        auto hitSphere = SdfSphereTrace(sdf, {-5, 0.5f, 0.5f}, {1, 0, 0}, 100, 0.5f);
+        Assert(hitSphere.hit);
+        Assert(fabsf(hitSphere.distance - 4.5f) < 0.02f);
+
+        auto miss = SdfSphereTrace(sdf, {-5, 10.5f, 0.5f}, {1, 0, 0}, 100);
+        Assert_False(miss.hit);
+
+        auto tooFar = SdfSphereTrace(sdf, {-5, 0.5f, 0.5f}, {1, 0, 0}, 3);
+        Assert_False(tooFar.hit);
+    }
+}
@@ -0,0 +1,274 @@
+//----------------------------------------------------------------------------------
+// Shader Cache.
+//----------------------------------------------------------------------------------
+// Слинкованные программы сохраняются на диск (glGetProgramBinary),
+// и на следующем запуске GLSL не компилируется вовсе.
+//
+// Ключ - Hash64 от исходников (уже с defines) и строк драйвера
+// (GL_VENDOR, GL_RENDERER, GL_VERSION): после обновления драйвера ключи другие.
+// Драйвер всё равно вправе отвергнуть бинарник (после glProgramBinary
+// GL_LINK_STATUS == 0) - тогда компилируем из исходников и перезаписываем файл.
+//
+// Без GL 4.1 (см. GLSupportsProgramBinaries) - обычная компиляция через raylib.
+//
+// Файл SHADER_CACHE_DIRECTORY/<ключ>.bin:
+// u32  SHADER_CACHE_MAGIC
+// u32  binaryFormat
+// u8   binary[]
+const char* SHADER_CACHE_DIRECTORY = "shader_cache";
+const u32   SHADER_CACHE_MAGIC     = 0x31434853;  // "SHC1".
+
+struct ShaderCacheHeader_ {
+    u32 magic        = SHADER_CACHE_MAGIC;
+    u32 binaryFormat = 0;
+};
+
+globalVar struct ShaderCacheStats_ {
+    int hits     = 0;
+    int misses   = 0;
+    int rejected = 0;  // Бинарник был, но драйвер его не принял.
+} shaderCacheStats;
+
+// defines вставляются сразу после строки #version.
+std::string InjectShaderDefines_(const char* code, const char* defines) {
+    std::string result = code;
+    if ((defines == nullptr) || (defines[0] == '\0'))
+        return result;
+
+    size_t at = 0;
+    if (result.rfind("#version", 0) == 0) {
+        at = result.find('\n');
+        at = (at == std::string::npos) ? result.size() : at + 1;
+    }
+
+    std::string block = defines;
+    if (block.back() != '\n')
+        block += '\n';
+
+    result.insert(at, block);
+    return result;
+}
+
+u64 ShaderCacheKey_(const std::string* sources, int count) {
+    u64 hash = HASH64_SEED;
+
+    if (gl.getString != nullptr) {
+        for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            auto value = (const char*)gl.getString(name);
+            if (value != nullptr)
+                hash = Hash64(value, strlen(value) + 1, hash);
+        }
+    }
+
+    // С нулевым байтом, чтобы ("ab", "c") и ("a", "bc") различались.
+    FOR_RANGE (int, i, count) {
+        hash = Hash64(sources[i].c_str(), sources[i].size() + 1, hash);
+    }
+    return hash;
+}
+
+// Компиляция и линковка с GL_PROGRAM_BINARY_RETRIEVABLE_HINT. 0 - ошибка.
+unsigned int LinkShaderProgram_(const std::string* sources, const int* types, int count) {
+    unsigned int shaders[2] = {};
+    Assert(count <= 2);
+
+    bool compiled = true;
+    FOR_RANGE (int, i, count) {
+        shaders[i] = rlCompileShader(sources[i].c_str(), types[i]);
+        compiled &= (shaders[i] != 0);
+    }
+
+    unsigned int program = 0;
+    if (compiled) {
+        program = gl.createProgram();
+        gl.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+        FOR_RANGE (int, i, count) {
+            gl.attachShader(program, shaders[i]);
+        }
+        gl.linkProgram(program);
+        FOR_RANGE (int, i, count) {
+            gl.detachShader(program, shaders[i]);
+        }
+
+        int linked = 0;
+        gl.getProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            TraceLog(
+                LOG_WARNING, "SHADER: [ID %i] Failed to link shader program", program
+            );
+            rlUnloadShaderProgram(program);
+            program = 0;
+        }
+    }
+
+    FOR_RANGE (int, i, count) {
+        if (shaders[i] != 0)
+            gl.deleteShader(shaders[i]);
+    }
+    return program;
+}
+
+void SaveShaderBinary_(unsigned int program, const char* path) {
+    int length = 0;
+    gl.getProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    ShaderCacheHeader_ header = {};
+    std::vector<u8>    data(sizeof(header) + length);
+
+    int written = 0;
+    gl.getProgramBinary(
+        program, length, &written, &header.binaryFormat, data.data() + sizeof(header)
+    );
+    if (written <= 0)
+        return;
+    memcpy(data.data(), &header, sizeof(header));
+
+    std::error_code error;
+    std::filesystem::create_directories(SHADER_CACHE_DIRECTORY, error);
+    SaveFileData(path, data.data(), (int)sizeof(header) + written);
+}
+
+unsigned int LoadShaderBinary_(const char* path) {
+    if (!FileExists(path))
+        return 0;
+
+    int  size = 0;
+    auto data = (u8*)LoadFileData(path, &size);
+    defer {
+        UnloadFileData((unsigned char*)data);
+    };
+
+    ShaderCacheHeader_ header = {};
+    if ((data == nullptr) || (size <= (int)sizeof(header)))
+        return 0;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SHADER_CACHE_MAGIC)
+        return 0;
+
+    const auto program = gl.createProgram();
+    gl.programBinary(
+        program, header.binaryFormat, data + sizeof(header), size - (int)sizeof(header)
+    );
+
+    int linked = 0;
+    gl.getProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        rlUnloadShaderProgram(program);
+        shaderCacheStats.rejected++;
+        return 0;
+    }
+    return program;
+}
+
+unsigned int LoadCachedProgram_(const std::string* sources, const int* types, int count) {
+    const auto key  = ShaderCacheKey_(sources, count);
+    const auto path = std::string(TextFormat(
+        "%s/%016llx.bin", SHADER_CACHE_DIRECTORY, (unsigned long long)key
+    ));
+
+    auto program = LoadShaderBinary_(path.c_str());
+    if (program != 0) {
+        shaderCacheStats.hits++;
+        return program;
+    }
+
+    shaderCacheStats.misses++;
+    program = LinkShaderProgram_(sources, types, count);
+    if (program != 0)
+        SaveShaderBinary_(program, path.c_str());
+    return program;
+}
+
+// Как LoadShader. defines (например "#define LODS 4\n") вставляются после #version.
+Shader LoadCachedShader(
+    const char* vsPath,
+    const char* fsPath,
+    const char* defines = nullptr
+) {
+    LoadGLFunctions();
+
+    char* vsCode = LoadFileText(vsPath);
+    char* fsCode = LoadFileText(fsPath);
+    defer {
+        UnloadFileText(vsCode);
+        UnloadFileText(fsCode);
+    };
+    if ((vsCode == nullptr) || (fsCode == nullptr))
+        return {rlGetShaderIdDefault(), rlGetShaderLocsDefault()};
+
+    const std::string sources[] = {
+        InjectShaderDefines_(vsCode, defines),
+        InjectShaderDefines_(fsCode, defines),
+    };
+
+    if (!GLSupportsProgramBinaries())
+        return LoadShaderFromMemory(sources[0].c_str(), sources[1].c_str());
+
+    const int  types[] = {RL_VERTEX_SHADER, RL_FRAGMENT_SHADER};
+    const auto program = LoadCachedProgram_(sources, types, 2);
+    if (program == 0)
+        return {rlGetShaderIdDefault(), rlGetShaderLocsDefault()};
+
+    // Локации, которые выставляет LoadShader. Наши шейдеры задают их явно,
+    // но raylib-овские функции отрисовки смотрят сюда.
+    Shader shader = {};
+    shader.id     = program;
+    shader.locs   = (int*)RL_MALLOC(RL_MAX_SHADER_LOCATIONS * sizeof(int));
+
+    auto locs = shader.locs;
+    FOR_RANGE (int, i, RL_MAX_SHADER_LOCATIONS) {
+        locs[i] = -1;
+    }
+    locs[SHADER_LOC_VERTEX_POSITION]   = rlGetLocationAttrib(program, "vertexPosition");
+    locs[SHADER_LOC_VERTEX_TEXCOORD01] = rlGetLocationAttrib(program, "vertexTexCoord");
+    locs[SHADER_LOC_VERTEX_COLOR]      = rlGetLocationAttrib(program, "vertexColor");
+    locs[SHADER_LOC_MATRIX_MVP]        = rlGetLocationUniform(program, "mvp");
+    locs[SHADER_LOC_COLOR_DIFFUSE]     = rlGetLocationUniform(program, "colDiffuse");
+    locs[SHADER_LOC_MAP_DIFFUSE]       = rlGetLocationUniform(program, "texture0");
+    return shader;
+}
+
+// Как rlCompileShader + rlLoadComputeShaderProgram.
+unsigned int LoadCachedComputeShader(const char* path, const char* defines = nullptr) {
+    LoadGLFunctions();
+
+    char* code = LoadFileText(path);
+    defer {
+        UnloadFileText(code);
+    };
+    if (code == nullptr)
+        return 0;
+
+    const std::string source = InjectShaderDefines_(code, defines);
+
+    if (!GLSupportsProgramBinaries()) {
+        const auto shader = rlCompileShader(source.c_str(), RL_COMPUTE_SHADER);
+        return rlLoadComputeShaderProgram(shader);
+    }
+
+    const int type = RL_COMPUTE_SHADER;
+    return LoadCachedProgram_(&source, &type, 1);
+}
+
+TEST_CASE ("ShaderCache") {
+    SUBCASE ("Defines go after #version") {
+        Assert(
+            InjectShaderDefines_("#version 430\nvoid main() {}", "#define A 1")
+            == "#version 430\n#define A 1\nvoid main() {}"
+        );
+        Assert(InjectShaderDefines_("void main() {}", "#define A 1\n")
+               == "#define A 1\nvoid main() {}");
+        Assert(InjectShaderDefines_("#version 430", nullptr) == "#version 430");
+    }
+
+    SUBCASE ("Key depends on every source") {
+        const std::string a[] = {"ab", "c"};
+        const std::string b[] = {"a", "bc"};
+        const std::string c[] = {"ab", "c"};
+        Assert(ShaderCacheKey_(a, 2) != ShaderCacheKey_(b, 2));
+        Assert(ShaderCacheKey_(a, 2) == ShaderCacheKey_(c, 2));
+        Assert(ShaderCacheKey_(a, 2) != ShaderCacheKey_(a, 1));
+    }
+}
@@ -0,0 +1,171 @@
+//----------------------------------------------------------------------------------
+// Stream Buffer.
+//----------------------------------------------------------------------------------
+// SSBO для данных, которые каждый кадр заливаются с CPU на GPU.
+//
+// rlUpdateShaderBuffer - это glBufferSubData в буфер, который, возможно, ещё читает
+// отрисовка предыдущего кадра. Драйвер в таком случае либо копирует данные,
+// либо ждёт GPU.
+//
+// Тут буфер создаётся через glBufferStorage и один раз маппится (persistent + coherent).
+// Внутри он поделён на STREAM_BUFFER_REGIONS регионов: кадр пишет в свой регион,
+// пока GPU читает регионы предыдущих кадров. После отрисовки, читающей регион,
+// ставится fence. Перед повторной записью в регион ждём его fence -
+// к этому моменту он почти всегда уже сигнализирован.
+//
+// Если persistent mapping недоступен - пишем в CPU буфер
+// и заливаем его через rlUpdateShaderBuffer, как раньше.
+//
+// Использование:
+//
+//     auto data = (Vector4*)StreamBufferBegin(buffer);
+//     ... пишем data[i] ...
+//     StreamBufferEnd(buffer, bytesWritten);
+//     ...
+//     StreamBufferBind(buffer, 0);
+//     ... отрисовка ...
+//     StreamBufferFence(buffer);
+//
+const int STREAM_BUFFER_REGIONS = 3;
+
+struct StreamBuffer {
+    unsigned int id         = 0;
+    int          size       = 0;  // Размер одного региона, который запросили.
+    int          regionSize = 0;  // Размер региона с учётом выравнивания.
+    int          current    = 0;
+
+    // nullptr, если persistent mapping недоступен.
+    u8*     mapped                         = nullptr;
+    GLsync_ fences[STREAM_BUFFER_REGIONS] = {};
+
+    // Fallback.
+    u8* staging = nullptr;
+
+    // Сколько раз пришлось реально ждать GPU перед записью.
+    int stalls = 0;
+};
+
+StreamBuffer MakeStreamBuffer(int size) {
+    Assert(size > 0);
+
+    StreamBuffer buffer = {};
+    buffer.size         = size;
+
+    if (!GLSupportsPersistentMapping()) {
+        buffer.regionSize = size;
+        buffer.staging    = (u8*)RL_CALLOC(size, 1);
+        buffer.id         = rlLoadShaderBuffer(size, nullptr, RL_DYNAMIC_COPY);
+        Assert(buffer.id != 0);
+        return buffer;
+    }
+
+    int alignment = 0;
+    gl.getIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment         = Max(alignment, 16);
+    buffer.regionSize = CeilDivision(size, alignment) * alignment;
+
+    const ptrdiff_t totalSize = (ptrdiff_t)buffer.regionSize * STREAM_BUFFER_REGIONS;
+    const unsigned int flags
+        = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    gl.genBuffers(1, &buffer.id);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id);
+    gl.bufferStorage(GL_SHADER_STORAGE_BUFFER, totalSize, nullptr, flags);
+    buffer.mapped
+        = (u8*)gl.mapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, totalSize, flags);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    Assert(buffer.id != 0);
+    Assert(buffer.mapped != nullptr);
+    return buffer;
+}
+
+void FreeStreamBuffer(StreamBuffer& buffer) {
+    if (buffer.mapped != nullptr) {
+        FOR_RANGE (int, i, STREAM_BUFFER_REGIONS) {
+            if (buffer.fences[i] != nullptr)
+                gl.deleteSync(buffer.fences[i]);
+        }
+
+        gl.bindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id);
+        gl.unmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        gl.bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        gl.deleteBuffers(1, &buffer.id);
+    }
+    else {
+        rlUnloadShaderBuffer(buffer.id);
+        RL_FREE(buffer.staging);
+    }
+
+    buffer = {};
+}
+
+// Байты на GPU, для MemorySubsystem.
+int StreamBufferMemorySize(const StreamBuffer& buffer) {
+    if (buffer.mapped != nullptr)
+        return buffer.regionSize * STREAM_BUFFER_REGIONS;
+    return buffer.size;
+}
+
+// Возвращает память, в которую нужно записать данные текущего кадра.
+// В неё можно только писать: память write-combined, чтение из неё очень медленное.
+u8* StreamBufferBegin(StreamBuffer& buffer) {
+    if (buffer.mapped == nullptr)
+        return buffer.staging;
+
+    auto& fence = buffer.fences[buffer.current];
+    if (fence != nullptr) {
+        auto status = gl.clientWaitSync(fence, 0, 0);
+        if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED)) {
+            buffer.stalls++;
+
+            const uint64_t timeout = 1000000;  // 1 ms.
+            while ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED)
+                   && (status != GL_WAIT_FAILED))
+            {
+                status = gl.clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            }
+        }
+
+        gl.deleteSync(fence);
+        fence = nullptr;
+    }
+
+    return buffer.mapped + (ptrdiff_t)buffer.current * buffer.regionSize;
+}
+
+void StreamBufferEnd(StreamBuffer& buffer, int bytesWritten) {
+    Assert(bytesWritten >= 0);
+    Assert(bytesWritten <= buffer.size);
+
+    // NOTE: Память coherent, так что при persistent mapping делать ничего не нужно.
+    if ((buffer.mapped == nullptr) && (bytesWritten > 0))
+        rlUpdateShaderBuffer(buffer.id, buffer.staging, bytesWritten, 0);
+
+    TelemetryAdd(TelemetryMetric::UPLOADED_BYTES, (float)bytesWritten);
+}
+
+void StreamBufferBind(const StreamBuffer& buffer, unsigned int binding) {
+    if (buffer.mapped == nullptr) {
+        rlBindShaderBuffer(buffer.id, binding);
+        return;
+    }
+
+    gl.bindBufferRange(
+        GL_SHADER_STORAGE_BUFFER,
+        binding,
+        buffer.id,
+        (ptrdiff_t)buffer.current * buffer.regionSize,
+        buffer.size
+    );
+}
+
+// Вызывается после всех отрисовок, которые читают текущий регион.
+// Следующий StreamBufferBegin будет писать уже в следующий регион.
+void StreamBufferFence(StreamBuffer& buffer) {
+    if (buffer.mapped == nullptr)
+        return;
+
+    buffer.fences[buffer.current] = gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffer.current = (buffer.current + 1) % STREAM_BUFFER_REGIONS;
+}
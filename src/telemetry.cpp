@@ -0,0 +1,239 @@
+//----------------------------------------------------------------------------------
+// Frame Telemetry.
+//----------------------------------------------------------------------------------
+// Метрики каждого кадра в кольце на TELEMETRY_FRAMES кадров.
+// Средние прячут редкие долгие кадры, поэтому отчёт - перцентили и максимум.
+//
+// В течение кадра метрики копятся в telemetry.current (TelemetryAdd / TelemetrySet),
+// TelemetryEndFrame кладёт кадр в кольцо. Всё - только с главного потока.
+//
+// Использование:
+//
+//     TelemetryAdd(TelemetryMetric::DRAW_CALLS, 1);
+//     ...
+//     TelemetryEndFrame(telemetry, GetTime());
+//
+//     const auto p = ComputeTelemetryPercentiles(telemetry, TelemetryMetric::FRAME_MS);
+//
+enum class TelemetryMetric {
+    FRAME_MS = 0,    // От конца прошлого кадра до конца этого.
+    SIM_MS,          // Тик симуляции. В потоке симуляции (F4) - прошлый тик.
+    RENDER_MS,       // CPU на отрисовку геймплея.
+    GPU_WORLD_MS,    // GPU на мир, с задержкой GPU_TIMER_LATENCY кадров.
+    DRAW_CALLS,      // Только наши. Батч rlgl (сетка, линии, текст) не считается.
+    PARTICLES,       // Живые частицы, оценка сверху.
+    UPLOADED_BYTES,  // Залитое в SSBO с CPU.
+    VOXEL_FACES,     // Нарисованные грани чанков (только WorldRenderPath::RASTERIZED).
+    ALLOCATIONS,     // Выделения в куче за кадр, все потоки. См. allocation_tracker.cpp.
+    ALLOCATED_BYTES,
+    COUNT,
+};
+
+// Они же - заголовки CSV.
+const char* telemetryMetricNames[] = {
+    "frame_ms",
+    "sim_ms",
+    "render_ms",
+    "gpu_world_ms",
+    "draw_calls",
+    "particles",
+    "uploaded_bytes",
+    "voxel_faces",
+    "allocations",
+    "allocated_bytes",
+};
+static_assert(sizeof(telemetryMetricNames) / sizeof(telemetryMetricNames[0])
+              == (int)TelemetryMetric::COUNT);
+
+// 68 секунд на 60 FPS.
+const int TELEMETRY_FRAMES = 4096;
+
+struct FrameTelemetry {
+    float values[(int)TelemetryMetric::COUNT] = {};
+};
+
+struct Telemetry {
+    FrameTelemetry frames[TELEMETRY_FRAMES] = {};
+
+    int count = 0;  // Заполненные кадры, не больше TELEMETRY_FRAMES.
+    int next  = 0;  // Куда ляжет следующий кадр.
+    i64 total = 0;  // Всего кадров с последнего ResetTelemetry.
+
+    FrameTelemetry current      = {};
+    double         lastFrameEnd = -1;
+};
+
+struct TelemetryPercentiles {
+    float p50 = 0;
+    float p95 = 0;
+    float p99 = 0;
+    float max = 0;
+};
+
+globalVar Telemetry telemetry;
+
+// Для ComputeTelemetryPercentiles, чтобы оверлей (F9) не выделял память каждый кадр.
+globalVar float telemetrySortScratch_[TELEMETRY_FRAMES];
+
+void TelemetryAdd(TelemetryMetric metric, float value) {
+    telemetry.current.values[(int)metric] += value;
+}
+
+void TelemetrySet(TelemetryMetric metric, float value) {
+    telemetry.current.values[(int)metric] = value;
+}
+
+// time - секунды (GetTime). Первый кадр после ResetTelemetry не знает
+// своего начала, его FRAME_MS - что выставили через TelemetrySet.
+void TelemetryEndFrame(Telemetry& t, double time) {
+    if (t.lastFrameEnd >= 0) {
+        t.current.values[(int)TelemetryMetric::FRAME_MS]
+            = (float)((time - t.lastFrameEnd) * 1000.0);
+    }
+    t.lastFrameEnd = time;
+
+    t.frames[t.next] = t.current;
+    t.next           = (t.next + 1) % TELEMETRY_FRAMES;
+    t.count          = Min(t.count + 1, TELEMETRY_FRAMES);
+    t.total++;
+    t.current = {};
+}
+
+void ResetTelemetry(Telemetry& t) {
+    t.count        = 0;
+    t.next         = 0;
+    t.total        = 0;
+    t.current      = {};
+    t.lastFrameEnd = -1;
+}
+
+// i-й кадр от самого старого из тех, что в кольце.
+const FrameTelemetry& TelemetryFrame(const Telemetry& t, int i) {
+    Assert(i >= 0);
+    Assert(i < t.count);
+    return t.frames[(t.next - t.count + i + TELEMETRY_FRAMES) % TELEMETRY_FRAMES];
+}
+
+// Nearest rank: p-й перцентиль - наименьшее значение, не меньше которого p% кадров.
+// Только с главного потока.
+TelemetryPercentiles ComputeTelemetryPercentiles(
+    const Telemetry& t,
+    TelemetryMetric  metric
+) {
+    if (t.count == 0)
+        return {};
+
+    auto values = telemetrySortScratch_;
+    FOR_RANGE (int, i, t.count) {
+        values[i] = t.frames[i].values[(int)metric];
+    }
+    std::sort(values, values + t.count);
+
+    auto rank = [&](int percent) {
+        const int index = CeilDivision(t.count * percent, 100) - 1;
+        return values[Max(0, index)];
+    };
+
+    TelemetryPercentiles result = {};
+    result.p50                  = rank(50);
+    result.p95                  = rank(95);
+    result.p99                  = rank(99);
+    result.max                  = values[t.count - 1];
+    return result;
+}
+
+// Строка на кадр, от старого к новому.
+std::string TelemetryCsv(const Telemetry& t) {
+    std::string result = "frame";
+    for (auto name : telemetryMetricNames) {
+        result += ',';
+        result += name;
+    }
+    result += '\n';
+
+    const i64 first = t.total - t.count;
+    FOR_RANGE (int, i, t.count) {
+        result += TextFormat("%lld", (long long)(first + i));
+        for (float value : TelemetryFrame(t, i).values)
+            result += TextFormat(",%.6g", value);
+        result += '\n';
+    }
+    return result;
+}
+
+bool SaveTelemetryCsv(const Telemetry& t, const char* path) {
+    const auto text = TelemetryCsv(t);
+    if (!SaveFileData(path, (void*)text.data(), (int)text.size()))
+        return false;
+
+    TraceLog(LOG_INFO, "TELEMETRY: [%s] %d frames saved", path, t.count);
+    return true;
+}
+
+// Перцентили всех метрик, строка на метрику. Для консоли.
+std::string TelemetryReport(const Telemetry& t) {
+    std::string result = TextFormat(
+        "%-16s %10s %10s %10s %10s\n", "metric", "p50", "p95", "p99", "max"
+    );
+    FOR_RANGE (int, i, (int)TelemetryMetric::COUNT) {
+        const auto p = ComputeTelemetryPercentiles(t, (TelemetryMetric)i);
+        result += TextFormat(
+            "%-16s %10.3f %10.3f %10.3f %10.3f\n",
+            telemetryMetricNames[i],
+            p.p50,
+            p.p95,
+            p.p99,
+            p.max
+        );
+    }
+    return result;
+}
+
+TEST_CASE ("Telemetry") {
+    static Telemetry t = {};
+    ResetTelemetry(t);
+    Assert(ComputeTelemetryPercentiles(t, TelemetryMetric::FRAME_MS).max == 0);
+
+    // 1..100 ms, кадры идут по 1 секунде - FRAME_MS перезаписывается.
+    FOR_RANGE (int, i, 100) {
+        t.current.values[(int)TelemetryMetric::SIM_MS]     = (float)(100 - i);
+        t.current.values[(int)TelemetryMetric::DRAW_CALLS] = 7;
+        TelemetryEndFrame(t, (double)i);
+    }
+    Assert(t.count == 100);
+    Assert(TelemetryFrame(t, 0).values[(int)TelemetryMetric::FRAME_MS] == 0);
+    Assert(TelemetryFrame(t, 1).values[(int)TelemetryMetric::FRAME_MS] == 1000);
+
+    auto p = ComputeTelemetryPercentiles(t, TelemetryMetric::SIM_MS);
+    Assert(p.p50 == 50);
+    Assert(p.p95 == 95);
+    Assert(p.p99 == 99);
+    Assert(p.max == 100);
+
+    p = ComputeTelemetryPercentiles(t, TelemetryMetric::DRAW_CALLS);
+    Assert(p.p50 == 7);
+    Assert(p.max == 7);
+
+    // Кольцо: остаются только последние TELEMETRY_FRAMES кадров.
+    FOR_RANGE (int, i, TELEMETRY_FRAMES) {
+        t.current.values[(int)TelemetryMetric::PARTICLES] = (float)i;
+        TelemetryEndFrame(t, 100.0 + i);
+    }
+    Assert(t.count == TELEMETRY_FRAMES);
+    Assert(t.total == 100 + TELEMETRY_FRAMES);
+    Assert(TelemetryFrame(t, 0).values[(int)TelemetryMetric::PARTICLES] == 0);
+    Assert(TelemetryFrame(t, 0).values[(int)TelemetryMetric::SIM_MS] == 0);
+    p = ComputeTelemetryPercentiles(t, TelemetryMetric::PARTICLES);
+    Assert(p.max == TELEMETRY_FRAMES - 1);
+
+    ResetTelemetry(t);
+    t.current.values[(int)TelemetryMetric::FRAME_MS]       = 16.5f;
+    t.current.values[(int)TelemetryMetric::UPLOADED_BYTES] = 4096;
+    TelemetryEndFrame(t, 0);
+    Assert(
+        TelemetryCsv(t)
+        == "frame,frame_ms,sim_ms,render_ms,gpu_world_ms,draw_calls,particles,"
+           "uploaded_bytes,voxel_faces,allocations,allocated_bytes\n"
+           "0,16.5,0,0,0,0,0,4096,0,0,0\n"
+    );
+}
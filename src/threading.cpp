@@ -0,0 +1,355 @@
+//----------------------------------------------------------------------------------
+// Triple Buffer.
+//----------------------------------------------------------------------------------
+// Передача данных от одного потока-писателя одному потоку-читателю без блокировок.
+//
+// Буферов три: писатель пишет в back, читатель читает front,
+// а middle - последний опубликованный, ещё не забранный читателем.
+// Публикация и забирание - это один atomic exchange индекса middle.
+// Писатель и читатель никогда не работают с одним и тем же буфером.
+//
+// Если писатель опубликует два раза подряд, а читатель между ними не заберёт,
+// первый из опубликованных буферов будет перезаписан.
+//
+// Использование:
+//
+//     // Писатель.
+//     auto& data = TripleBufferWriteBuffer(buffer);
+//     ... пишем data ...
+//     TripleBufferPublish(buffer);
+//
+//     // Читатель.
+//     if (TripleBufferAcquire(buffer))
+//         ... TripleBufferReadBuffer(buffer) содержит новые данные ...
+//
+const int TRIPLE_BUFFER_INDEX_MASK = 0b011;
+const int TRIPLE_BUFFER_FRESH_BIT  = 0b100;
+
+template <typename T>
+struct TripleBuffer {
+    T buffers[3] = {};
+
+    // Индекс middle буфера + TRIPLE_BUFFER_FRESH_BIT,
+    // если писатель опубликовал его после последнего TripleBufferAcquire.
+    std::atomic<int> middle = 1;
+
+    int back  = 0;  // Принадлежит писателю.
+    int front = 2;  // Принадлежит читателю.
+};
+
+template <typename T>
+T& TripleBufferWriteBuffer(TripleBuffer<T>& buffer) {
+    return buffer.buffers[buffer.back];
+}
+
+template <typename T>
+void TripleBufferPublish(TripleBuffer<T>& buffer) {
+    const int previous = buffer.middle.exchange(
+        buffer.back | TRIPLE_BUFFER_FRESH_BIT, std::memory_order_acq_rel
+    );
+    buffer.back = previous & TRIPLE_BUFFER_INDEX_MASK;
+}
+
+// Возвращает true, если с прошлого вызова были опубликованы новые данные.
+template <typename T>
+bool TripleBufferAcquire(TripleBuffer<T>& buffer) {
+    if ((buffer.middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH_BIT) == 0)
+        return false;
+
+    const int previous = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel);
+    buffer.front       = previous & TRIPLE_BUFFER_INDEX_MASK;
+    return true;
+}
+
+template <typename T>
+T& TripleBufferReadBuffer(TripleBuffer<T>& buffer) {
+    return buffer.buffers[buffer.front];
+}
+
+TEST_CASE ("TripleBuffer") {
+    SUBCASE ("Single thread") {
+        TripleBuffer<int> buffer = {};
+
+        Assert_False(TripleBufferAcquire(buffer));
+
+        TripleBufferWriteBuffer(buffer) = 1;
+        TripleBufferPublish(buffer);
+        TripleBufferWriteBuffer(buffer) = 2;
+        TripleBufferPublish(buffer);
+
+        // Забирается только последняя публикация.
+        Assert(TripleBufferAcquire(buffer));
+        Assert(TripleBufferReadBuffer(buffer) == 2);
+        Assert_False(TripleBufferAcquire(buffer));
+        Assert(TripleBufferReadBuffer(buffer) == 2);
+    }
+
+    SUBCASE ("Two threads") {
+        struct Data {
+            int a = 0;
+            int b = 0;
+        };
+        static TripleBuffer<Data> buffer = {};
+
+        const int count = 100000;
+
+        std::thread writer([]() {
+            FOR_RANGE (int, i, count) {
+                auto& data = TripleBufferWriteBuffer(buffer);
+                data.a     = i + 1;
+                data.b     = -(i + 1);
+                TripleBufferPublish(buffer);
+            }
+        });
+
+        // Читатель не должен увидеть ни порванных данных, ни шага назад.
+        int  last       = 0;
+        bool consistent = true;
+        while (last < count) {
+            if (!TripleBufferAcquire(buffer))
+                continue;
+
+            const auto& data = TripleBufferReadBuffer(buffer);
+            consistent &= (data.a == -data.b) && (data.a > last);
+            last = data.a;
+        }
+
+        writer.join();
+        Assert(consistent);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Worker Thread.
+//----------------------------------------------------------------------------------
+// Поток, который по WorkerThreadKick один раз выполняет job
+// и сообщает о завершении через WorkerThreadWait.
+//
+// Всё, что записано до WorkerThreadKick, видно внутри job,
+// а всё, что записано в job, видно после WorkerThreadWait.
+struct WorkerThread {
+    std::thread           thread = {};
+    std::binary_semaphore kick{0};
+    std::binary_semaphore done{0};
+    std::atomic<bool>     quit = false;
+
+    // Был WorkerThreadKick без WorkerThreadWait.
+    bool inFlight = false;
+
+    void (*job)(void* userData) = nullptr;
+    void* userData              = nullptr;
+};
+
+void WorkerThreadLoop_(WorkerThread* worker) {
+    while (true) {
+        worker->kick.acquire();
+        if (worker->quit.load(std::memory_order_acquire))
+            return;
+
+        worker->job(worker->userData);
+        worker->done.release();
+    }
+}
+
+void StartWorkerThread(WorkerThread& worker, void (*job)(void*), void* userData) {
+    Assert(!worker.thread.joinable());
+    Assert(job != nullptr);
+
+    worker.job      = job;
+    worker.userData = userData;
+    worker.quit     = false;
+    worker.inFlight = false;
+    worker.thread   = std::thread(WorkerThreadLoop_, &worker);
+}
+
+void WorkerThreadKick(WorkerThread& worker) {
+    Assert(worker.thread.joinable());
+    Assert(!worker.inFlight);
+
+    worker.inFlight = true;
+    worker.kick.release();
+}
+
+// Ничего не делает, если job не запускался.
+void WorkerThreadWait(WorkerThread& worker) {
+    if (!worker.inFlight)
+        return;
+
+    worker.done.acquire();
+    worker.inFlight = false;
+}
+
+// Как WorkerThreadWait, но не ждёт. true - job завершён или не запускался.
+bool WorkerThreadPoll(WorkerThread& worker) {
+    if (!worker.inFlight)
+        return true;
+    if (!worker.done.try_acquire())
+        return false;
+
+    worker.inFlight = false;
+    return true;
+}
+
+void StopWorkerThread(WorkerThread& worker) {
+    if (!worker.thread.joinable())
+        return;
+
+    WorkerThreadWait(worker);
+    worker.quit.store(true, std::memory_order_release);
+    worker.kick.release();
+    worker.thread.join();
+}
+
+TEST_CASE ("WorkerThread") {
+    static WorkerThread worker = {};
+
+    int counter = 0;
+    StartWorkerThread(worker, [](void* userData) { (*(int*)userData)++; }, &counter);
+
+    FOR_RANGE (int, i, 100) {
+        WorkerThreadKick(worker);
+        WorkerThreadWait(worker);
+        Assert(counter == i + 1);
+    }
+
+    WorkerThreadKick(worker);
+    while (!WorkerThreadPoll(worker)) {
+    }
+    Assert(counter == 101);
+    Assert(WorkerThreadPoll(worker));
+
+    StopWorkerThread(worker);
+    Assert_False(worker.thread.joinable());
+}
+
+//----------------------------------------------------------------------------------
+// Parallel For.
+//----------------------------------------------------------------------------------
+// Делит [0, count) на threadsCount кусков и вызывает fn(begin, end) для каждого.
+// Один из кусков выполняется на вызывающем потоке, остальные - на потоках
+// workerPool. Возвращается, когда все куски выполнены.
+//
+// Потоки пула заводятся при первом ParallelFor, которому их не хватило,
+// и живут до конца программы, поэтому ParallelFor годится и для мелких пачек.
+//
+// Пул за раз занят одним ParallelFor. ParallelFor из другого потока или
+// изнутри fn в это время выполняется целиком на вызывающем потоке.
+//
+// threadsCount <= 0 - по количеству ядер.
+const int WORKER_POOL_THREADS_MAX = 64;
+
+struct ParallelForTask_ {
+    void (*call)(void* fn, int begin, int end) = nullptr;
+
+    void* fn    = nullptr;
+    int   begin = 0;
+    int   end   = 0;
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+struct WorkerPool {
+    WorkerThread     workers[WORKER_POOL_THREADS_MAX - 1] = {};
+    ParallelForTask_ tasks[WORKER_POOL_THREADS_MAX - 1]   = {};
+    int              workersCount                         = 0;
+
+    std::atomic<bool> busy = false;
+
+    ~WorkerPool() {
+        FOR_RANGE (int, i, workersCount) {
+            StopWorkerThread(workers[i]);
+        }
+    }
+};
+
+globalVar WorkerPool workerPool;
+
+void ParallelForJob_(void* userData) {
+    const auto& task = *(ParallelForTask_*)userData;
+    task.call(task.fn, task.begin, task.end);
+}
+
+int ParallelForThreadsCount(int threadsCount) {
+    if (threadsCount <= 0)
+        threadsCount = Max(1, (int)std::thread::hardware_concurrency());
+    return Min(threadsCount, WORKER_POOL_THREADS_MAX);
+}
+
+template <typename F>
+void ParallelFor(int count, int threadsCount, F&& fn) {
+    threadsCount = Min(ParallelForThreadsCount(threadsCount), count);
+
+    auto& pool = workerPool;
+    if ((threadsCount <= 1) || pool.busy.exchange(true, std::memory_order_acquire)) {
+        if (count > 0)
+            fn(0, count);
+        return;
+    }
+
+    while (pool.workersCount < threadsCount - 1) {
+        const int i = pool.workersCount++;
+        StartWorkerThread(pool.workers[i], ParallelForJob_, pool.tasks + i);
+    }
+
+    auto chunkBegin = [count, threadsCount](int chunk) {
+        return (int)((i64)count * chunk / threadsCount);
+    };
+
+    using Fn = std::remove_reference_t<F>;
+    FOR_RANGE (int, chunk, threadsCount - 1) {
+        auto& task = pool.tasks[chunk];
+        task.call  = [](void* fn, int begin, int end) { (*(Fn*)fn)(begin, end); };
+        task.fn    = (void*)&fn;
+        task.begin = chunkBegin(chunk);
+        task.end   = chunkBegin(chunk + 1);
+        WorkerThreadKick(pool.workers[chunk]);
+    }
+
+    fn(chunkBegin(threadsCount - 1), count);
+
+    FOR_RANGE (int, chunk, threadsCount - 1) {
+        WorkerThreadWait(pool.workers[chunk]);
+    }
+    pool.busy.store(false, std::memory_order_release);
+}
+
+TEST_CASE ("ParallelFor") {
+    const int count = 1000;
+
+    std::atomic<int> calls          = 0;
+    int              visited[count] = {};
+
+    ParallelFor(count, 7, [&](int begin, int end) {
+        calls++;
+        for (int i = begin; i < end; i++)
+            visited[i]++;
+    });
+
+    bool allOnce = true;
+    for (int v : visited)
+        allOnce &= v == 1;
+
+    Assert(allOnce);
+    Assert(calls == 7);
+
+    // Потоки пула переиспользуются.
+    const int workersCount = workerPool.workersCount;
+    FOR_RANGE (int, i, 100) {
+        ParallelFor(count, 7, [&](int begin, int end) {
+            for (int k = begin; k < end; k++)
+                visited[k]++;
+        });
+    }
+    Assert(workerPool.workersCount == workersCount);
+
+    // Вложенный ParallelFor выполняется на том же потоке.
+    std::atomic<int> nestedCalls = 0;
+    ParallelFor(4, 4, [&](int /* begin */, int /* end */) {
+        ParallelFor(count, 7, [&](int /* begin */, int /* end */) { nestedCalls++; });
+    });
+    Assert(nestedCalls == 4);
+
+    allOnce = true;
+    for (int v : visited)
+        allOnce &= v == 101;
+    Assert(allOnce);
+}
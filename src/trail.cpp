@@ -0,0 +1,152 @@
+//----------------------------------------------------------------------------------
+// Trails.
+//----------------------------------------------------------------------------------
+// След за движущимся объектом - кольцевой буфер последних позиций.
+//
+// Рисуется лентой, повёрнутой к камере: вертексы строятся в trail_vertex.glsl
+// по gl_VertexID из буфера точек (6 вертексов на отрезок между соседними точками).
+//
+// Новая точка добавляется, только когда объект отошёл от предыдущей
+// на segmentLength. До этого последняя точка просто следует за объектом,
+// поэтому лента всегда доходит до него.
+//
+// TrailBreak начинает новую полосу: точки разных полос не соединяются.
+const int TRAIL_CAPACITY = 128;
+
+// Раскладка совпадает с std430 структурой в trail_vertex.glsl.
+struct TrailPoint {
+    Vector3 position = {};
+    float   time     = 0;  // Когда точка была записана.
+    int     strip    = 0;
+
+    float padding_[3] = {};
+};
+static_assert(sizeof(TrailPoint) == 32);
+
+struct Trail {
+    TrailPoint points[TRAIL_CAPACITY] = {};
+
+    int head  = 0;  // Куда будет записана следующая точка.
+    int count = 0;
+
+    int  strip  = 0;
+    bool broken = true;
+
+    float segmentLength = 0.25f;
+    float lifetime      = 0.5f;  // Сколько секунд живёт точка.
+};
+
+// i-я точка с конца. 0 - самая новая.
+TrailPoint& TrailPointFromNewest_(Trail& trail, int i) {
+    Assert(i < trail.count);
+    return trail.points[(trail.head - 1 - i + TRAIL_CAPACITY) % TRAIL_CAPACITY];
+}
+
+void TrailBreak(Trail& trail) {
+    trail.broken = true;
+}
+
+void TrailClear(Trail& trail) {
+    trail.head   = 0;
+    trail.count  = 0;
+    trail.broken = true;
+}
+
+void TrailPush(Trail& trail, Vector3 position, float time) {
+    if (trail.broken) {
+        trail.broken = false;
+        trail.strip++;
+    }
+    else if (trail.count >= 2) {
+        auto&       newest   = TrailPointFromNewest_(trail, 0);
+        const auto& previous = TrailPointFromNewest_(trail, 1);
+
+        const bool sameStrip = (newest.strip == trail.strip)  //
+                               && (previous.strip == trail.strip);
+        const float distance = Vector3Distance(previous.position, position);
+
+        if (sameStrip && (distance < trail.segmentLength)) {
+            newest.position = position;
+            newest.time     = time;
+            return;
+        }
+    }
+
+    // Если буфер заполнен, перезаписывается самая старая точка.
+    auto& point    = trail.points[trail.head];
+    point.position = position;
+    point.time     = time;
+    point.strip    = trail.strip;
+
+    trail.head  = (trail.head + 1) % TRAIL_CAPACITY;
+    trail.count = Min(trail.count + 1, TRAIL_CAPACITY);
+}
+
+// Выкидывает точки старше lifetime.
+void TrailExpire(Trail& trail, float time) {
+    while (trail.count > 0) {
+        const auto& oldest = TrailPointFromNewest_(trail, trail.count - 1);
+        if (time - oldest.time <= trail.lifetime)
+            break;
+
+        trail.count--;
+    }
+}
+
+// Копирует точки в out от самой старой к самой новой. Возвращает их количество.
+int TrailGetPoints(Trail& trail, TrailPoint* out) {
+    FOR_RANGE (int, i, trail.count) {
+        out[i] = TrailPointFromNewest_(trail, trail.count - 1 - i);
+    }
+    return trail.count;
+}
+
+TEST_CASE ("Trail") {
+    Trail trail         = {};
+    trail.segmentLength = 1;
+    trail.lifetime      = 10;
+
+    TrailPoint points[TRAIL_CAPACITY];
+
+    SUBCASE ("Newest point follows until segmentLength") {
+        TrailPush(trail, {0, 0, 0}, 0);
+        TrailPush(trail, {0.5f, 0, 0}, 1);
+        Assert(trail.count == 2);
+
+        TrailPush(trail, {0.8f, 0, 0}, 2);
+        Assert(trail.count == 2);
+        Assert(TrailGetPoints(trail, points) == 2);
+        Assert(points[1].position.x == 0.8f);
+        Assert(points[1].time == 2);
+
+        TrailPush(trail, {1.5f, 0, 0}, 3);
+        Assert(trail.count == 3);
+    }
+
+    SUBCASE ("Break starts a new strip") {
+        TrailPush(trail, {0, 0, 0}, 0);
+        TrailPush(trail, {2, 0, 0}, 1);
+        TrailBreak(trail);
+        TrailPush(trail, {2.1f, 0, 0}, 2);
+
+        Assert(TrailGetPoints(trail, points) == 3);
+        Assert(points[0].strip == points[1].strip);
+        Assert(points[1].strip != points[2].strip);
+    }
+
+    SUBCASE ("Expire and overflow") {
+        FOR_RANGE (int, i, TRAIL_CAPACITY + 10) {
+            TrailPush(trail, {(float)i * 2, 0, 0}, (float)i);
+        }
+        Assert(trail.count == TRAIL_CAPACITY);
+
+        Assert(TrailGetPoints(trail, points) == TRAIL_CAPACITY);
+        Assert(points[0].time == 10);
+        Assert(points[TRAIL_CAPACITY - 1].time == TRAIL_CAPACITY + 9);
+
+        TrailExpire(trail, TRAIL_CAPACITY + 9 + 5.5f);
+        Assert(trail.count == 5);
+        Assert(TrailGetPoints(trail, points) == 5);
+        Assert(points[0].time == TRAIL_CAPACITY + 5);
+    }
+}
@@ -0,0 +1,241 @@
+struct CubeVoxel {
+    Vector3Int pos;
+    int        colorIndex;
+};
+
+//----------------------------------------------------------------------------------
+// Voxel Grid.
+//----------------------------------------------------------------------------------
+// Плотная сетка занятости, строится из `CubeVoxel`-ов. Геймплей держит уровень
+// в BrickMap (см. brick_map.cpp), сетка - для запекания SDF, тестов и бенчмарков.
+// Клетка (x, y, z) - это куб [x, x + 1] x [y, y + 1] x [z, z + 1] в мировых координатах.
+//
+// Значение клетки: 0 - пусто, иначе - colorIndex + 1.
+struct VoxelGrid {
+    Vector3Int origin = {};  // Мировые координаты клетки с индексом (0, 0, 0).
+    Vector3Int size   = {};
+    u8*        cells  = nullptr;
+};
+
+VoxelGrid MakeVoxelGrid(const CubeVoxel* cubes, int cubesCount) {
+    VoxelGrid grid = {};
+    if (cubesCount == 0)
+        return grid;
+
+    Vector3Int minPos = cubes[0].pos;
+    Vector3Int maxPos = cubes[0].pos;
+    FOR_RANGE (int, i, cubesCount) {
+        const auto& p = cubes[i].pos;
+        minPos        = {Min(minPos.x, p.x), Min(minPos.y, p.y), Min(minPos.z, p.z)};
+        maxPos        = {Max(maxPos.x, p.x), Max(maxPos.y, p.y), Max(maxPos.z, p.z)};
+    }
+
+    grid.origin = minPos;
+    grid.size   = {
+        maxPos.x - minPos.x + 1,
+        maxPos.y - minPos.y + 1,
+        maxPos.z - minPos.z + 1,
+    };
+    grid.cells = (u8*)RL_CALLOC(grid.size.x * grid.size.y * grid.size.z, sizeof(u8));
+
+    FOR_RANGE (int, i, cubesCount) {
+        const auto& cube = cubes[i];
+        // NOTE: u8 знаковый, поэтому в палитре не может быть больше 127 цветов.
+        Assert(cube.colorIndex >= 0);
+        Assert(cube.colorIndex < 127);
+
+        const int x = cube.pos.x - grid.origin.x;
+        const int y = cube.pos.y - grid.origin.y;
+        const int z = cube.pos.z - grid.origin.z;
+
+        grid.cells[(z * grid.size.y + y) * grid.size.x + x] = (u8)(cube.colorIndex + 1);
+    }
+
+    return grid;
+}
+
+void FreeVoxelGrid(VoxelGrid& grid) {
+    RL_FREE(grid.cells);
+    grid = {};
+}
+
+// Всё, что вне сетки, считается пустым.
+u8 VoxelGridGet(const VoxelGrid& grid, int x, int y, int z) {
+    x -= grid.origin.x;
+    y -= grid.origin.y;
+    z -= grid.origin.z;
+
+    if ((x < 0) || (y < 0) || (z < 0)  //
+        || (x >= grid.size.x) || (y >= grid.size.y) || (z >= grid.size.z))
+        return 0;
+
+    return grid.cells[(z * grid.size.y + y) * grid.size.x + x];
+}
+
+bool VoxelGridIsSolid(const VoxelGrid& grid, int x, int y, int z) {
+    return VoxelGridGet(grid, x, y, z) != 0;
+}
+
+//----------------------------------------------------------------------------------
+// Raycast vs Voxel Grid.
+//----------------------------------------------------------------------------------
+struct VoxelRaycastHit {
+    bool       hit      = false;
+    float      distance = 0;
+    Vector3    point    = {};
+    Vector3    normal   = {};
+    Vector3Int cell     = {};
+};
+
+// Обход клеток вдоль луча (Amanatides & Woo, "A Fast Voxel Traversal Algorithm").
+// Посещаются только клетки, через которые проходит луч.
+//
+// direction должен быть нормализован.
+// Если луч начинается внутри твёрдой клетки - попадание на расстоянии 0
+// с нулевой нормалью.
+VoxelRaycastHit VoxelGridRaycast(
+    const VoxelGrid& grid,
+    Vector3          origin,
+    Vector3          direction,
+    float            maxDistance
+) {
+    VoxelRaycastHit result = {};
+
+    const int gridMin[3] = {grid.origin.x, grid.origin.y, grid.origin.z};
+    const int gridMax[3] = {
+        grid.origin.x + grid.size.x,
+        grid.origin.y + grid.size.y,
+        grid.origin.z + grid.size.z,
+    };
+
+    const float* o = &origin.x;
+    const float* d = &direction.x;
+
+    // Обрезаем луч по AABB сетки, чтобы не шагать по пустоте снаружи неё.
+    float tEnter    = 0;
+    float tExit     = maxDistance;
+    int   enterAxis = -1;
+    FOR_RANGE (int, a, 3) {
+        if (d[a] == 0) {
+            if ((o[a] < (float)gridMin[a]) || (o[a] > (float)gridMax[a]))
+                return result;
+            continue;
+        }
+
+        float t0 = ((float)gridMin[a] - o[a]) / d[a];
+        float t1 = ((float)gridMax[a] - o[a]) / d[a];
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        if (t0 > tEnter) {
+            tEnter    = t0;
+            enterAxis = a;
+        }
+        tExit = Min(tExit, t1);
+    }
+    if (tEnter > tExit)
+        return result;
+
+    int   cell[3]   = {};
+    int   step[3]   = {};
+    float tMax[3]   = {};
+    float tDelta[3] = {};
+
+    FOR_RANGE (int, a, 3) {
+        const float p = o[a] + d[a] * tEnter;
+
+        cell[a] = (int)floorf(p);
+        // Из-за погрешности на границе сетки можем оказаться на клетку снаружи.
+        cell[a] = Max(gridMin[a], Min(gridMax[a] - 1, cell[a]));
+
+        if (d[a] > 0) {
+            step[a]   = 1;
+            tMax[a]   = tEnter + ((float)(cell[a] + 1) - p) / d[a];
+            tDelta[a] = 1 / d[a];
+        }
+        else if (d[a] < 0) {
+            step[a]   = -1;
+            tMax[a]   = tEnter + ((float)cell[a] - p) / d[a];
+            tDelta[a] = -1 / d[a];
+        }
+        else
+            tMax[a] = floatInf;
+    }
+
+    float t        = tEnter;
+    int   lastAxis = enterAxis;
+    while (t <= tExit) {
+        if (VoxelGridIsSolid(grid, cell[0], cell[1], cell[2])) {
+            result.hit      = true;
+            result.distance = t;
+            result.point    = origin + direction * t;
+            result.cell     = {cell[0], cell[1], cell[2]};
+            if (lastAxis != -1)
+                (&result.normal.x)[lastAxis] = (float)-step[lastAxis];
+            return result;
+        }
+
+        int a = 0;
+        if (tMax[1] < tMax[a])
+            a = 1;
+        if (tMax[2] < tMax[a])
+            a = 2;
+
+        t = tMax[a];
+        cell[a] += step[a];
+        tMax[a] += tDelta[a];
+        lastAxis = a;
+
+        if ((cell[a] < gridMin[a]) || (cell[a] >= gridMax[a]))
+            break;
+    }
+
+    return result;
+}
+
+TEST_CASE ("VoxelGridRaycast") {
+    CubeVoxel cubes[] = {
+        {{5, 0, 0}, 0},
+        {{0, 0, 0}, 0},
+        {{2, 3, 4}, 0},
+    };
+    auto grid = MakeVoxelGrid(cubes, 3);
+    defer {
+        FreeVoxelGrid(grid);
+    };
+
+    SUBCASE ("Hits the nearest cube") {
+        auto hit = VoxelGridRaycast(grid, {1.5f, 0.5f, 0.5f}, {1, 0, 0}, 100);
+        Assert(hit.hit);
+        Assert(FloatEquals(hit.distance, 3.5f));
+        Assert(hit.cell.x == 5);
+        Assert(hit.normal.x == -1);
+    }
+
+    SUBCASE ("Respects maxDistance") {
+        auto hit = VoxelGridRaycast(grid, {1.5f, 0.5f, 0.5f}, {1, 0, 0}, 3);
+        Assert_False(hit.hit);
+    }
+
+    SUBCASE ("Enters the grid from outside") {
+        auto hit = VoxelGridRaycast(grid, {-10, 0.5f, 0.5f}, {1, 0, 0}, 100);
+        Assert(hit.hit);
+        Assert(FloatEquals(hit.distance, 10));
+        Assert(hit.cell.x == 0);
+        Assert(hit.normal.x == -1);
+    }
+
+    SUBCASE ("Diagonal") {
+        const auto dir = Vector3Normalize({1, 1, 1});
+        auto hit = VoxelGridRaycast(grid, {-0.5f, 0.5f, 1.5f}, dir, 100);
+        Assert(hit.hit);
+        Assert(hit.cell.x == 2);
+        Assert(hit.cell.y == 3);
+        Assert(hit.cell.z == 4);
+    }
+
+    SUBCASE ("Misses") {
+        auto hit = VoxelGridRaycast(grid, {1.5f, 0.5f, 0.5f}, {0, 1, 0}, 100);
+        Assert_False(hit.hit);
+    }
+}
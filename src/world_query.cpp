@@ -0,0 +1,336 @@
+//----------------------------------------------------------------------------------
+// World Queries.
+//----------------------------------------------------------------------------------
+// Запросы к миру поверх BrickMap: лучи, пересечение сферы, ближайшая поверхность,
+// cone cast для aim assist-а. Пустые кирпичи пропускаются целиком, поэтому цена
+// зависит от того, сколько поверхности рядом, а не от размера уровня.
+//
+// Запросы только читают данные мира, поэтому их можно звать из любых потоков
+// одновременно (пока мир не перестраивается).
+struct World {
+    const BrickMap* bricks = nullptr;
+};
+
+struct WorldRay {
+    Vector3 origin      = {};
+    Vector3 direction   = {};  // Нормализован.
+    float   maxDistance = 0;
+};
+
+VoxelRaycastHit WorldRaycast(const World& world, const WorldRay& ray) {
+    return BrickMapRaycast(*world.bricks, ray.origin, ray.direction, ray.maxDistance);
+}
+
+// Лучей на поток не меньше этого - иначе раздача по потокам дороже самих лучей.
+const int worldRaycastsPerThreadMin = 32;
+
+// Лучи раскидываются по потокам пула (см. ParallelFor).
+// threadsCount <= 0 - по количеству ядер.
+void WorldRaycastBatch(
+    const World&     world,
+    const WorldRay*  rays,
+    int              count,
+    VoxelRaycastHit* out,
+    int              threadsCount = 0
+) {
+    threadsCount = Min(
+        ParallelForThreadsCount(threadsCount), Max(1, count / worldRaycastsPerThreadMin)
+    );
+
+    ParallelFor(count, threadsCount, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            out[i] = WorldRaycast(world, rays[i]);
+    });
+}
+
+// Ближайшая к p точка куба клетки.
+Vector3 ClosestPointOnCell_(Vector3Int cell, Vector3 p) {
+    return {
+        Clamp(p.x, (float)cell.x, (float)(cell.x + 1)),
+        Clamp(p.y, (float)cell.y, (float)(cell.y + 1)),
+        Clamp(p.z, (float)cell.z, (float)(cell.z + 1)),
+    };
+}
+
+// fn(cell, closest) для каждой занятой клетки, пересекающей сферу.
+// closest - ближайшая к center точка клетки. Если fn вернёт false - обход прекращается.
+template <typename F>
+void ForEachWorldCellInSphere_(const World& world, Vector3 center, float radius, F&& fn) {
+    const Vector3Int from = {
+        (int)floorf(center.x - radius),
+        (int)floorf(center.y - radius),
+        (int)floorf(center.z - radius),
+    };
+    const Vector3Int to = {
+        (int)floorf(center.x + radius),
+        (int)floorf(center.y + radius),
+        (int)floorf(center.z + radius),
+    };
+
+    ForEachBrickMapSolidCell(*world.bricks, from, to, [&](Vector3Int cell) {
+        const auto closest = ClosestPointOnCell_(cell, center);
+        if (Vector3DistanceSqr(closest, center) > radius * radius)
+            return true;
+        return fn(cell, closest);
+    });
+}
+
+// Пересекает ли сфера что-нибудь.
+bool WorldSphereOverlap(const World& world, Vector3 center, float radius) {
+    bool result = false;
+    ForEachWorldCellInSphere_(world, center, radius, [&](Vector3Int, Vector3) {
+        result = true;
+        return false;
+    });
+    return result;
+}
+
+// Занятые клетки, пересекающие сферу. Возвращает их количество
+// (может быть больше maxCount - в out записываются только первые maxCount).
+int WorldSphereOverlapCells(
+    const World& world,
+    Vector3      center,
+    float        radius,
+    Vector3Int*  out,
+    int          maxCount
+) {
+    int count = 0;
+    ForEachWorldCellInSphere_(world, center, radius, [&](Vector3Int cell, Vector3) {
+        if (count < maxCount)
+            out[count] = cell;
+        count++;
+        return true;
+    });
+    return count;
+}
+
+// Ближайшая к center точка поверхности, если она не дальше radius.
+// normal смотрит от поверхности в сторону center
+// (нулевая, если center внутри занятой клетки).
+VoxelRaycastHit WorldNearestSurface(const World& world, Vector3 center, float radius) {
+    VoxelRaycastHit result  = {};
+    float           bestSqr = floatInf;
+
+    ForEachWorldCellInSphere_(world, center, radius, [&](Vector3Int cell, Vector3 p) {
+        const float distanceSqr = Vector3DistanceSqr(p, center);
+        if (distanceSqr < bestSqr) {
+            bestSqr      = distanceSqr;
+            result.hit   = true;
+            result.point = p;
+            result.cell  = cell;
+        }
+        return distanceSqr > 0;
+    });
+
+    if (result.hit) {
+        result.distance = sqrtf(bestSqr);
+        if (result.distance > 0)
+            result.normal = (center - result.point) / result.distance;
+    }
+    return result;
+}
+
+// Ближайшая к лучу точка куба клетки: попеременные проекции на луч и на куб.
+// Двух шагов хватает, остаток покрывает worldConeCastSlack.
+Vector3 ClosestPointOnCellToRay_(Vector3Int cell, Vector3 origin, Vector3 direction) {
+    Vector3 p = {cell.x + 0.5f, cell.y + 0.5f, cell.z + 0.5f};
+    FOR_RANGE (int, i, 2) {
+        const float t = Max(0.0f, Vector3DotProduct(p - origin, direction));
+        p             = ClosestPointOnCell_(cell, origin + direction * t);
+    }
+    return p;
+}
+
+// Насколько клетка может выйти за конус и всё равно считаться в нём.
+const float worldConeCastSlack = 0.05f;
+
+// Первая поверхность внутри конуса с вершиной в origin.
+// Для aim assist-а: находит, куда зацепиться, даже если луч по центру промахнулся.
+// distance - расстояние от origin до найденной точки.
+//
+// Конус покрывается сферами вдоль оси. Сфера покрывает срез конуса
+// длиной step, шаг растёт вместе с радиусом конуса.
+// Сферы шире конуса, поэтому клетка считается, только если её ближайшая
+// к оси точка не дальше halfAngle от direction. В первой сфере, где что-то
+// нашлось, берётся ближайшая к origin точка перед ним.
+VoxelRaycastHit WorldConeCast(
+    const World& world,
+    Vector3      origin,
+    Vector3      direction,
+    float        halfAngle,
+    float        maxDistance
+) {
+    const float minStep = 0.5f;
+    const float tanHalf = tanf(halfAngle);
+
+    direction = Vector3Normalize(direction);
+
+    float t = 0;
+    while (t <= maxDistance) {
+        const float step   = minStep + t * tanHalf;
+        const auto  center = origin + direction * t;
+        const float radius = step / 2 + (t + step / 2) * tanHalf;
+
+        VoxelRaycastHit result  = {};
+        float           bestSqr = floatInf;
+
+        auto visit = [&](Vector3Int cell, Vector3 p) {
+            const auto  toAxis = ClosestPointOnCellToRay_(cell, origin, direction) - origin;
+            const float along  = Vector3DotProduct(toAxis, direction);
+            const float off    = Vector3Length(toAxis - direction * along);
+            if (off > along * tanHalf + worldConeCastSlack)
+                return true;
+
+            const auto  toPoint     = p - origin;
+            const float distanceSqr = Vector3LengthSqr(toPoint);
+            if ((Vector3DotProduct(toPoint, direction) > 0) && (distanceSqr < bestSqr)) {
+                bestSqr       = distanceSqr;
+                result.hit    = true;
+                result.point  = p;
+                result.cell   = cell;
+                result.normal = center - p;
+            }
+            return true;
+        };
+        ForEachWorldCellInSphere_(world, center, radius, visit);
+
+        if (result.hit) {
+            result.distance = sqrtf(bestSqr);
+            result.normal   = (Vector3LengthSqr(result.normal) > 0)
+                                  ? Vector3Normalize(result.normal)
+                                  : -direction;
+            return result;
+        }
+
+        t += step;
+    }
+
+    return {};
+}
+
+TEST_CASE ("WorldQuery") {
+    // Стена 1 x 5 x 5 на x = 10.
+    std::vector<CubeVoxel> cubes;
+    FOR_RANGE (int, y, 5) {
+        FOR_RANGE (int, z, 5) {
+            cubes.push_back({{10, y - 2, z - 2}, 0});
+        }
+    }
+    auto grid   = MakeVoxelGrid(cubes.data(), (int)cubes.size());
+    auto bricks = MakeBrickMap(cubes.data(), (int)cubes.size());
+    defer {
+        FreeBrickMap(bricks);
+        FreeVoxelGrid(grid);
+    };
+
+    const World world = {&bricks};
+
+    SUBCASE ("Raycast batch") {
+        WorldRay rays[64];
+        FOR_RANGE (int, i, 64) {
+            rays[i] = {{0, (float)(i % 8) - 3.5f, 0.5f}, {1, 0, 0}, 100};
+        }
+
+        VoxelRaycastHit hits[64];
+        WorldRaycastBatch(world, rays, 64, hits, 3);
+
+        bool same = true;
+        FOR_RANGE (int, i, 64) {
+            const auto expected = WorldRaycast(world, rays[i]);
+            same &= (hits[i].hit == expected.hit)
+                    && (hits[i].distance == expected.distance);
+
+            const auto& ray    = rays[i];
+            const auto  inGrid = VoxelGridRaycast(
+                grid, ray.origin, ray.direction, ray.maxDistance
+            );
+            same &= (inGrid.hit == expected.hit)
+                    && FloatEquals(inGrid.distance, expected.distance);
+        }
+        Assert(same);
+        Assert(hits[2].hit);        // y = -1.5.
+        Assert_False(hits[0].hit);  // y = -3.5.
+    }
+
+    SUBCASE ("Sphere overlap") {
+        Assert(WorldSphereOverlap(world, {9.5f, 0.5f, 0.5f}, 1));
+        Assert(WorldSphereOverlap(world, {9.5f, 0.5f, 0.5f}, 0.6f));
+        Assert_False(WorldSphereOverlap(world, {9.5f, 0.5f, 0.5f}, 0.4f));
+        Assert_False(WorldSphereOverlap(world, {5, 0.5f, 0.5f}, 1));
+
+        Vector3Int cells[32];
+        Assert(WorldSphereOverlapCells(world, {9.5f, 0.5f, 0.5f}, 0.6f, cells, 32) == 1);
+        Assert(cells[0].x == 10);
+        Assert(WorldSphereOverlapCells(world, {9.5f, 0.5f, 0.5f}, 1.2f, cells, 32) == 9);
+        Assert(WorldSphereOverlapCells(world, {5, 0.5f, 0.5f}, 1.2f, cells, 32) == 0);
+        Assert(WorldSphereOverlapCells(world, {9.5f, 0.5f, 0.5f}, 1.2f, cells, 4) == 9);
+    }
+
+    SUBCASE ("Nearest surface") {
+        auto hit = WorldNearestSurface(world, {8, 0.5f, 0.5f}, 3);
+        Assert(hit.hit);
+        Assert(FloatEquals(hit.distance, 2));
+        Assert(Vector3Distance(hit.point, {10, 0.5f, 0.5f}) < 0.001f);
+        Assert(hit.normal.x < -0.999f);
+        Assert(hit.cell.x == 10);
+
+        // У ребра стены - до ребра, а не до ближайшей грани.
+        hit = WorldNearestSurface(world, {9, 4, 0.5f}, 3);
+        Assert(hit.hit);
+        Assert(FloatEquals(hit.distance, sqrtf(2)));
+        Assert(Vector3Distance(hit.point, {10, 3, 0.5f}) < 0.001f);
+
+        Assert_False(WorldNearestSurface(world, {8, 0.5f, 0.5f}, 1).hit);
+    }
+
+    SUBCASE ("Cone cast") {
+        // Луч проходит над стеной, но стена попадает в конус.
+        const Vector3 origin    = {0, 4.5f, 0.5f};
+        const Vector3 direction = {1, 0, 0};
+
+        Assert_False(WorldRaycast(world, {origin, direction, 100}).hit);
+
+        auto hit = WorldConeCast(world, origin, direction, 10 * DEG2RAD, 100);
+        Assert(hit.hit);
+        Assert(hit.point.x > 9.9f);
+        Assert(hit.point.y < 3.1f);
+        Assert(FloatEquals(hit.distance, Vector3Distance(origin, hit.point)));
+
+        Assert_False(WorldConeCast(world, origin, direction, 2 * DEG2RAD, 100).hit);
+
+        // Ребро стены рядом с вершиной, но позади неё - не считается.
+        const Vector3 behind = {11.2f, 3.2f, 0.5f};
+        Assert_False(WorldConeCast(world, behind, direction, 10 * DEG2RAD, 100).hit);
+    }
+}
+
+TEST_CASE ("WorldConeCast") {
+    // Стена 5 x 1 x 5 вдоль луча, в 0.3 м от него - как у игрока,
+    // бегущего вдоль стены. aimAssistHalfAngle - 2 градуса.
+    std::vector<CubeVoxel> cubes;
+    FOR_RANGE (int, x, 5) {
+        FOR_RANGE (int, z, 5) {
+            cubes.push_back({{x, 0, z - 2}, 0});
+        }
+    }
+    auto bricks = MakeBrickMap(cubes.data(), (int)cubes.size());
+    defer {
+        FreeBrickMap(bricks);
+    };
+
+    const World   world     = {&bricks};
+    const Vector3 origin    = {-1, -0.3f, 0.5f};
+    const Vector3 direction = {1, 0, 0};
+
+    Assert_False(WorldRaycast(world, {origin, direction, 100}).hit);
+    Assert_False(WorldConeCast(world, origin, direction, 2 * DEG2RAD, 100).hit);
+
+    // В широкий конус стена попадает.
+    Assert(WorldConeCast(world, origin, direction, 10 * DEG2RAD, 100).hit);
+
+    // Прицел в стену - попадание и при 2 градусах.
+    const Vector3 down = Vector3Normalize({1, 0.2f, 0});
+    const auto    hit  = WorldConeCast(world, origin, down, 2 * DEG2RAD, 100);
+    Assert(hit.hit);
+    Assert(hit.cell.y == 0);
+}